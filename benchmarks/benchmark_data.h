@@ -0,0 +1,71 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_BENCHMARK_DATA_H_
+#define ROBOMASTER_CAN_CONTROLLER_BENCHMARK_DATA_H_
+
+#include "robomaster_can_controller/emulator.h"
+#include "robomaster_can_controller/message.h"
+#include "robomaster_can_controller/transport.h"
+#include "robomaster_can_controller/definitions.h"
+
+#include <cstring>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The velocity command of the chassis as sent by RoboMaster::set_velocity.
+     */
+    inline Message make_velocity_message() {
+        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, 0, { 0x00, 0x3f, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+        msg.set_value_float(3, 0.5f);
+        msg.set_value_float(7, -0.25f);
+        msg.set_value_float(11, 45.0f);
+        return msg;
+    }
+
+    /**
+     * @brief The LED command as sent by RoboMaster::set_led_on.
+     */
+    inline Message make_led_message() {
+        return Message(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, 0, { 0x00, 0x3f, 0x32, 0x71, 0x00, 0x00, 0xff, 0x80, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x00 });
+    }
+
+    /**
+     * @brief The can frames of a driving emulator, one state push every 20 frames.
+     *
+     * @param pushes The number of state pushes.
+     * @param corruption The probability of a flipped bit per frame.
+     */
+    inline std::vector<CanFrame> make_state_frames(const size_t pushes, const double corruption=0.0) {
+        std::vector<CanFrame> frames;
+        Emulator emulator(1337);
+        emulator.set_frame_sink([&frames](const uint32_t id, const uint8_t *data, const size_t length) {
+            CanFrame &frame = frames.emplace_back();
+            frame.id = id;
+            frame.length = static_cast<uint8_t>(length);
+            std::memcpy(frame.data, data, length);
+        });
+        emulator.set_push_rate(100.0);
+        emulator.set_frame_corruption(corruption);
+
+        const auto data = make_velocity_message().to_vector();
+        for (size_t i = 0; i < data.size(); i += 8) { emulator.push_frame(DEVICE_ID_INTELLI_CONTROLLER, data.data() + i, std::min(static_cast<size_t>(8), data.size() - i)); }
+        emulator.step(pushes * 10000000ULL);
+        return frames;
+    }
+
+    /**
+     * @brief A reassembled state push of the motion controller.
+     */
+    inline Message make_state_message() {
+        std::vector<uint8_t> data;
+        for (const auto &frame : make_state_frames(1)) { data.insert(data.end(), frame.data, frame.data + frame.length); }
+        return Message(DEVICE_ID_MOTION_CONTROLLER, data);
+    }
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_BENCHMARK_DATA_H_
@@ -0,0 +1,88 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "benchmark_data.h"
+#include "robomaster_can_controller/data.h"
+#include "robomaster_can_controller/serializer.h"
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <sstream>
+
+namespace robomaster_can_controller {
+    static void BM_DecodeDataVelocity(benchmark::State &state) {
+        const Message msg = make_state_message();
+        for (auto _ : state) { benchmark::DoNotOptimize(decode_data_velocity(27, msg)); }
+    }
+    BENCHMARK(BM_DecodeDataVelocity);
+
+    static void BM_DecodeDataBattery(benchmark::State &state) {
+        const Message msg = make_state_message();
+        for (auto _ : state) { benchmark::DoNotOptimize(decode_data_battery(51, msg)); }
+    }
+    BENCHMARK(BM_DecodeDataBattery);
+
+    static void BM_DecodeDataEsc(benchmark::State &state) {
+        const Message msg = make_state_message();
+        for (auto _ : state) { benchmark::DoNotOptimize(decode_data_esc(61, msg)); }
+    }
+    BENCHMARK(BM_DecodeDataEsc);
+
+    static void BM_DecodeDataImu(benchmark::State &state) {
+        const Message msg = make_state_message();
+        for (auto _ : state) { benchmark::DoNotOptimize(decode_data_imu(97, msg)); }
+    }
+    BENCHMARK(BM_DecodeDataImu);
+
+    static void BM_DecodeDataAttitude(benchmark::State &state) {
+        const Message msg = make_state_message();
+        for (auto _ : state) { benchmark::DoNotOptimize(decode_data_attitude(121, msg)); }
+    }
+    BENCHMARK(BM_DecodeDataAttitude);
+
+    static void BM_DecodeDataPosition(benchmark::State &state) {
+        const Message msg = make_state_message();
+        for (auto _ : state) { benchmark::DoNotOptimize(decode_data_position(133, msg)); }
+    }
+    BENCHMARK(BM_DecodeDataPosition);
+
+    static void BM_DecodeRoboMasterState(benchmark::State &state) {
+        const Message msg = make_state_message();
+        for (auto _ : state) { benchmark::DoNotOptimize(decode_robomaster_state(msg)); }
+    }
+    BENCHMARK(BM_DecodeRoboMasterState);
+
+    static void BM_OstreamRoboMasterState(benchmark::State &state) {
+        const DataRoboMasterState data = decode_robomaster_state(make_state_message());
+        std::ostringstream stream;
+        for (auto _ : state) {
+            stream.str(std::string());
+            stream << data;
+            benchmark::DoNotOptimize(stream);
+        }
+    }
+    BENCHMARK(BM_OstreamRoboMasterState);
+
+    static void BM_JsonRoboMasterState(benchmark::State &state) {
+        const DataRoboMasterState data = decode_robomaster_state(make_state_message());
+        std::array<char, SERIALIZER_MAX_SIZE> buffer{};
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(to_json(data, buffer.data(), buffer.size()));
+            benchmark::ClobberMemory();
+        }
+    }
+    BENCHMARK(BM_JsonRoboMasterState);
+
+    static void BM_CsvRoboMasterState(benchmark::State &state) {
+        const DataRoboMasterState data = decode_robomaster_state(make_state_message());
+        std::array<char, SERIALIZER_MAX_SIZE> buffer{};
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(to_csv(data, buffer.data(), buffer.size()));
+            benchmark::ClobberMemory();
+        }
+    }
+    BENCHMARK(BM_CsvRoboMasterState);
+} // namespace robomaster_can_controller
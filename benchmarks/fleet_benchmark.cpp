@@ -0,0 +1,85 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/emulator.h"
+#include "robomaster_can_controller/fleet.h"
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The push rate of the emulated motion controllers in Hz.
+     */
+    static constexpr double STD_PUSH_RATE = 50.0;
+
+    /**
+     * @brief The wall time of one iteration, the cpu time of the process is counted over it.
+     */
+    static constexpr auto STD_PERIOD = std::chrono::milliseconds(100);
+
+    /**
+     * @brief Start one emulator per robot, each on its own loopback bus.
+     *
+     * @param emulators The emulators to start.
+     * @param prefix The prefix of the bus names.
+     */
+    static void start_emulators(std::vector<Emulator> &emulators, const std::string &prefix) {
+        for (size_t i = 0; i < emulators.size(); i++) {
+            emulators[i].set_push_rate(STD_PUSH_RATE);
+            emulators[i].init(std::make_unique<LoopbackTransport>(), prefix + std::to_string(i));
+        }
+    }
+
+    /**
+     * @brief The cpu time of the emulators alone, subtract it from the two benchmarks below to get the cost of the handlers.
+     */
+    static void BM_FleetEmulators(benchmark::State &state) {
+        std::vector<Emulator> emulators(state.range(0));
+        start_emulators(emulators, "fleet_benchmark_emulators_");
+        for (auto _ : state) { std::this_thread::sleep_for(STD_PERIOD); }
+        state.counters["robots"] = static_cast<double>(state.range(0));
+    }
+    BENCHMARK(BM_FleetEmulators)->RangeMultiplier(2)->Range(1, 16)->Iterations(10)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::kMillisecond);
+
+    /**
+     * @brief Every robot runs its own receiver, sender and handler thread.
+     */
+    static void BM_FleetDedicatedThreads(benchmark::State &state) {
+        std::vector<Emulator> emulators(state.range(0));
+        start_emulators(emulators, "fleet_benchmark_dedicated_");
+        std::vector<std::unique_ptr<BasicHandler<LoopbackTransport>>> handlers;
+        for (size_t i = 0; i < emulators.size(); i++) {
+            handlers.push_back(std::make_unique<BasicHandler<LoopbackTransport>>());
+            handlers.back()->init("fleet_benchmark_dedicated_" + std::to_string(i));
+        }
+        for (auto _ : state) { std::this_thread::sleep_for(STD_PERIOD); }
+        state.counters["robots"] = static_cast<double>(state.range(0));
+    }
+    BENCHMARK(BM_FleetDedicatedThreads)->RangeMultiplier(2)->Range(1, 16)->Iterations(10)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::kMillisecond);
+
+    /**
+     * @brief All robots share the io thread and two dispatch threads of one fleet.
+     */
+    static void BM_FleetSharedThreads(benchmark::State &state) {
+        std::vector<Emulator> emulators(state.range(0));
+        start_emulators(emulators, "fleet_benchmark_shared_");
+        BasicFleet<LoopbackTransport> fleet;
+        fleet.init(2);
+        std::vector<std::unique_ptr<BasicHandler<LoopbackTransport>>> handlers;
+        for (size_t i = 0; i < emulators.size(); i++) {
+            handlers.push_back(std::make_unique<BasicHandler<LoopbackTransport>>());
+            handlers.back()->init(fleet, "fleet_benchmark_shared_" + std::to_string(i));
+        }
+        for (auto _ : state) { std::this_thread::sleep_for(STD_PERIOD); }
+        state.counters["robots"] = static_cast<double>(state.range(0));
+    }
+    BENCHMARK(BM_FleetSharedThreads)->RangeMultiplier(2)->Range(1, 16)->Iterations(10)->MeasureProcessCPUTime()->UseRealTime()->Unit(benchmark::kMillisecond);
+} // namespace robomaster_can_controller
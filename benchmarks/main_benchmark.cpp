@@ -0,0 +1,9 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
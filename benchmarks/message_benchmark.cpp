@@ -0,0 +1,44 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "benchmark_data.h"
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+
+namespace robomaster_can_controller {
+    static void BM_MessageToVectorVelocity(benchmark::State &state) {
+        const Message msg = make_velocity_message();
+        for (auto _ : state) { benchmark::DoNotOptimize(msg.to_vector()); }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * msg.get_length()));
+    }
+    BENCHMARK(BM_MessageToVectorVelocity);
+
+    static void BM_MessageToVectorState(benchmark::State &state) {
+        const Message msg = make_state_message();
+        for (auto _ : state) { benchmark::DoNotOptimize(msg.to_vector()); }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * msg.get_length()));
+    }
+    BENCHMARK(BM_MessageToVectorState);
+
+    static void BM_MessageParseState(benchmark::State &state) {
+        const auto data = make_state_message().to_vector();
+        for (auto _ : state) { benchmark::DoNotOptimize(Message(DEVICE_ID_MOTION_CONTROLLER, data)); }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+    }
+    BENCHMARK(BM_MessageParseState);
+
+    static void BM_MessageOstreamState(benchmark::State &state) {
+        const Message msg = make_state_message();
+        std::ostringstream stream;
+        for (auto _ : state) {
+            stream.str(std::string());
+            stream << msg;
+            benchmark::DoNotOptimize(stream);
+        }
+    }
+    BENCHMARK(BM_MessageOstreamState);
+} // namespace robomaster_can_controller
@@ -0,0 +1,28 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/metrics.h"
+#include <benchmark/benchmark.h>
+
+namespace robomaster_can_controller {
+    static Metrics metrics;
+
+    static void BM_MetricsAdd(benchmark::State &state) {
+        for (auto _ : state) { metrics.add(METRIC_FRAMES_RECEIVED); }
+    }
+    BENCHMARK(BM_MetricsAdd)->ThreadRange(1, 4);
+
+    static void BM_MetricsRecord(benchmark::State &state) {
+        uint64_t value = 1000;
+        for (auto _ : state) { metrics.record(METRIC_CALLBACK_DURATION, value++ & 0xffff); }
+    }
+    BENCHMARK(BM_MetricsRecord)->ThreadRange(1, 4);
+
+    static void BM_MetricsPrometheus(benchmark::State &state) {
+        for (auto _ : state) { benchmark::DoNotOptimize(to_prometheus(metrics.get_snapshot())); }
+    }
+    BENCHMARK(BM_MetricsPrometheus);
+} // namespace robomaster_can_controller
@@ -0,0 +1,41 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "benchmark_data.h"
+#include "robomaster_can_controller/queue_msg.h"
+#include <benchmark/benchmark.h>
+
+namespace robomaster_can_controller {
+    static void BM_QueueMsgPushPop(benchmark::State &state) {
+        QueueMsg queue;
+        const Message msg = make_velocity_message();
+        for (auto _ : state) {
+            queue.push(msg);
+            benchmark::DoNotOptimize(queue.pop());
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_QueueMsgPushPop);
+
+    /**
+     * @brief The handoff from a producer to the sender thread. Thread 0 pushes the commands, thread 1 pops them like the sender thread.
+     */
+    static void BM_QueueMsgHandoff(benchmark::State &state) {
+        static QueueMsg queue;
+        const Message msg = make_velocity_message();
+        size_t counter = 0;
+
+        if (state.thread_index() == 0) {
+            for (auto _ : state) { queue.push(msg); }
+        } else {
+            for (auto _ : state) { if (queue.pop().is_valid()) { counter++; } }
+        }
+        // the share of pops which found a message, the overflow of the queue drops the oldest commands.
+        if (state.thread_index() == 1) { state.counters["hit_rate"] = benchmark::Counter(static_cast<double>(counter) / static_cast<double>(state.iterations())); }
+        if (state.thread_index() == 0) { queue.clear(); }
+    }
+    BENCHMARK(BM_QueueMsgHandoff)->Threads(2)->UseRealTime();
+} // namespace robomaster_can_controller
@@ -0,0 +1,31 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "benchmark_data.h"
+#include "robomaster_can_controller/reassembler.h"
+#include <benchmark/benchmark.h>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Reassemble the state pushes of the motion controller like the receiver thread of the handler.
+     * The argument is the probability of a flipped bit per frame in percent.
+     */
+    static void BM_ReassembleStatePush(benchmark::State &state) {
+        const auto frames = make_state_frames(100, static_cast<double>(state.range(0)) / 100.0);
+        Reassembler reassembler;
+        std::vector<Message> messages;
+        size_t counter = 0;
+
+        for (auto _ : state) {
+            for (const auto &frame : frames) { reassembler.push_frame(frame.id, frame.data, frame.length, messages); }
+            counter += messages.size();
+            messages.clear();
+        }
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * frames.size()));
+        state.counters["messages"] = benchmark::Counter(static_cast<double>(counter), benchmark::Counter::kIsRate);
+    }
+    BENCHMARK(BM_ReassembleStatePush)->Arg(0)->Arg(1)->Arg(10);
+} // namespace robomaster_can_controller
@@ -0,0 +1,49 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "benchmark_data.h"
+#include "robomaster_can_controller/utils.h"
+#include <benchmark/benchmark.h>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief CRC8 over the header of a message, the range 3 covers the header size.
+     */
+    static void BM_CalculateCrc8(benchmark::State &state) {
+        const auto data = make_state_message().to_vector();
+        for (auto _ : state) { benchmark::DoNotOptimize(calculate_crc8(data.data(), 3)); }
+    }
+    BENCHMARK(BM_CalculateCrc8);
+
+    /**
+     * @brief CRC16 over a whole message, the ranges cover the velocity command and the state push.
+     */
+    static void BM_CalculateCrc16(benchmark::State &state) {
+        const auto data = make_state_message().to_vector();
+        const auto length = std::min(static_cast<size_t>(state.range(0)), data.size() - 2);
+        for (auto _ : state) { benchmark::DoNotOptimize(calculate_crc16(data.data(), length)); }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * length));
+    }
+    BENCHMARK(BM_CalculateCrc16)->Arg(make_velocity_message().get_length() - 2)->Arg(make_state_message().get_length() - 2);
+
+    static void BM_StringToHexState(benchmark::State &state) {
+        const auto data = make_state_message().to_vector();
+        for (auto _ : state) { benchmark::DoNotOptimize(string_to_hex(data)); }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+    }
+    BENCHMARK(BM_StringToHexState);
+
+    /**
+     * @brief Hex digits of a whole state push into a caller buffer, without allocation.
+     */
+    static void BM_HexEncodeState(benchmark::State &state) {
+        const auto data = make_state_message().to_vector();
+        std::vector<char> buffer(data.size() * 2);
+        for (auto _ : state) { benchmark::DoNotOptimize(hex_encode(data.data(), data.size(), buffer.data(), buffer.size())); benchmark::ClobberMemory(); }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+    }
+    BENCHMARK(BM_HexEncodeState);
+} // namespace robomaster_can_controller
@@ -3,15 +3,18 @@
 // Licensed under the MIT License.
 // For details on the licensing terms, see the LICENSE file. Copyright refers to Fraunhofer IML
 
-#include <iostream>
+#include <array>
+#include <cstdio>
 #include "robomaster_can_controller/robomaster.h"
+#include "robomaster_can_controller/serializer.h"
 #include <robomaster_can_controller/definitions.h>
 
 /**
- * @brief Callback to print the state of the RoboMaster.
+ * @brief Callback to print the state of the RoboMaster as JSON, the buffer is reused for every state.
  */
 void callback(const robomaster_can_controller::DataRoboMasterState &state) {
-    std::cout << state << std::endl;
+    static std::array<char, robomaster_can_controller::SERIALIZER_MAX_SIZE> buffer;
+    robomaster_can_controller::write_line(stdout, buffer.data(), robomaster_can_controller::to_json(state, buffer.data(), buffer.size()));
 }
 
 /**
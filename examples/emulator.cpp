@@ -0,0 +1,36 @@
+// Copyright (c) 2024 Vinzenz Weist
+//
+// Licensed under the MIT License.
+// For details on the licensing terms, see the LICENSE file. Copyright refers to Fraunhofer IML
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include "robomaster_can_controller/emulator.h"
+
+/**
+ * Emulate the motion controller of the RoboMaster on a virtual can interface.
+ * Usage: robomaster_can_controller_emulator [interface] [push rate in Hz] [frame loss] [frame corruption]
+ */
+int main(int argc, char **argv) {
+    // Using namespace for simplicity
+    using namespace robomaster_can_controller;
+
+    const std::string can_interface = 1 < argc ? argv[1] : "vcan0";
+    Emulator emulator;
+    emulator.set_push_rate(2 < argc ? std::atof(argv[2]) : 50.0);
+    emulator.set_frame_loss(3 < argc ? std::atof(argv[3]) : 0.0);
+    emulator.set_frame_corruption(4 < argc ? std::atof(argv[4]) : 0.0);
+
+    if (!emulator.init(can_interface)) { std::cout << "Failed to serve " << can_interface << std::endl; return EXIT_FAILURE; }
+
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        const auto state = emulator.get_state();
+        const auto statistics = emulator.get_statistics();
+        std::cout << "booted: " << state.booted << " work mode: " << state.work_mode
+                  << " messages: " << statistics.messages_received << " acks: " << statistics.acks
+                  << " pushes: " << statistics.pushes << " frames: " << statistics.frames_sent << std::endl;
+    }
+}
@@ -0,0 +1,94 @@
+# Copyright (c) 2024 Vinzenz Weist
+#
+# Licensed under the MIT License.
+# For details on the licensing terms, see the LICENSE file. Copyright refers to Fraunhofer IML
+
+import sys
+import time
+
+import numpy as np
+import robomaster_can_controller as rm
+
+
+def callback(states: dict) -> None:
+    """Print the mean of the imu data and the wheel speeds of a batch, the arrays are copies which may be kept."""
+    valid = (states["sections"] & rm.SECTION_IMU) != 0
+    if not valid.any():
+        return
+    acc_x = states["acc_x"][valid].mean()
+    gyro_z = states["gyro_z"][valid].mean()
+    speed = states["speed"][valid].mean(axis=0)
+    print(f"[Example]: states {states['sequence'][0]}-{states['sequence'][-1]} acc_x {acc_x} gyro_z {gyro_z} speed {speed}")
+
+
+def rainbow(position: int) -> tuple:
+    """Get the color value for a rainbow scale for a given position."""
+    position %= 256
+    if position < 85:
+        return position * 3, 255 - position * 3, 0
+    if position < 170:
+        position -= 85
+        return 255 - position * 3, 0, position * 3
+    position -= 170
+    return 0, position * 3, 255 - position * 3
+
+
+def main() -> int:
+    # Create the robomaster with a history of one minute at 50 Hertz.
+    robomaster = rm.RoboMaster(history=3000)
+
+    # Try to init, the can interface can be given as argument, e.g. vcan0 for the emulator.
+    if not robomaster.init(sys.argv[1] if 1 < len(sys.argv) else "can0"):
+        print("[Example]: Robomaster initialization failed")
+        return 1
+
+    # Bind the callback, it is called with 25 states at once instead of 50 times a second with a single state.
+    robomaster.bind(callback, batch=25)
+
+    # Enable the robomaster to execute drive commands.
+    robomaster.enable()
+
+    # CAUTION: Sleep for a short period to not overfill the can bus communication.
+    time.sleep(0.025)
+
+    # A small presentation of the LED breath effect.
+    for i in range(0, 512, 20):
+        robomaster.led_breath(*rainbow(i), 0.4)
+        time.sleep(0.1)
+
+    # Let the robomaster drive forward with increasing wheel speed and increase set led brightness.
+    for i in range(100):
+        robomaster.led_on(i * 2, i * 2, i * 2)
+        robomaster.wheelRPM(i * 2, i * 2, i * 2, i * 2)
+        time.sleep(0.025)
+
+    # Slow the robomaster and decrease the LED light.
+    for i in reversed(range(100)):
+        robomaster.led_on(i * 2, i * 2, i * 2)
+        robomaster.wheelRPM(i * 2, i * 2, i * 2, i * 2)
+        time.sleep(0.025)
+
+    # Stop the wheel of the robomaster.
+    robomaster.stop()
+
+    # Windowed statistics of the last ten seconds, the arrays are copies, copy=False returns read only views of the history.
+    window = robomaster.last(500)
+    print(f"[Example]: {len(window['sequence'])} states, yaw range {np.ptp(window['yaw'])} deg, "
+          f"max wheel speed {np.abs(window['speed']).max()} rpm")
+
+    # Use the LED Flash of all LED.
+    robomaster.led_flash(255, 0, 0, 0.4)
+    time.sleep(2.0)
+
+    # Turn of the LED.
+    robomaster.led_off()
+    time.sleep(0.01)
+
+    # Disable the robomaster after finish the example.
+    robomaster.disable()
+    robomaster.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
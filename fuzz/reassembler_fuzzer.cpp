@@ -0,0 +1,82 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/reassembler.h"
+#include "robomaster_can_controller/message.h"
+#include "robomaster_can_controller/data.h"
+#include "robomaster_can_controller/definitions.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The can ids a frame of the input is sent from, the last one is not handled by the reassembler.
+     */
+    static constexpr std::array<uint32_t, 8> STD_FUZZ_DEVICES = {
+        DEVICE_ID_MOTION_CONTROLLER, DEVICE_ID_MOTION_CONTROLLER, DEVICE_ID_MOTION_CONTROLLER, DEVICE_ID_GIMBAL,
+        DEVICE_ID_HIT_DETECTOR_1, DEVICE_ID_HIT_DETECTOR_4, DEVICE_ID_INTELLI_CONTROLLER, 0x123
+    };
+
+    /**
+     * @brief Abort on a broken invariant, so the fuzzer reports the input like a crash.
+     */
+    static void check(const bool condition) {
+        if (!condition) { std::abort(); }
+    }
+
+    /**
+     * @brief Decode a reassembled message with every decoder and check that it survives a round trip.
+     */
+    static void process_message(const Message &msg, std::ostringstream &os) {
+        check(msg.is_valid());
+        check(msg.get_time_first_frame() <= msg.get_time_last_frame());
+
+        const DataRoboMasterState state = decode_robomaster_state(msg);
+        os << state;
+        for (size_t index = 0; index < msg.get_payload().size(); index += 7) {
+            os << decode_data_battery(index, msg) << decode_data_esc(index, msg) << decode_data_imu(index, msg) << decode_data_attitude(index, msg)
+               << decode_data_position(index, msg) << decode_data_velocity(index, msg);
+        }
+        os << msg;
+
+        const Message copy(msg.get_device_id(), msg.to_vector());
+        check(copy.is_valid() && copy.get_type() == msg.get_type() && copy.get_sequence() == msg.get_sequence() && copy.get_payload() == msg.get_payload());
+    }
+} // namespace robomaster_can_controller
+
+/**
+ * The input is a sequence of frames, every frame starts with a control byte: the low three bits select the can id,
+ * the high bits the length of the frame in 0 to 8 bytes, followed by the data. A truncated last frame is pushed as it is.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, const size_t size) {
+    using namespace robomaster_can_controller;
+
+    Reassembler reassembler;
+    std::vector<Message> messages;
+    std::ostringstream os;
+    uint64_t timestamp = 1;
+
+    for (size_t offset = 0; offset < size;) {
+        const uint8_t control = data[offset++];
+        const uint32_t device_id = STD_FUZZ_DEVICES[control & 0x07];
+        const size_t length = std::min(static_cast<size_t>((control >> 3) % 9), size - offset);
+
+        const size_t count = reassembler.push_frame(device_id, data + offset, length, messages, timestamp++);
+        check(count <= messages.size());
+        offset += length;
+    }
+    for (const Message &msg : messages) { process_message(msg, os); }
+
+    // the raw input as a single message must never be read out of bounds.
+    const Message raw(DEVICE_ID_MOTION_CONTROLLER, std::vector(data, data + size));
+    if (raw.is_valid()) { process_message(raw, os); }
+    return 0;
+}
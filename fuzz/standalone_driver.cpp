@@ -0,0 +1,151 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+// Drives LLVMFuzzerTestOneInput without libFuzzer, e.g. with gcc and -fsanitize=address,undefined. It replays the given
+// files and directories and then runs random inputs, which are mutations of the replayed inputs when there are any.
+// The flags follow libFuzzer: -runs=N, -seed=N, -max_len=N and -report_slow_units=S with fractional seconds.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace {
+    /**
+     * @brief The options of the driver.
+     */
+    struct Options {
+        size_t runs = 10000;
+        size_t max_len = 4096;
+        uint64_t seed = 0;
+        double slow_seconds = 0.01;
+        std::vector<std::string> paths;
+    };
+
+    /**
+     * @brief The slowest input so far.
+     */
+    struct Slowest {
+        double seconds = 0.0;
+        std::vector<uint8_t> data;
+    };
+
+    /**
+     * @brief Run one input and measure its duration.
+     */
+    double measure(const std::vector<uint8_t> &data) {
+        const auto start = std::chrono::steady_clock::now();
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * @brief Run one input, report it when it is slow and keep the slowest.
+     */
+    void run(const std::vector<uint8_t> &data, const std::string &name, const Options &options, Slowest &slowest, size_t &slow_units) {
+        double seconds = measure(data);
+
+        // a slow input is measured again, so a preemption of the process is not reported as slow input.
+        if (options.slow_seconds <= seconds) { seconds = std::min(seconds, measure(data)); }
+
+        if (slowest.seconds < seconds) { slowest.seconds = seconds; slowest.data = data; }
+        if (seconds < options.slow_seconds) { return; }
+
+        slow_units++;
+        std::printf("Slow unit: %.3f ms for %zu bytes (%s)\n", seconds * 1e3, data.size(), name.c_str());
+        if (name != "random") { return; }
+
+        const std::string path = "slow-unit-" + std::to_string(slow_units);
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        std::printf("Slow unit written to %s\n", path.c_str());
+    }
+
+    /**
+     * @brief Read a file as input.
+     */
+    bool read_file(const std::filesystem::path &path, std::vector<uint8_t> &data) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) { std::printf("[Fuzz]: Failed to open %s\n", path.c_str()); return false; }
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    /**
+     * @brief Create a random input, either new or by mutating one of the corpus.
+     */
+    std::vector<uint8_t> generate(std::mt19937_64 &random, const std::vector<std::vector<uint8_t>> &corpus, const size_t max_len) {
+        std::vector<uint8_t> data;
+        if (!corpus.empty() && random() % 4 != 0) {
+            data = corpus[random() % corpus.size()];
+            const size_t mutations = 1 + random() % 8;
+            for (size_t i = 0; i < mutations && !data.empty(); i++) {
+                switch (random() % 4) {
+                    case 0: data[random() % data.size()] ^= static_cast<uint8_t>(1 << random() % 8); break;
+                    case 1: data[random() % data.size()] = static_cast<uint8_t>(random()); break;
+                    case 2: data.erase(data.begin() + static_cast<long>(random() % data.size())); break;
+                    default: data.insert(data.begin() + static_cast<long>(random() % data.size()), static_cast<uint8_t>(random())); break;
+                }
+            }
+        } else {
+            // sync bytes and the maximum frame length are likely, so the inputs reach the header search and the reassembly.
+            data.resize(random() % (max_len + 1));
+            for (auto &byte : data) { byte = random() % 3 == 0 ? (random() % 2 == 0 ? 0x55 : 0x40) : static_cast<uint8_t>(random()); }
+        }
+        if (max_len < data.size()) { data.resize(max_len); }
+        return data;
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg.rfind("-runs=", 0) == 0) { options.runs = std::strtoull(arg.c_str() + 6, nullptr, 10); }
+        else if (arg.rfind("-seed=", 0) == 0) { options.seed = std::strtoull(arg.c_str() + 6, nullptr, 10); }
+        else if (arg.rfind("-max_len=", 0) == 0) { options.max_len = std::strtoull(arg.c_str() + 9, nullptr, 10); }
+        else if (arg.rfind("-report_slow_units=", 0) == 0) { options.slow_seconds = std::strtod(arg.c_str() + 19, nullptr); }
+        else if (arg.rfind('-', 0) == 0) { std::printf("Usage: %s [-runs=N] [-seed=N] [-max_len=N] [-report_slow_units=S] [files or directories]\n", argv[0]); return 1; }
+        else { options.paths.push_back(arg); }
+    }
+
+    Slowest slowest;
+    size_t slow_units = 0;
+    std::vector<std::vector<uint8_t>> corpus;
+    for (const auto &path : options.paths) {
+        std::vector<std::filesystem::path> files;
+        if (std::filesystem::is_directory(path)) {
+            for (const auto &entry : std::filesystem::directory_iterator(path)) { if (entry.is_regular_file()) { files.push_back(entry.path()); } }
+        } else {
+            files.emplace_back(path);
+        }
+        for (const auto &file : files) {
+            std::vector<uint8_t> data;
+            if (!read_file(file, data)) { return 1; }
+            run(data, file.string(), options, slowest, slow_units);
+            corpus.push_back(std::move(data));
+        }
+    }
+
+    std::mt19937_64 random(options.seed);
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < options.runs; i++) { run(generate(random, corpus, options.max_len), "random", options, slowest, slow_units); }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("Done %zu corpus units and %zu runs in %.2f s, %zu slow units, slowest %.3f ms for %zu bytes\n",
+                corpus.size(), options.runs, seconds, slow_units, slowest.seconds * 1e3, slowest.data.size());
+    return 0;
+}
@@ -0,0 +1,459 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_BRIDGE_H_
+#define ROBOMASTER_CAN_CONTROLLER_BRIDGE_H_
+
+#include "data.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The magic at the beginning of every packet.
+     */
+    static constexpr char BRIDGE_MAGIC[2] = { 'R', 'B' };
+
+    /**
+     * @brief The version of the protocol.
+     */
+    static constexpr uint8_t BRIDGE_VERSION = 1;
+
+    /**
+     * @brief The maximum number of states in one packet.
+     */
+    static constexpr uint16_t BRIDGE_MAX_BATCH = 16;
+
+    /**
+     * @brief The type of a packet.
+     */
+    enum BridgePacketType : uint8_t {
+        BRIDGE_SUBSCRIBE = 1,
+        BRIDGE_COMMAND = 2,
+        BRIDGE_STATES = 3
+    };
+
+    /**
+     * @brief The command of a BridgeCommand, every command maps to the setter of the RoboMaster with the same name.
+     */
+    enum BridgeCommandType : uint8_t {
+        BRIDGE_WORK_MODE = 1,
+        BRIDGE_VELOCITY = 2,
+        BRIDGE_WHEEL_RPM = 3,
+        BRIDGE_BRAKE = 4,
+        BRIDGE_GIMBAL = 5,
+        BRIDGE_BLASTER = 6,
+        BRIDGE_LED_OFF = 7,
+        BRIDGE_LED_ON = 8,
+        BRIDGE_LED_BREATH = 9,
+        BRIDGE_LED_FLASH = 10
+    };
+
+    /**
+     * @brief The header of every packet, followed by count entries of the type. All values are stored in host byte order and the
+     * structures have a fixed layout without implicit padding, a client of another language reads them at their offsets.
+     */
+    struct BridgeHeader {
+        char magic[2];
+        uint8_t version;
+        uint8_t type;
+        uint16_t count;
+        uint16_t reserved;
+    };
+    static_assert(sizeof(BridgeHeader) == 8);
+
+    /**
+     * @brief The subscription of a client, answered by the bridge with the same packet once it is active. A new client receives
+     * all sections of every state one per packet until it subscribes.
+     */
+    struct BridgeSubscribe {
+        /**
+         * @brief The mask of StateSection, zero stops the states.
+         */
+        uint32_t sections;
+
+        /**
+         * @brief The number of states per packet, up to BRIDGE_MAX_BATCH.
+         */
+        uint16_t batch;
+
+        /**
+         * @brief Every decimation-th state is sent, e.g. 5 for 10 Hz.
+         */
+        uint16_t decimation;
+    };
+    static_assert(sizeof(BridgeSubscribe) == 8);
+
+    /**
+     * @brief A command of a client, the unused values are ignored.
+     */
+    struct BridgeCommand {
+        uint8_t type;
+        uint8_t r;
+        uint8_t g;
+        uint8_t b;
+
+        /**
+         * @brief The LED mask, the work mode or the BlasterType.
+         */
+        uint16_t mask;
+        uint16_t reserved;
+
+        /**
+         * @brief The rise or on time and the down or off time of the LED in milliseconds.
+         */
+        uint16_t t_1;
+        uint16_t t_2;
+
+        /**
+         * @brief The wheel rpm fr, fl, rl and rr or the gimbal y and z.
+         */
+        int16_t values[4];
+
+        /**
+         * @brief The velocities x, y and z.
+         */
+        float x;
+        float y;
+        float z;
+    };
+    static_assert(sizeof(BridgeCommand) == 32);
+
+    /**
+     * @brief The header of a state in a BRIDGE_STATES packet, followed by the sections.
+     */
+    struct BridgeStateRecord {
+        /**
+         * @brief The number of the state since the bridge was opened.
+         */
+        uint64_t sequence;
+
+        /**
+         * @brief The mask of the following sections.
+         */
+        uint32_t sections;
+
+        /**
+         * @brief The size of the record including the sections.
+         */
+        uint32_t size;
+    };
+    static_assert(sizeof(BridgeStateRecord) == 16);
+
+    struct BridgeBattery {
+        uint16_t adc_value;
+        uint16_t temperature;
+        int32_t current;
+        uint8_t percent;
+        uint8_t reserved[3];
+    };
+    static_assert(sizeof(BridgeBattery) == 12);
+
+    struct BridgeEsc {
+        int16_t speed[4];
+        int16_t angle[4];
+        uint32_t time_stamp[4];
+        uint8_t state[4];
+    };
+    static_assert(sizeof(BridgeEsc) == 36);
+
+    struct BridgeImu {
+        float acc_x, acc_y, acc_z;
+        float gyro_x, gyro_y, gyro_z;
+    };
+    static_assert(sizeof(BridgeImu) == 24);
+
+    struct BridgeVelocity {
+        float vgx, vgy, vgz;
+        float vbx, vby, vbz;
+    };
+    static_assert(sizeof(BridgeVelocity) == 24);
+
+    struct BridgePosition {
+        float x, y, z;
+    };
+    static_assert(sizeof(BridgePosition) == 12);
+
+    struct BridgeAttitude {
+        float roll, pitch, yaw;
+    };
+    static_assert(sizeof(BridgeAttitude) == 12);
+
+    /**
+     * @brief The timestamp section, its offset in the record is not 8 byte aligned for every subscription.
+     */
+    struct BridgeTimestamp {
+        uint64_t first_frame;
+        uint64_t last_frame;
+        uint64_t acquisition;
+        uint64_t uncertainty;
+    };
+    static_assert(sizeof(BridgeTimestamp) == 32);
+
+    /**
+     * @brief The maximum size of a state record.
+     */
+    static constexpr size_t BRIDGE_MAX_RECORD = sizeof(BridgeStateRecord) + sizeof(BridgeBattery) + sizeof(BridgeEsc) + sizeof(BridgeImu)
+        + sizeof(BridgeVelocity) + sizeof(BridgePosition) + sizeof(BridgeAttitude) + sizeof(BridgeTimestamp);
+
+    /**
+     * @brief Encode the subscribed sections with data of a state, the record holds them in the order of StateSection.
+     *
+     * @param state The state.
+     * @param sections The mask of StateSection.
+     * @param sequence The number of the state.
+     * @param buffer The buffer of at least BRIDGE_MAX_RECORD bytes.
+     * @return size_t as size of the record.
+     */
+    size_t encode_bridge_record(const DataRoboMasterState &state, uint32_t sections, uint64_t sequence, uint8_t *buffer);
+
+    /**
+     * @brief Decode a state record, the sections which are not in the record have no data.
+     *
+     * @param buffer The record.
+     * @param length The remaining bytes of the packet.
+     * @param state The state.
+     * @param sequence The number of the state.
+     * @return size_t as size of the record, zero when the record is invalid.
+     */
+    size_t decode_bridge_record(const uint8_t *buffer, size_t length, DataRoboMasterState &state, uint64_t &sequence);
+
+    /**
+     * @brief Counters of the bridge.
+     */
+    struct BridgeStatistics {
+        /**
+         * @brief Number of connected clients.
+         */
+        uint64_t clients = 0;
+
+        /**
+         * @brief Number of published states.
+         */
+        uint64_t states = 0;
+
+        /**
+         * @brief Number of sent packets.
+         */
+        uint64_t packets = 0;
+
+        /**
+         * @brief Number of sent state records.
+         */
+        uint64_t records = 0;
+
+        /**
+         * @brief Number of state records dropped because a client was too slow or the io thread was behind.
+         */
+        uint64_t dropped = 0;
+
+        /**
+         * @brief Number of received commands.
+         */
+        uint64_t commands = 0;
+
+        /**
+         * @brief Number of received packets with an unknown layout.
+         */
+        uint64_t invalid = 0;
+    };
+
+    /**
+     * @brief This class serves the states and accepts commands over a local SOCK_SEQPACKET unix socket, for clients which can not
+     * link the library. A single io thread accepts the clients, reads their subscriptions and commands and sends the states. A state is
+     * encoded once per distinct subscription and the records of a client are sent in batches of its subscription. The io thread never
+     * blocks on a client, a packet which does not fit into the socket buffer of a slow client is dropped, so the client receives the
+     * newest states once it catches up. Publishing only queues the state and never blocks on the io thread either.
+     */
+    class Bridge {
+        /**
+         * @brief A connected client.
+         */
+        struct Client {
+            int fd = -1;
+            uint32_t sections = SECTION_ALL;
+            uint16_t batch = 1;
+            uint16_t decimation = 1;
+            uint16_t count = 0;
+            std::vector<uint8_t> packet;
+        };
+
+        /**
+         * @brief The listening socket.
+         */
+        int listen_fd_;
+
+        /**
+         * @brief The epoll instance of the io thread.
+         */
+        int epoll_fd_;
+
+        /**
+         * @brief Signalled when a state is published, replaced and closed under the mutex of the published states.
+         */
+        int event_fd_;
+
+        /**
+         * @brief The path of the socket.
+         */
+        std::string path_;
+
+        /**
+         * @brief The maximum number of clients.
+         */
+        size_t max_clients_;
+
+        /**
+         * @brief The connected clients by their socket, only used by the io thread.
+         */
+        std::unordered_map<int, std::unique_ptr<Client>> clients_;
+
+        /**
+         * @brief The published states which are not yet sent.
+         */
+        std::vector<DataRoboMasterState> pending_;
+
+        /**
+         * @brief Mutex of the published states and of the event file descriptor.
+         */
+        std::mutex mutex_;
+
+        /**
+         * @brief The callback of the commands.
+         */
+        std::function<void(const BridgeCommand&)> callback_;
+
+        /**
+         * @brief Mutex of the callback.
+         */
+        std::mutex callback_mutex_;
+
+        /**
+         * @brief The counters.
+         */
+        BridgeStatistics statistics_;
+
+        /**
+         * @brief Mutex of the counters.
+         */
+        mutable std::mutex statistics_mutex_;
+
+        /**
+         * @brief The number of the next state.
+         */
+        uint64_t sequence_;
+
+        /**
+         * @brief Thread for the io of all clients.
+         */
+        std::thread thread_;
+
+        /**
+         * @brief Flag whether the eventfd is already signalled and not yet consumed by the io thread.
+         */
+        std::atomic<bool> flag_notified_;
+
+        /**
+         * @brief Flag to stop the thread.
+         */
+        std::atomic<bool> flag_stop_;
+
+        /**
+         * @brief Run function of the io thread.
+         */
+        void start_io_thread();
+
+        /**
+         * @brief Accept the pending clients.
+         */
+        void accept_clients();
+
+        /**
+         * @brief Read the packets of a client.
+         *
+         * @return false, when the client disconnected.
+         */
+        bool read_client(Client &client);
+
+        /**
+         * @brief Send the published states to the subscribed clients.
+         */
+        void send_states(const std::vector<DataRoboMasterState> &states);
+
+        /**
+         * @brief Send the batch of a client.
+         *
+         * @return false, when the client disconnected.
+         */
+        bool flush_client(Client &client);
+
+        /**
+         * @brief Remove a client.
+         */
+        void remove_client(int fd);
+
+    public:
+        /**
+         * @brief Construct a new Bridge object.
+         */
+        Bridge();
+
+        /**
+         * @brief Destroy the Bridge object, stops the thread and removes the socket.
+         */
+        ~Bridge();
+
+        Bridge(const Bridge&) = delete;
+        Bridge &operator=(const Bridge&) = delete;
+
+        /**
+         * @brief Create the socket and start the io thread, an existing socket file of the same path is replaced.
+         *
+         * @param path The path of the socket, e.g. /run/robomaster.sock.
+         * @param max_clients The maximum number of clients, further clients are disconnected.
+         * @return true, by success.
+         * @return false, when already open or the socket could not be created.
+         */
+        bool open(const std::string &path, size_t max_clients=64);
+
+        /**
+         * @brief Stop the io thread, disconnect the clients and remove the socket.
+         */
+        void close();
+
+        /**
+         * @brief Publish a state to the clients, e.g. from the callback of the RoboMaster.
+         *
+         * @param state The state.
+         */
+        void publish(const DataRoboMasterState &state);
+
+        /**
+         * @brief Set the callback of the commands, it is called by the io thread.
+         *
+         * @param func Function to bind as callback.
+         */
+        void set_command_callback(std::function<void(const BridgeCommand&)> func);
+
+        /**
+         * @brief Get the counters.
+         *
+         * @return BridgeStatistics as counters.
+         */
+        BridgeStatistics get_statistics() const;
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_BRIDGE_H_
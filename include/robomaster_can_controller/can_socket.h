@@ -17,11 +17,13 @@
 #include <linux/can/raw.h>
 #include <string>
 
+#include "transport.h"
+
 namespace robomaster_can_controller {
     /**
      * @brief This class manage the io of the can bus.
      */
-    class CanSocket {
+    class CanSocket final : public Transport {
         /**
          * @brief The Socket for the CanBus.
          */
@@ -46,7 +48,10 @@ namespace robomaster_can_controller {
         /**
          * @brief Destroy the Can Socket object and close socket.
          */
-        ~CanSocket();
+        ~CanSocket() override;
+
+        CanSocket(const CanSocket&) = delete;
+        CanSocket &operator=(const CanSocket&) = delete;
 
         /**
          * @brief Set the timeout for reading the can socket.
@@ -61,7 +66,7 @@ namespace robomaster_can_controller {
          *
          * @param seconds Float in seconds.
          */
-        void set_timeout(double seconds);
+        void set_timeout(double seconds) override;
 
         /**
          * @brief Open the can socket by the given can interface name.
@@ -70,7 +75,14 @@ namespace robomaster_can_controller {
          * @return true, when the socket is open successfully.
          * @return false, when this socket failed to open.
          */
-        bool init(const std::string &can_interface);
+        bool init(const std::string &can_interface) override;
+
+        /**
+         * @brief Get the file descriptor of the can socket, e.g. to wait for readiness with poll.
+         *
+         * @return int as file descriptor.
+         */
+        int get_fd() const override;
 
         /**
          * @brief Send a can frame over the socket.
@@ -81,7 +93,7 @@ namespace robomaster_can_controller {
          * @return true, by success.
          * @return false, when failed.
          */
-        bool send_frame(uint32_t id, const uint8_t data[8], size_t length);
+        bool send_frame(uint32_t id, const uint8_t data[8], size_t length) override;
 
         /**
          * @brief Read the next incoming can frame from the can socket. This function is blocking until the timeout is reached.
@@ -93,6 +105,39 @@ namespace robomaster_can_controller {
          * @return false  when failed.
          */
         bool read_frame(uint32_t &id, uint8_t data[8], size_t &length);
+
+        /**
+         * @brief Read the next incoming can frame from the can socket with its receive timestamp. This function is blocking until the timeout is reached.
+         *
+         * @param id The device id.
+         * @param data The data of the can frame.
+         * @param length The length of the data. The length is zero, when the timeout is reached.
+         * @param timestamp The kernel receive time of the frame in nanoseconds since epoch (CLOCK_REALTIME). Falls back to the read time when the kernel provides no timestamp.
+         * @return true, by success.
+         * @return false  when failed.
+         */
+        bool read_frame(uint32_t &id, uint8_t data[8], size_t &length, uint64_t &timestamp) override;
+
+        /**
+         * @brief Send multiple can frames in order with a single sendmmsg call per batch.
+         *
+         * @param frames The can frames to send.
+         * @param count The number of can frames.
+         * @return true, when all frames are sent.
+         * @return false, when failed.
+         */
+        bool send_frames(const CanFrame *frames, size_t count) override;
+
+        /**
+         * @brief Read all queued can frames up to the capacity with a single recvmmsg call. This function is blocking until at least one frame is received or the timeout is reached.
+         *
+         * @param frames The buffer for the can frames.
+         * @param capacity The number of can frames the buffer can hold.
+         * @param count The number of read can frames. The count is zero, when the timeout is reached.
+         * @return true, by success.
+         * @return false, when failed.
+         */
+        bool read_frames(CanFrame *frames, size_t capacity, size_t &count) override;
     };
 } // namespace robomaster_can_controller
 
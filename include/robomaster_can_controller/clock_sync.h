@@ -0,0 +1,146 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_CLOCK_SYNC_H_
+#define ROBOMASTER_CAN_CONTROLLER_CLOCK_SYNC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief This class estimates the offset and the drift between the clock of a device and the host clock.
+     * Every sample pairs a device timestamp with the host receive time of the same message. The transport delay is always positive,
+     * so the lower convex hull of the samples bounds the clock mapping from above and delayed samples do not influence the estimation.
+     */
+    class ClockSync {
+        /**
+         * @brief A device timestamp and the host receive time relative to the first sample.
+         */
+        struct Sample {
+            int64_t device;
+            int64_t host;
+        };
+
+        /**
+         * @brief The samples of the sliding window ordered by device time.
+         */
+        std::deque<Sample> samples_;
+
+        /**
+         * @brief The lower convex hull of the samples, reused between the updates.
+         */
+        std::vector<Sample> hull_;
+
+        /**
+         * @brief The distances of the samples to the estimated mapping, reused between the updates.
+         */
+        std::vector<double> residuals_;
+
+        /**
+         * @brief The maximal number of samples in the sliding window.
+         */
+        size_t window_;
+
+        /**
+         * @brief The raw device time of the first sample.
+         */
+        uint32_t device_reference_;
+
+        /**
+         * @brief The host time of the first sample in nanoseconds since epoch.
+         */
+        uint64_t host_reference_;
+
+        /**
+         * @brief The unwrapped device time of the last sample relative to the first sample.
+         */
+        int64_t device_last_;
+
+        /**
+         * @brief The estimated host time relative to host_reference_ at device time zero.
+         */
+        double offset_;
+
+        /**
+         * @brief The estimated host nanoseconds per device tick.
+         */
+        double skew_;
+
+        /**
+         * @brief The uncertainty of the mapped times in nanoseconds.
+         */
+        uint64_t uncertainty_;
+
+        /**
+         * @brief True when offset and skew are estimated.
+         */
+        bool flag_synchronised_;
+
+        /**
+         * @brief Fit the clock mapping to the lower convex hull of the samples.
+         */
+        void estimate();
+
+    public:
+        /**
+         * @brief Construct a new ClockSync object.
+         *
+         * @param window The number of samples in the sliding window.
+         */
+        explicit ClockSync(size_t window=256);
+
+        /**
+         * @brief Add a pair of device timestamp and host receive time. A device time which jumps backwards restarts the estimation.
+         *
+         * @param device_time The timestamp of the device clock in device ticks. Wrap arounds are handled.
+         * @param host_time The host receive time in nanoseconds since epoch.
+         */
+        void add_sample(uint32_t device_time, uint64_t host_time);
+
+        /**
+         * @brief True when enough samples are collected to map device times to host times.
+         *
+         * @return true, when synchronised.
+         * @return false, when more samples are needed.
+         */
+        bool is_synchronised() const;
+
+        /**
+         * @brief Map a device timestamp close to the last sample to the host clock.
+         * The result is the acquisition time plus the minimal transport delay of the bus.
+         *
+         * @param device_time The timestamp of the device clock in device ticks.
+         * @return uint64_t as host time in nanoseconds since epoch, zero when not synchronised.
+         */
+        uint64_t to_host_time(uint32_t device_time) const;
+
+        /**
+         * @brief Get the uncertainty of the mapped host times, a bound of the error with high probability. This is the distance of the
+         * twenty-fourth fastest sample of the window to the estimated mapping, the scatter of the fastest delays, or the smallest distance of the
+         * recent samples when it is larger, which grows when the drift changes faster than the window can follow.
+         *
+         * @return uint64_t as uncertainty in nanoseconds.
+         */
+        uint64_t get_uncertainty() const;
+
+        /**
+         * @brief Get the estimated host nanoseconds per device tick.
+         *
+         * @return double as skew, zero when not synchronised.
+         */
+        double get_skew() const;
+
+        /**
+         * @brief Drop all samples and restart the estimation.
+         */
+        void reset();
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_CLOCK_SYNC_H_
@@ -0,0 +1,131 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_COMMAND_H_
+#define ROBOMASTER_CAN_CONTROLLER_COMMAND_H_
+
+#include "message.h"
+
+#include <cstdint>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The blaster type
+     */
+    enum BlasterType {
+        INFRARED,
+        GELBEADS
+    };
+
+    /**
+     * @brief Create the command to enable or disable the work mode of the RoboMaster chassis.
+     *
+     * @param mode The work mode.
+     * @return Message as command.
+     */
+    Message make_work_mode_command(bool mode);
+
+    /**
+     * @brief Create the command to drive the RoboMaster with the given velocities, the velocities are clipped.
+     *
+     * @param x Linear x velocity in m/s.
+     * @param y Linear y velocity in m/s.
+     * @param z Angular velocity in radiant/s.
+     * @param sequence The sequence of the drive messages.
+     * @return Message as command.
+     */
+    Message make_velocity_command(float x, float y, float z, uint16_t sequence=0);
+
+    /**
+     * @brief Create the command to control each individual wheel of the RoboMaster in rpm, the rpm are clipped.
+     *
+     * @param fr Front right wheel in rpm.
+     * @param fl Front left wheel in rpm.
+     * @param rl Rear left wheel in rpm.
+     * @param rr Rear right wheel in rpm.
+     * @param sequence The sequence of the drive messages.
+     * @return Message as command.
+     */
+    Message make_wheel_rpm_command(int16_t fr, int16_t fl, int16_t rl, int16_t rr, uint16_t sequence=0);
+
+    /**
+     * @brief Create the command to stop the RoboMaster with zero velocities.
+     *
+     * @param sequence The sequence of the drive messages.
+     * @return Message as command.
+     */
+    Message make_brake_command(uint16_t sequence=0);
+
+    /**
+     * @brief Create the command to control the gimbal of the RoboMaster, the velocities are clipped.
+     *
+     * @param y Angular y velocity in radiant/s
+     * @param z Angular z velocity in radiant/s
+     * @param sequence The sequence of the gimbal messages.
+     * @return Message as command.
+     */
+    Message make_gimbal_command(int16_t y, int16_t z, uint16_t sequence=0);
+
+    /**
+     * @brief Create the command to fire the blaster of the RoboMaster.
+     *
+     * @param blaster The blaster type.
+     * @param sequence The sequence of the blaster messages.
+     * @return Message as command.
+     */
+    Message make_blaster_command(BlasterType blaster, uint16_t sequence=0);
+
+    /**
+     * @brief Create the command to set the LED off by the given mask.
+     *
+     * @param mask Mask for selecting the LED, e.g. LED_MASK_ALL.
+     * @param sequence The sequence of the LED messages.
+     * @return Message as command.
+     */
+    Message make_led_off_command(uint16_t mask, uint16_t sequence=0);
+
+    /**
+     * @brief Create the command to set the LED on by the given mask and colour.
+     *
+     * @param mask Mask for selecting the LED, e.g. LED_MASK_ALL.
+     * @param r Red value colour between 0-255.
+     * @param g Green value colour between 0-255.
+     * @param b Blue value colour between 0-255.
+     * @param sequence The sequence of the LED messages.
+     * @return Message as command.
+     */
+    Message make_led_on_command(uint16_t mask, uint8_t r, uint8_t g, uint8_t b, uint16_t sequence=0);
+
+    /**
+     * @brief Create the command to set the LED with a breath effect.
+     *
+     * @param mask Mask for selecting the LED, e.g. LED_MASK_ALL.
+     * @param r Red value colour between 0-255.
+     * @param g Green value colour between 0-255.
+     * @param b Blue value colour between 0-255.
+     * @param t_rise The rise time of the LED in milliseconds.
+     * @param t_down The down time of the LED in milliseconds.
+     * @param sequence The sequence of the LED messages.
+     * @return Message as command.
+     */
+    Message make_led_breath_command(uint16_t mask, uint8_t r, uint8_t g, uint8_t b, uint16_t t_rise, uint16_t t_down, uint16_t sequence=0);
+
+    /**
+     * @brief Create the command to set the LED with a flash effect.
+     *
+     * @param mask Mask for selecting the LED, e.g. LED_MASK_ALL.
+     * @param r Red value colour between 0-255.
+     * @param g Green value colour between 0-255.
+     * @param b Blue value colour between 0-255.
+     * @param t_on The on time of the LED in milliseconds.
+     * @param t_off The off time of the LED in milliseconds.
+     * @param sequence The sequence of the LED messages.
+     * @return Message as command.
+     */
+    Message make_led_flash_command(uint16_t mask, uint8_t r, uint8_t g, uint8_t b, uint16_t t_on, uint16_t t_off, uint16_t sequence=0);
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_COMMAND_H_
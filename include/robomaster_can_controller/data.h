@@ -209,6 +209,51 @@ namespace robomaster_can_controller {
         float z = 0.0f;
     };
 
+    /**
+     * @brief Struct for the host receive times of the RoboMaster state message.
+     */
+    struct DataTimestamp {
+        /**
+         * @brief True when the receive times are known.
+         */
+        bool has_data = false;
+
+        /**
+         * @brief Kernel receive time of the first can frame of the message in nanoseconds since epoch (CLOCK_REALTIME).
+         */
+        uint64_t first_frame = 0;
+
+        /**
+         * @brief Kernel receive time of the last can frame of the message in nanoseconds since epoch (CLOCK_REALTIME).
+         */
+        uint64_t last_frame = 0;
+
+        /**
+         * @brief Acquisition time of the ESC data mapped from the motion controller clock to the host clock in nanoseconds since epoch.
+         * Includes the minimal transport delay of the bus. Zero until the clock synchronisation has enough samples.
+         */
+        uint64_t acquisition = 0;
+
+        /**
+         * @brief Uncertainty of the acquisition time in nanoseconds.
+         */
+        uint64_t uncertainty = 0;
+    };
+
+    /**
+     * @brief The parts of a state as bits, e.g. the parts with data of a state in the history and the state log or the subscribed parts of a bridge client.
+     */
+    enum StateSection : uint32_t {
+        SECTION_BATTERY = 1 << 0,
+        SECTION_ESC = 1 << 1,
+        SECTION_IMU = 1 << 2,
+        SECTION_VELOCITY = 1 << 3,
+        SECTION_POSITION = 1 << 4,
+        SECTION_ATTITUDE = 1 << 5,
+        SECTION_TIMESTAMP = 1 << 6,
+        SECTION_ALL = (1 << 7) - 1
+    };
+
     /**
      * @brief Collection of all data struct from the RoboMaster.
      */
@@ -242,6 +287,11 @@ namespace robomaster_can_controller {
          * @brief Attitude data.
          */
         DataAttitude attitude;
+
+        /**
+         * @brief Receive times of the message.
+         */
+        DataTimestamp timestamp;
     };
 
     /**
@@ -298,13 +348,57 @@ namespace robomaster_can_controller {
      */
     DataPosition decode_data_position(size_t index, const Message &msg);
 
+    /**
+     * @brief Decode the receive times of the message.
+     *
+     * @param msg Message from the motion controller.
+     * @return struct DataTimestamp. has_data is true, when the message carries receive times.
+     */
+    DataTimestamp decode_data_timestamp(const Message &msg);
+
+    /**
+     * @brief Decode all data of the RoboMasterState message which is pushed by the motion controller.
+     * The acquisition time of the timestamp is not set, because it needs the clock synchronisation of the RoboMaster class.
+     *
+     * @param msg The RoboMasterState message from the motion controller.
+     * @return struct DataRoboMasterState. has_data of each part is true, by successful decoding.
+     */
+    DataRoboMasterState decode_robomaster_state(const Message &msg);
+
+    /**
+     * @brief Get the sections of the parts of a state with data.
+     *
+     * @param data The state.
+     * @return uint32_t as mask of StateSection.
+     */
+    uint32_t get_sections(const DataRoboMasterState &data);
+
+    /**
+     * @brief Set has_data of every part of a state by its section.
+     *
+     * @param data The state.
+     * @param sections The mask of StateSection.
+     */
+    void set_sections(DataRoboMasterState &data, uint32_t sections);
+
     std::ostream& operator<<(std::ostream& os, const DataEsc &data);
     std::ostream& operator<<(std::ostream& os, const DataImu &data);
     std::ostream& operator<<(std::ostream& os, const DataAttitude &data);
     std::ostream& operator<<(std::ostream& os, const DataBattery &data);
     std::ostream& operator<<(std::ostream& os, const DataVelocity &data);
     std::ostream& operator<<(std::ostream& os, const DataPosition &data);
+    std::ostream& operator<<(std::ostream& os, const DataTimestamp &data);
     std::ostream& operator<<(std::ostream& os, const DataRoboMasterState &data);
+
+    /**
+     * @brief Print the state as JSON like the stream operator with the receive times as additional key timestamp.
+     * The stream operator keeps its format without the receive times, so existing parsers of its output are not affected.
+     *
+     * @param os The stream.
+     * @param data The state.
+     * @return std::ostream& as the stream.
+     */
+    std::ostream& print_with_timestamp(std::ostream& os, const DataRoboMasterState &data);
 } // namespace robomaster_can_controller
 
 #endif // ROBOMASTER_CAN_CONTROLLER_DATA_H_
\ No newline at end of file
@@ -0,0 +1,91 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_DISPATCHER_H_
+#define ROBOMASTER_CAN_CONTROLLER_DISPATCHER_H_
+
+#include "message.h"
+
+#include <functional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief This class dispatches received RoboMaster messages to the registered callbacks.
+     * The callbacks are stored in a hash table keyed by device id and message type, a payload prefix selects the callback inside a table entry.
+     */
+    class Dispatcher {
+        /**
+         * @brief A registered callback with the payload prefix which must match the beginning of the message payload.
+         */
+        struct Subscription {
+            std::vector<uint8_t> prefix;
+            std::function<void(const Message&)> callback;
+        };
+
+        /**
+         * @brief The dispatch table with the packed device id and message type as key.
+         */
+        std::unordered_map<uint64_t, std::vector<Subscription>> table_;
+
+        /**
+         * @brief The mutex to protect the dispatch table. The dispatching itself only takes a shared lock.
+         */
+        mutable std::shared_mutex mutex_;
+
+        /**
+         * @brief Pack the device id and the message type into one key for the dispatch table.
+         *
+         * @param device_id The can device id.
+         * @param type The message type.
+         * @return uint64_t as key.
+         */
+        static uint64_t make_key(uint32_t device_id, uint16_t type);
+
+    public:
+        /**
+         * @brief Construct a new Dispatcher object.
+         */
+        Dispatcher();
+
+        /**
+         * @brief Register a callback for the given device id, message type and payload prefix.
+         * An already registered callback with the same device id, type and prefix is replaced. An empty prefix matches every payload,
+         * a payload equal to the prefix matches as well, e.g. for acknowledgements without data. The decoders check the payload size themselves.
+         *
+         * @param device_id The can device id.
+         * @param type The message type.
+         * @param prefix The bytes which must match the beginning of the payload.
+         * @param func The callback to trigger.
+         */
+        void bind_callback(uint32_t device_id, uint16_t type, std::vector<uint8_t> prefix, std::function<void(const Message&)> func);
+
+        /**
+         * @brief Remove the callback for the given device id, message type and payload prefix.
+         *
+         * @param device_id The can device id.
+         * @param type The message type.
+         * @param prefix The payload prefix of the registered callback.
+         * @return true, when a callback was removed.
+         * @return false, when no callback was registered.
+         */
+        bool unbind_callback(uint32_t device_id, uint16_t type, const std::vector<uint8_t> &prefix);
+
+        /**
+         * @brief Trigger all callbacks matching the device id, type and payload of the message.
+         * Callbacks must not bind or unbind callbacks on the same dispatcher.
+         *
+         * @param msg RoboMaster message.
+         * @return true, when at least one callback was triggered.
+         * @return false, when no callback matched the message.
+         */
+        bool dispatch(const Message &msg) const;
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_DISPATCHER_H_
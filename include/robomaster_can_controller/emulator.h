@@ -0,0 +1,318 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_EMULATOR_H_
+#define ROBOMASTER_CAN_CONTROLLER_EMULATOR_H_
+
+#include "message.h"
+#include "reassembler.h"
+#include "transport.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The commanded state of the emulated RoboMaster.
+     */
+    struct EmulatorState {
+        /**
+         * @brief True when the work mode is enabled.
+         */
+        bool work_mode = false;
+
+        /**
+         * @brief True when the boot sequence was received completely.
+         */
+        bool booted = false;
+
+        /**
+         * @brief Commanded velocity in m/s on the x-axis and y-axis and in degree/s around the z-axis.
+         */
+        std::array<float, 3> velocity = { 0.0f, 0.0f, 0.0f };
+
+        /**
+         * @brief Commanded wheel speed in rpm in the order front right, front left, rear left, rear right.
+         */
+        std::array<int16_t, 4> wheel_rpm = { 0, 0, 0, 0 };
+
+        /**
+         * @brief Commanded gimbal speed for the y-axis and the z-axis.
+         */
+        std::array<int16_t, 2> gimbal = { 0, 0 };
+
+        /**
+         * @brief Last LED effect mode, mask and color.
+         */
+        uint16_t led_mode = 0;
+        uint16_t led_mask = 0;
+        std::array<uint8_t, 3> led_color = { 0, 0, 0 };
+
+        /**
+         * @brief Integrated position in m and yaw in degree.
+         */
+        std::array<float, 3> position = { 0.0f, 0.0f, 0.0f };
+        float yaw = 0.0f;
+    };
+
+    /**
+     * @brief Counters of the emulator.
+     */
+    struct EmulatorStatistics {
+        /**
+         * @brief Number of can frames received from the host.
+         */
+        uint64_t frames_received = 0;
+
+        /**
+         * @brief Number of complete messages received from the host.
+         */
+        uint64_t messages_received = 0;
+
+        /**
+         * @brief Number of received heartbeat messages.
+         */
+        uint64_t heartbeats = 0;
+
+        /**
+         * @brief Number of acknowledged messages.
+         */
+        uint64_t acks = 0;
+
+        /**
+         * @brief Number of generated state pushes.
+         */
+        uint64_t pushes = 0;
+
+        /**
+         * @brief Number of can frames passed to the frame sink.
+         */
+        uint64_t frames_sent = 0;
+
+        /**
+         * @brief Number of can frames dropped by the loss injection.
+         */
+        uint64_t frames_dropped = 0;
+
+        /**
+         * @brief Number of can frames modified by the corruption injection.
+         */
+        uint64_t frames_corrupted = 0;
+    };
+
+    /**
+     * @brief This class emulates the motion controller of the RoboMaster. The core is independent of the transport, received can frames
+     * are passed to push_frame and generated can frames leave through the frame sink. Time only advances with step, so tests and benchmarks
+     * run deterministic and faster than real time. Optionally the emulator serves a can interface like vcan0 or any other transport in its own thread.
+     */
+    class Emulator {
+        /**
+         * @brief Mutex for the state, the statistics and the random generator.
+         */
+        mutable std::mutex mutex_;
+
+        /**
+         * @brief Reassembler for the messages of the host.
+         */
+        Reassembler reassembler_;
+
+        /**
+         * @brief Sink for the generated can frames.
+         */
+        std::function<void(uint32_t, const uint8_t*, size_t)> frame_sink_;
+
+        /**
+         * @brief Random generator for the fault injection.
+         */
+        std::mt19937_64 generator_;
+
+        /**
+         * @brief Probability to drop a can frame.
+         */
+        double frame_loss_;
+
+        /**
+         * @brief Probability to flip a random bit in a can frame.
+         */
+        double frame_corruption_;
+
+        /**
+         * @brief Period of the state push in nanoseconds, zero disables the push.
+         */
+        uint64_t push_period_;
+
+        /**
+         * @brief Emulator time of the next state push in nanoseconds.
+         */
+        uint64_t push_time_;
+
+        /**
+         * @brief Emulator time of the last step in nanoseconds.
+         */
+        uint64_t time_;
+
+        /**
+         * @brief Sequence of the state push messages.
+         */
+        uint16_t push_sequence_;
+
+        /**
+         * @brief Bit mask of the received boot messages.
+         */
+        uint8_t boot_mask_;
+
+        /**
+         * @brief The commanded and integrated state.
+         */
+        EmulatorState state_;
+
+        /**
+         * @brief The counters.
+         */
+        EmulatorStatistics statistics_;
+
+        /**
+         * @brief Transport for serving a can interface.
+         */
+        AnyTransport transport_;
+
+        /**
+         * @brief Thread for serving a can interface.
+         */
+        std::thread thread_;
+
+        /**
+         * @brief Flag to stop the thread.
+         */
+        std::atomic<bool> flag_stop_;
+
+        /**
+         * @brief Apply a received message to the state and acknowledge it when requested.
+         *
+         * @param msg The message of the host.
+         */
+        void process_message(const Message &msg);
+
+        /**
+         * @brief Build the state push message from the current state.
+         *
+         * @return Message as state push.
+         */
+        Message make_state_push();
+
+        /**
+         * @brief Fragment the message into can frames, inject the faults and pass the frames to the sink.
+         *
+         * @param msg The message to send.
+         */
+        void send_message(const Message &msg);
+
+        /**
+         * @brief Run function of the thread which serves a can interface.
+         */
+        void start_thread();
+
+    public:
+        /**
+         * @brief Construct a new Emulator object.
+         *
+         * @param seed The seed of the random generator for the fault injection.
+         */
+        explicit Emulator(uint64_t seed=0);
+
+        /**
+         * @brief Destroy the Emulator object and stop the thread.
+         */
+        ~Emulator();
+
+        /**
+         * @brief Set the sink for the generated can frames.
+         *
+         * @param func The sink which receives the can device id, the frame data and the frame length.
+         */
+        void set_frame_sink(std::function<void(uint32_t, const uint8_t*, size_t)> func);
+
+        /**
+         * @brief Set the rate of the state push.
+         *
+         * @param rate The rate in Hz, zero disables the push.
+         */
+        void set_push_rate(double rate);
+
+        /**
+         * @brief Set the probability to drop a generated can frame.
+         *
+         * @param probability The probability between 0 and 1.
+         */
+        void set_frame_loss(double probability);
+
+        /**
+         * @brief Set the probability to flip a random bit in a generated can frame.
+         *
+         * @param probability The probability between 0 and 1.
+         */
+        void set_frame_corruption(double probability);
+
+        /**
+         * @brief Pass a can frame of the host to the emulator. Complete messages are processed immediately.
+         *
+         * @param id The can device id.
+         * @param data The data of the can frame.
+         * @param length The length of the data.
+         */
+        void push_frame(uint32_t id, const uint8_t *data, size_t length);
+
+        /**
+         * @brief Advance the emulator time and generate all state pushes which are due.
+         *
+         * @param time The emulator time in nanoseconds, which must not decrease.
+         * @return size_t as number of generated state pushes.
+         */
+        size_t step(uint64_t time);
+
+        /**
+         * @brief Serve the given can interface in a thread with the host clock as emulator time.
+         *
+         * @param can_interface The can interface name, e.g. vcan0.
+         * @return true, when the can interface is open.
+         * @return false, when the can interface failed to open or the thread is already running.
+         */
+        bool init(const std::string &can_interface);
+
+        /**
+         * @brief Serve the given transport in a thread with the host clock as emulator time, e.g. a LoopbackTransport for tests.
+         *
+         * @param transport The transport which is initialised with the given name.
+         * @param name The interface name or the bus name.
+         * @return true, when the transport is open.
+         * @return false, when the transport failed to open or the thread is already running.
+         */
+        bool init(std::unique_ptr<Transport> transport, const std::string &name);
+
+        /**
+         * @brief Get the commanded and integrated state.
+         *
+         * @return EmulatorState as state.
+         */
+        EmulatorState get_state() const;
+
+        /**
+         * @brief Get the counters.
+         *
+         * @return EmulatorStatistics as counters.
+         */
+        EmulatorStatistics get_statistics() const;
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_EMULATOR_H_
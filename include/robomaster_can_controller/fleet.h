@@ -0,0 +1,195 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_FLEET_H_
+#define ROBOMASTER_CAN_CONTROLLER_FLEET_H_
+
+#include "handler.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief This class runs many handlers on shared threads instead of three threads per handler. A single io thread waits with epoll
+     * on the transports of all handlers, a timerfd for the next heartbeat and an eventfd for pushed messages. It reads and reassembles
+     * the frames and sends the heartbeats and the queued messages of every handler. The received messages are processed by a small
+     * dispatch pool, the messages of one handler are never processed concurrently, so the callbacks of a handler keep their order.
+     * Every handler keeps its own reassembly state, sequence counters and heartbeat schedule.
+     *
+     * @tparam T The frame transport.
+     */
+    template<FrameTransport T>
+    class BasicFleet {
+        /**
+         * @brief An attached handler.
+         */
+        struct Member {
+            BasicHandler<T> *handler = nullptr;
+            std::mutex dispatch_mutex;
+            std::atomic<bool> scheduled = false;
+            bool detached = false;
+            bool polled = true;
+        };
+
+        /**
+         * @brief The epoll instance of the io thread.
+         */
+        int epoll_fd_;
+
+        /**
+         * @brief The timer of the next heartbeat.
+         */
+        int timer_fd_;
+
+        /**
+         * @brief Signalled when a message is pushed.
+         */
+        int event_fd_;
+
+        /**
+         * @brief The attached handlers.
+         */
+        std::vector<std::shared_ptr<Member>> members_;
+
+        /**
+         * @brief Mutex for the members, held by the io thread while it processes the ready transports.
+         */
+        std::mutex mutex_;
+
+        /**
+         * @brief The handlers with messages to process.
+         */
+        std::deque<std::shared_ptr<Member>> dispatch_queue_;
+
+        /**
+         * @brief Mutex of the dispatch queue.
+         */
+        std::mutex dispatch_mutex_;
+
+        /**
+         * @brief Conditional variable of the dispatch pool.
+         */
+        std::condition_variable cv_dispatch_;
+
+        /**
+         * @brief Thread for the io of all handlers.
+         */
+        std::thread thread_io_;
+
+        /**
+         * @brief Threads of the dispatch pool.
+         */
+        std::vector<std::thread> threads_dispatch_;
+
+        /**
+         * @brief Flag whether the eventfd is already signalled and not yet consumed by the io thread.
+         */
+        std::atomic<bool> flag_notified_;
+
+        /**
+         * @brief Flag to stop the threads.
+         */
+        std::atomic<bool> flag_stop_;
+
+        /**
+         * @brief Flag of the initialisation.
+         */
+        bool flag_initialised_;
+
+        /**
+         * @brief Run function of the io thread.
+         */
+        void start_io_thread();
+
+        /**
+         * @brief Run function of a dispatch thread.
+         */
+        void start_dispatch_thread();
+
+        /**
+         * @brief Queue a handler for the dispatch pool, unless it is already queued.
+         *
+         * @param member The handler.
+         */
+        void schedule(const std::shared_ptr<Member> &member);
+
+        /**
+         * @brief Send the due heartbeats and the queued messages of all handlers and arm the timer for the next heartbeat.
+         *
+         * @return true, when a handler has more messages than sent in one round.
+         * @return false, when all queued messages are sent.
+         */
+        bool send_all();
+
+        /**
+         * @brief Init the transport of the handler and attach it to the io thread.
+         *
+         * @param handler The handler.
+         * @param can_interface The can interface name.
+         * @return true, by success.
+         * @return false, when the fleet is not initialised or the transport could not be initialised.
+         */
+        bool attach(BasicHandler<T> &handler, const std::string &can_interface);
+
+        /**
+         * @brief Detach the handler, waits until the threads of the fleet no longer use it.
+         *
+         * @param handler The handler.
+         */
+        void detach(BasicHandler<T> &handler);
+
+        /**
+         * @brief Wake up the io thread to send the pushed messages.
+         */
+        void notify();
+
+        friend class BasicHandler<T>;
+
+    public:
+        /**
+         * @brief Construct a new Fleet object.
+         */
+        BasicFleet();
+
+        /**
+         * @brief Destroy the Fleet object, stops the threads and all attached handlers.
+         */
+        ~BasicFleet();
+
+        BasicFleet(const BasicFleet&) = delete;
+        BasicFleet &operator=(const BasicFleet&) = delete;
+
+        /**
+         * @brief Create the epoll instance and start the io thread and the dispatch pool.
+         *
+         * @param dispatch_threads The number of threads which process the received messages and call the callbacks.
+         * @return true, by success.
+         * @return false, when already running or the file descriptors could not be created.
+         */
+        bool init(size_t dispatch_threads=1);
+
+        /**
+         * @brief Get the number of attached handlers.
+         *
+         * @return size_t as count.
+         */
+        size_t get_size();
+    };
+
+    /**
+     * @brief The fleet for the can bus over socketcan.
+     */
+    using Fleet = BasicFleet<CanSocket>;
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_FLEET_H_
@@ -8,24 +8,53 @@
 #define ROBOMASTER_CAN_CONTROLLER_HANDLER_H_
 
 #include "can_socket.h"
+#include "dispatcher.h"
+#include "ingress.h"
+#include "latency.h"
+#include "loopback_transport.h"
 #include "message.h"
+#include "metrics.h"
 #include "queue_msg.h"
+#include "reassembler.h"
+#include "recorder.h"
+#include "transport.h"
 
- 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <thread>
 #include <condition_variable>
 #include <functional>
+#include <shared_mutex>
 
 namespace robomaster_can_controller {
+    template<FrameTransport T>
+    class BasicFleet;
+
+    class Replay;
+
+    /**
+     * @brief The number of sequence counters, a prime so the known command types get distinct counters.
+     */
+    static constexpr size_t HANDLER_SEQUENCE_COUNTERS = 61;
+
     /**
      * @brief This class handles the incoming and outgoing RoboMaster message over the can bus.
+     * The frame transport is a template parameter, so the io calls are resolved at compile time. The member functions are defined in
+     * handler.cpp and explicitly instantiated for CanSocket, LoopbackTransport and AnyTransport. The handler runs its own receiver,
+     * sender and handler thread, or it is attached to a BasicFleet which runs the same steps for many handlers on shared threads.
+     *
+     * The recorder and the command ingress are attached at runtime. Their setters wait until no thread uses the previous object,
+     * so it can be destroyed as soon as the setter returned.
      *
+     * @tparam T The frame transport.
      */
-    class Handler {
+    template<FrameTransport T>
+    class BasicHandler {
         /**
-         * @brief CanSocket class for the can bus io.
+         * @brief The transport for the can bus io.
          */
-        CanSocket can_socket_;
+        T transport_;
 
         /**
          * @brief Thread for reading on the can socket and put valid messages in the receiver queue.
@@ -42,6 +71,11 @@ namespace robomaster_can_controller {
          */
         std::thread thread_handler_;
 
+        /**
+         * @brief Reassembler for the messages of all known devices, only accessed by the receiver thread.
+         */
+        Reassembler reassembler_;
+
         /**
          * @brief Receiver queue for received messages.
          */
@@ -73,19 +107,84 @@ namespace robomaster_can_controller {
         std::mutex cv_sender_mutex_;
 
         /**
-         * @brief callback function for the data of the robomaster motion controller.
+         * @brief Dispatch table for the callbacks of the received messages.
+         */
+        Dispatcher dispatcher_;
+
+        /**
+         * @brief Recorder for the received and sent frames, nullptr when recording is disabled.
+         */
+        Recorder *recorder_;
+
+        /**
+         * @brief Command ingress of other processes, nullptr when disabled.
          */
-        std::function<void(const Message&)> callback_data_robomaster_state_;
+        CommandIngress *ingress_;
+
+        /**
+         * @brief Mutex for the recorder and the ingress, shared by the threads which use them and exclusive in their setters.
+         */
+        mutable std::shared_mutex attach_mutex_;
+
+        /**
+         * @brief Number of running set_command_ingress calls, the sender does not wait on the ingress meanwhile.
+         */
+        std::atomic<uint32_t> attaching_;
+
+        /**
+         * @brief Tracker of the latency of the pushed commands.
+         */
+        LatencyTracker latency_tracker_;
+
+        /**
+         * @brief Runtime counters and histograms of the threads.
+         */
+        Metrics metrics_;
+
+        /**
+         * @brief The fleet the handler is attached to, nullptr when the handler runs its own threads.
+         */
+        std::atomic<BasicFleet<T>*> fleet_;
+
+        /**
+         * @brief The time of the next heartbeat.
+         */
+        std::chrono::high_resolution_clock::time_point heartbeat_time_point_;
+
+        /**
+         * @brief The next sequence per command type, shared by the local commands, the commands of the ingress and the heartbeat.
+         */
+        std::array<std::atomic<uint16_t>, HANDLER_SEQUENCE_COUNTERS> sequences_;
+
+        /**
+         * @brief The number of failed reads of the transport.
+         */
+        size_t receiver_errors_;
+
+        /**
+         * @brief The number of consecutive failed sends.
+         */
+        size_t sender_errors_;
+
+        /**
+         * @brief The messages popped from the sender queue, only accessed by the sender.
+         */
+        std::vector<Message> sender_messages_;
+
+        /**
+         * @brief The frames of the messages to send, only accessed by the sender.
+         */
+        std::vector<CanFrame> sender_frames_;
 
         /**
          * @brief Flag of the initialisation of the handler class. True when the can socket was successfully initialised.
          */
-        bool flag_initialised_;
+        std::atomic<bool> flag_initialised_;
 
         /**
          * @brief Flag then the threads are running to prevent multiply starts.
          */
-        bool flag_stop_;
+        std::atomic<bool> flag_stop_;
 
         /**
          * @brief Run function of the sender thread.
@@ -102,6 +201,35 @@ namespace robomaster_can_controller {
          */
         void start_handler_thread();
 
+        /**
+         * @brief Read one batch of frames, reassemble it and push the messages into the receiver queue.
+         * The handler is stopped after too many failed reads.
+         *
+         * @param frames The buffer for the frames.
+         * @param capacity The capacity of the buffer.
+         * @param messages The buffer for the reassembled messages, empty after the call.
+         * @return size_t as number of messages pushed into the receiver queue.
+         */
+        size_t receive_step(CanFrame *frames, size_t capacity, std::vector<Message> &messages);
+
+        /**
+         * @brief Send the heartbeat when it is due, otherwise the commands of the ingress and the sender queue together. The ingress
+         * is drained first, so a full local queue cannot starve the other processes, and both are drained every step.
+         * The handler is stopped after too many consecutive failed sends.
+         *
+         * @param now The current time.
+         * @return true, when a message was sent or failed to send.
+         * @return false, when nothing was due.
+         */
+        bool send_step(std::chrono::high_resolution_clock::time_point now);
+
+        /**
+         * @brief Process all messages of the receiver queue.
+         *
+         * @return size_t as number of processed messages.
+         */
+        size_t dispatch_step();
+
         /**
          * @brief Notify all conditional variable eg. stopping the threads.
          */
@@ -113,14 +241,14 @@ namespace robomaster_can_controller {
         void join_all();
 
         /**
-         * @brief Send the message to the can socket.
+         * @brief Send the messages to the can socket, the frames of all messages back to back with one batch call of the transport.
          *
-         * @param id The can device it.
-         * @param data Data of the hole message.
+         * @param msgs The RoboMaster messages.
+         * @param count The number of messages.
          * @return true, by success.
-         * @return false, by failing to send the message.
+         * @return false, by failing to send the messages.
          */
-        bool send_message(uint32_t id, const std::vector<uint8_t> &data);
+        bool send_messages(const Message *msgs, size_t count);
 
         /**
          * @brief Send the message to the can socket.
@@ -138,27 +266,48 @@ namespace robomaster_can_controller {
          */
         void process_message(const Message &msg);
 
+        friend class BasicFleet<T>;
+        friend class Replay;
+
     public:
         /**
          * @brief Construct a new Handler object.
          *
          */
-        Handler();
+        BasicHandler();
 
         /**
          * @brief Destroy the Handler object and stopped the threads.
          */
-        ~Handler();
+        ~BasicHandler();
+
+        /**
+         * @brief Get the transport, e.g. to set the transport of an AnyTransport before the initialisation.
+         *
+         * @return T& as transport.
+         */
+        T &get_transport();
 
         /**
          * @brief Init the can socket and start the threads.
          *
-         * @param can_interface The can interface name.
+         * @param can_interface The can interface name, or the bus name for the loopback transport.
          * @return true, when successful initialised.
          * @return false, by failing the initialisation.
          */
         bool init(const std::string &can_interface="can0");
 
+        /**
+         * @brief Init the can socket and attach the handler to the threads of the fleet instead of starting its own threads.
+         * The handler detaches itself when it is destroyed, the fleet stops all attached handlers when it is destroyed first.
+         *
+         * @param fleet The initialised fleet.
+         * @param can_interface The can interface name, or the bus name for the loopback transport.
+         * @return true, when successful initialised.
+         * @return false, by failing the initialisation.
+         */
+        bool init(BasicFleet<T> &fleet, const std::string &can_interface="can0");
+
         /**
          * @brief Bind the given callback for triggering when the message for the RoboMasterState is received.
          *
@@ -166,6 +315,27 @@ namespace robomaster_can_controller {
          */
         void bind_callback(std::function<void(const Message&)> func);
 
+        /**
+         * @brief Bind the given callback for triggering when a message with the given device id, type and payload prefix is received.
+         *
+         * @param device_id The can device id of the sender.
+         * @param type The message type.
+         * @param prefix The bytes which must match the beginning of the payload. An empty prefix matches every payload.
+         * @param func The callback to trigger.
+         */
+        void bind_callback(uint32_t device_id, uint16_t type, std::vector<uint8_t> prefix, std::function<void(const Message&)> func);
+
+        /**
+         * @brief Remove the callback for the given device id, type and payload prefix.
+         *
+         * @param device_id The can device id of the sender.
+         * @param type The message type.
+         * @param prefix The payload prefix of the bound callback.
+         * @return true, when a callback was removed.
+         * @return false, when no callback was bound.
+         */
+        bool unbind_callback(uint32_t device_id, uint16_t type, const std::vector<uint8_t> &prefix);
+
         /**
          * @brief Push a message to the sender queue to send it over the can bus.
          *
@@ -173,6 +343,26 @@ namespace robomaster_can_controller {
          */
         void push_message(const Message &msg);
 
+        /**
+         * @brief Push several messages to the sender queue with a single lock and a single wakeup of the sender.
+         * The sender takes them from the queue together and sends them back to back, without a heartbeat in between.
+         * The queued messages are never evicted for the batch, a batch which does not fit is dropped as a whole.
+         *
+         * @param msgs The RoboMaster messages.
+         * @return true, by success.
+         * @return false, when the sender queue has no room for all messages.
+         */
+        bool push_messages(const std::vector<Message> &msgs);
+
+        /**
+         * @brief Get the next sequence of a command type, e.g. for a command pushed with push_message. The local commands and the
+         * commands of the ingress share the counters, so their sequences do not collide.
+         *
+         * @param type The message type.
+         * @return uint16_t as sequence.
+         */
+        uint16_t next_sequence(uint16_t type);
+
         /**
          * @brief State if the handler is running or not.
          *
@@ -180,7 +370,50 @@ namespace robomaster_can_controller {
          * @return false If the handler was stopped due to error.
          */
         bool is_running() const;
+
+        /**
+         * @brief Get the throughput counters of the stream of the given device id.
+         *
+         * @param device_id The can device id, e.g. DEVICE_ID_GIMBAL.
+         * @return StreamStatistics of the device.
+         */
+        StreamStatistics get_stream_statistics(uint32_t device_id) const;
+
+        /**
+         * @brief Enable or disable the recording of all received and sent frames at runtime.
+         * Returns when no thread uses the previous recorder anymore.
+         *
+         * @param recorder The open recorder, nullptr disables the recording.
+         */
+        void set_recorder(Recorder *recorder);
+
+        /**
+         * @brief Enable or disable the commands of other processes at runtime. The sender sends them before its own queue and the
+         * commands of the queue are arbitrated with the local priority of the ingress. Returns when no thread uses the previous ingress anymore.
+         *
+         * @param ingress The open ingress, nullptr disables the commands of other processes.
+         */
+        void set_command_ingress(CommandIngress *ingress);
+
+        /**
+         * @brief Get the latency statistics of the pushed commands per channel.
+         *
+         * @return std::vector<ChannelLatency> ordered by device id and type.
+         */
+        std::vector<ChannelLatency> get_latency_statistics() const;
+
+        /**
+         * @brief Get a snapshot of the runtime counters and histograms including the counters of every received stream.
+         *
+         * @return MetricsSnapshot of the handler.
+         */
+        MetricsSnapshot get_metrics() const;
     };
+
+    /**
+     * @brief The handler for the can bus over socketcan.
+     */
+    using Handler = BasicHandler<CanSocket>;
 } // namespace robomaster_can_controller
 
 #endif // ROBOMASTER_CAN_CONTROLLER_HANDLER_H_
\ No newline at end of file
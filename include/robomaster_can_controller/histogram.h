@@ -0,0 +1,206 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_HISTOGRAM_H_
+#define ROBOMASTER_CAN_CONTROLLER_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief This class counts values in log-linear buckets. Every power of two is split into 16 linear buckets,
+     * so a bucket covers at most 1/16 of its value. Values below 32 are counted exactly.
+     */
+    class Histogram {
+        friend class AtomicHistogram;
+
+    public:
+        /**
+         * @brief The number of linear buckets per power of two.
+         */
+        static constexpr size_t SUB_BUCKETS = 16;
+
+        /**
+         * @brief The number of buckets for the whole uint64_t range.
+         */
+        static constexpr size_t BUCKETS = (64 - 4) * SUB_BUCKETS + SUB_BUCKETS;
+
+    private:
+        /**
+         * @brief The counter of every bucket.
+         */
+        std::array<uint64_t, BUCKETS> buckets_;
+
+        /**
+         * @brief Number of recorded values.
+         */
+        uint64_t count_;
+
+        /**
+         * @brief Sum of the recorded values.
+         */
+        uint64_t total_;
+
+        /**
+         * @brief Smallest recorded value.
+         */
+        uint64_t min_;
+
+        /**
+         * @brief Largest recorded value.
+         */
+        uint64_t max_;
+
+    public:
+        /**
+         * @brief Construct a new empty Histogram object.
+         */
+        Histogram();
+
+        /**
+         * @brief Get the bucket of a value.
+         *
+         * @param value The value.
+         * @return size_t as bucket index.
+         */
+        static size_t get_bucket(uint64_t value);
+
+        /**
+         * @brief Get the smallest value of a bucket.
+         *
+         * @param bucket The bucket index.
+         * @return uint64_t as lower bound of the bucket.
+         */
+        static uint64_t get_lower_bound(size_t bucket);
+
+        /**
+         * @brief Record a value.
+         *
+         * @param value The value.
+         */
+        void record(uint64_t value);
+
+        /**
+         * @brief Add the values of another histogram.
+         *
+         * @param other The other histogram.
+         */
+        void merge(const Histogram &other);
+
+        /**
+         * @brief Remove all values.
+         */
+        void reset();
+
+        /**
+         * @brief Number of recorded values.
+         *
+         * @return uint64_t as count.
+         */
+        uint64_t get_count() const;
+
+        /**
+         * @brief Smallest recorded value.
+         *
+         * @return uint64_t as minimum, zero when empty.
+         */
+        uint64_t get_min() const;
+
+        /**
+         * @brief Largest recorded value.
+         *
+         * @return uint64_t as maximum, zero when empty.
+         */
+        uint64_t get_max() const;
+
+        /**
+         * @brief Mean of the recorded values.
+         *
+         * @return double as mean, zero when empty.
+         */
+        double get_mean() const;
+
+        /**
+         * @brief Get the value below which the given share of the values lies, within the resolution of the buckets.
+         *
+         * @param percentile The percentile between 0 and 100.
+         * @return uint64_t as value, zero when empty.
+         */
+        uint64_t get_percentile(double percentile) const;
+
+        /**
+         * @brief Get the counter of a bucket.
+         *
+         * @param bucket The bucket index.
+         * @return uint64_t as count.
+         */
+        uint64_t get_bucket_count(size_t bucket) const;
+    };
+
+    /**
+     * @brief This class counts values in the buckets of the Histogram with relaxed atomics, so multiple threads can record without a lock.
+     * A snapshot is taken by adding the buckets into a Histogram, it is not consistent with concurrently recorded values.
+     */
+    class AtomicHistogram {
+        /**
+         * @brief The counter of every bucket.
+         */
+        std::array<std::atomic<uint64_t>, Histogram::BUCKETS> buckets_;
+
+        /**
+         * @brief Number of recorded values.
+         */
+        std::atomic<uint64_t> count_;
+
+        /**
+         * @brief Sum of the recorded values.
+         */
+        std::atomic<uint64_t> total_;
+
+        /**
+         * @brief Smallest recorded value, UINT64_MAX when empty.
+         */
+        std::atomic<uint64_t> min_;
+
+        /**
+         * @brief Largest recorded value.
+         */
+        std::atomic<uint64_t> max_;
+
+    public:
+        /**
+         * @brief Construct a new empty AtomicHistogram object.
+         */
+        AtomicHistogram();
+
+        AtomicHistogram(const AtomicHistogram&) = delete;
+        AtomicHistogram &operator=(const AtomicHistogram&) = delete;
+
+        /**
+         * @brief Record a value.
+         *
+         * @param value The value.
+         */
+        void record(uint64_t value);
+
+        /**
+         * @brief Add the recorded values to a histogram.
+         *
+         * @param histogram The histogram.
+         */
+        void load(Histogram &histogram) const;
+
+        /**
+         * @brief Remove all values, must not run concurrently to record.
+         */
+        void reset();
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_HISTOGRAM_H_
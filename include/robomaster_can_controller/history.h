@@ -0,0 +1,217 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_HISTORY_H_
+#define ROBOMASTER_CAN_CONTROLLER_HISTORY_H_
+
+#include "data.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief A window of consecutive states of the StateHistory. Every column is a contiguous span of the history itself,
+     * so a window is created without a copy. The spans stay valid as long as the history exists, but the states are
+     * overwritten when the history wraps around, check the window with StateHistory::is_valid after it is used.
+     */
+    struct HistoryWindow {
+        /**
+         * @brief The number of the first state, counted from the first pushed state.
+         */
+        uint64_t begin = 0;
+
+        /**
+         * @brief The number of states.
+         */
+        size_t size = 0;
+
+        /**
+         * @brief The receive time in nanoseconds since epoch (CLOCK_REALTIME), the time of the first can frame when known.
+         */
+        std::span<const uint64_t> time;
+
+        /**
+         * @brief The StateSection bits of the parts of the state with data.
+         */
+        std::span<const uint8_t> sections;
+
+        std::span<const uint16_t> adc_value;
+        std::span<const uint16_t> temperature;
+        std::span<const int32_t> current;
+        std::span<const uint8_t> percent;
+
+        std::span<const std::array<int16_t, 4>> speed;
+        std::span<const std::array<int16_t, 4>> angle;
+        std::span<const std::array<uint32_t, 4>> time_stamp;
+        std::span<const std::array<uint8_t, 4>> state;
+
+        std::span<const float> acc_x;
+        std::span<const float> acc_y;
+        std::span<const float> acc_z;
+        std::span<const float> gyro_x;
+        std::span<const float> gyro_y;
+        std::span<const float> gyro_z;
+
+        std::span<const float> vgx;
+        std::span<const float> vgy;
+        std::span<const float> vgz;
+        std::span<const float> vbx;
+        std::span<const float> vby;
+        std::span<const float> vbz;
+
+        std::span<const float> x;
+        std::span<const float> y;
+        std::span<const float> z;
+
+        std::span<const float> roll;
+        std::span<const float> pitch;
+        std::span<const float> yaw;
+
+        std::span<const uint64_t> last_frame;
+        std::span<const uint64_t> acquisition;
+        std::span<const uint64_t> uncertainty;
+    };
+
+    /**
+     * @brief This class keeps the latest states of the RoboMaster as structure of arrays, e.g. one contiguous column for
+     * the accelerations of every axis, so windowed statistics scan only the columns they need. A single writer appends
+     * without a lock and any number of readers query the last states or a time range concurrently. Every state is written
+     * twice, at its row and at its row plus the size of the ring, so every window of up to capacity states is contiguous.
+     * The ring holds one state more than the capacity, so the last capacity states stay intact while the next one is pushed.
+     */
+    class StateHistory {
+        /**
+         * @brief The number of states of the history.
+         */
+        size_t capacity_;
+
+        /**
+         * @brief The number of pushed states, stored after the state is written.
+         */
+        std::atomic<uint64_t> count_;
+
+        /**
+         * @brief Incremented for every push, the readers wait on it as futex.
+         */
+        std::atomic<uint32_t> signal_;
+
+        /**
+         * @brief The number of waiting readers, the writer only wakes up the futex when a reader waits.
+         */
+        mutable std::atomic<uint32_t> waiters_;
+
+        std::vector<uint64_t> time_;
+        std::vector<uint8_t> sections_;
+        std::vector<uint16_t> adc_value_;
+        std::vector<uint16_t> temperature_;
+        std::vector<int32_t> current_;
+        std::vector<uint8_t> percent_;
+        std::vector<std::array<int16_t, 4>> speed_;
+        std::vector<std::array<int16_t, 4>> angle_;
+        std::vector<std::array<uint32_t, 4>> time_stamp_;
+        std::vector<std::array<uint8_t, 4>> state_;
+        std::vector<float> acc_x_, acc_y_, acc_z_, gyro_x_, gyro_y_, gyro_z_;
+        std::vector<float> vgx_, vgy_, vgz_, vbx_, vby_, vbz_;
+        std::vector<float> x_, y_, z_;
+        std::vector<float> roll_, pitch_, yaw_;
+        std::vector<uint64_t> last_frame_;
+        std::vector<uint64_t> acquisition_;
+        std::vector<uint64_t> uncertainty_;
+
+        /**
+         * @brief Write a state into the columns of a row.
+         */
+        void write(size_t row, const DataRoboMasterState &state, uint64_t time);
+
+    public:
+        /**
+         * @brief Construct a new StateHistory object.
+         *
+         * @param capacity The number of states, the default holds one minute at 50 Hertz.
+         */
+        explicit StateHistory(size_t capacity=3000);
+
+        StateHistory(const StateHistory&) = delete;
+        StateHistory &operator=(const StateHistory&) = delete;
+
+        /**
+         * @brief Get the number of states of the history.
+         *
+         * @return size_t as capacity.
+         */
+        size_t get_capacity() const;
+
+        /**
+         * @brief Get the number of pushed states.
+         *
+         * @return uint64_t as count.
+         */
+        uint64_t get_count() const;
+
+        /**
+         * @brief Append a state, only a single thread may push. The time is the receive time of the first can frame,
+         * or the current time when the state has no receive times.
+         *
+         * @param state The state.
+         */
+        void push(const DataRoboMasterState &state);
+
+        /**
+         * @brief Get the window of the states [begin, begin + size), limited to the states of the history.
+         *
+         * @param begin The number of the first state.
+         * @param size The number of states.
+         * @return HistoryWindow of the states.
+         */
+        HistoryWindow get_window(uint64_t begin, size_t size) const;
+
+        /**
+         * @brief Get the window of the last states.
+         *
+         * @param size The number of states, limited to the states of the history.
+         * @return HistoryWindow of the states.
+         */
+        HistoryWindow last(size_t size) const;
+
+        /**
+         * @brief Get the window of the states received within [t0, t1]. The search expects non decreasing receive times.
+         *
+         * @param t0 The begin in nanoseconds since epoch (CLOCK_REALTIME).
+         * @param t1 The end in nanoseconds since epoch (CLOCK_REALTIME).
+         * @return HistoryWindow of the states, empty when no state is within the range.
+         */
+        HistoryWindow between(uint64_t t0, uint64_t t1) const;
+
+        /**
+         * @brief State if the states of a window are not overwritten yet, checked after the window is used.
+         *
+         * @param window The window.
+         * @return true, when the states of the window are intact.
+         */
+        bool is_valid(const HistoryWindow &window) const;
+
+        /**
+         * @brief Wait until more than count states are pushed or the timeout expires. Returns early by notify.
+         *
+         * @param count The number of states already known.
+         * @param timeout The timeout in seconds, 0.0 waits until a state is pushed.
+         * @return true, when more than count states are pushed.
+         */
+        bool wait(uint64_t count, double timeout=0.0) const;
+
+        /**
+         * @brief Wake up all waiting readers, e.g. to stop a reader thread.
+         */
+        void notify();
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_HISTORY_H_
@@ -0,0 +1,369 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_INGRESS_H_
+#define ROBOMASTER_CAN_CONTROLLER_INGRESS_H_
+
+#include "message.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The magic at the beginning of a command ingress segment.
+     */
+    static constexpr char INGRESS_MAGIC[4] = { 'R', 'M', 'C', 'I' };
+
+    /**
+     * @brief The version of the segment layout.
+     */
+    static constexpr uint32_t INGRESS_VERSION = 1;
+
+    /**
+     * @brief The maximum number of connected clients.
+     */
+    static constexpr size_t INGRESS_MAX_CLIENTS = 16;
+
+    /**
+     * @brief The maximum payload of a command.
+     */
+    static constexpr size_t INGRESS_MAX_PAYLOAD = 64;
+
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free, "the atomics are shared between processes");
+
+    /**
+     * @brief A command of the ring, the sequence follows the bounded multi producer queue of the logger.
+     */
+    struct IngressCommand {
+        std::atomic<uint64_t> sequence;
+        uint32_t client;
+        uint32_t priority;
+        uint32_t device_id;
+        uint16_t type;
+        uint16_t length;
+        uint64_t time;
+        uint8_t payload[INGRESS_MAX_PAYLOAD];
+    };
+
+    /**
+     * @brief A client slot of the segment, free, claimed while a client registers and ready afterwards.
+     */
+    struct IngressClient {
+        std::atomic<uint32_t> state;
+        int32_t pid;
+        uint32_t priority;
+        char name[32];
+        std::atomic<uint64_t> pushed;
+        std::atomic<uint64_t> dropped;
+        std::atomic<uint64_t> accepted;
+        std::atomic<uint64_t> rejected;
+    };
+
+    /**
+     * @brief The layout of the shared memory segment, followed by the commands of the ring.
+     */
+    struct alignas(64) IngressSegment {
+        char magic[4];
+        uint32_t version;
+        uint32_t capacity;
+        uint32_t max_payload;
+
+        /**
+         * @brief The enqueue position of the producers.
+         */
+        alignas(64) std::atomic<uint64_t> enqueue;
+
+        /**
+         * @brief Incremented for every pushed command, the sender thread waits on it as futex.
+         */
+        alignas(64) std::atomic<uint32_t> signal;
+
+        /**
+         * @brief The client slots.
+         */
+        alignas(64) IngressClient clients[INGRESS_MAX_CLIENTS];
+    };
+
+    /**
+     * @brief The statistics of a connected client.
+     */
+    struct IngressClientStatistics {
+        std::string name;
+        int32_t pid = 0;
+        uint32_t priority = 0;
+
+        /**
+         * @brief Number of commands pushed into the ring.
+         */
+        uint64_t pushed = 0;
+
+        /**
+         * @brief Number of commands dropped because the ring was full.
+         */
+        uint64_t dropped = 0;
+
+        /**
+         * @brief Number of commands sent to the RoboMaster.
+         */
+        uint64_t accepted = 0;
+
+        /**
+         * @brief Number of commands discarded by the arbitration.
+         */
+        uint64_t rejected = 0;
+    };
+
+    /**
+     * @brief This class receives the commands of other processes through a lock free multi producer ring in POSIX shared memory.
+     * The sender thread of the handler drains the ring before its own queue and wakes up on a futex when a client pushes a command.
+     * Every command channel, the device id and type of a command, e.g. the drive commands of set_velocity and set_brake, is owned by
+     * the client with the highest priority which sent a command within the hold time. The commands of lower priorities are discarded
+     * until the owner is silent for the hold time, so e.g. a safety monitor overrides the autonomy as long as it keeps sending. The
+     * commands of the local RoboMaster take part in the arbitration with the local priority. The handler assigns the sequence of an
+     * accepted command from the same counters as the local commands. A client which dies in the middle of a push blocks the ring,
+     * the owner has to recreate the segment.
+     */
+    class CommandIngress {
+        /**
+         * @brief The owner state of a command channel.
+         */
+        struct Channel {
+            uint32_t device_id = 0;
+            uint16_t type = 0;
+            uint32_t priority = 0;
+            std::chrono::steady_clock::time_point until;
+        };
+
+        /**
+         * @brief The shared memory object.
+         */
+        int fd_;
+
+        /**
+         * @brief The mapped segment.
+         */
+        IngressSegment *segment_;
+
+        /**
+         * @brief The size of the mapping.
+         */
+        size_t size_;
+
+        /**
+         * @brief The name of the shared memory object.
+         */
+        std::string name_;
+
+        /**
+         * @brief The dequeue position of the consumer.
+         */
+        uint64_t dequeue_;
+
+        /**
+         * @brief The time a channel stays owned by a client after its last command.
+         */
+        std::chrono::steady_clock::duration hold_;
+
+        /**
+         * @brief The priority of the commands of the local RoboMaster.
+         */
+        uint32_t local_priority_;
+
+        /**
+         * @brief The command channels.
+         */
+        std::vector<Channel> channels_;
+
+        /**
+         * @brief Get the channel of a command.
+         */
+        Channel &get_channel(uint32_t device_id, uint16_t type);
+
+        /**
+         * @brief Arbitrate a command, the channel is taken over when the priority is not lower than the one of its owner.
+         */
+        bool arbitrate(uint32_t device_id, uint16_t type, uint32_t priority);
+
+    public:
+        /**
+         * @brief Construct a new CommandIngress object.
+         */
+        CommandIngress();
+
+        /**
+         * @brief Destroy the CommandIngress object and remove the segment.
+         */
+        ~CommandIngress();
+
+        CommandIngress(const CommandIngress&) = delete;
+        CommandIngress &operator=(const CommandIngress&) = delete;
+
+        /**
+         * @brief Create the segment.
+         *
+         * @param name The name of the shared memory object, e.g. /robomaster_commands.
+         * @param capacity The number of commands of the ring.
+         * @param hold The time in seconds a channel stays owned by a client after its last command.
+         * @param local_priority The priority of the commands of the local RoboMaster.
+         * @param replace True to remove an existing segment of the same name first, e.g. the stale segment of a crashed process.
+         * @return true, by success.
+         * @return false, when already open, a segment of the same name exists without replace or the segment could not be created.
+         */
+        bool open(const std::string &name, size_t capacity=256, double hold=0.2, uint32_t local_priority=0, bool replace=false);
+
+        /**
+         * @brief Unmap and remove the segment.
+         */
+        void close();
+
+        /**
+         * @brief State if the segment is open.
+         *
+         * @return true, when open.
+         */
+        bool is_open() const;
+
+        /**
+         * @brief State if the ring holds no published command.
+         *
+         * @return true, when empty.
+         */
+        bool empty() const;
+
+        /**
+         * @brief Pop the next command and arbitrate it. Only a single thread may pop.
+         *
+         * @param time The push time of the command in nanoseconds since epoch (CLOCK_REALTIME).
+         * @return Message as command without sequence, not valid when the ring is empty or the command was discarded.
+         */
+        Message pop(uint64_t &time);
+
+        /**
+         * @brief Arbitrate a command of the local RoboMaster with the local priority. Only the popping thread may accept.
+         *
+         * @param msg The command.
+         * @return true, when the command may be sent.
+         * @return false, when a client with a higher priority owns the channel.
+         */
+        bool accept(const Message &msg);
+
+        /**
+         * @brief Get the current value of the futex word, read before the ring is checked.
+         *
+         * @return uint32_t as signal.
+         */
+        uint32_t get_signal() const;
+
+        /**
+         * @brief Wait until the futex word changes or the deadline expires.
+         *
+         * @param signal The value of get_signal.
+         * @param deadline The deadline.
+         */
+        void wait(uint32_t signal, std::chrono::high_resolution_clock::time_point deadline) const;
+
+        /**
+         * @brief Wake up the waiting thread, e.g. for a command of the local queue.
+         */
+        void notify();
+
+        /**
+         * @brief Get the statistics of the connected clients.
+         *
+         * @return std::vector<IngressClientStatistics> of the clients.
+         */
+        std::vector<IngressClientStatistics> get_clients() const;
+    };
+
+    /**
+     * @brief This class pushes commands from another process into the CommandIngress of the RoboMaster owner. A push never blocks,
+     * it fails when the ring is full. The commands are created with the encoders of command.h.
+     */
+    class CommandClient {
+        /**
+         * @brief The shared memory object.
+         */
+        int fd_;
+
+        /**
+         * @brief The mapped segment.
+         */
+        IngressSegment *segment_;
+
+        /**
+         * @brief The size of the mapping.
+         */
+        size_t size_;
+
+        /**
+         * @brief The client slot.
+         */
+        uint32_t client_;
+
+        /**
+         * @brief The priority of the commands.
+         */
+        uint32_t priority_;
+
+        /**
+         * @brief Claim a client slot, a slot of a dead process is reused.
+         */
+        bool claim(const std::string &client_name);
+
+    public:
+        /**
+         * @brief Construct a new CommandClient object.
+         */
+        CommandClient();
+
+        /**
+         * @brief Destroy the CommandClient object and release the client slot.
+         */
+        ~CommandClient();
+
+        CommandClient(const CommandClient&) = delete;
+        CommandClient &operator=(const CommandClient&) = delete;
+
+        /**
+         * @brief Map the segment of a CommandIngress and register as client.
+         *
+         * @param name The name of the shared memory object.
+         * @param client_name The name of the client, e.g. safety.
+         * @param priority The priority of the commands, higher priorities override lower ones.
+         * @return true, by success.
+         * @return false, when the segment does not exist, has an unknown layout or all client slots are used.
+         */
+        bool open(const std::string &name, const std::string &client_name, uint32_t priority);
+
+        /**
+         * @brief Release the client slot and unmap the segment.
+         */
+        void close();
+
+        /**
+         * @brief State if the client is connected.
+         *
+         * @return true, when connected.
+         */
+        bool is_open() const;
+
+        /**
+         * @brief Push a command, the sequence of the message is ignored.
+         *
+         * @param msg The command.
+         * @return true, by success.
+         * @return false, when not connected, the payload is too long or the ring is full.
+         */
+        bool push(const Message &msg);
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_INGRESS_H_
@@ -0,0 +1,203 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_LATENCY_H_
+#define ROBOMASTER_CAN_CONTROLLER_LATENCY_H_
+
+#include "histogram.h"
+#include "message.h"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Counters and latencies of the commands of a channel. A channel is the device id and the type of the command.
+     * All latencies are in nanoseconds and measured from the enqueue of the command.
+     */
+    struct ChannelLatency {
+        /**
+         * @brief The can device id of the command.
+         */
+        uint32_t device_id = 0;
+
+        /**
+         * @brief The message type of the command.
+         */
+        uint16_t type = 0;
+
+        /**
+         * @brief Number of commands pushed into the sender queue.
+         */
+        uint64_t enqueued = 0;
+
+        /**
+         * @brief Number of commands dropped by the overflow of the sender queue.
+         */
+        uint64_t evicted = 0;
+
+        /**
+         * @brief Number of commands written to the transport.
+         */
+        uint64_t sent = 0;
+
+        /**
+         * @brief Number of commands the transport failed to write.
+         */
+        uint64_t send_failures = 0;
+
+        /**
+         * @brief Number of acknowledged commands.
+         */
+        uint64_t acked = 0;
+
+        /**
+         * @brief Number of sent commands which requested an acknowledgement but got none within the timeout.
+         */
+        uint64_t unanswered = 0;
+
+        /**
+         * @brief Time from enqueue to dequeue by the sender thread.
+         */
+        Histogram queue;
+
+        /**
+         * @brief Time from enqueue until the last frame was written to the transport.
+         */
+        Histogram sent_latency;
+
+        /**
+         * @brief Time from enqueue until the receive time of the acknowledgement.
+         */
+        Histogram ack_latency;
+    };
+
+    /**
+     * @brief This class tracks every command by its type and sequence number from the enqueue until it is written to the transport
+     * and, when the command requests one, until its acknowledgement is received. The acknowledgement of the RoboMaster has the byte swapped type
+     * and the same sequence number as the command. All times are taken from CLOCK_REALTIME like the kernel receive timestamps.
+     */
+    class LatencyTracker {
+        /**
+         * @brief The times of a command in flight.
+         */
+        struct Pending {
+            uint32_t device_id = 0;
+            uint64_t enqueue = 0;
+            bool need_ack = false;
+            bool sent = false;
+            bool acked = false;
+        };
+
+        /**
+         * @brief Commands in flight by type and sequence number.
+         */
+        std::unordered_map<uint32_t, Pending> pending_;
+
+        /**
+         * @brief The statistics by device id and type.
+         */
+        std::map<std::pair<uint32_t, uint16_t>, ChannelLatency> channels_;
+
+        /**
+         * @brief The time of the last purge of the commands in flight.
+         */
+        uint64_t purge_time_;
+
+        /**
+         * @brief Mutex for the pending commands and the statistics.
+         */
+        mutable std::mutex mutex_;
+
+        /**
+         * @brief Get the statistics of a channel.
+         *
+         * @param device_id The can device id.
+         * @param type The message type.
+         * @return ChannelLatency of the channel.
+         */
+        ChannelLatency &get_channel(uint32_t device_id, uint16_t type);
+
+        /**
+         * @brief Remove commands in flight which are older than the acknowledgement timeout.
+         *
+         * @param time The current time.
+         */
+        void purge(uint64_t time);
+
+    public:
+        /**
+         * @brief Construct a new LatencyTracker object.
+         */
+        LatencyTracker();
+
+        /**
+         * @brief Get the current time as used by the tracker.
+         *
+         * @return uint64_t as nanoseconds since epoch (CLOCK_REALTIME).
+         */
+        static uint64_t now();
+
+        /**
+         * @brief Track a command which is pushed into the sender queue.
+         *
+         * @param msg The command.
+         * @param time The enqueue time.
+         */
+        void enqueue(const Message &msg, uint64_t time=now());
+
+        /**
+         * @brief Track a command which was dropped by the overflow of the sender queue.
+         *
+         * @param msg The dropped command.
+         */
+        void evict(const Message &msg);
+
+        /**
+         * @brief Track a command which was taken from the sender queue.
+         *
+         * @param msg The command.
+         * @param time The dequeue time.
+         */
+        void dequeue(const Message &msg, uint64_t time=now());
+
+        /**
+         * @brief Track a command after the transport wrote its frames.
+         *
+         * @param msg The command.
+         * @param success True when the transport wrote all frames.
+         * @param time The time after the write.
+         */
+        void sent(const Message &msg, bool success, uint64_t time=now());
+
+        /**
+         * @brief Match a received message against the commands in flight.
+         *
+         * @param msg The received message, the receive time of its last frame is used when available.
+         * @return true, when the message acknowledged a tracked command.
+         * @return false, when the message is no acknowledgement of a tracked command.
+         */
+        bool receive(const Message &msg);
+
+        /**
+         * @brief Get the statistics of all channels ordered by device id and type.
+         *
+         * @return std::vector<ChannelLatency> as statistics.
+         */
+        std::vector<ChannelLatency> get_statistics() const;
+
+        /**
+         * @brief Remove all statistics and commands in flight.
+         */
+        void reset();
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_LATENCY_H_
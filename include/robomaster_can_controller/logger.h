@@ -0,0 +1,287 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_LOGGER_H_
+#define ROBOMASTER_CAN_CONTROLLER_LOGGER_H_
+
+#include <array>
+#include <atomic>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The severity of a log message.
+     */
+    enum LogLevel {
+        LOG_DEBUG,
+        LOG_INFO,
+        LOG_WARNING,
+        LOG_ERROR
+    };
+
+    /**
+     * @brief A formatted log message.
+     */
+    struct LogRecord {
+        /**
+         * @brief The maximum length of the text including the terminating zero, longer texts are truncated.
+         */
+        static constexpr size_t TEXT_SIZE = 128;
+
+        /**
+         * @brief The time of the message in nanoseconds since epoch (CLOCK_REALTIME).
+         */
+        uint64_t time = 0;
+
+        /**
+         * @brief The severity.
+         */
+        LogLevel level = LOG_INFO;
+
+        /**
+         * @brief The tag of the module, e.g. CAN or Handler.
+         */
+        const char *tag = "";
+
+        /**
+         * @brief The number of messages with the same format which were suppressed by the rate limit before this message.
+         */
+        uint64_t suppressed = 0;
+
+        /**
+         * @brief The formatted text.
+         */
+        char text[TEXT_SIZE] = {};
+    };
+
+    /**
+     * @brief This class formats log messages on the calling thread and hands them to a drain thread through a lock-free ring,
+     * the drain thread passes them to the sink. Logging never blocks: a message is dropped when the ring is full and repeated
+     * messages of the same format are limited to a burst per window, the suppressed messages are counted and reported with the
+     * next message which passes.
+     */
+    class Logger {
+    public:
+        /**
+         * @brief The number of messages in the ring.
+         */
+        static constexpr size_t CAPACITY = 1024;
+
+        /**
+         * @brief The number of formats which are rate limited, further formats are not limited.
+         */
+        static constexpr size_t RATE_LIMITS = 64;
+
+    private:
+        /**
+         * @brief A message of the ring with its sequence.
+         */
+        struct Slot {
+            std::atomic<uint64_t> sequence;
+            LogRecord record;
+        };
+
+        /**
+         * @brief The rate limit of a single format.
+         */
+        struct RateLimit {
+            std::atomic<const char*> format = nullptr;
+            std::atomic<uint64_t> window = 0;
+            std::atomic<uint64_t> count = 0;
+            std::atomic<uint64_t> suppressed = 0;
+        };
+
+        /**
+         * @brief The ring.
+         */
+        std::array<Slot, CAPACITY> slots_;
+
+        /**
+         * @brief The rate limits by format.
+         */
+        std::array<RateLimit, RATE_LIMITS> rate_limits_;
+
+        /**
+         * @brief The sequence of the next message to write.
+         */
+        alignas(64) std::atomic<uint64_t> enqueue_;
+
+        /**
+         * @brief The sequence of the next message to drain.
+         */
+        alignas(64) std::atomic<uint64_t> dequeue_;
+
+        /**
+         * @brief Incremented for every message, the drain thread waits on it.
+         */
+        std::atomic<uint32_t> signal_;
+
+        /**
+         * @brief The number of messages dropped by a full ring.
+         */
+        std::atomic<uint64_t> dropped_;
+
+        /**
+         * @brief The minimum severity.
+         */
+        std::atomic<int> level_;
+
+        /**
+         * @brief The number of messages per format and window.
+         */
+        const uint64_t burst_;
+
+        /**
+         * @brief The window of the rate limit in nanoseconds.
+         */
+        const uint64_t window_;
+
+        /**
+         * @brief The sink, only called by the drain thread.
+         */
+        std::function<void(const LogRecord&)> sink_;
+
+        /**
+         * @brief Mutex for the sink.
+         */
+        std::mutex sink_mutex_;
+
+        /**
+         * @brief Thread which drains the ring.
+         */
+        std::thread thread_;
+
+        /**
+         * @brief Flag to stop the drain thread.
+         */
+        std::atomic<bool> flag_stop_;
+
+        /**
+         * @brief Apply the rate limit of a format.
+         *
+         * @param format The format.
+         * @param time The time of the message.
+         * @param suppressed The number of suppressed messages since the last message which passed.
+         * @return true, when the message passes.
+         * @return false, when the message is suppressed.
+         */
+        bool rate_limit(const char *format, uint64_t time, uint64_t &suppressed);
+
+        /**
+         * @brief Take the next message from the ring, only called by the drain thread.
+         *
+         * @param record The message.
+         * @return true, by success.
+         * @return false, when the ring is empty.
+         */
+        bool pop(LogRecord &record);
+
+        /**
+         * @brief Run function of the drain thread.
+         */
+        void start_thread();
+
+    public:
+        /**
+         * @brief Construct a new Logger object and start the drain thread.
+         *
+         * @param burst The number of messages per format and window.
+         * @param window The window of the rate limit in nanoseconds.
+         */
+        explicit Logger(uint64_t burst=10, uint64_t window=1000000000);
+
+        /**
+         * @brief Drain the remaining messages and stop the drain thread.
+         */
+        ~Logger();
+
+        Logger(const Logger&) = delete;
+        Logger &operator=(const Logger&) = delete;
+
+        /**
+         * @brief Get the process wide logger, which is used by the library.
+         *
+         * @return Logger instance.
+         */
+        static Logger &get_instance();
+
+        /**
+         * @brief The default sink, writes the message to stdout as [tag]: text.
+         *
+         * @param record The message.
+         */
+        static void print(const LogRecord &record);
+
+        /**
+         * @brief Log a message, the format must be a string with static lifetime since it identifies the message for the rate limit.
+         *
+         * @param level The severity.
+         * @param tag The tag with static lifetime.
+         * @param format The printf format.
+         * @param ... The arguments.
+         * @return true, when the message is queued.
+         * @return false, when the message is filtered by the severity, suppressed by the rate limit or dropped by a full ring.
+         */
+        bool log(LogLevel level, const char *tag, const char *format, ...) __attribute__((format(printf, 4, 5)));
+
+        /**
+         * @brief Log a message with a list of arguments.
+         *
+         * @param level The severity.
+         * @param tag The tag with static lifetime.
+         * @param format The printf format.
+         * @param args The arguments.
+         * @return true, when the message is queued.
+         * @return false, when the message is filtered by the severity, suppressed by the rate limit or dropped by a full ring.
+         */
+        bool log(LogLevel level, const char *tag, const char *format, va_list args);
+
+        /**
+         * @brief Set the sink which receives the messages on the drain thread.
+         *
+         * @param sink The sink, Logger::print by default.
+         */
+        void set_sink(std::function<void(const LogRecord&)> sink);
+
+        /**
+         * @brief Set the minimum severity, messages below are discarded on the calling thread.
+         *
+         * @param level The severity, LOG_INFO by default.
+         */
+        void set_level(LogLevel level);
+
+        /**
+         * @brief Wait until all messages queued before the call are passed to the sink.
+         */
+        void flush();
+
+        /**
+         * @brief Get the number of messages dropped by a full ring.
+         *
+         * @return uint64_t as count.
+         */
+        uint64_t get_dropped() const;
+    };
+
+    /**
+     * @brief Log a message with the process wide logger.
+     *
+     * @param level The severity.
+     * @param tag The tag with static lifetime.
+     * @param format The printf format with static lifetime.
+     * @param ... The arguments.
+     * @return true, when the message is queued.
+     * @return false, when the message is filtered, suppressed or dropped.
+     */
+    bool log_message(LogLevel level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_LOGGER_H_
@@ -0,0 +1,149 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_LOOPBACK_TRANSPORT_H_
+#define ROBOMASTER_CAN_CONTROLLER_LOOPBACK_TRANSPORT_H_
+
+#include "transport.h"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief This class is an in-memory can bus for deterministic tests without a can interface.
+     * All transports which are initialised with the same name share a bus. Like on a real can bus, a sent frame is received by every other
+     * transport on the bus but not by the sender. The file descriptor is an eventfd which is readable while frames are queued.
+     */
+    class LoopbackTransport final : public Transport {
+        struct Bus;
+
+        /**
+         * @brief The bus which this transport joined, nullptr before init.
+         */
+        std::shared_ptr<Bus> bus_;
+
+        /**
+         * @brief The received frames which are not read yet.
+         */
+        std::deque<CanFrame> queue_;
+
+        /**
+         * @brief Mutex of the receive queue.
+         */
+        std::mutex mutex_;
+
+        /**
+         * @brief The eventfd which signals queued frames.
+         */
+        int event_fd_;
+
+        /**
+         * @brief The read timeout in milliseconds, negative blocks until a frame is received.
+         */
+        int timeout_;
+
+        /**
+         * @brief Queue a frame which was sent by another transport of the bus.
+         *
+         * @param frame The can frame.
+         */
+        void deliver(const CanFrame &frame);
+
+        /**
+         * @brief Wait until frames are queued or the timeout is reached.
+         *
+         * @return true, when frames are queued.
+         * @return false, when the timeout is reached.
+         */
+        bool wait();
+
+    public:
+        /**
+         * @brief Construct a new LoopbackTransport object.
+         */
+        LoopbackTransport();
+
+        /**
+         * @brief Destroy the LoopbackTransport object and leave the bus.
+         */
+        ~LoopbackTransport() override;
+
+        LoopbackTransport(const LoopbackTransport&) = delete;
+        LoopbackTransport &operator=(const LoopbackTransport&) = delete;
+
+        /**
+         * @brief Join the bus with the given name. The bus is created by the first transport and removed with the last one.
+         *
+         * @param name The name of the bus.
+         * @return true, when the bus is joined.
+         * @return false, when the transport already joined a bus or the eventfd failed to open.
+         */
+        bool init(const std::string &name) override;
+
+        /**
+         * @brief Set the timeout for reading frames.
+         *
+         * @param seconds Timeout in seconds, zero blocks until a frame is received.
+         */
+        void set_timeout(double seconds) override;
+
+        /**
+         * @brief Get the eventfd which is readable while frames are queued.
+         *
+         * @return int as file descriptor.
+         */
+        int get_fd() const override;
+
+        /**
+         * @brief Send a single can frame to every other transport of the bus.
+         *
+         * @param id The device id.
+         * @param data The data of the can frame.
+         * @param length The length of the data.
+         * @return true, by success.
+         * @return false, when the length is invalid or the transport is not initialised.
+         */
+        bool send_frame(uint32_t id, const uint8_t data[8], size_t length) override;
+
+        /**
+         * @brief Read the next can frame. This function is blocking until the timeout is reached.
+         *
+         * @param id The device id.
+         * @param data The data of the can frame.
+         * @param length The length of the data. The length is zero, when the timeout is reached.
+         * @param timestamp The send time in nanoseconds since epoch.
+         * @return true, by success.
+         * @return false, when the transport is not initialised.
+         */
+        bool read_frame(uint32_t &id, uint8_t data[8], size_t &length, uint64_t &timestamp) override;
+
+        /**
+         * @brief Send multiple can frames to every other transport of the bus under a single lock.
+         *
+         * @param frames The can frames to send.
+         * @param count The number of can frames.
+         * @return true, when all frames are sent.
+         * @return false, when a length is invalid or the transport is not initialised.
+         */
+        bool send_frames(const CanFrame *frames, size_t count) override;
+
+        /**
+         * @brief Read all queued can frames up to the capacity. This function is blocking until at least one frame is received or the timeout is reached.
+         *
+         * @param frames The buffer for the can frames.
+         * @param capacity The number of can frames the buffer can hold.
+         * @param count The number of read can frames. The count is zero, when the timeout is reached.
+         * @return true, by success.
+         * @return false, when the transport is not initialised.
+         */
+        bool read_frames(CanFrame *frames, size_t capacity, size_t &count) override;
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_LOOPBACK_TRANSPORT_H_
@@ -40,9 +40,20 @@ namespace robomaster_can_controller {
          */
         std::vector<uint8_t> payload_;
 
+        /**
+         * @brief The receive time of the first can frame of the message in nanoseconds since epoch, zero when unknown.
+         */
+        uint64_t time_first_frame_;
+
+        /**
+         * @brief The receive time of the last can frame of the message in nanoseconds since epoch, zero when unknown.
+         */
+        uint64_t time_last_frame_;
+
     public:
         /**
-         * @brief Construct a new Message object from the given raw data.
+         * @brief Construct a new Message object from the given raw data. The message is invalid unless the data starts with
+         * the sync byte, the length byte matches the size of the data and the data holds at least one byte of payload.
          *
          * @param device_id The can device id.
          * @param msg_data The raw data for example can bus to parse into a RoboMaster message.
@@ -83,9 +94,9 @@ namespace robomaster_can_controller {
         /**
          * @brief Get the payload from the message.
          *
-         * @return std::vector<uint8_t> as payload.
+         * @return const std::vector<uint8_t>& as payload.
          */
-        std::vector<uint8_t> get_payload() const;
+        const std::vector<uint8_t> &get_payload() const;
 
         /**
          * @brief Retuns true for a valid message, when message length and crc is correct.
@@ -102,6 +113,28 @@ namespace robomaster_can_controller {
          */
         size_t get_length() const;
 
+        /**
+         * @brief Get the receive time of the first can frame of the message.
+         *
+         * @return uint64_t as nanoseconds since epoch, zero when unknown.
+         */
+        uint64_t get_time_first_frame() const;
+
+        /**
+         * @brief Get the receive time of the last can frame of the message.
+         *
+         * @return uint64_t as nanoseconds since epoch, zero when unknown.
+         */
+        uint64_t get_time_last_frame() const;
+
+        /**
+         * @brief Set the receive times of the first and the last can frame of the message.
+         *
+         * @param time_first_frame Receive time of the first frame in nanoseconds since epoch.
+         * @param time_last_frame Receive time of the last frame in nanoseconds since epoch.
+         */
+        void set_time(uint64_t time_first_frame, uint64_t time_last_frame);
+
         /**
          * @brief Set the uint8 value into the payload at given index.
          *
@@ -219,6 +252,13 @@ namespace robomaster_can_controller {
          */
         void increment_sequence();
 
+        /**
+         * @brief Set the sequence.
+         *
+         * @param sequence The sequence.
+         */
+        void set_sequence(uint16_t sequence);
+
         /**
          * @brief Set the payload.
          *
@@ -229,7 +269,7 @@ namespace robomaster_can_controller {
         /**
          * @brief Create a vector as raw data from the message including header, crc and payload.
          *
-         * @return std::vector<uint8_t> as raw data message.
+         * @return std::vector<uint8_t> as raw data message, empty when the message is invalid or the payload does not fit the length byte.
          */
         std::vector<uint8_t> to_vector() const;
 
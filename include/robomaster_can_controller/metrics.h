@@ -0,0 +1,229 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_METRICS_H_
+#define ROBOMASTER_CAN_CONTROLLER_METRICS_H_
+
+#include "histogram.h"
+#include "reassembler.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The counters of the runtime metrics.
+     */
+    enum MetricCounter {
+        METRIC_FRAMES_RECEIVED,
+        METRIC_FRAMES_SENT,
+        METRIC_MESSAGES_RECEIVED,
+        METRIC_MESSAGES_SENT,
+        METRIC_READ_ERRORS,
+        METRIC_SEND_ERRORS,
+        METRIC_RECEIVE_QUEUE_DROPS,
+        METRIC_SEND_QUEUE_DROPS,
+        METRIC_HEARTBEATS,
+        METRIC_INGRESS_COMMANDS,
+        METRIC_INGRESS_REJECTED,
+        METRIC_LOCAL_REJECTED,
+        METRIC_COUNTER_COUNT
+    };
+
+    /**
+     * @brief The histograms of the runtime metrics, all values are in nanoseconds.
+     */
+    enum MetricHistogram {
+        METRIC_HEARTBEAT_LATENESS,
+        METRIC_CALLBACK_DURATION,
+        METRIC_HISTOGRAM_COUNT
+    };
+
+    /**
+     * @brief A consistent copy of the runtime metrics.
+     */
+    struct MetricsSnapshot {
+        /**
+         * @brief The time of the snapshot in nanoseconds since epoch (CLOCK_REALTIME).
+         */
+        uint64_t time = 0;
+
+        /**
+         * @brief The counters indexed by MetricCounter.
+         */
+        std::array<uint64_t, METRIC_COUNTER_COUNT> counters{};
+
+        /**
+         * @brief The histograms indexed by MetricHistogram.
+         */
+        std::array<Histogram, METRIC_HISTOGRAM_COUNT> histograms;
+
+        /**
+         * @brief The counters of the reassembled streams by can device id.
+         */
+        std::vector<std::pair<uint32_t, StreamStatistics>> streams;
+    };
+
+    /**
+     * @brief This class collects runtime counters and histograms with negligible overhead on the hot path. Every thread records into one of
+     * a few cache line aligned shards with relaxed atomics, so the threads of the handler never share a cache line. The shards are only
+     * summed when a snapshot is taken.
+     */
+    class Metrics {
+    public:
+        /**
+         * @brief The number of shards.
+         */
+        static constexpr size_t SHARDS = 8;
+
+    private:
+        /**
+         * @brief The metrics of a group of threads.
+         */
+        struct alignas(64) Shard {
+            std::array<std::atomic<uint64_t>, METRIC_COUNTER_COUNT> counters{};
+            std::array<AtomicHistogram, METRIC_HISTOGRAM_COUNT> histograms;
+        };
+
+        /**
+         * @brief The shards.
+         */
+        std::array<Shard, SHARDS> shards_;
+
+        /**
+         * @brief Get the shard of the calling thread.
+         *
+         * @return Shard of the thread.
+         */
+        Shard &get_shard();
+
+    public:
+        /**
+         * @brief Construct a new Metrics object.
+         */
+        Metrics();
+
+        Metrics(const Metrics&) = delete;
+        Metrics &operator=(const Metrics&) = delete;
+
+        /**
+         * @brief Add to a counter.
+         *
+         * @param counter The counter.
+         * @param value The value to add.
+         */
+        void add(MetricCounter counter, uint64_t value=1);
+
+        /**
+         * @brief Record a value into a histogram.
+         *
+         * @param histogram The histogram.
+         * @param value The value in nanoseconds.
+         */
+        void record(MetricHistogram histogram, uint64_t value);
+
+        /**
+         * @brief Sum the shards into a snapshot, the streams of the snapshot are left empty.
+         *
+         * @return MetricsSnapshot of the counters and histograms.
+         */
+        MetricsSnapshot get_snapshot() const;
+    };
+
+    /**
+     * @brief Format a snapshot in the Prometheus text exposition format. The counters are exported with a _total suffix,
+     * the histograms as summaries in seconds and the streams with a device label.
+     *
+     * @param snapshot The snapshot.
+     * @return std::string as text.
+     */
+    std::string to_prometheus(const MetricsSnapshot &snapshot);
+
+    /**
+     * @brief Write a text to a file, the file is replaced atomically so a reader never sees a partial file.
+     *
+     * @param path The path of the file, e.g. in the textfile directory of the node exporter.
+     * @param text The text.
+     * @return true, by success.
+     * @return false, when the file could not be written.
+     */
+    bool write_text_file(const std::string &path, const std::string &text);
+
+    /**
+     * @brief This class serves the Prometheus text on a local Unix stream socket. Every connection receives the current text and is closed,
+     * e.g. read with socat - UNIX-CONNECT:/tmp/robomaster.prom. The text is only generated when a client connects.
+     */
+    class MetricsExporter {
+        /**
+         * @brief Source of the text.
+         */
+        std::function<std::string()> source_;
+
+        /**
+         * @brief The path of the socket.
+         */
+        std::string path_;
+
+        /**
+         * @brief The listening socket.
+         */
+        int socket_;
+
+        /**
+         * @brief Thread which accepts the connections.
+         */
+        std::thread thread_;
+
+        /**
+         * @brief Flag to stop the thread.
+         */
+        std::atomic<bool> flag_stop_;
+
+        /**
+         * @brief Run function of the thread.
+         */
+        void start_thread();
+
+    public:
+        /**
+         * @brief Construct a new MetricsExporter object.
+         *
+         * @param source Function which returns the current text, e.g. to_prometheus(robomaster.get_metrics()).
+         */
+        explicit MetricsExporter(std::function<std::string()> source);
+
+        /**
+         * @brief Destroy the MetricsExporter object and remove the socket.
+         */
+        ~MetricsExporter();
+
+        MetricsExporter(const MetricsExporter&) = delete;
+        MetricsExporter &operator=(const MetricsExporter&) = delete;
+
+        /**
+         * @brief Create the socket and start serving.
+         *
+         * @param path The path of the socket, an existing socket file is replaced.
+         * @return true, by success.
+         * @return false, when already running or the socket could not be created.
+         */
+        bool start(const std::string &path);
+
+        /**
+         * @brief Stop serving and remove the socket.
+         */
+        void stop();
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_METRICS_H_
@@ -8,10 +8,17 @@
 #define ROBOMASTER_CAN_CONTROLLER_QUEUE_MSG_H_
 
 #include <mutex>
+#include <optional>
 #include <queue>
+#include <vector>
 #include "message.h"
 
 namespace robomaster_can_controller {
+    /**
+     * @brief The maximal number of messages of a QueueMsg.
+     */
+    static constexpr size_t QUEUE_MSG_MAX_SIZE = 10;
+
     /**
      * @brief This class is queue for RoboMaster messages which is protected by a mutex.
      */
@@ -37,15 +44,27 @@ namespace robomaster_can_controller {
          * @brief Push a Message into the queue. If the maximal queue size is reached the front message will be pop.
          *
          * @param msg A RoboMaster message.
+         * @return std::optional<Message> with the evicted front message, when the maximal queue size was reached.
          */
-        void push(const Message &msg);
+        std::optional<Message> push(const Message &msg);
 
         /**
          * @brief Push a Message into the queue. If the maximal queue size is reached the front message will be pop.
          *
          * @param msg A RoboMaster message.
+         * @return std::optional<Message> with the evicted front message, when the maximal queue size was reached.
          */
-        void push(Message && msg);
+        std::optional<Message> push(Message && msg);
+
+        /**
+         * @brief Push several messages into the queue under a single lock, so a consumer sees either all or none of them.
+         * Unlike push no message is evicted, a batch which does not fit into the free space of the queue is rejected.
+         *
+         * @param msgs The RoboMaster messages.
+         * @return true, by success.
+         * @return false, when the queue has no room for all messages, nothing is pushed.
+         */
+        bool push_batch(const std::vector<Message> &msgs);
 
         /**
          * @brief Pop and return the message of the queue. If the queue is empty a empty message is returned.
@@ -54,6 +73,14 @@ namespace robomaster_can_controller {
          */
         Message pop();
 
+        /**
+         * @brief Pop all messages of the queue under a single lock.
+         *
+         * @param msgs The popped messages are appended.
+         * @return size_t as number of popped messages.
+         */
+        size_t pop_all(std::vector<Message> &msgs);
+
         /**
          * @brief The current size of the queue.
          *
@@ -0,0 +1,204 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_REASSEMBLER_H_
+#define ROBOMASTER_CAN_CONTROLLER_REASSEMBLER_H_
+
+#include "message.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Counters of a single device stream.
+     */
+    struct StreamStatistics {
+        /**
+         * @brief Number of received can frames.
+         */
+        uint64_t frames = 0;
+
+        /**
+         * @brief Number of received bytes.
+         */
+        uint64_t bytes = 0;
+
+        /**
+         * @brief Number of completed messages with valid crc.
+         */
+        uint64_t messages = 0;
+
+        /**
+         * @brief Number of messages dropped due to a wrong crc16.
+         */
+        uint64_t crc_errors = 0;
+
+        /**
+         * @brief Number of sync bytes with a wrong crc8 of the header.
+         */
+        uint64_t crc8_errors = 0;
+
+        /**
+         * @brief Number of bytes skipped while searching for a valid message header.
+         */
+        uint64_t discarded_bytes = 0;
+
+        /**
+         * @brief Number of times the stream lost the message boundary and searched for the next header.
+         */
+        uint64_t resyncs = 0;
+    };
+
+    /**
+     * @brief This class reassembles RoboMaster messages from the can frames of every known device.
+     * The stream state is kept in a flat array indexed by the can device id, so each frame is routed in constant time.
+     */
+    class Reassembler {
+    public:
+        /**
+         * @brief The lowest can device id handled by the reassembler.
+         */
+        static constexpr uint32_t DEVICE_ID_BASE = 0x200;
+
+        /**
+         * @brief The number of can device ids starting at DEVICE_ID_BASE handled by the reassembler.
+         */
+        static constexpr size_t DEVICE_ID_COUNT = 0x20;
+
+    private:
+        /**
+         * @brief The reassembly state and counters of a single device.
+         */
+        struct Stream {
+            bool enabled = false;
+            std::vector<uint8_t> buffer;
+            std::vector<std::pair<size_t, uint64_t>> frame_times;
+            size_t head = 0;
+            size_t length = 0;
+            std::atomic<uint64_t> frames = 0;
+            std::atomic<uint64_t> bytes = 0;
+            std::atomic<uint64_t> messages = 0;
+            std::atomic<uint64_t> crc_errors = 0;
+            std::atomic<uint64_t> crc8_errors = 0;
+            std::atomic<uint64_t> discarded_bytes = 0;
+            std::atomic<uint64_t> resyncs = 0;
+        };
+
+        /**
+         * @brief The device streams indexed by can device id minus DEVICE_ID_BASE.
+         */
+        std::array<Stream, DEVICE_ID_COUNT> streams_;
+
+        /**
+         * @brief Get the stream of the given device id.
+         *
+         * @param device_id The can device id.
+         * @return Stream* the stream, or nullptr when the device id is out of range.
+         */
+        Stream *get_stream(uint32_t device_id);
+
+        /**
+         * @brief Get the stream of the given device id.
+         *
+         * @param device_id The can device id.
+         * @return const Stream* the stream, or nullptr when the device id is out of range.
+         */
+        const Stream *get_stream(uint32_t device_id) const;
+
+        /**
+         * @brief Move the head of the stream to the next valid message header without moving the buffered data.
+         * Candidates are found with a block wise search for the sync byte and validated in place by the header crc8.
+         *
+         * @param stream The device stream.
+         * @return true, when a valid header was found and the message length is set.
+         * @return false, when more data is needed.
+         */
+        static bool synchronise(Stream &stream);
+
+        /**
+         * @brief Get the receive time of the buffered frame which contains the given buffer position.
+         *
+         * @param stream The device stream.
+         * @param position The position in the buffer.
+         * @return uint64_t as receive time in nanoseconds since epoch.
+         */
+        static uint64_t get_frame_time(const Stream &stream, size_t position);
+
+        /**
+         * @brief Drop the consumed data in front of the head of the stream.
+         *
+         * @param stream The device stream.
+         */
+        static void compact(Stream &stream);
+
+    public:
+        /**
+         * @brief Construct a new Reassembler object with all known RoboMaster devices enabled.
+         */
+        Reassembler();
+
+        /**
+         * @brief Enable the reassembly for the given device id. Must not be called while frames are pushed from another thread.
+         *
+         * @param device_id The can device id.
+         * @return true, when the device id is in range of the reassembler.
+         * @return false, when the device id is out of range.
+         */
+        bool enable_device(uint32_t device_id);
+
+        /**
+         * @brief Disable the reassembly for the given device id and drop its buffered data. Must not be called while frames are pushed from another thread.
+         *
+         * @param device_id The can device id.
+         */
+        void disable_device(uint32_t device_id);
+
+        /**
+         * @brief True when frames of the given device id are reassembled.
+         *
+         * @param device_id The can device id.
+         * @return true, when enabled.
+         * @return false, when disabled or out of range.
+         */
+        bool is_enabled(uint32_t device_id) const;
+
+        /**
+         * @brief Append a can frame to the stream of its device and collect every completed message.
+         *
+         * @param device_id The can device id of the frame.
+         * @param data The data of the can frame.
+         * @param length The length of the data.
+         * @param messages Completed messages with valid crc are appended to this vector. The messages carry the receive times of their first and last frame.
+         * @param timestamp The receive time of the can frame in nanoseconds since epoch.
+         * @return size_t as number of appended messages.
+         */
+        size_t push_frame(uint32_t device_id, const uint8_t *data, size_t length, std::vector<Message> &messages, uint64_t timestamp=0);
+
+        /**
+         * @brief Get the counters of the given device id. The counters may be read from any thread.
+         *
+         * @param device_id The can device id.
+         * @return StreamStatistics of the device, all zero when the device id is out of range.
+         */
+        StreamStatistics get_statistics(uint32_t device_id) const;
+
+        /**
+         * @brief Drop the buffered data of all streams.
+         */
+        void reset();
+
+        /**
+         * @brief Set the counters of all streams to zero. Must not be called while frames are pushed from another thread.
+         */
+        void reset_statistics();
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_REASSEMBLER_H_
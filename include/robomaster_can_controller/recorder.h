@@ -0,0 +1,284 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_RECORDER_H_
+#define ROBOMASTER_CAN_CONTROLLER_RECORDER_H_
+
+#include "transport.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The type of a record in the log file.
+     */
+    enum RecordType : uint8_t {
+        RECORD_NONE = 0,
+        RECORD_RECEIVE = 1,
+        RECORD_TRANSMIT = 2,
+        RECORD_INDEX = 3
+    };
+
+    /**
+     * @brief The magic at the beginning of every log file.
+     */
+    static constexpr char RECORD_MAGIC[8] = { 'R', 'M', 'C', 'A', 'N', 'L', 'O', 'G' };
+
+    /**
+     * @brief The version of the log format.
+     */
+    static constexpr uint32_t RECORD_VERSION = 1;
+
+    /**
+     * @brief The header at the beginning of the log file. All values are stored in host byte order.
+     */
+    struct RecordFileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+
+        /**
+         * @brief Every index_interval-th record is an index record, starting with the first record.
+         */
+        uint32_t index_interval;
+        uint32_t reserved_0;
+
+        /**
+         * @brief The time the log was opened in nanoseconds since epoch.
+         */
+        uint64_t start_time;
+
+        /**
+         * @brief The number of records including the index records, zero when the log was not closed.
+         */
+        uint64_t record_count;
+        uint8_t reserved_1[24];
+    };
+    static_assert(sizeof(RecordFileHeader) == 64);
+
+    /**
+     * @brief A single fixed size record of the log file.
+     * For frame records the sequence is the number of the frame in the log. An index record holds the timestamp and the sequence of the
+     * following frame record, so the log can be searched by time without reading the frames.
+     */
+    struct Record {
+        uint64_t timestamp;
+        uint32_t id;
+        uint8_t type;
+        uint8_t length;
+        uint16_t reserved;
+        uint8_t data[8];
+        uint64_t sequence;
+    };
+    static_assert(sizeof(Record) == 32);
+
+    /**
+     * @brief Counters of the recorder.
+     */
+    struct RecorderStatistics {
+        /**
+         * @brief Number of frames accepted into the ring.
+         */
+        uint64_t recorded = 0;
+
+        /**
+         * @brief Number of frames dropped because the ring was full or the log was not open.
+         */
+        uint64_t dropped = 0;
+
+        /**
+         * @brief Number of records written to the log file including the index records.
+         */
+        uint64_t written = 0;
+    };
+
+    /**
+     * @brief This class records can frames into an append-only binary log. The recording threads only copy the frame into a lock-free ring,
+     * a background thread writes the records into the memory mapped log file. When the ring is full the frame is dropped and counted
+     * instead of blocking the caller.
+     */
+    class Recorder {
+        /**
+         * @brief A slot of the ring with the sequence of the bounded multi producer queue.
+         */
+        struct Slot {
+            std::atomic<uint64_t> sequence;
+            Record record;
+        };
+
+        /**
+         * @brief The slots of the ring.
+         */
+        std::unique_ptr<Slot[]> slots_;
+
+        /**
+         * @brief The number of slots minus one, the number of slots is a power of two.
+         */
+        size_t mask_;
+
+        /**
+         * @brief The next position to enqueue, shared by all recording threads.
+         */
+        alignas(64) std::atomic<uint64_t> head_;
+
+        /**
+         * @brief The next position to dequeue, only used by the writer thread.
+         */
+        alignas(64) uint64_t tail_;
+
+        /**
+         * @brief Counters of the recording threads.
+         */
+        alignas(64) std::atomic<uint64_t> recorded_;
+        std::atomic<uint64_t> dropped_;
+
+        /**
+         * @brief Number of written records.
+         */
+        std::atomic<uint64_t> written_;
+
+        /**
+         * @brief The file descriptor of the log file.
+         */
+        int fd_;
+
+        /**
+         * @brief The currently mapped chunk of the log file.
+         */
+        uint8_t *chunk_;
+
+        /**
+         * @brief The file offset of the mapped chunk.
+         */
+        size_t chunk_offset_;
+
+        /**
+         * @brief The file offset of the next record.
+         */
+        size_t offset_;
+
+        /**
+         * @brief The number of written frame records.
+         */
+        uint64_t sequence_;
+
+        /**
+         * @brief The interval of the index records.
+         */
+        uint32_t index_interval_;
+
+        /**
+         * @brief Background thread which writes the records.
+         */
+        std::thread thread_;
+
+        /**
+         * @brief True while the log is open and frames are accepted.
+         */
+        std::atomic<bool> flag_open_;
+
+        /**
+         * @brief Flag to stop the writer thread.
+         */
+        std::atomic<bool> flag_stop_;
+
+        /**
+         * @brief Take the next record from the ring.
+         *
+         * @param record The record.
+         * @return true, when a record was taken.
+         * @return false, when the ring is empty.
+         */
+        bool pop(Record &record);
+
+        /**
+         * @brief Write a record at the end of the log file and map the next chunk when needed.
+         *
+         * @param record The record.
+         * @return true, by success.
+         * @return false, when the log file could not grow.
+         */
+        bool write_record(const Record &record);
+
+        /**
+         * @brief Run function of the writer thread.
+         */
+        void start_writer_thread();
+
+    public:
+        /**
+         * @brief Construct a new Recorder object.
+         *
+         * @param capacity The number of frames the ring can hold, rounded up to a power of two.
+         * @param index_interval The interval of the index records.
+         */
+        explicit Recorder(size_t capacity=65536, uint32_t index_interval=1024);
+
+        /**
+         * @brief Destroy the Recorder object and close the log.
+         */
+        ~Recorder();
+
+        Recorder(const Recorder&) = delete;
+        Recorder &operator=(const Recorder&) = delete;
+
+        /**
+         * @brief Create the log file and start the writer thread.
+         *
+         * @param path The path of the log file, an existing file is truncated.
+         * @return true, when the log is open.
+         * @return false, when the log is already open or the file could not be created.
+         */
+        bool open(const std::string &path);
+
+        /**
+         * @brief Write all recorded frames, stop the writer thread and close the log file.
+         */
+        void close();
+
+        /**
+         * @brief True while the log is open.
+         *
+         * @return true, when open.
+         * @return false, when closed.
+         */
+        bool is_open() const;
+
+        /**
+         * @brief Record a frame. This function never blocks, a frame without timestamp is stamped with the current time.
+         *
+         * @param frame The can frame.
+         * @param type The direction of the frame, RECORD_RECEIVE or RECORD_TRANSMIT.
+         * @return true, when the frame was recorded.
+         * @return false, when the frame was dropped.
+         */
+        bool record(const CanFrame &frame, RecordType type);
+
+        /**
+         * @brief Record multiple frames.
+         *
+         * @param frames The can frames.
+         * @param count The number of can frames.
+         * @param type The direction of the frames, RECORD_RECEIVE or RECORD_TRANSMIT.
+         * @return size_t as number of recorded frames.
+         */
+        size_t record(const CanFrame *frames, size_t count, RecordType type);
+
+        /**
+         * @brief Get the counters.
+         *
+         * @return RecorderStatistics as counters.
+         */
+        RecorderStatistics get_statistics() const;
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_RECORDER_H_
@@ -0,0 +1,205 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_REPLAY_H_
+#define ROBOMASTER_CAN_CONTROLLER_REPLAY_H_
+
+#include "data.h"
+#include "reassembler.h"
+#include "robomaster.h"
+#include "transport.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The pacing of the replay.
+     */
+    enum ReplayMode {
+        REPLAY_FAST,
+        REPLAY_REALTIME
+    };
+
+    /**
+     * @brief The latency of a single processing stage.
+     */
+    struct StageLatency {
+        /**
+         * @brief Number of measured calls.
+         */
+        uint64_t count = 0;
+
+        /**
+         * @brief Sum of the latencies in nanoseconds.
+         */
+        uint64_t total = 0;
+
+        /**
+         * @brief Largest latency in nanoseconds.
+         */
+        uint64_t max = 0;
+    };
+
+    /**
+     * @brief Counters and latencies of a replay run.
+     */
+    struct ReplayStatistics {
+        /**
+         * @brief Number of replayed can frames.
+         */
+        uint64_t frames = 0;
+
+        /**
+         * @brief Number of reassembled messages.
+         */
+        uint64_t messages = 0;
+
+        /**
+         * @brief Number of decoded RoboMasterState messages.
+         */
+        uint64_t states = 0;
+
+        /**
+         * @brief Wall time of the run in nanoseconds.
+         */
+        uint64_t duration = 0;
+
+        /**
+         * @brief Reassembled messages per second of wall time.
+         */
+        double messages_per_second = 0.0;
+
+        /**
+         * @brief Latency of the reassembler per can frame.
+         */
+        StageLatency reassembly;
+
+        /**
+         * @brief Latency of the handler per message except the RoboMasterState messages, including the callbacks.
+         */
+        StageLatency dispatch;
+
+        /**
+         * @brief Latency of the handler per RoboMasterState message, including the decoding, the clock synchronisation and the callbacks.
+         */
+        StageLatency decode;
+    };
+
+    /**
+     * @brief Load the received frames of a log which was written by the Recorder.
+     *
+     * @param path The path of the log file.
+     * @param frames The loaded frames are appended.
+     * @param include_transmit True to load the sent frames as well.
+     * @return true, when the log is valid.
+     * @return false, when the file could not be read or is no recorder log.
+     */
+    bool load_record_log(const std::string &path, std::vector<CanFrame> &frames, bool include_transmit=false);
+
+    /**
+     * @brief Load the frames of a candump log file, the format of candump -l with lines like "(1700000000.123456) can0 202#5511...".
+     *
+     * @param path The path of the log file.
+     * @param frames The loaded frames are appended, remote and can fd frames are skipped.
+     * @return true, when the file was read.
+     * @return false, when the file could not be read or contains a malformed line.
+     */
+    bool load_candump_log(const std::string &path, std::vector<CanFrame> &frames);
+
+    /**
+     * @brief Load a recorder log or a candump log, the format is detected by the magic of the recorder log.
+     *
+     * @param path The path of the log file.
+     * @param frames The loaded frames are appended.
+     * @return true, when the log was read.
+     * @return false, when the log could not be read.
+     */
+    bool load_log(const std::string &path, std::vector<CanFrame> &frames);
+
+    /**
+     * @brief Write a frame as line of a candump log without newline into the buffer, e.g. "(1700000000.123456) can0 202#5511...".
+     * The line is read again by load_candump_log, the receive time is cut to microseconds like by candump.
+     *
+     * @param frame The frame.
+     * @param interface The name of the can interface.
+     * @param buffer The buffer, not null terminated.
+     * @param size The size of the buffer.
+     * @return size_t as number of written characters, 0 when the buffer is too small.
+     */
+    size_t to_candump(const CanFrame &frame, const std::string &interface, char *buffer, size_t size);
+
+    /**
+     * @brief This class replays recorded can frames through the same reassembly, dispatch and decoding path as the Handler and RoboMaster class.
+     * Every reassembled message is processed by the handler of a RoboMaster which is never initialised, so no thread or can socket is used.
+     * The receive times of the log are kept, so the decoded data of a replay are reproducible.
+     */
+    class Replay {
+        /**
+         * @brief Reassembler for the messages of all known devices.
+         */
+        Reassembler reassembler_;
+
+        /**
+         * @brief The RoboMaster which decodes the messages, with the clock synchronisation of the live path.
+         */
+        RoboMaster robomaster_;
+
+        /**
+         * @brief Callback for the decoded RoboMasterState.
+         */
+        std::function<void(const DataRoboMasterState&)> callback_data_robomaster_state_;
+
+        /**
+         * @brief The statistics of the current run.
+         */
+        ReplayStatistics statistics_;
+
+    public:
+        /**
+         * @brief Construct a new Replay object.
+         */
+        Replay();
+
+        /**
+         * @brief Set the callback for the decoded RoboMasterState.
+         *
+         * @param func The callback function.
+         */
+        void set_callback(std::function<void(const DataRoboMasterState&)> func);
+
+        /**
+         * @brief Bind the given callback for triggering when a message with the given device id, type and payload prefix is replayed.
+         *
+         * @param device_id The can device id of the sender.
+         * @param type The message type.
+         * @param prefix The bytes which must match the beginning of the payload. An empty prefix matches every payload.
+         * @param func The callback to trigger.
+         */
+        void bind_callback(uint32_t device_id, uint16_t type, std::vector<uint8_t> prefix, std::function<void(const Message&)> func);
+
+        /**
+         * @brief Replay the frames from a fresh reassembler state with stream counters starting at zero.
+         *
+         * @param frames The frames ordered by receive time.
+         * @param mode REPLAY_FAST replays as fast as possible, REPLAY_REALTIME keeps the original time between the frames.
+         * @return ReplayStatistics of the run.
+         */
+        ReplayStatistics run(const std::vector<CanFrame> &frames, ReplayMode mode=REPLAY_FAST);
+
+        /**
+         * @brief Get the counters of the reassembled stream of the given device id during the last run.
+         *
+         * @param device_id The can device id.
+         * @return StreamStatistics of the device.
+         */
+        StreamStatistics get_stream_statistics(uint32_t device_id) const;
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_REPLAY_H_
@@ -8,20 +8,170 @@
 #define ROBOMASTER_CAN_CONTROLLER_ROBOMASTER_H_
 
 #include "handler.h"
+#include "command.h"
+#include "fleet.h"
 #include "data.h"
+#include "clock_sync.h"
+#include "telemetry.h"
+#include "history.h"
+#include "state_log.h"
+
+#include <mutex>
 
 namespace robomaster_can_controller {
+    class RoboMaster;
+
+    /**
+     * @brief The maximal number of commands of a CommandBatch, the size of the sender queue.
+     */
+    static constexpr size_t COMMAND_BATCH_MAX_SIZE = QUEUE_MSG_MAX_SIZE;
+
     /**
-     * @brief The blaster type
+     * @brief This class collects the commands of one control tick, e.g. wheels, LEDs and gimbal, and commits them together.
+     * The commands are pushed into the sender queue with a single lock and a single wakeup of the sender, which sends their
+     * frames back to back with one batch call of the transport and without a heartbeat in between. The sequence numbers are
+     * assigned by commit, a batch is created by RoboMaster::batch and used by the thread which controls the RoboMaster.
      */
-    enum BlasterType {
-        INFRARED,
-        GELBEADS
+    class CommandBatch {
+        /**
+         * @brief The RoboMaster of the batch.
+         */
+        RoboMaster &robomaster_;
+
+        /**
+         * @brief The collected commands.
+         */
+        std::vector<Message> messages_;
+
+        /**
+         * @brief True for the commands which get the next sequence of their type at commit, the work mode keeps sequence 0.
+         */
+        std::vector<bool> sequenced_;
+
+        /**
+         * @brief Add a command, its sequence is assigned at commit.
+         */
+        CommandBatch &add(Message msg, bool sequenced=true);
+
+    public:
+        /**
+         * @brief Construct a new empty CommandBatch object.
+         *
+         * @param robomaster The RoboMaster, must outlive the batch.
+         */
+        explicit CommandBatch(RoboMaster &robomaster);
+
+        /**
+         * @brief Add the command to enable or disable the work mode of the chassis.
+         */
+        CommandBatch &set_work_mode(bool mode);
+
+        /**
+         * @brief Add the command to drive with the given velocities.
+         *
+         * @param x Linear x velocity in m/s.
+         * @param y Linear y velocity in m/s.
+         * @param z Angular velocity in radiant/s.
+         */
+        CommandBatch &set_velocity(float x, float y, float z);
+
+        /**
+         * @brief Add the command to control each individual wheel in rpm.
+         *
+         * @param fr Front right wheel in rpm.
+         * @param fl Front left wheel in rpm.
+         * @param rl Rear left wheel in rpm.
+         * @param rr Rear right wheel in rpm.
+         */
+        CommandBatch &set_wheel_rpm(int16_t fr, int16_t fl, int16_t rl, int16_t rr);
+
+        /**
+         * @brief Add the command to stop with zero velocities.
+         */
+        CommandBatch &set_brake();
+
+        /**
+         * @brief Add the command to control the gimbal.
+         *
+         * @param y Angular y velocity in radiant/s
+         * @param z Angular z velocity in radiant/s
+         */
+        CommandBatch &set_gimbal(int16_t y, int16_t z);
+
+        /**
+         * @brief Add the command to fire the blaster.
+         */
+        CommandBatch &set_blaster(BlasterType blaster);
+
+        /**
+         * @brief Add the command to set the LED off by the given mask.
+         *
+         * @param mask Mask for selecting the LED, e.g. LED_MASK_ALL.
+         */
+        CommandBatch &set_led_off(uint16_t mask);
+
+        /**
+         * @brief Add the command to set the LED on by the given mask.
+         *
+         * @param mask Mask for selecting the LED, e.g. LED_MASK_ALL.
+         * @param r Red value colour between 0-255.
+         * @param g Green value colour between 0-255.
+         * @param b Blue value colour between 0-255.
+         */
+        CommandBatch &set_led_on(uint16_t mask, uint8_t r, uint8_t g, uint8_t b);
+
+        /**
+         * @brief Add the command to set the LED with a breath effect.
+         *
+         * @param mask Mask for selecting the LED, e.g. LED_MASK_ALL.
+         * @param r Red value colour between 0-255.
+         * @param g Green value colour between 0-255.
+         * @param b Blue value colour between 0-255.
+         * @param t_rise The rising time of the LED in milliseconds.
+         * @param t_down The falling time of the LED in milliseconds.
+         */
+        CommandBatch &set_led_breath(uint16_t mask, uint8_t r, uint8_t g, uint8_t b, uint16_t t_rise, uint16_t t_down);
+
+        /**
+         * @brief Add the command to set the LED with a flash effect.
+         *
+         * @param mask Mask for selecting the LED, e.g. LED_MASK_ALL.
+         * @param r Red value colour between 0-255.
+         * @param g Green value colour between 0-255.
+         * @param b Blue value colour between 0-255.
+         * @param t_on The on time of the LED in milliseconds.
+         * @param t_off The off time of the LED in milliseconds.
+         */
+        CommandBatch &set_led_flash(uint16_t mask, uint8_t r, uint8_t g, uint8_t b, uint16_t t_on, uint16_t t_off);
+
+        /**
+         * @brief Get the number of collected commands.
+         *
+         * @return size_t as number of commands.
+         */
+        size_t size() const;
+
+        /**
+         * @brief Assign the sequences, push all collected commands to the sender and clear the batch, so it can be used for the next
+         * control tick. The commands of the sender queue are never evicted for a batch. With a CommandIngress every command is
+         * arbitrated on its own channel, so the commands of a channel owned by a client with a higher priority are discarded and
+         * the rest of the batch is sent.
+         *
+         * @return true, by success.
+         * @return false, when the batch has more than COMMAND_BATCH_MAX_SIZE commands or does not fit into the sender queue, the batch is discarded.
+         */
+        bool commit();
+
+        /**
+         * @brief Discard all collected commands.
+         */
+        void clear();
     };
 
     /**
      * @brief This class manage the control of the RoboMaster via can socket.
-     *
+     * The setters of the recorder, publisher, history, log and ingress return when no thread uses the previous object anymore,
+     * so it can be destroyed as soon as it was replaced or set to nullptr.
      */
     class RoboMaster {
         /**
@@ -35,24 +185,36 @@ namespace robomaster_can_controller {
         std::function<void(const DataRoboMasterState &)> callback_data_robomaster_state_;
 
         /**
-         * @brief Counter for the message sequence of the drive messages.
+         * @brief Clock synchronisation between the ESC timestamps of the motion controller and the host receive times.
          */
-        uint16_t counter_drive_;
+        ClockSync clock_sync_;
 
         /**
-         * @brief Counter for the message sequence of the LED messages.
+         * @brief The publisher of the decoded states for other processes, nullptr when disabled.
          */
-        uint16_t counter_led_;
+        TelemetryPublisher *telemetry_publisher_;
 
         /**
-        * @brief Counter for the message sequence of the gimbal messages.
-        */
-        uint16_t counter_gimbal_;
+         * @brief The history of the decoded states, nullptr when disabled.
+         */
+        StateHistory *history_;
 
         /**
-        * @brief Counter for the message sequence of the blaster messages.
-        */
-        uint16_t counter_blaster_;
+         * @brief The log of the decoded states, nullptr when disabled.
+         */
+        StateLog *state_log_;
+
+        /**
+         * @brief Mutex for the publisher, history and log, held by the decoding and by their setters.
+         */
+        std::mutex attach_mutex_;
+
+        /**
+         * @brief Push a command with the next sequence of its type, shared with the commands of the ingress.
+         *
+         * @param msg The command.
+         */
+        void push_command(Message msg);
 
         /**
          * @brief The boot sequence to configure the RoboMasterState messages.
@@ -66,6 +228,9 @@ namespace robomaster_can_controller {
          */
         void decode_state(const Message &msg);
 
+        friend class CommandBatch;
+        friend class Replay;
+
     public:
         /**
          * @brief Constructor of the RoboMaster class.
@@ -202,6 +367,14 @@ namespace robomaster_can_controller {
          */
         void set_led_flash(uint16_t mask, uint8_t r, uint8_t g, uint8_t b, float rate);
 
+        /**
+         * @brief Create a batch to send several commands of one control tick together, e.g.
+         * robomaster.batch().set_wheel_rpm(100, -100, -100, 100).set_led_on(LED_MASK_ALL, 0, 255, 0).commit().
+         *
+         * @return CommandBatch as empty batch.
+         */
+        CommandBatch batch();
+
         /**
          * @brief Bind a function to the callback which get triggered when a new RoboMasterState message is received.
          *
@@ -209,6 +382,17 @@ namespace robomaster_can_controller {
          */
         void set_callback(std::function<void(const DataRoboMasterState&)> func);
 
+        /**
+         * @brief Bind a function to the callback which get triggered when a message with the given device id, type and payload prefix is received.
+         * This gives access to message types which are not decoded by the library, e.g. command acknowledgements.
+         *
+         * @param device_id The can device id of the sender, e.g. DEVICE_ID_MOTION_CONTROLLER.
+         * @param type The message type.
+         * @param prefix The bytes which must match the beginning of the payload. An empty prefix matches every payload.
+         * @param func Function to bind as callback.
+         */
+        void set_callback(uint32_t device_id, uint16_t type, std::vector<uint8_t> prefix, std::function<void(const Message&)> func);
+
         /**
          * @brief Init the RoboMaster can socket to communicate with the motion controller.
          *
@@ -218,12 +402,85 @@ namespace robomaster_can_controller {
          */
         bool init(const std::string &can_interface="can0");
 
+        /**
+         * @brief Init the RoboMaster can socket on the shared threads of a fleet instead of own threads.
+         *
+         * @param fleet The initialised fleet, e.g. shared by the RoboMasters of all can interfaces of the host.
+         * @param can_interface Can interface name.
+         * @return true, by success.
+         * @return false, when initialization failed.
+         */
+        bool init(Fleet &fleet, const std::string &can_interface="can0");
+
         /**
          * @brief True when the robomaster is successful initialized and ready to receive and send messages.
          *
          * @return true if the robomaster is successful initialized and is running. false when a can error is appeared.
          */
         bool is_running() const;
+
+        /**
+         * @brief Get the throughput counters of the received stream of the given device id.
+         *
+         * @param device_id The can device id, e.g. DEVICE_ID_MOTION_CONTROLLER.
+         * @return StreamStatistics of the device.
+         */
+        StreamStatistics get_stream_statistics(uint32_t device_id) const;
+
+        /**
+         * @brief Enable or disable the recording of all received and sent can frames at runtime.
+         * Returns when the previous object is no longer used.
+         *
+         * @param recorder The open recorder, nullptr disables the recording.
+         */
+        void set_recorder(Recorder *recorder);
+
+        /**
+         * @brief Enable or disable the publication of the decoded states into shared memory at runtime.
+         * Returns when the previous object is no longer used.
+         *
+         * @param publisher The open publisher, nullptr disables the publication.
+         */
+        void set_telemetry_publisher(TelemetryPublisher *publisher);
+
+        /**
+         * @brief Enable or disable the history of the decoded states at runtime, the receiver thread is the single writer.
+         * Returns when the previous object is no longer used.
+         *
+         * @param history The history, nullptr disables the history.
+         */
+        void set_history(StateHistory *history);
+
+        /**
+         * @brief Enable or disable the log of the decoded states at runtime, the receiver thread is the single producer.
+         * Returns when the previous object is no longer used.
+         *
+         * @param log The open log, nullptr disables the log.
+         */
+        void set_state_log(StateLog *log);
+
+        /**
+         * @brief Enable or disable the commands of other processes at runtime, e.g. of a teleoperation and a safety monitor.
+         * Returns when the previous object is no longer used.
+         *
+         * @param ingress The open ingress, nullptr disables the commands of other processes.
+         */
+        void set_command_ingress(CommandIngress *ingress);
+
+        /**
+         * @brief Get the latency of the commands per channel, from the call of e.g. set_velocity until the frames are written
+         * and until the acknowledgement of the RoboMaster is received for commands which request one.
+         *
+         * @return std::vector<ChannelLatency> ordered by device id and type.
+         */
+        std::vector<ChannelLatency> get_latency_statistics() const;
+
+        /**
+         * @brief Get a snapshot of the runtime metrics, e.g. for the export with to_prometheus.
+         *
+         * @return MetricsSnapshot of the handler.
+         */
+        MetricsSnapshot get_metrics() const;
     };
 } // namespace robomaster_can_controller
 
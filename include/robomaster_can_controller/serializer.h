@@ -0,0 +1,65 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_SERIALIZER_H_
+#define ROBOMASTER_CAN_CONTROLLER_SERIALIZER_H_
+
+#include "data.h"
+
+#include <cstddef>
+#include <cstdio>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The size of a buffer which holds every serialized state and the CSV header.
+     */
+    static constexpr size_t SERIALIZER_MAX_SIZE = 1024;
+
+    /**
+     * @brief Serialize a state as JSON into the buffer. The output equals the output of the stream operator, with timestamp the
+     * output of print_with_timestamp. The floats are formatted by std::to_chars with the general format and a precision of 6,
+     * independent of the locale and without allocation.
+     *
+     * @param data The state.
+     * @param buffer The buffer, not null terminated.
+     * @param size The size of the buffer.
+     * @param timestamp True to add the receive times as key timestamp.
+     * @return size_t as number of written characters, 0 when the buffer is too small.
+     */
+    size_t to_json(const DataRoboMasterState &data, char *buffer, size_t size, bool timestamp=false);
+
+    /**
+     * @brief Serialize a state as CSV line without newline into the buffer, the columns of a part without data are empty.
+     *
+     * @param data The state.
+     * @param buffer The buffer, not null terminated.
+     * @param size The size of the buffer.
+     * @return size_t as number of written characters, 0 when the buffer is too small.
+     */
+    size_t to_csv(const DataRoboMasterState &data, char *buffer, size_t size);
+
+    /**
+     * @brief Write the CSV header without newline into the buffer, the columns are named by the keys of the JSON output, e.g. imu.accel.0.
+     *
+     * @param buffer The buffer, not null terminated.
+     * @param size The size of the buffer.
+     * @return size_t as number of written characters, 0 when the buffer is too small.
+     */
+    size_t to_csv_header(char *buffer, size_t size);
+
+    /**
+     * @brief Write the serialized characters of the buffer followed by a newline, the newline is not written into the buffer.
+     *
+     * @param file The file, e.g. stdout.
+     * @param buffer The buffer of the serializer.
+     * @param size The number of serialized characters, 0 writes nothing.
+     * @return true, by success.
+     * @return false, when nothing was serialized or the write failed.
+     */
+    bool write_line(std::FILE *file, const char *buffer, size_t size);
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_SERIALIZER_H_
@@ -0,0 +1,353 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_STATE_LOG_H_
+#define ROBOMASTER_CAN_CONTROLLER_STATE_LOG_H_
+
+#include "data.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The magic at the beginning of every state log.
+     */
+    static constexpr char STATE_LOG_MAGIC[8] = { 'R', 'M', 'S', 'T', 'A', 'T', 'E', 'S' };
+
+    /**
+     * @brief The magic at the beginning of every block.
+     */
+    static constexpr char STATE_LOG_BLOCK_MAGIC[4] = { 'R', 'M', 'S', 'B' };
+
+    /**
+     * @brief The version of the log format.
+     */
+    static constexpr uint32_t STATE_LOG_VERSION = 1;
+
+    /**
+     * @brief The maximum number of states of a block, a reader rejects a larger block before its states are allocated.
+     */
+    static constexpr size_t STATE_LOG_MAX_BLOCK_SIZE = 65536;
+
+    /**
+     * @brief The header at the beginning of the state log. All values are stored in host byte order.
+     */
+    struct StateLogHeader {
+        char magic[8];
+        uint32_t version;
+
+        /**
+         * @brief The maximum number of states of a block.
+         */
+        uint32_t block_size;
+
+        /**
+         * @brief The time the log was opened in nanoseconds since epoch.
+         */
+        uint64_t start_time;
+        uint8_t reserved[40];
+    };
+    static_assert(sizeof(StateLogHeader) == 64);
+
+    /**
+     * @brief The header of a block, followed by size bytes with the columns of count states. Every column is encoded on its own:
+     * the integers as zigzag varints of the delta to the previous state, the receive times of the delta of the deltas, and
+     * the floats by the XOR with the previous value as in the Gorilla time series compression.
+     */
+    struct StateLogBlock {
+        char magic[4];
+        uint32_t count;
+        uint32_t size;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(StateLogBlock) == 16);
+
+    /**
+     * @brief Counters of the state log.
+     */
+    struct StateLogStatistics {
+        /**
+         * @brief Number of states accepted into the ring.
+         */
+        uint64_t pushed = 0;
+
+        /**
+         * @brief Number of states dropped because the ring was full or the log was not open.
+         */
+        uint64_t dropped = 0;
+
+        /**
+         * @brief Number of states written to the log file.
+         */
+        uint64_t written = 0;
+
+        /**
+         * @brief Number of written blocks.
+         */
+        uint64_t blocks = 0;
+
+        /**
+         * @brief Number of bytes of the log file.
+         */
+        uint64_t bytes = 0;
+    };
+
+    /**
+     * @brief Encode the columns of states into a block payload.
+     *
+     * @param states The states.
+     * @param count The number of states.
+     * @param payload The payload, the encoded columns are appended.
+     */
+    void encode_state_block(const DataRoboMasterState *states, size_t count, std::vector<uint8_t> &payload);
+
+    /**
+     * @brief Decode the columns of a block payload.
+     *
+     * @param payload The payload.
+     * @param size The size of the payload.
+     * @param count The number of states of the block.
+     * @param states The decoded states.
+     * @return true, by success.
+     * @return false, when the payload is truncated or corrupt or the count exceeds STATE_LOG_MAX_BLOCK_SIZE or the payload.
+     */
+    bool decode_state_block(const uint8_t *payload, size_t size, size_t count, std::vector<DataRoboMasterState> &states);
+
+    /**
+     * @brief This class writes the decoded states into a compact columnar log, e.g. for hours of field runs. The receiver thread
+     * only copies the state into a single producer ring, a background thread collects the states into blocks, encodes and
+     * writes them. When the ring is full the state is dropped and counted instead of blocking the receiver thread.
+     * A block is written when it is full or the log is closed, so a crash loses at most the states of one block.
+     */
+    class StateLog {
+        /**
+         * @brief The states of the ring.
+         */
+        std::unique_ptr<DataRoboMasterState[]> ring_;
+
+        /**
+         * @brief The number of states of the ring minus one, the number of states is a power of two.
+         */
+        size_t mask_;
+
+        /**
+         * @brief The next position to push, only written by the producer.
+         */
+        alignas(64) std::atomic<uint64_t> head_;
+
+        /**
+         * @brief Incremented for every push and by close, the writer thread waits on it as futex when the ring is empty.
+         */
+        std::atomic<uint32_t> signal_;
+
+        /**
+         * @brief The next position to pop, only written by the writer thread.
+         */
+        alignas(64) std::atomic<uint64_t> tail_;
+
+        /**
+         * @brief True while the writer thread waits, the producer only wakes up the futex when the writer waits.
+         */
+        std::atomic<bool> waiting_;
+
+        /**
+         * @brief Counters.
+         */
+        alignas(64) std::atomic<uint64_t> pushed_;
+        std::atomic<uint64_t> dropped_;
+        std::atomic<uint64_t> written_;
+        std::atomic<uint64_t> blocks_;
+        std::atomic<uint64_t> bytes_;
+
+        /**
+         * @brief The file descriptor of the log file.
+         */
+        int fd_;
+
+        /**
+         * @brief The maximum number of states of a block.
+         */
+        size_t block_size_;
+
+        /**
+         * @brief Background thread which encodes and writes the blocks.
+         */
+        std::thread thread_;
+
+        /**
+         * @brief True while the log is open and states are accepted.
+         */
+        std::atomic<bool> flag_open_;
+
+        /**
+         * @brief Flag to stop the writer thread.
+         */
+        std::atomic<bool> flag_stop_;
+
+        /**
+         * @brief Write the buffer to the log file.
+         *
+         * @return true, by success.
+         */
+        bool write_all(const uint8_t *data, size_t size);
+
+        /**
+         * @brief Encode and write a block.
+         *
+         * @return true, by success.
+         */
+        bool write_block(const std::vector<DataRoboMasterState> &states, std::vector<uint8_t> &buffer);
+
+        /**
+         * @brief Run function of the writer thread.
+         */
+        void start_writer_thread();
+
+    public:
+        /**
+         * @brief Construct a new StateLog object.
+         *
+         * @param capacity The number of states the ring can hold, rounded up to a power of two.
+         * @param block_size The maximum number of states of a block, the default is 10 s at 50 Hz, at most STATE_LOG_MAX_BLOCK_SIZE.
+         */
+        explicit StateLog(size_t capacity=1024, size_t block_size=500);
+
+        /**
+         * @brief Destroy the StateLog object and close the log.
+         */
+        ~StateLog();
+
+        StateLog(const StateLog&) = delete;
+        StateLog &operator=(const StateLog&) = delete;
+
+        /**
+         * @brief Create the log file and start the writer thread.
+         *
+         * @param path The path of the log file, an existing file is truncated.
+         * @return true, when the log is open.
+         * @return false, when the log is already open or the file could not be created.
+         */
+        bool open(const std::string &path);
+
+        /**
+         * @brief Write all pushed states, stop the writer thread and close the log file.
+         */
+        void close();
+
+        /**
+         * @brief True while the log is open.
+         *
+         * @return true, when open.
+         */
+        bool is_open() const;
+
+        /**
+         * @brief Push a state. This function never blocks, only a single thread may push.
+         *
+         * @param state The state.
+         * @return true, when the state was accepted.
+         * @return false, when the state was dropped.
+         */
+        bool push(const DataRoboMasterState &state);
+
+        /**
+         * @brief Get the counters.
+         *
+         * @return StateLogStatistics as counters.
+         */
+        StateLogStatistics get_statistics() const;
+    };
+
+    /**
+     * @brief This class reads a state log block by block, so logs of any length are read with the memory of a single block.
+     */
+    class StateLogReader {
+        /**
+         * @brief The file descriptor of the log file.
+         */
+        int fd_;
+
+        /**
+         * @brief The header of the log.
+         */
+        StateLogHeader header_;
+
+        /**
+         * @brief The states of the current block.
+         */
+        std::vector<DataRoboMasterState> states_;
+
+        /**
+         * @brief The index of the next state of the current block.
+         */
+        size_t index_;
+
+        /**
+         * @brief The payload of the current block.
+         */
+        std::vector<uint8_t> payload_;
+
+        /**
+         * @brief Read the next block.
+         *
+         * @return true, by success.
+         * @return false, at the end of the log or when the block is truncated or corrupt.
+         */
+        bool read_block();
+
+    public:
+        /**
+         * @brief Construct a new StateLogReader object.
+         */
+        StateLogReader();
+
+        /**
+         * @brief Destroy the StateLogReader object and close the log.
+         */
+        ~StateLogReader();
+
+        StateLogReader(const StateLogReader&) = delete;
+        StateLogReader &operator=(const StateLogReader&) = delete;
+
+        /**
+         * @brief Open a log file and check the header.
+         *
+         * @param path The path of the log file.
+         * @return true, by success.
+         * @return false, when the file does not exist or is no state log.
+         */
+        bool open(const std::string &path);
+
+        /**
+         * @brief Close the log file.
+         */
+        void close();
+
+        /**
+         * @brief Get the time the log was opened.
+         *
+         * @return uint64_t as time in nanoseconds since epoch.
+         */
+        uint64_t get_start_time() const;
+
+        /**
+         * @brief Read the next state.
+         *
+         * @param state The state.
+         * @return true, by success.
+         * @return false, at the end of the log. A block which was cut by a crash ends the log.
+         */
+        bool next(DataRoboMasterState &state);
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_STATE_LOG_H_
@@ -0,0 +1,266 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_TELEMETRY_H_
+#define ROBOMASTER_CAN_CONTROLLER_TELEMETRY_H_
+
+#include "data.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The magic at the beginning of a telemetry segment.
+     */
+    static constexpr char TELEMETRY_MAGIC[4] = { 'R', 'M', 'T', 'L' };
+
+    /**
+     * @brief The version of the segment layout.
+     */
+    static constexpr uint32_t TELEMETRY_VERSION = 1;
+
+    static_assert(std::is_trivially_copyable_v<DataRoboMasterState>, "the state is copied into shared memory");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free, "the atomics are shared between processes");
+
+    /**
+     * @brief A state of the history ring with its own sequence.
+     */
+    struct TelemetryEntry {
+        /**
+         * @brief Odd while the entry is written, 2 * (number + 1) for the state with the given publish number.
+         */
+        std::atomic<uint64_t> sequence;
+
+        /**
+         * @brief The state.
+         */
+        DataRoboMasterState state;
+    };
+
+    /**
+     * @brief The layout of the shared memory segment, followed by the entries of the history ring.
+     */
+    struct alignas(64) TelemetrySegment {
+        /**
+         * @brief The magic TELEMETRY_MAGIC.
+         */
+        char magic[4];
+
+        /**
+         * @brief The version TELEMETRY_VERSION.
+         */
+        uint32_t version;
+
+        /**
+         * @brief The size of DataRoboMasterState of the publisher.
+         */
+        uint32_t state_size;
+
+        /**
+         * @brief The number of entries of the history ring.
+         */
+        uint32_t capacity;
+
+        /**
+         * @brief The seqlock of the latest state, odd while it is written. It is also the futex word the readers wait on.
+         */
+        alignas(64) std::atomic<uint32_t> sequence;
+
+        /**
+         * @brief The number of published states.
+         */
+        std::atomic<uint64_t> count;
+
+        /**
+         * @brief The latest state.
+         */
+        DataRoboMasterState latest;
+    };
+
+    /**
+     * @brief This class publishes the decoded states into a POSIX shared memory segment for other processes. The segment holds the
+     * latest state behind a seqlock and a history ring of the last states, the readers wait on a futex. Publishing never blocks on a
+     * reader, a reader which is too slow misses the overwritten states of the ring. There must be a single publisher per segment.
+     */
+    class TelemetryPublisher {
+        /**
+         * @brief The shared memory object.
+         */
+        int fd_;
+
+        /**
+         * @brief The mapped segment.
+         */
+        TelemetrySegment *segment_;
+
+        /**
+         * @brief The size of the mapping.
+         */
+        size_t size_;
+
+        /**
+         * @brief The name of the shared memory object.
+         */
+        std::string name_;
+
+    public:
+        /**
+         * @brief Construct a new TelemetryPublisher object.
+         */
+        TelemetryPublisher();
+
+        /**
+         * @brief Destroy the TelemetryPublisher object and remove the segment.
+         */
+        ~TelemetryPublisher();
+
+        TelemetryPublisher(const TelemetryPublisher&) = delete;
+        TelemetryPublisher &operator=(const TelemetryPublisher&) = delete;
+
+        /**
+         * @brief Create the segment.
+         *
+         * @param name The name of the shared memory object, e.g. /robomaster.
+         * @param capacity The number of states of the history ring.
+         * @param replace True to remove an existing segment of the same name first, e.g. the stale segment of a crashed process.
+         * @return true, by success.
+         * @return false, when already open, a segment of the same name exists without replace or the segment could not be created.
+         */
+        bool open(const std::string &name, size_t capacity=256, bool replace=false);
+
+        /**
+         * @brief Unmap and remove the segment, mapped readers keep the last states.
+         */
+        void close();
+
+        /**
+         * @brief State if the segment is open.
+         *
+         * @return true, when open.
+         */
+        bool is_open() const;
+
+        /**
+         * @brief Publish a state as latest state and into the history ring and wake the waiting readers.
+         *
+         * @param state The state.
+         */
+        void publish(const DataRoboMasterState &state);
+
+        /**
+         * @brief Get the number of published states.
+         *
+         * @return uint64_t as count.
+         */
+        uint64_t get_count() const;
+    };
+
+    /**
+     * @brief This class reads the states of a TelemetryPublisher from another process. The segment is mapped read only, so a reader
+     * can never disturb the publisher or other readers.
+     */
+    class TelemetryReader {
+        /**
+         * @brief The shared memory object.
+         */
+        int fd_;
+
+        /**
+         * @brief The mapped segment.
+         */
+        const TelemetrySegment *segment_;
+
+        /**
+         * @brief The size of the mapping.
+         */
+        size_t size_;
+
+    public:
+        /**
+         * @brief Construct a new TelemetryReader object.
+         */
+        TelemetryReader();
+
+        /**
+         * @brief Destroy the TelemetryReader object and unmap the segment.
+         */
+        ~TelemetryReader();
+
+        TelemetryReader(const TelemetryReader&) = delete;
+        TelemetryReader &operator=(const TelemetryReader&) = delete;
+
+        /**
+         * @brief Map the segment of a publisher.
+         *
+         * @param name The name of the shared memory object.
+         * @return true, by success.
+         * @return false, when the segment does not exist or has an unknown layout.
+         */
+        bool open(const std::string &name);
+
+        /**
+         * @brief Unmap the segment.
+         */
+        void close();
+
+        /**
+         * @brief State if the segment is mapped.
+         *
+         * @return true, when mapped.
+         */
+        bool is_open() const;
+
+        /**
+         * @brief Get the number of states of the history ring.
+         *
+         * @return size_t as capacity.
+         */
+        size_t get_capacity() const;
+
+        /**
+         * @brief Get the number of published states.
+         *
+         * @return uint64_t as count.
+         */
+        uint64_t get_count() const;
+
+        /**
+         * @brief Read the latest state, retried while the publisher writes it.
+         *
+         * @param state The latest state.
+         * @param count The number of published states including the latest state.
+         * @return true, by success.
+         * @return false, when nothing is published yet.
+         */
+        bool read_latest(DataRoboMasterState &state, uint64_t &count) const;
+
+        /**
+         * @brief Read a state of the history ring.
+         *
+         * @param number The publish number of the state, starting at zero.
+         * @param state The state.
+         * @return true, by success.
+         * @return false, when the state is not published yet or already overwritten.
+         */
+        bool read(uint64_t number, DataRoboMasterState &state) const;
+
+        /**
+         * @brief Wait until more than the given number of states is published.
+         *
+         * @param count The number of states already seen.
+         * @param timeout The timeout in seconds, zero or negative waits without timeout.
+         * @return true, when a new state is published.
+         * @return false, by timeout.
+         */
+        bool wait(uint64_t count, double timeout=0.0) const;
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_TELEMETRY_H_
@@ -0,0 +1,238 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_TRACE_H_
+#define ROBOMASTER_CAN_CONTROLLER_TRACE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief A single trace event, a span with duration or an instant.
+     */
+    struct TraceEvent {
+        /**
+         * @brief The name of the event, must be a string with static lifetime.
+         */
+        const char *name = nullptr;
+
+        /**
+         * @brief The start in nanoseconds since epoch (CLOCK_REALTIME), the same clock as the kernel receive timestamps.
+         */
+        uint64_t start = 0;
+
+        /**
+         * @brief The duration in nanoseconds, zero for an instant.
+         */
+        uint64_t duration = 0;
+
+        /**
+         * @brief The Chrome trace phase, 'X' for a span and 'i' for an instant.
+         */
+        char phase = 'X';
+    };
+
+    /**
+     * @brief This class collects trace events into a lock-free ring per thread and writes them as Chrome trace JSON,
+     * which can be opened in chrome://tracing or the Perfetto UI. A thread only writes into its own ring, so recording
+     * needs no lock and no atomic read-modify-write. When a ring is full the oldest events are overwritten.
+     */
+    class Tracer {
+    public:
+        /**
+         * @brief The number of events per thread.
+         */
+        static constexpr size_t CAPACITY = 16384;
+
+        /**
+         * @brief The number of rings of exited threads which are kept until they are dumped, further rings drop the oldest.
+         */
+        static constexpr size_t RETIRED_CAPACITY = 8;
+
+    private:
+        /**
+         * @brief The ring of a single thread.
+         */
+        struct Buffer {
+            std::array<TraceEvent, CAPACITY> events;
+            std::atomic<uint64_t> head = 0;
+            uint32_t thread_id = 0;
+            std::string thread_name;
+            bool retired = false;
+        };
+
+        /**
+         * @brief The owner of the ring of a thread, returns the ring to the tracer when the thread exits.
+         */
+        struct BufferOwner {
+            Buffer *buffer = nullptr;
+            ~BufferOwner();
+        };
+
+        /**
+         * @brief The rings of the running threads and the rings of exited threads which are not dumped yet.
+         */
+        std::vector<std::unique_ptr<Buffer>> buffers_;
+
+        /**
+         * @brief The rings of exited threads which were dumped, reused by new threads.
+         */
+        std::vector<std::unique_ptr<Buffer>> free_;
+
+        /**
+         * @brief Mutex for the lists of rings.
+         */
+        std::mutex mutex_;
+
+        /**
+         * @brief Get the ring of the calling thread, a free ring is reused or a new ring is created on first use.
+         *
+         * @return Buffer of the thread.
+         */
+        Buffer &get_buffer();
+
+        /**
+         * @brief Mark the ring of an exiting thread as retired, its events stay until the next dump.
+         *
+         * @param buffer The ring.
+         */
+        void retire(Buffer &buffer);
+
+        /**
+         * @brief Move the retired rings into the free list, called with the mutex held after a dump.
+         *
+         * @param keep The number of the latest retired rings to keep.
+         */
+        void recycle(size_t keep=0);
+
+        /**
+         * @brief Append the valid events of a ring.
+         *
+         * @param buffer The ring.
+         * @param events The copied events are appended.
+         */
+        static void copy_events(const Buffer &buffer, std::vector<TraceEvent> &events);
+
+        Tracer() = default;
+
+    public:
+        Tracer(const Tracer&) = delete;
+        Tracer &operator=(const Tracer&) = delete;
+
+        /**
+         * @brief Get the process wide tracer.
+         *
+         * @return Tracer instance.
+         */
+        static Tracer &get_instance();
+
+        /**
+         * @brief Get the current time of the trace clock.
+         *
+         * @return uint64_t as nanoseconds since epoch (CLOCK_REALTIME).
+         */
+        static uint64_t now();
+
+        /**
+         * @brief Record an event into the ring of the calling thread.
+         *
+         * @param name The name with static lifetime.
+         * @param start The start time.
+         * @param duration The duration, zero for an instant.
+         * @param phase The Chrome trace phase.
+         */
+        void record(const char *name, uint64_t start, uint64_t duration, char phase='X');
+
+        /**
+         * @brief Set the name of the calling thread in the trace.
+         *
+         * @param name The name.
+         */
+        void set_thread_name(const std::string &name);
+
+        /**
+         * @brief Get a copy of the recorded events of all threads. Events which are overwritten during the copy are skipped.
+         * The rings of exited threads are released afterwards, so their events are returned once.
+         *
+         * @return std::vector<TraceEvent> of all threads.
+         */
+        std::vector<TraceEvent> get_events();
+
+        /**
+         * @brief Write the recorded events as Chrome trace JSON. The rings of exited threads are released afterwards, so their events are written once.
+         *
+         * @param path The path of the file.
+         * @return true, by success.
+         * @return false, when the file could not be written.
+         */
+        bool write_chrome_trace(const std::string &path);
+
+        /**
+         * @brief Remove the recorded events of all threads, must not run concurrently to record.
+         */
+        void clear();
+    };
+
+    /**
+     * @brief Records a span from the construction until the destruction.
+     */
+    class TraceScope {
+        /**
+         * @brief The name of the span.
+         */
+        const char *name_;
+
+        /**
+         * @brief The start of the span.
+         */
+        uint64_t start_;
+
+    public:
+        /**
+         * @brief Start a span.
+         *
+         * @param name The name with static lifetime.
+         */
+        explicit TraceScope(const char *name) : name_(name), start_(Tracer::now()) { }
+
+        /**
+         * @brief End the span and record it.
+         */
+        ~TraceScope() { Tracer::get_instance().record(this->name_, this->start_, Tracer::now() - this->start_); }
+
+        TraceScope(const TraceScope&) = delete;
+        TraceScope &operator=(const TraceScope&) = delete;
+    };
+} // namespace robomaster_can_controller
+
+/**
+ * The trace points are compiled in with the cmake option ROBOMASTER_ENABLE_TRACING, otherwise they expand to nothing.
+ * ROBOMASTER_TRACE_SCOPE records a span until the end of the scope, ROBOMASTER_TRACE_SPAN records a span between two times of the trace clock
+ * and is skipped for a start of zero, ROBOMASTER_TRACE_INSTANT records an instant.
+ */
+#define ROBOMASTER_TRACE_CONCAT_(a, b) a##b
+#define ROBOMASTER_TRACE_CONCAT(a, b) ROBOMASTER_TRACE_CONCAT_(a, b)
+
+#ifdef ROBOMASTER_ENABLE_TRACING
+#define ROBOMASTER_TRACE_SCOPE(name) const robomaster_can_controller::TraceScope ROBOMASTER_TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define ROBOMASTER_TRACE_SPAN(name, start, end) do { if ((start) != 0 && (start) <= (end)) { robomaster_can_controller::Tracer::get_instance().record(name, start, (end) - (start)); } } while (0)
+#define ROBOMASTER_TRACE_INSTANT(name) robomaster_can_controller::Tracer::get_instance().record(name, robomaster_can_controller::Tracer::now(), 0, 'i')
+#define ROBOMASTER_TRACE_THREAD_NAME(name) robomaster_can_controller::Tracer::get_instance().set_thread_name(name)
+#else
+#define ROBOMASTER_TRACE_SCOPE(name) ((void)0)
+#define ROBOMASTER_TRACE_SPAN(name, start, end) ((void)0)
+#define ROBOMASTER_TRACE_INSTANT(name) ((void)0)
+#define ROBOMASTER_TRACE_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif // ROBOMASTER_CAN_CONTROLLER_TRACE_H_
@@ -0,0 +1,180 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_TRANSPORT_H_
+#define ROBOMASTER_CAN_CONTROLLER_TRANSPORT_H_
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief A single can frame with its receive timestamp.
+     */
+    struct CanFrame {
+        /**
+         * @brief The can device id.
+         */
+        uint32_t id = 0;
+
+        /**
+         * @brief The length of the data.
+         */
+        uint8_t length = 0;
+
+        /**
+         * @brief The data of the can frame.
+         */
+        uint8_t data[8] = {};
+
+        /**
+         * @brief The receive time in nanoseconds since epoch (CLOCK_REALTIME), zero for frames to send.
+         */
+        uint64_t timestamp = 0;
+    };
+
+    /**
+     * @brief Compile time interface of a frame transport, used to parameterize the handler without virtual calls.
+     * A read returns with success and no frame when the timeout is reached.
+     */
+    template<typename T>
+    concept FrameTransport = requires(T transport, const std::string &name, double seconds, uint32_t &id, uint8_t *data, size_t &length, uint64_t &timestamp, const CanFrame *frames, CanFrame *buffer, size_t count) {
+        { transport.init(name) } -> std::same_as<bool>;
+        { transport.set_timeout(seconds) };
+        { transport.get_fd() } -> std::same_as<int>;
+        { transport.send_frame(id, data, count) } -> std::same_as<bool>;
+        { transport.read_frame(id, data, length, timestamp) } -> std::same_as<bool>;
+        { transport.send_frames(frames, count) } -> std::same_as<bool>;
+        { transport.read_frames(buffer, count, length) } -> std::same_as<bool>;
+    };
+
+    /**
+     * @brief Runtime interface of a frame transport for tooling which selects the transport at runtime.
+     * Every transport implements this interface as final class, so calls on the concrete type are resolved at compile time.
+     */
+    class Transport {
+    public:
+        virtual ~Transport() = default;
+
+        /**
+         * @brief Open the transport by the given interface name.
+         *
+         * @param name The name of the interface.
+         * @return true, when the transport is open successfully.
+         * @return false, when the transport failed to open.
+         */
+        virtual bool init(const std::string &name) = 0;
+
+        /**
+         * @brief Set the timeout for reading frames.
+         *
+         * @param seconds Timeout in seconds, zero blocks until a frame is received.
+         */
+        virtual void set_timeout(double seconds) = 0;
+
+        /**
+         * @brief Get a file descriptor which is readable when frames are available, e.g. for poll or epoll.
+         *
+         * @return int as file descriptor.
+         */
+        virtual int get_fd() const = 0;
+
+        /**
+         * @brief Send a single can frame.
+         *
+         * @param id The device id.
+         * @param data The data of the can frame.
+         * @param length The length of the data.
+         * @return true, by success.
+         * @return false, when failed.
+         */
+        virtual bool send_frame(uint32_t id, const uint8_t data[8], size_t length) = 0;
+
+        /**
+         * @brief Read the next can frame with its receive timestamp. This function is blocking until the timeout is reached.
+         *
+         * @param id The device id.
+         * @param data The data of the can frame.
+         * @param length The length of the data. The length is zero, when the timeout is reached.
+         * @param timestamp The receive time in nanoseconds since epoch.
+         * @return true, by success.
+         * @return false, when failed.
+         */
+        virtual bool read_frame(uint32_t &id, uint8_t data[8], size_t &length, uint64_t &timestamp) = 0;
+
+        /**
+         * @brief Send multiple can frames in order with as few system calls as possible.
+         *
+         * @param frames The can frames to send.
+         * @param count The number of can frames.
+         * @return true, when all frames are sent.
+         * @return false, when failed.
+         */
+        virtual bool send_frames(const CanFrame *frames, size_t count) = 0;
+
+        /**
+         * @brief Read all available can frames up to the capacity. This function is blocking until at least one frame is received or the timeout is reached.
+         *
+         * @param frames The buffer for the can frames.
+         * @param capacity The number of can frames the buffer can hold.
+         * @param count The number of read can frames. The count is zero, when the timeout is reached.
+         * @return true, by success.
+         * @return false, when failed.
+         */
+        virtual bool read_frames(CanFrame *frames, size_t capacity, size_t &count) = 0;
+    };
+
+    /**
+     * @brief This class owns a transport selected at runtime and forwards every call through the runtime interface.
+     */
+    class AnyTransport {
+        /**
+         * @brief The owned transport.
+         */
+        std::unique_ptr<Transport> transport_;
+
+    public:
+        /**
+         * @brief Construct a new AnyTransport object without a transport. Every call fails until a transport is set.
+         */
+        AnyTransport() = default;
+
+        /**
+         * @brief Construct a new AnyTransport object which owns the given transport.
+         *
+         * @param transport The transport.
+         */
+        explicit AnyTransport(std::unique_ptr<Transport> transport) : transport_(std::move(transport)) { }
+
+        /**
+         * @brief Replace the owned transport.
+         *
+         * @param transport The transport.
+         */
+        void set_transport(std::unique_ptr<Transport> transport) { this->transport_ = std::move(transport); }
+
+        /**
+         * @brief Get the owned transport.
+         *
+         * @return Transport* as transport, nullptr when not set.
+         */
+        Transport *get_transport() const { return this->transport_.get(); }
+
+        bool init(const std::string &name) { return this->transport_ && this->transport_->init(name); }
+        void set_timeout(const double seconds) { if (this->transport_) { this->transport_->set_timeout(seconds); } }
+        int get_fd() const { return this->transport_ ? this->transport_->get_fd() : -1; }
+        bool send_frame(const uint32_t id, const uint8_t data[8], const size_t length) { return this->transport_ && this->transport_->send_frame(id, data, length); }
+        bool read_frame(uint32_t &id, uint8_t data[8], size_t &length, uint64_t &timestamp) { return this->transport_ && this->transport_->read_frame(id, data, length, timestamp); }
+        bool send_frames(const CanFrame *frames, const size_t count) { return this->transport_ && this->transport_->send_frames(frames, count); }
+        bool read_frames(CanFrame *frames, const size_t capacity, size_t &count) { return this->transport_ && this->transport_->read_frames(frames, capacity, count); }
+    };
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_TRANSPORT_H_
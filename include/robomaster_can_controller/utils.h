@@ -9,7 +9,9 @@
 
 #include <algorithm>
 #include <arpa/inet.h>
+#include <cstdint>
 #include <sstream>
+#include <string>
 #include <vector>
 
 namespace robomaster_can_controller {
@@ -45,6 +47,48 @@ namespace robomaster_can_controller {
      */
     uint16_t calculate_crc16(const uint8_t *data, size_t length);
 
+    /**
+     * @brief Find the first occurrence of the given byte. Blocks of 16 bytes are compared at once with SSE2 or NEON when available.
+     *
+     * @param data Data to search.
+     * @param length Length of the data.
+     * @param value The byte to search for.
+     * @return size_t Index of the first occurrence, length when the byte was not found.
+     */
+    size_t find_byte(const uint8_t *data, size_t length, uint8_t value);
+
+    /**
+     * @brief Write the data as lower case hex digits without separator into the buffer, e.g. "deadbeef". The digits are
+     * looked up in a table, blocks of 16 bytes are converted at once with SSE2 or NEON when available.
+     *
+     * @param data Input data.
+     * @param length Length of the data.
+     * @param buffer The buffer, not null terminated.
+     * @param size The size of the buffer.
+     * @return size_t as number of written characters, 0 when the buffer is too small.
+     */
+    size_t hex_encode(const uint8_t *data, size_t length, char *buffer, size_t size);
+
+    /**
+     * @brief Write the data as lower case hex digits with a separator between the bytes into the buffer, e.g. "de ad be ef".
+     *
+     * @param data Input data.
+     * @param length Length of the data.
+     * @param buffer The buffer, not null terminated.
+     * @param size The size of the buffer.
+     * @param separator The character between two bytes.
+     * @return size_t as number of written characters, 0 when the buffer is too small.
+     */
+    size_t hex_dump(const uint8_t *data, size_t length, char *buffer, size_t size, char separator=' ');
+
+    /**
+     * @brief Write the lower digits of a value as lower case hex digits into the buffer, e.g. "0202" for 0x202 and 4 digits.
+     *
+     * @param value The value.
+     * @param buffer The buffer, at least digits characters.
+     * @param digits The number of digits, at most 16.
+     */
+    void uint_to_hex(uint64_t value, char *buffer, size_t digits);
 
     /**
      * @brief Give the given uint8 data array in hex as string back.
@@ -56,10 +100,10 @@ namespace robomaster_can_controller {
     std::string string_to_hex(const uint8_t * data, size_t length);
 
     /**
-     * @brief
+     * @brief Give the given data in hex as string back, the bytes are separated by a space.
      *
-     * @param data
-     * @return std::string
+     * @param data Input data.
+     * @return std::string Data as string visualization.
      */
     std::string string_to_hex(const std::vector<uint8_t> &data);
 
@@ -0,0 +1,405 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/robomaster.h"
+#include "robomaster_can_controller/history.h"
+#include "robomaster_can_controller/definitions.h"
+
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <span>
+#include <thread>
+
+namespace py = pybind11;
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The default number of states of the history, one minute at 50 Hertz.
+     */
+    static constexpr size_t STD_HISTORY_CAPACITY = 3000;
+
+    /**
+     * @brief The default number of states of a callback batch.
+     */
+    static constexpr size_t STD_BATCH_SIZE = 10;
+
+    /**
+     * @brief The maximum time in seconds of a wait of the dispatcher.
+     */
+    static constexpr double STD_DISPATCHER_TIMEOUT = 0.1;
+
+    /**
+     * @brief Create a numpy array of a column of a window. With a base the array is a read only view and the base keeps the history
+     * alive, without a base numpy copies the column.
+     */
+    template<typename T>
+    static py::array make_view(const T *data, const size_t width, const size_t rows, const py::handle base) {
+        const auto size = static_cast<py::ssize_t>(sizeof(T));
+        py::array view = width == 1
+            ? py::array_t<T>(std::vector<py::ssize_t>{ static_cast<py::ssize_t>(rows) }, std::vector<py::ssize_t>{ size }, data, base)
+            : py::array_t<T>(std::vector<py::ssize_t>{ static_cast<py::ssize_t>(rows), static_cast<py::ssize_t>(width) },
+                             std::vector<py::ssize_t>{ static_cast<py::ssize_t>(width) * size, size }, data, base);
+        if (base) { view.attr("setflags")(py::arg("write") = false); }
+        return view;
+    }
+
+    template<typename T>
+    static py::array make_view(const std::span<const T> column, const py::handle base) {
+        return make_view(column.data(), 1, column.size(), base);
+    }
+
+    template<typename T, size_t N>
+    static py::array make_view(const std::span<const std::array<T, N>> column, const py::handle base) {
+        static_assert(sizeof(std::array<T, N>) == N * sizeof(T), "the rows of the column are contiguous");
+        return make_view(reinterpret_cast<const T*>(column.data()), N, column.size(), base);
+    }
+
+    /**
+     * @brief Create the numpy arrays of the columns of a window, views of the history with a base and copies without.
+     */
+    static py::dict get_views(const HistoryWindow &window, const py::handle base) {
+        py::array_t<uint64_t> sequence(static_cast<py::ssize_t>(window.size));
+        auto numbers = sequence.mutable_unchecked<1>();
+        for (size_t i = 0; i < window.size; i++) { numbers(static_cast<py::ssize_t>(i)) = window.begin + i; }
+
+        py::dict views;
+        views["sequence"] = sequence;
+        views["time"] = make_view(window.time, base);
+        views["sections"] = make_view(window.sections, base);
+        views["adc_value"] = make_view(window.adc_value, base);
+        views["temperature"] = make_view(window.temperature, base);
+        views["current"] = make_view(window.current, base);
+        views["percent"] = make_view(window.percent, base);
+        views["speed"] = make_view(window.speed, base);
+        views["angle"] = make_view(window.angle, base);
+        views["time_stamp"] = make_view(window.time_stamp, base);
+        views["state"] = make_view(window.state, base);
+        views["acc_x"] = make_view(window.acc_x, base);
+        views["acc_y"] = make_view(window.acc_y, base);
+        views["acc_z"] = make_view(window.acc_z, base);
+        views["gyro_x"] = make_view(window.gyro_x, base);
+        views["gyro_y"] = make_view(window.gyro_y, base);
+        views["gyro_z"] = make_view(window.gyro_z, base);
+        views["vgx"] = make_view(window.vgx, base);
+        views["vgy"] = make_view(window.vgy, base);
+        views["vgz"] = make_view(window.vgz, base);
+        views["vbx"] = make_view(window.vbx, base);
+        views["vby"] = make_view(window.vby, base);
+        views["vbz"] = make_view(window.vbz, base);
+        views["x"] = make_view(window.x, base);
+        views["y"] = make_view(window.y, base);
+        views["z"] = make_view(window.z, base);
+        views["roll"] = make_view(window.roll, base);
+        views["pitch"] = make_view(window.pitch, base);
+        views["yaw"] = make_view(window.yaw, base);
+        views["last_frame"] = make_view(window.last_frame, base);
+        views["acquisition"] = make_view(window.acquisition, base);
+        views["uncertainty"] = make_view(window.uncertainty, base);
+        return views;
+    }
+
+    /**
+     * @brief Copy the columns of a window, the window is taken again when the history overwrote it during the copy.
+     */
+    template<typename F>
+    static py::dict get_copies(const StateHistory &history, F get_window) {
+        while (true) {
+            const HistoryWindow window = get_window();
+            py::dict columns = get_views(window, py::handle());
+            if (history.is_valid(window)) { return columns; }
+        }
+    }
+
+    /**
+     * @brief State if the views of a window are not overwritten yet, the window is found by the column sequence.
+     */
+    static bool is_valid(const StateHistory &history, const py::dict &views) {
+        const auto sequence = views["sequence"].cast<py::array_t<uint64_t>>();
+        if (sequence.size() == 0) { return true; }
+        HistoryWindow window;
+        window.begin = sequence.at(0);
+        window.size = static_cast<size_t>(sequence.size());
+        return history.is_valid(window);
+    }
+
+    /**
+     * @brief Copy the state of a row of a window.
+     */
+    static DataRoboMasterState get_state(const HistoryWindow &window, const size_t row) {
+        DataRoboMasterState state;
+        const uint8_t sections = window.sections[row];
+        state.battery = { (sections & SECTION_BATTERY) != 0, window.adc_value[row], window.temperature[row], window.current[row], window.percent[row], 0 };
+        state.esc = { (sections & SECTION_ESC) != 0, window.speed[row], window.angle[row], window.time_stamp[row], window.state[row] };
+        state.imu = { (sections & SECTION_IMU) != 0, window.acc_x[row], window.acc_y[row], window.acc_z[row], window.gyro_x[row], window.gyro_y[row], window.gyro_z[row] };
+        state.velocity = { (sections & SECTION_VELOCITY) != 0, window.vgx[row], window.vgy[row], window.vgz[row], window.vbx[row], window.vby[row], window.vbz[row] };
+        state.position = { (sections & SECTION_POSITION) != 0, window.x[row], window.y[row], window.z[row] };
+        state.attitude = { (sections & SECTION_ATTITUDE) != 0, window.roll[row], window.pitch[row], window.yaw[row] };
+        state.timestamp = { (sections & SECTION_TIMESTAMP) != 0, window.time[row], window.last_frame[row], window.acquisition[row], window.uncertainty[row] };
+        return state;
+    }
+
+    /**
+     * @brief The python class RoboMaster, the states are collected in the history and passed in batches to the bound function.
+     * The function is called by a dispatcher thread, so the receiver thread of the handler never waits for the GIL.
+     */
+    class PyRoboMaster {
+        StateHistory history_;
+        py::function callback_;
+        size_t batch_;
+        bool copy_;
+        std::thread dispatcher_;
+        std::atomic<bool> flag_stop_;
+        std::unique_ptr<RoboMaster> robomaster_;
+
+        /**
+         * @brief The live objects, stopped before the interpreter finalizes.
+         */
+        static std::mutex instances_mutex_;
+        static std::set<PyRoboMaster*> instances_;
+
+        void start_dispatcher(const py::object &self) {
+            this->flag_stop_ = false;
+            this->dispatcher_ = std::thread([this, base = self.ptr()] {
+                uint64_t next = this->history_.get_count();
+                while (!this->flag_stop_) {
+                    // the timeout bounds the time until the flag is seen, when the notify of the stop is missed.
+                    if (!this->history_.wait(next + this->batch_ - 1, STD_DISPATCHER_TIMEOUT) || this->flag_stop_) { continue; }
+
+                    // a batch which is already overwritten is skipped, the function keeps up with the latest states instead.
+                    const uint64_t count = this->history_.get_count();
+                    if (next + this->history_.get_capacity() < count + this->batch_) { next = count - this->batch_; }
+
+                    // the flag is set before the GIL is released to stop the dispatcher, so the object is alive as long as it is clear.
+                    py::gil_scoped_acquire acquire;
+                    if (this->flag_stop_) { break; }
+                    const HistoryWindow window = this->history_.get_window(next, this->batch_);
+                    py::dict states = get_views(window, this->copy_ ? py::handle() : base);
+
+                    // a batch which was overwritten during the copy is skipped like a batch which is already overwritten.
+                    if (this->copy_ && !this->history_.is_valid(window)) { continue; }
+                    try { this->callback_(states); }
+                    catch (py::error_already_set &error) { error.discard_as_unraisable("RoboMaster.bind"); }
+                    next += this->batch_;
+                }
+            });
+        }
+
+    public:
+        explicit PyRoboMaster(const size_t history) : history_(history), batch_(STD_BATCH_SIZE), copy_(true), flag_stop_(false), robomaster_(std::make_unique<RoboMaster>()) {
+            if (history == 0) { throw py::value_error("history must not be zero"); }
+            this->robomaster_->set_history(&this->history_);
+            std::lock_guard lock(instances_mutex_);
+            instances_.insert(this);
+        }
+
+        ~PyRoboMaster() {
+            {
+                std::lock_guard lock(instances_mutex_);
+                instances_.erase(this);
+            }
+            this->flag_stop_ = true;
+            py::gil_scoped_release release;
+            this->close();
+        }
+
+        PyRoboMaster(const PyRoboMaster&) = delete;
+        PyRoboMaster &operator=(const PyRoboMaster&) = delete;
+
+        /**
+         * @brief Get the RoboMaster or raise an error when it is closed.
+         */
+        RoboMaster &get() {
+            if (!this->robomaster_) { throw py::value_error("RoboMaster is closed"); }
+            return *this->robomaster_;
+        }
+
+        StateHistory &get_history() {
+            return this->history_;
+        }
+
+        /**
+         * @brief Bind a function for the batches of states, None removes the function. Called with the GIL held.
+         * The batches are copies, or views which expire when the history wraps around.
+         */
+        void bind(const py::object &self, const py::object &func, const size_t batch, const bool copy) {
+            if (batch == 0 || this->history_.get_capacity() < batch) { throw py::value_error("batch must be within [1, history]"); }
+            this->flag_stop_ = true;
+            {
+                py::gil_scoped_release release;
+                this->stop_dispatcher();
+            }
+            if (func.is_none()) { this->callback_ = py::function(); return; }
+            this->callback_ = func.cast<py::function>();
+            this->batch_ = batch;
+            this->copy_ = copy;
+            this->start_dispatcher(self);
+        }
+
+        /**
+         * @brief Stop the dispatcher thread, called without the GIL.
+         */
+        void stop_dispatcher() {
+            if (!this->dispatcher_.joinable()) { return; }
+            this->flag_stop_ = true;
+            this->history_.notify();
+            this->dispatcher_.join();
+        }
+
+        /**
+         * @brief Stop the dispatcher and the handler threads, called without the GIL.
+         */
+        void close() {
+            this->stop_dispatcher();
+            this->robomaster_.reset();
+        }
+
+        /**
+         * @brief Stop the dispatcher threads of all live objects, registered with atexit.
+         */
+        static void stop_all() {
+            std::lock_guard lock(instances_mutex_);
+            py::gil_scoped_release release;
+            for (PyRoboMaster *instance : instances_) { instance->stop_dispatcher(); }
+        }
+    };
+
+    std::mutex PyRoboMaster::instances_mutex_;
+    std::set<PyRoboMaster*> PyRoboMaster::instances_;
+} // namespace robomaster_can_controller
+
+using namespace robomaster_can_controller;
+
+PYBIND11_MODULE(robomaster_can_controller, module) {
+    module.doc() = "Control the RoboMaster chassis via CAN bus.";
+
+    py::class_<DataBattery>(module, "Battery")
+        .def_readonly("has_data", &DataBattery::has_data)
+        .def_readonly("adc_value", &DataBattery::adc_value)
+        .def_readonly("temperature", &DataBattery::temperature)
+        .def_readonly("current", &DataBattery::current)
+        .def_readonly("percent", &DataBattery::percent)
+        .def_readonly("recv", &DataBattery::recv);
+
+    py::class_<DataEsc>(module, "Esc")
+        .def_readonly("has_data", &DataEsc::has_data)
+        .def_readonly("speed", &DataEsc::speed)
+        .def_readonly("angle", &DataEsc::angle)
+        .def_readonly("time_stamp", &DataEsc::time_stamp)
+        .def_readonly("state", &DataEsc::state);
+
+    py::class_<DataImu>(module, "Imu")
+        .def_readonly("has_data", &DataImu::has_data)
+        .def_readonly("acc_x", &DataImu::acc_x)
+        .def_readonly("acc_y", &DataImu::acc_y)
+        .def_readonly("acc_z", &DataImu::acc_z)
+        .def_readonly("gyro_x", &DataImu::gyro_x)
+        .def_readonly("gyro_y", &DataImu::gyro_y)
+        .def_readonly("gyro_z", &DataImu::gyro_z);
+
+    py::class_<DataVelocity>(module, "Velocity")
+        .def_readonly("has_data", &DataVelocity::has_data)
+        .def_readonly("vgx", &DataVelocity::vgx)
+        .def_readonly("vgy", &DataVelocity::vgy)
+        .def_readonly("vgz", &DataVelocity::vgz)
+        .def_readonly("vbx", &DataVelocity::vbx)
+        .def_readonly("vby", &DataVelocity::vby)
+        .def_readonly("vbz", &DataVelocity::vbz);
+
+    py::class_<DataPosition>(module, "Position")
+        .def_readonly("has_data", &DataPosition::has_data)
+        .def_readonly("x", &DataPosition::x)
+        .def_readonly("y", &DataPosition::y)
+        .def_readonly("z", &DataPosition::z);
+
+    py::class_<DataAttitude>(module, "Attitude")
+        .def_readonly("has_data", &DataAttitude::has_data)
+        .def_readonly("roll", &DataAttitude::roll)
+        .def_readonly("pitch", &DataAttitude::pitch)
+        .def_readonly("yaw", &DataAttitude::yaw);
+
+    py::class_<DataTimestamp>(module, "Timestamp")
+        .def_readonly("has_data", &DataTimestamp::has_data)
+        .def_readonly("first_frame", &DataTimestamp::first_frame)
+        .def_readonly("last_frame", &DataTimestamp::last_frame)
+        .def_readonly("acquisition", &DataTimestamp::acquisition)
+        .def_readonly("uncertainty", &DataTimestamp::uncertainty);
+
+    py::class_<DataRoboMasterState>(module, "State")
+        .def_readonly("battery", &DataRoboMasterState::battery)
+        .def_readonly("esc", &DataRoboMasterState::esc)
+        .def_readonly("imu", &DataRoboMasterState::imu)
+        .def_readonly("velocity", &DataRoboMasterState::velocity)
+        .def_readonly("position", &DataRoboMasterState::position)
+        .def_readonly("attitude", &DataRoboMasterState::attitude)
+        .def_readonly("timestamp", &DataRoboMasterState::timestamp);
+
+    module.attr("SECTION_BATTERY") = static_cast<uint32_t>(SECTION_BATTERY);
+    module.attr("SECTION_ESC") = static_cast<uint32_t>(SECTION_ESC);
+    module.attr("SECTION_IMU") = static_cast<uint32_t>(SECTION_IMU);
+    module.attr("SECTION_VELOCITY") = static_cast<uint32_t>(SECTION_VELOCITY);
+    module.attr("SECTION_POSITION") = static_cast<uint32_t>(SECTION_POSITION);
+    module.attr("SECTION_ATTITUDE") = static_cast<uint32_t>(SECTION_ATTITUDE);
+    module.attr("SECTION_TIMESTAMP") = static_cast<uint32_t>(SECTION_TIMESTAMP);
+
+    py::class_<PyRoboMaster>(module, "RoboMaster")
+        .def(py::init<size_t>(), py::arg("history") = STD_HISTORY_CAPACITY)
+        .def("init", [](PyRoboMaster &self, const std::string &can_interface) { return self.get().init(can_interface); },
+             py::arg("can_interface") = "can0", py::call_guard<py::gil_scoped_release>())
+        .def("is_running", [](PyRoboMaster &self) { return self.get().is_running(); })
+        .def("close", &PyRoboMaster::close, py::call_guard<py::gil_scoped_release>())
+        .def("bind", [](py::object self, const py::object &func, const size_t batch, const bool copy) { self.cast<PyRoboMaster&>().bind(self, func, batch, copy); },
+             py::arg("func"), py::arg("batch") = STD_BATCH_SIZE, py::arg("copy") = true)
+        .def("count", [](PyRoboMaster &self) { return self.get_history().get_count(); })
+        .def("capacity", [](PyRoboMaster &self) { return self.get_history().get_capacity(); })
+        .def("latest", [](PyRoboMaster &self) -> py::object {
+            const HistoryWindow window = self.get_history().last(1);
+            if (window.size == 0) { return py::none(); }
+            return py::cast(get_state(window, 0));
+        })
+        .def("last", [](py::object self, const size_t n, const bool copy) {
+            const StateHistory &history = self.cast<PyRoboMaster&>().get_history();
+            if (!copy) { return get_views(history.last(n), self); }
+            return get_copies(history, [&history, n] { return history.last(n); });
+        }, py::arg("n"), py::arg("copy") = true)
+        .def("between", [](py::object self, const uint64_t t0, const uint64_t t1, const bool copy) {
+            const StateHistory &history = self.cast<PyRoboMaster&>().get_history();
+            if (!copy) { return get_views(history.between(t0, t1), self); }
+            return get_copies(history, [&history, t0, t1] { return history.between(t0, t1); });
+        }, py::arg("t0"), py::arg("t1"), py::arg("copy") = true)
+        .def("is_valid", [](PyRoboMaster &self, const py::dict &views) { return is_valid(self.get_history(), views); }, py::arg("views"))
+        .def("wait", [](PyRoboMaster &self, const uint64_t count, const double timeout) {
+            self.get_history().wait(count, timeout);
+            return self.get_history().get_count();
+        }, py::arg("count"), py::arg("timeout") = 0.0, py::call_guard<py::gil_scoped_release>())
+        .def("enable", [](PyRoboMaster &self) { self.get().set_work_mode(true); })
+        .def("disable", [](PyRoboMaster &self) { self.get().set_work_mode(false); })
+        .def("stop", [](PyRoboMaster &self) { self.get().set_brake(); })
+        .def("wheelRPM", [](PyRoboMaster &self, const int16_t fr, const int16_t fl, const int16_t rl, const int16_t rr) {
+            self.get().set_wheel_rpm(fr, fl, rl, rr);
+        }, py::arg("fr"), py::arg("fl"), py::arg("rl"), py::arg("rr"))
+        .def("velocity", [](PyRoboMaster &self, const float x, const float y, const float z) { self.get().set_velocity(x, y, z); },
+             py::arg("x"), py::arg("y"), py::arg("z"))
+        .def("led_off", [](PyRoboMaster &self) { self.get().set_led_off(LED_MASK_ALL); })
+        .def("led_on", [](PyRoboMaster &self, const uint8_t r, const uint8_t g, const uint8_t b) { self.get().set_led_on(LED_MASK_ALL, r, g, b); },
+             py::arg("r"), py::arg("g"), py::arg("b"))
+        .def("led_breath", [](PyRoboMaster &self, const uint8_t r, const uint8_t g, const uint8_t b, const float rate) {
+            self.get().set_led_breath(LED_MASK_ALL, r, g, b, rate);
+        }, py::arg("r"), py::arg("g"), py::arg("b"), py::arg("rate"))
+        .def("led_flash", [](PyRoboMaster &self, const uint8_t r, const uint8_t g, const uint8_t b, const float rate) {
+            self.get().set_led_flash(LED_MASK_ALL, r, g, b, rate);
+        }, py::arg("r"), py::arg("g"), py::arg("b"), py::arg("rate"));
+
+    // the dispatcher threads have to be stopped while the interpreter is alive, they acquire the GIL for every batch.
+    py::module_::import("atexit").attr("register")(py::cpp_function(&PyRoboMaster::stop_all));
+}
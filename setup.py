@@ -0,0 +1,53 @@
+# Copyright (c) 2024 Vinzenz Weist
+#
+# Licensed under the MIT License.
+# For details on the licensing terms, see the LICENSE file. Copyright refers to Fraunhofer IML
+
+import os
+import subprocess
+import sys
+from pathlib import Path
+
+from setuptools import Extension, setup
+from setuptools.command.build_ext import build_ext
+
+
+class CMakeExtension(Extension):
+    """An extension which is built by the CMakeLists.txt of the given directory."""
+
+    def __init__(self, name: str, source_dir: str = "") -> None:
+        super().__init__(name, sources=[])
+        self.source_dir = os.fspath(Path(source_dir).resolve())
+
+
+class CMakeBuild(build_ext):
+    """Build the python bindings with cmake and ninja."""
+
+    def build_extension(self, ext: CMakeExtension) -> None:
+        output_dir = Path(self.get_ext_fullpath(ext.name)).parent.resolve()
+        build_type = "Debug" if self.debug else "Release"
+        build_dir = Path(self.build_temp) / ext.name
+        build_dir.mkdir(parents=True, exist_ok=True)
+
+        # pybind11 is a build requirement, its cmake config is found in the isolated build environment instead of the system.
+        import pybind11
+
+        subprocess.run(["cmake", ext.source_dir, "-G", "Ninja",
+                        f"-DCMAKE_BUILD_TYPE={build_type}",
+                        f"-DCMAKE_LIBRARY_OUTPUT_DIRECTORY={output_dir}{os.sep}",
+                        f"-DPython3_EXECUTABLE={sys.executable}",
+                        f"-Dpybind11_DIR={pybind11.get_cmake_dir()}",
+                        "-DBUILD_PYTHON_BINDINGS=ON"], cwd=build_dir, check=True)
+        subprocess.run(["cmake", "--build", ".", "--target", "robomaster_can_controller_python"], cwd=build_dir, check=True)
+
+
+setup(
+    name="robomaster_can_controller",
+    version="1.0.0",
+    description="Control the RoboMaster chassis via CAN bus.",
+    ext_modules=[CMakeExtension("robomaster_can_controller")],
+    cmdclass={"build_ext": CMakeBuild},
+    install_requires=["numpy"],
+    python_requires=">=3.8",
+    zip_safe=False,
+)
@@ -0,0 +1,396 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/bridge.h"
+#include "robomaster_can_controller/logger.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+namespace robomaster_can_controller {
+    static constexpr size_t STD_MAX_EVENTS = 32;
+    static constexpr size_t STD_MAX_PENDING = 64;
+    static constexpr size_t STD_MAX_PACKET = 1024;
+
+    /**
+     * @brief Append a section to the record.
+     */
+    template<typename S>
+    static size_t put(uint8_t *buffer, const size_t offset, const S &section) {
+        std::memcpy(buffer + offset, &section, sizeof(S));
+        return offset + sizeof(S);
+    }
+
+    /**
+     * @brief Read a section of the record.
+     */
+    template<typename S>
+    static bool get(const uint8_t *buffer, const size_t end, size_t &offset, S &section) {
+        if (end < offset + sizeof(S)) { return false; }
+        std::memcpy(&section, buffer + offset, sizeof(S));
+        offset += sizeof(S);
+        return true;
+    }
+
+    static void write_header(uint8_t *buffer, const uint8_t type, const uint16_t count) {
+        BridgeHeader header{};
+        std::memcpy(header.magic, BRIDGE_MAGIC, sizeof(BRIDGE_MAGIC));
+        header.version = BRIDGE_VERSION;
+        header.type = type;
+        header.count = count;
+        std::memcpy(buffer, &header, sizeof(header));
+    }
+
+    size_t encode_bridge_record(const DataRoboMasterState &state, const uint32_t sections, const uint64_t sequence, uint8_t *buffer) {
+        BridgeStateRecord record{};
+        record.sequence = sequence;
+        size_t offset = sizeof(BridgeStateRecord);
+
+        if (sections & SECTION_BATTERY && state.battery.has_data) {
+            const BridgeBattery battery{ state.battery.adc_value, state.battery.temperature, state.battery.current, state.battery.percent, {} };
+            offset = put(buffer, offset, battery);
+            record.sections |= SECTION_BATTERY;
+        }
+        if (sections & SECTION_ESC && state.esc.has_data) {
+            BridgeEsc esc{};
+            std::copy(state.esc.speed.begin(), state.esc.speed.end(), esc.speed);
+            std::copy(state.esc.angle.begin(), state.esc.angle.end(), esc.angle);
+            std::copy(state.esc.time_stamp.begin(), state.esc.time_stamp.end(), esc.time_stamp);
+            std::copy(state.esc.state.begin(), state.esc.state.end(), esc.state);
+            offset = put(buffer, offset, esc);
+            record.sections |= SECTION_ESC;
+        }
+        if (sections & SECTION_IMU && state.imu.has_data) {
+            const BridgeImu imu{ state.imu.acc_x, state.imu.acc_y, state.imu.acc_z, state.imu.gyro_x, state.imu.gyro_y, state.imu.gyro_z };
+            offset = put(buffer, offset, imu);
+            record.sections |= SECTION_IMU;
+        }
+        if (sections & SECTION_VELOCITY && state.velocity.has_data) {
+            const BridgeVelocity velocity{ state.velocity.vgx, state.velocity.vgy, state.velocity.vgz, state.velocity.vbx, state.velocity.vby, state.velocity.vbz };
+            offset = put(buffer, offset, velocity);
+            record.sections |= SECTION_VELOCITY;
+        }
+        if (sections & SECTION_POSITION && state.position.has_data) {
+            offset = put(buffer, offset, BridgePosition{ state.position.x, state.position.y, state.position.z });
+            record.sections |= SECTION_POSITION;
+        }
+        if (sections & SECTION_ATTITUDE && state.attitude.has_data) {
+            offset = put(buffer, offset, BridgeAttitude{ state.attitude.roll, state.attitude.pitch, state.attitude.yaw });
+            record.sections |= SECTION_ATTITUDE;
+        }
+        if (sections & SECTION_TIMESTAMP && state.timestamp.has_data) {
+            offset = put(buffer, offset, BridgeTimestamp{ state.timestamp.first_frame, state.timestamp.last_frame, state.timestamp.acquisition, state.timestamp.uncertainty });
+            record.sections |= SECTION_TIMESTAMP;
+        }
+
+        record.size = static_cast<uint32_t>(offset);
+        std::memcpy(buffer, &record, sizeof(record));
+        return offset;
+    }
+
+    size_t decode_bridge_record(const uint8_t *buffer, const size_t length, DataRoboMasterState &state, uint64_t &sequence) {
+        BridgeStateRecord record{};
+        size_t offset = 0;
+        if (!get(buffer, length, offset, record) || record.size < sizeof(record) || length < record.size) { return 0; }
+        sequence = record.sequence;
+        state = DataRoboMasterState();
+
+        const size_t end = record.size;
+        if (record.sections & SECTION_BATTERY) {
+            BridgeBattery battery{};
+            if (!get(buffer, end, offset, battery)) { return 0; }
+            state.battery = { true, battery.adc_value, battery.temperature, battery.current, battery.percent, 0 };
+        }
+        if (record.sections & SECTION_ESC) {
+            BridgeEsc esc{};
+            if (!get(buffer, end, offset, esc)) { return 0; }
+            state.esc.has_data = true;
+            std::copy_n(esc.speed, 4, state.esc.speed.begin());
+            std::copy_n(esc.angle, 4, state.esc.angle.begin());
+            std::copy_n(esc.time_stamp, 4, state.esc.time_stamp.begin());
+            std::copy_n(esc.state, 4, state.esc.state.begin());
+        }
+        if (record.sections & SECTION_IMU) {
+            BridgeImu imu{};
+            if (!get(buffer, end, offset, imu)) { return 0; }
+            state.imu = { true, imu.acc_x, imu.acc_y, imu.acc_z, imu.gyro_x, imu.gyro_y, imu.gyro_z };
+        }
+        if (record.sections & SECTION_VELOCITY) {
+            BridgeVelocity velocity{};
+            if (!get(buffer, end, offset, velocity)) { return 0; }
+            state.velocity = { true, velocity.vgx, velocity.vgy, velocity.vgz, velocity.vbx, velocity.vby, velocity.vbz };
+        }
+        if (record.sections & SECTION_POSITION) {
+            BridgePosition position{};
+            if (!get(buffer, end, offset, position)) { return 0; }
+            state.position = { true, position.x, position.y, position.z };
+        }
+        if (record.sections & SECTION_ATTITUDE) {
+            BridgeAttitude attitude{};
+            if (!get(buffer, end, offset, attitude)) { return 0; }
+            state.attitude = { true, attitude.roll, attitude.pitch, attitude.yaw };
+        }
+        if (record.sections & SECTION_TIMESTAMP) {
+            BridgeTimestamp timestamp{};
+            if (!get(buffer, end, offset, timestamp)) { return 0; }
+            state.timestamp = { true, timestamp.first_frame, timestamp.last_frame, timestamp.acquisition, timestamp.uncertainty };
+        }
+        return offset == end ? end : 0;
+    }
+
+    Bridge::Bridge() : listen_fd_(-1), epoll_fd_(-1), event_fd_(-1), max_clients_(0), sequence_(0), flag_notified_(false), flag_stop_(false) { }
+
+    Bridge::~Bridge() {
+        this->close();
+    }
+
+    bool Bridge::open(const std::string &path, const size_t max_clients) {
+        if (0 <= this->listen_fd_) { log_message(LOG_WARNING, "Bridge", "Bridge already open"); return false; }
+
+        sockaddr_un address{};
+        if (sizeof(address.sun_path) <= path.size()) { log_message(LOG_ERROR, "Bridge", "Socket path too long"); return false; }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+
+        // a socket file of a previous run is replaced.
+        unlink(path.c_str());
+        this->listen_fd_ = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        this->epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        // a concurrent publish sees either no event file descriptor or a valid one.
+        { std::lock_guard lock(this->mutex_); this->event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC); }
+        if (this->listen_fd_ < 0 || this->epoll_fd_ < 0 || this->event_fd_ < 0
+            || bind(this->listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(this->listen_fd_, SOMAXCONN) < 0) {
+            log_message(LOG_ERROR, "Bridge", "Failed to create socket %s", path.c_str());
+            this->close();
+            return false;
+        }
+
+        for (const int fd : { this->listen_fd_, this->event_fd_ }) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) { log_message(LOG_ERROR, "Bridge", "Failed to register file descriptor"); this->close(); return false; }
+        }
+
+        this->path_ = path;
+        this->max_clients_ = max_clients;
+        this->flag_notified_ = false;
+        this->flag_stop_ = false;
+        this->thread_ = std::thread(&Bridge::start_io_thread, this);
+        return true;
+    }
+
+    void Bridge::close() {
+        if (this->thread_.joinable()) {
+            this->flag_stop_ = true;
+            constexpr uint64_t value = 1;
+            (void)write(this->event_fd_, &value, sizeof(value));
+            this->thread_.join();
+        }
+        for (const auto &[fd, client] : this->clients_) { ::close(fd); }
+        this->clients_.clear();
+        for (int *fd : { &this->listen_fd_, &this->epoll_fd_ }) { if (0 <= *fd) { ::close(*fd); *fd = -1; } }
+        {
+            // a publish in another thread must not write to the closed or an already reused file descriptor.
+            std::lock_guard lock(this->mutex_);
+            if (0 <= this->event_fd_) { ::close(this->event_fd_); this->event_fd_ = -1; }
+            this->pending_.clear();
+        }
+        if (!this->path_.empty()) { unlink(this->path_.c_str()); this->path_.clear(); }
+
+        std::lock_guard lock(this->statistics_mutex_);
+        this->statistics_.clients = 0;
+    }
+
+    void Bridge::publish(const DataRoboMasterState &state) {
+        std::lock_guard lock(this->mutex_);
+        if (this->event_fd_ < 0) { return; }
+        // the io thread is behind, the oldest state is stale and dropped.
+        if (STD_MAX_PENDING <= this->pending_.size()) {
+            this->pending_.erase(this->pending_.begin());
+            std::lock_guard statistics_lock(this->statistics_mutex_);
+            this->statistics_.dropped++;
+        }
+        this->pending_.push_back(state);
+
+        // the write to the non blocking event file descriptor stays under the lock, so close cannot release it in between.
+        if (this->flag_notified_.exchange(true, std::memory_order_acq_rel)) { return; }
+        constexpr uint64_t value = 1;
+        (void)write(this->event_fd_, &value, sizeof(value));
+    }
+
+    void Bridge::set_command_callback(std::function<void(const BridgeCommand&)> func) {
+        std::lock_guard lock(this->callback_mutex_);
+        this->callback_ = std::move(func);
+    }
+
+    BridgeStatistics Bridge::get_statistics() const {
+        std::lock_guard lock(this->statistics_mutex_);
+        return this->statistics_;
+    }
+
+    void Bridge::remove_client(const int fd) {
+        epoll_ctl(this->epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        this->clients_.erase(fd);
+        std::lock_guard lock(this->statistics_mutex_);
+        this->statistics_.clients = this->clients_.size();
+    }
+
+    void Bridge::accept_clients() {
+        while (true) {
+            const int fd = accept4(this->listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) { return; }
+            if (this->max_clients_ <= this->clients_.size()) { log_message(LOG_WARNING, "Bridge", "Too many clients"); ::close(fd); continue; }
+
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) { ::close(fd); continue; }
+
+            auto client = std::make_unique<Client>();
+            client->fd = fd;
+            client->packet.reserve(sizeof(BridgeHeader) + BRIDGE_MAX_BATCH * BRIDGE_MAX_RECORD);
+            this->clients_.emplace(fd, std::move(client));
+            std::lock_guard lock(this->statistics_mutex_);
+            this->statistics_.clients = this->clients_.size();
+        }
+    }
+
+    bool Bridge::read_client(Client &client) {
+        std::array<uint8_t, STD_MAX_PACKET> buffer;
+        while (true) {
+            const ssize_t length = recv(client.fd, buffer.data(), buffer.size(), MSG_DONTWAIT);
+            if (length == 0) { return false; }
+            if (length < 0) { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+
+            BridgeHeader header{};
+            if (static_cast<size_t>(length) < sizeof(header)) { std::lock_guard lock(this->statistics_mutex_); this->statistics_.invalid++; continue; }
+            std::memcpy(&header, buffer.data(), sizeof(header));
+            const size_t size = static_cast<size_t>(length) - sizeof(header);
+            const uint8_t *body = buffer.data() + sizeof(header);
+            const bool valid = std::memcmp(header.magic, BRIDGE_MAGIC, sizeof(BRIDGE_MAGIC)) == 0 && header.version == BRIDGE_VERSION;
+
+            if (valid && header.type == BRIDGE_SUBSCRIBE && header.count == 1 && size == sizeof(BridgeSubscribe)) {
+                BridgeSubscribe subscribe{};
+                std::memcpy(&subscribe, body, sizeof(subscribe));
+                client.sections = subscribe.sections & SECTION_ALL;
+                client.batch = std::clamp<uint16_t>(subscribe.batch, 1, BRIDGE_MAX_BATCH);
+                client.decimation = std::max<uint16_t>(subscribe.decimation, 1);
+                client.count = 0;
+                client.packet.clear();
+
+                // the acknowledgement holds the effective subscription.
+                std::array<uint8_t, sizeof(BridgeHeader) + sizeof(BridgeSubscribe)> answer{};
+                write_header(answer.data(), BRIDGE_SUBSCRIBE, 1);
+                subscribe = { client.sections, client.batch, client.decimation };
+                std::memcpy(answer.data() + sizeof(BridgeHeader), &subscribe, sizeof(subscribe));
+                (void)send(client.fd, answer.data(), answer.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+            } else if (valid && header.type == BRIDGE_COMMAND && size == header.count * sizeof(BridgeCommand)) {
+                std::lock_guard lock(this->callback_mutex_);
+                for (size_t i = 0; i < header.count; i++) {
+                    BridgeCommand command{};
+                    std::memcpy(&command, body + i * sizeof(BridgeCommand), sizeof(command));
+                    if (this->callback_) { this->callback_(command); }
+                }
+                std::lock_guard statistics_lock(this->statistics_mutex_);
+                this->statistics_.commands += header.count;
+            } else {
+                std::lock_guard lock(this->statistics_mutex_);
+                this->statistics_.invalid++;
+            }
+        }
+    }
+
+    bool Bridge::flush_client(Client &client) {
+        if (client.count == 0) { return true; }
+        write_header(client.packet.data(), BRIDGE_STATES, client.count);
+        const ssize_t length = send(client.fd, client.packet.data(), client.packet.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        const uint16_t count = client.count;
+        client.count = 0;
+        client.packet.clear();
+
+        // a full socket buffer drops the batch, the client continues with the newer states.
+        std::lock_guard lock(this->statistics_mutex_);
+        if (0 <= length) { this->statistics_.packets++; this->statistics_.records += count; return true; }
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) { this->statistics_.dropped += count; return true; }
+        return false;
+    }
+
+    void Bridge::send_states(const std::vector<DataRoboMasterState> &states) {
+        // the records of one state are shared by all clients with the same subscription.
+        std::vector<std::pair<uint32_t, size_t>> encoded;
+        std::vector<uint8_t> records;
+        std::vector<int> disconnected;
+
+        for (const auto &state : states) {
+            const uint64_t sequence = this->sequence_++;
+            encoded.clear();
+            records.clear();
+
+            for (auto &[fd, client] : this->clients_) {
+                if (client->sections == 0 || sequence % client->decimation != 0) { continue; }
+
+                auto it = std::find_if(encoded.begin(), encoded.end(), [&client](const auto &e) { return e.first == client->sections; });
+                if (it == encoded.end()) {
+                    const size_t offset = records.size();
+                    records.resize(offset + BRIDGE_MAX_RECORD);
+                    records.resize(offset + encode_bridge_record(state, client->sections, sequence, records.data() + offset));
+                    it = encoded.emplace(encoded.end(), client->sections, offset);
+                }
+                const uint8_t *record = records.data() + it->second;
+                uint32_t size;
+                std::memcpy(&size, record + offsetof(BridgeStateRecord, size), sizeof(size));
+
+                if (client->packet.empty()) { client->packet.resize(sizeof(BridgeHeader)); }
+                client->packet.insert(client->packet.end(), record, record + size);
+                if (++client->count < client->batch) { continue; }
+                if (!this->flush_client(*client)) { disconnected.push_back(fd); }
+            }
+        }
+        for (const int fd : disconnected) { if (this->clients_.contains(fd)) { this->remove_client(fd); } }
+
+        std::lock_guard lock(this->statistics_mutex_);
+        this->statistics_.states += states.size();
+    }
+
+    void Bridge::start_io_thread() {
+        std::array<epoll_event, STD_MAX_EVENTS> events;
+        std::vector<DataRoboMasterState> states;
+
+        while (!this->flag_stop_) {
+            const int count = epoll_wait(this->epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+            if (count < 0 && errno != EINTR) { log_message(LOG_ERROR, "Bridge", "Failed to wait for events"); break; }
+
+            for (int i = 0; i < count; i++) {
+                const int fd = events[i].data.fd;
+                if (fd == this->listen_fd_) { this->accept_clients(); continue; }
+                if (fd == this->event_fd_) {
+                    uint64_t value;
+                    this->flag_notified_.store(false, std::memory_order_release);
+                    (void)read(this->event_fd_, &value, sizeof(value));
+                    { std::lock_guard lock(this->mutex_); states.swap(this->pending_); }
+                    this->send_states(states);
+                    states.clear();
+                    continue;
+                }
+
+                // the client may be removed by a failed send of this round, a hangup is reported by the read after the last packet.
+                const auto it = this->clients_.find(fd);
+                if (it == this->clients_.end()) { continue; }
+                if (events[i].events & EPOLLERR || !this->read_client(*it->second)) { this->remove_client(fd); }
+            }
+        }
+    }
+} // namespace robomaster_can_controller
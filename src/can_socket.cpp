@@ -5,17 +5,34 @@
 // All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
 
 #include "robomaster_can_controller/can_socket.h"
+#include "robomaster_can_controller/logger.h"
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <cmath>
+#include <ctime>
 
 namespace robomaster_can_controller {
-    CanSocket::CanSocket(): socket_(0) {
+    static constexpr size_t STD_BATCH_SIZE = 64;
+
+    /**
+     * @brief Get the receive time from the control messages or the current time as fallback.
+     */
+    static uint64_t get_timestamp(msghdr &msg) {
+        timespec time{};
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        while (cmsg != nullptr && !(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS)) { cmsg = CMSG_NXTHDR(&msg, cmsg); }
+        if (cmsg != nullptr) { memcpy(&time, CMSG_DATA(cmsg), sizeof(time)); } else { clock_gettime(CLOCK_REALTIME, &time); }
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+    CanSocket::CanSocket(): socket_(-1) {
         memset(&this->ifr_, 0x0, sizeof(this->ifr_));
         memset(&this->addr_, 0x0, sizeof(this->addr_));
     }
 
     CanSocket::~CanSocket() {
-        close(socket_);
+        if (0 <= this->socket_) { close(this->socket_); }
     }
 
     void CanSocket::set_timeout(const size_t seconds, const size_t microseconds) {
@@ -26,7 +43,7 @@ namespace robomaster_can_controller {
     }
 
     void CanSocket::set_timeout(const double seconds) {
-        if (seconds < 0.0) {
+        if (0.0 < seconds) {
             const auto seconds_t = static_cast<size_t>(std::floor(seconds));
             const auto microseconds_t = static_cast<size_t>((seconds - std::floor(seconds)) * 1e6);
             this->set_timeout(seconds_t, microseconds_t);
@@ -37,18 +54,25 @@ namespace robomaster_can_controller {
 
     bool CanSocket::init(const std::string &can_interface) {
         this->socket_ = socket(PF_CAN, SOCK_RAW, CAN_RAW);
-        if(this->socket_ < 0) { std::printf("[CAN]: Failed to open Socket\n"); return false; }
+        if(this->socket_ < 0) { log_message(LOG_ERROR, "CAN", "Failed to open Socket"); return false; }
 
         memcpy(this->ifr_.ifr_name, can_interface.c_str(), can_interface.size());
-        if(ioctl(this->socket_, SIOGIFINDEX, &this->ifr_) < 0) { std::printf("[CAN]: Failed to request interface %s\n", can_interface.c_str()); return false; }
+        if(ioctl(this->socket_, SIOGIFINDEX, &this->ifr_) < 0) { log_message(LOG_ERROR, "CAN", "Failed to request interface %s", can_interface.c_str()); return false; }
 
         this->addr_.can_ifindex = this->ifr_.ifr_ifindex;
         this->addr_.can_family= PF_CAN;
 
-        if(bind(this->socket_, reinterpret_cast<sockaddr *>(&this->addr_), sizeof(this->addr_)) < 0) { std::printf("[CAN]: Failed to bind the address\n"); return false; }
+        if(bind(this->socket_, reinterpret_cast<sockaddr *>(&this->addr_), sizeof(this->addr_)) < 0) { log_message(LOG_ERROR, "CAN", "Failed to bind the address"); return false; }
+
+        constexpr int enable = 1;
+        if(setsockopt(this->socket_, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0) { log_message(LOG_WARNING, "CAN", "Failed to enable receive timestamps"); }
         return true;
     }
 
+    int CanSocket::get_fd() const {
+        return this->socket_;
+    }
+
     bool CanSocket::send_frame(const uint32_t id, const uint8_t data[8], const size_t length) {
         if (length <= 8) {
             can_frame frame;
@@ -58,22 +82,104 @@ namespace robomaster_can_controller {
             frame.can_dlc = length;
             memcpy(static_cast<uint8_t *>(frame.data), data, length);
 
-            if(write(this->socket_, &frame, sizeof(frame)) < 0) { std::printf("[CAN]: Failed to send frame\n"); return false; }
+            if(write(this->socket_, &frame, sizeof(frame)) < 0) { log_message(LOG_ERROR, "CAN", "Failed to send frame"); return false; }
         } else {
-            std::printf("[CAN]: Failed to send frame\n"); return false;
+            log_message(LOG_ERROR, "CAN", "Failed to send frame"); return false;
         }
         return true;
     }
 
     bool CanSocket::read_frame(uint32_t &id, uint8_t data[8], size_t &length) {
+        uint64_t timestamp;
+        return this->read_frame(id, data, length, timestamp);
+    }
+
+    bool CanSocket::read_frame(uint32_t &id, uint8_t data[8], size_t &length, uint64_t &timestamp) {
         can_frame frame;
         memset(&frame, 0, sizeof(frame));
 
-        if(read(this->socket_, &frame, sizeof(frame)) < 0) { std::printf("[CAN]: Failed to read frame\n"); return false; }
+        iovec iov{ &frame, sizeof(frame) };
+        alignas(cmsghdr) uint8_t control[CMSG_SPACE(sizeof(timespec))];
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if(recvmsg(this->socket_, &msg, 0) < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { length = 0; timestamp = 0; return true; }
+            log_message(LOG_ERROR, "CAN", "Failed to read frame"); return false;
+        }
+        timestamp = get_timestamp(msg);
 
         id = (frame.can_id & CAN_EFF_FLAG) ? (frame.can_id & CAN_EFF_MASK): (frame.can_id & CAN_SFF_MASK);
         length = frame.can_dlc;
         memcpy(data, frame.data, length);
         return true;
     }
-} // namespace robomaster_can_controller
\ No newline at end of file
+
+    bool CanSocket::send_frames(const CanFrame *frames, const size_t count) {
+        can_frame buffer[STD_BATCH_SIZE];
+        iovec iov[STD_BATCH_SIZE];
+        mmsghdr msgs[STD_BATCH_SIZE];
+
+        for (size_t offset = 0; offset < count;) {
+            const size_t batch = std::min(STD_BATCH_SIZE, count - offset);
+            for (size_t i = 0; i < batch; i++) {
+                const CanFrame &frame = frames[offset + i];
+                if (8 < frame.length) { log_message(LOG_ERROR, "CAN", "Failed to send frame"); return false; }
+
+                memset(&buffer[i], 0, sizeof(can_frame));
+                buffer[i].can_id = frame.id;
+                buffer[i].can_dlc = frame.length;
+                memcpy(buffer[i].data, frame.data, frame.length);
+
+                iov[i] = iovec{ &buffer[i], sizeof(can_frame) };
+                msgs[i] = mmsghdr{};
+                msgs[i].msg_hdr.msg_iov = &iov[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+
+            // sendmmsg may send less frames than requested, e.g. when the socket buffer is full.
+            const int sent = sendmmsg(this->socket_, msgs, static_cast<unsigned int>(batch), 0);
+            if (sent <= 0) { log_message(LOG_ERROR, "CAN", "Failed to send frame"); return false; }
+            offset += static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    bool CanSocket::read_frames(CanFrame *frames, const size_t capacity, size_t &count) {
+        can_frame buffer[STD_BATCH_SIZE];
+        iovec iov[STD_BATCH_SIZE];
+        mmsghdr msgs[STD_BATCH_SIZE];
+        alignas(cmsghdr) uint8_t control[STD_BATCH_SIZE][CMSG_SPACE(sizeof(timespec))];
+
+        const size_t batch = std::min(STD_BATCH_SIZE, capacity);
+        for (size_t i = 0; i < batch; i++) {
+            iov[i] = iovec{ &buffer[i], sizeof(can_frame) };
+            msgs[i] = mmsghdr{};
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = control[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+        }
+
+        // block for the first frame only and take all further frames which are already queued.
+        const int received = recvmmsg(this->socket_, msgs, static_cast<unsigned int>(batch), MSG_WAITFORONE, nullptr);
+        if (received < 0) {
+            count = 0;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) { return true; }
+            log_message(LOG_ERROR, "CAN", "Failed to read frame"); return false;
+        }
+
+        count = static_cast<size_t>(received);
+        for (size_t i = 0; i < count; i++) {
+            const can_frame &frame = buffer[i];
+            frames[i].id = (frame.can_id & CAN_EFF_FLAG) ? (frame.can_id & CAN_EFF_MASK): (frame.can_id & CAN_SFF_MASK);
+            frames[i].length = std::min<uint8_t>(frame.can_dlc, 8);
+            memcpy(frames[i].data, frame.data, frames[i].length);
+            frames[i].timestamp = get_timestamp(msgs[i].msg_hdr);
+        }
+        return true;
+    }
+} // namespace robomaster_can_controller
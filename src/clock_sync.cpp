@@ -0,0 +1,138 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/clock_sync.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace robomaster_can_controller {
+    static constexpr size_t STD_MIN_SAMPLES = 16;
+    static constexpr size_t STD_UNCERTAINTY_SAMPLES = 16;
+    static constexpr size_t STD_UNCERTAINTY_RANK = 24;
+
+    ClockSync::ClockSync(const size_t window)
+        : window_(std::max(window, STD_MIN_SAMPLES)),
+          device_reference_(0),
+          host_reference_(0),
+          device_last_(0),
+          offset_(0.0),
+          skew_(0.0),
+          uncertainty_(0),
+          flag_synchronised_(false) { }
+
+    void ClockSync::reset() {
+        this->samples_.clear();
+        this->hull_.clear();
+        this->device_last_ = 0;
+        this->offset_ = 0.0;
+        this->skew_ = 0.0;
+        this->uncertainty_ = 0;
+        this->flag_synchronised_ = false;
+    }
+
+    void ClockSync::add_sample(const uint32_t device_time, const uint64_t host_time) {
+        if (this->samples_.empty()) {
+            this->device_reference_ = device_time;
+            this->host_reference_ = host_time;
+            this->device_last_ = 0;
+            this->samples_.push_back(Sample{ 0, 0 });
+            return;
+        }
+
+        // the signed difference to the last sample handles the wrap around of the device clock.
+        const auto delta = static_cast<int32_t>(device_time - static_cast<uint32_t>(this->device_reference_ + this->device_last_));
+        const auto host = static_cast<int64_t>(host_time - this->host_reference_);
+
+        if (delta < 0) { this->reset(); this->add_sample(device_time, host_time); return; }
+        if (delta == 0) { this->samples_.back().host = std::min(this->samples_.back().host, host); }
+        else {
+            this->device_last_ += delta;
+            this->samples_.push_back(Sample{ this->device_last_, host });
+            if (this->window_ < this->samples_.size()) { this->samples_.pop_front(); }
+        }
+        this->estimate();
+    }
+
+    void ClockSync::estimate() {
+        if (this->samples_.size() < STD_MIN_SAMPLES) { return; }
+
+        // lower convex hull with the monotone chain, the samples are already ordered by device time.
+        this->hull_.clear();
+        for (const auto &sample : this->samples_) {
+            while (2 <= this->hull_.size()) {
+                const auto &o = this->hull_[this->hull_.size() - 2];
+                const auto &a = this->hull_.back();
+                const double cross = static_cast<double>(a.device - o.device) * static_cast<double>(sample.host - o.host) - static_cast<double>(a.host - o.host) * static_cast<double>(sample.device - o.device);
+                if (0.0 < cross) { break; }
+                this->hull_.pop_back();
+            }
+            this->hull_.push_back(sample);
+        }
+
+        // the hull vertices around the mean device time give the drift, a chord of at least half the window keeps it robust against short hull edges.
+        double mean = 0.0;
+        for (const auto &sample : this->samples_) { mean += static_cast<double>(sample.device); }
+        mean /= static_cast<double>(this->samples_.size());
+
+        size_t first = 0;
+        while (first + 2 < this->hull_.size() && static_cast<double>(this->hull_[first + 1].device) < mean) { first++; }
+        size_t last = first + 1;
+
+        const int64_t span = (this->samples_.back().device - this->samples_.front().device) / 2;
+        while (this->hull_[last].device - this->hull_[first].device < span) {
+            if (0 < first) { first--; }
+            if (last + 1 < this->hull_.size()) { last++; }
+        }
+
+        const auto &p0 = this->hull_[first];
+        const auto &p1 = this->hull_[last];
+        const double skew = static_cast<double>(p1.host - p0.host) / static_cast<double>(p1.device - p0.device);
+        if (!(0.0 < skew)) { return; }
+
+        // lower the line until it supports the hull, so no sample is earlier than the mapped time.
+        double offset = INFINITY;
+        for (const auto &vertex : this->hull_) { offset = std::min(offset, static_cast<double>(vertex.host) - skew * static_cast<double>(vertex.device)); }
+
+        this->skew_ = skew;
+        this->offset_ = offset;
+
+        // the delay of the fastest samples scatters above the minimal delay by about the same amount as the fitted line does,
+        // so the distance of the STD_UNCERTAINTY_RANK-th fastest sample bounds the error of the line with high probability.
+        // When the drift changes faster than the window can follow, the recent samples move away from the line and raise the bound.
+        this->residuals_.clear();
+        for (const auto &sample : this->samples_) { this->residuals_.push_back(static_cast<double>(sample.host) - (this->offset_ + this->skew_ * static_cast<double>(sample.device))); }
+        const size_t rank = std::min(STD_UNCERTAINTY_RANK, this->residuals_.size() - 1);
+        std::nth_element(this->residuals_.begin(), this->residuals_.begin() + static_cast<long>(rank), this->residuals_.end());
+        double residual = INFINITY;
+        const size_t count = std::min(STD_UNCERTAINTY_SAMPLES, this->samples_.size());
+        for (auto sample = this->samples_.crbegin(); sample != this->samples_.crbegin() + static_cast<long>(count); ++sample) {
+            residual = std::min(residual, static_cast<double>(sample->host) - (this->offset_ + this->skew_ * static_cast<double>(sample->device)));
+        }
+        residual = std::max(residual, this->residuals_[rank]);
+        this->uncertainty_ = static_cast<uint64_t>(std::llround(std::max(residual, 0.0)));
+        this->flag_synchronised_ = true;
+    }
+
+    bool ClockSync::is_synchronised() const {
+        return this->flag_synchronised_;
+    }
+
+    uint64_t ClockSync::to_host_time(const uint32_t device_time) const {
+        if (!this->flag_synchronised_) { return 0; }
+        const auto delta = static_cast<int32_t>(device_time - static_cast<uint32_t>(this->device_reference_ + this->device_last_));
+        const double device = static_cast<double>(this->device_last_ + delta);
+        return this->host_reference_ + static_cast<uint64_t>(std::llround(this->offset_ + this->skew_ * device));
+    }
+
+    uint64_t ClockSync::get_uncertainty() const {
+        return this->uncertainty_;
+    }
+
+    double ClockSync::get_skew() const {
+        return this->flag_synchronised_ ? this->skew_ : 0.0;
+    }
+} // namespace robomaster_can_controller
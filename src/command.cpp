@@ -0,0 +1,97 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/command.h"
+#include "robomaster_can_controller/definitions.h"
+#include "robomaster_can_controller/utils.h"
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Create the LED message with the given effect mode and colour.
+     */
+    static Message make_led_command(const uint16_t mode, const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b, const uint16_t t_1, const uint16_t t_2, const uint16_t sequence) {
+        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, sequence, { 0x00, 0x3f, 0x32, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+        msg.set_value_uint16(3, mode);
+        msg.set_value_uint8(6, r);
+        msg.set_value_uint8(7, g);
+        msg.set_value_uint8(8, b);
+        msg.set_value_uint16(10, t_1);
+        msg.set_value_uint16(12, t_2);
+        msg.set_value_uint16(14, mask);
+        return msg;
+    }
+
+    Message make_work_mode_command(const bool mode) {
+        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0xc309, 0, { 0x40, 0x3f, 0x19, 0x00 });
+        msg.set_value_uint8(3, mode);
+        return msg;
+    }
+
+    Message make_velocity_command(const float x, const float y, const float z, const uint16_t sequence) {
+        const auto cx = clip<float>(x,   -3.5f,   3.5f);
+        const auto cy = clip<float>(y,   -3.5f,   3.5f);
+        const auto cz = clip<float>(z, -600.0f, 600.0f);
+
+        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, sequence, { 0x00, 0x3f, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+        msg.set_value_float(3, cx);
+        msg.set_value_float(7, cy);
+        msg.set_value_float(11, cz);
+        return msg;
+    }
+
+    Message make_wheel_rpm_command(const int16_t fr, const int16_t fl, const int16_t rl, const int16_t rr, const uint16_t sequence) {
+        const auto w1 = clip<int16_t>(fr, -1000, 1000);
+        const auto w2 = clip<int16_t>(fl, -1000, 1000);
+        const auto w3 = clip<int16_t>(rl, -1000, 1000);
+        const auto w4 = clip<int16_t>(rr, -1000, 1000);
+
+        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, sequence, { 0x40, 0x3F, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+        msg.set_value_int16(3, w1);
+        msg.set_value_int16(5, w2);
+        msg.set_value_int16(7, w3);
+        msg.set_value_int16(9, w4);
+        return msg;
+    }
+
+    Message make_brake_command(const uint16_t sequence) {
+        return Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, sequence, { 0x40, 0x3F, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+    }
+
+    Message make_gimbal_command(const int16_t y, const int16_t z, const uint16_t sequence) {
+        const auto cy = clip<int16_t>(y, -1024, 1024);
+        const auto cz = clip<int16_t>(z, -1024, 1024);
+
+        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0x0409, sequence, { 0x00, 0x04, 0x69, 0x08, 0x05, 0x00, 0x00, 0x00, 0x00 });
+        msg.set_value_int16(5, cy);
+        msg.set_value_int16(7, cz);
+        return msg;
+    }
+
+    Message make_blaster_command(const BlasterType blaster, const uint16_t sequence) {
+        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0x1709, sequence);
+        switch (blaster) {
+            case INFRARED: msg.set_payload({ 0x00, 0x3f, 0x55, 0x73, 0x00, 0xff, 0x00, 0x01, 0x28, 0x00, 0x00 }); break;
+            case GELBEADS: msg.set_payload({ 0x00, 0x3f, 0x51, 0x01 }); break;
+        }
+        return msg;
+    }
+
+    Message make_led_off_command(const uint16_t mask, const uint16_t sequence) {
+        return make_led_command(0x70, mask, 0, 0, 0, 0, 0, sequence);
+    }
+
+    Message make_led_on_command(const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b, const uint16_t sequence) {
+        return make_led_command(0x71, mask, r, g, b, 0, 0, sequence); // effect mode on
+    }
+
+    Message make_led_breath_command(const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b, const uint16_t t_rise, const uint16_t t_down, const uint16_t sequence) {
+        return make_led_command(0x72, mask, r, g, b, t_rise, t_down, sequence); // effect mode breath
+    }
+
+    Message make_led_flash_command(const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b, const uint16_t t_on, const uint16_t t_off, const uint16_t sequence) {
+        return make_led_command(0x73, mask, r, g, b, t_on, t_off, sequence);
+    }
+} // namespace robomaster_can_controller
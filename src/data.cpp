@@ -106,6 +106,52 @@ namespace robomaster_can_controller {
         return data;
     }
 
+    DataTimestamp decode_data_timestamp(const Message &msg) {
+        DataTimestamp data;
+
+        // A zero time marks a message without receive times.
+        if (msg.get_time_first_frame() != 0 && msg.get_time_last_frame() != 0) {
+            data.first_frame = msg.get_time_first_frame();
+            data.last_frame  = msg.get_time_last_frame();
+            data.has_data = true;
+        }
+        return data;
+    }
+
+    DataRoboMasterState decode_robomaster_state(const Message &msg) {
+        DataRoboMasterState data;
+        data.velocity   = decode_data_velocity(27, msg);
+        data.battery    = decode_data_battery(51, msg);
+        data.esc        = decode_data_esc(61, msg);
+        data.imu        = decode_data_imu(97, msg);
+        data.attitude   = decode_data_attitude(121, msg);
+        data.position   = decode_data_position(133, msg);
+        data.timestamp  = decode_data_timestamp(msg);
+        return data;
+    }
+
+    uint32_t get_sections(const DataRoboMasterState &data) {
+        uint32_t sections = 0;
+        if (data.battery.has_data) { sections |= SECTION_BATTERY; }
+        if (data.esc.has_data) { sections |= SECTION_ESC; }
+        if (data.imu.has_data) { sections |= SECTION_IMU; }
+        if (data.velocity.has_data) { sections |= SECTION_VELOCITY; }
+        if (data.position.has_data) { sections |= SECTION_POSITION; }
+        if (data.attitude.has_data) { sections |= SECTION_ATTITUDE; }
+        if (data.timestamp.has_data) { sections |= SECTION_TIMESTAMP; }
+        return sections;
+    }
+
+    void set_sections(DataRoboMasterState &data, const uint32_t sections) {
+        data.battery.has_data = (sections & SECTION_BATTERY) != 0;
+        data.esc.has_data = (sections & SECTION_ESC) != 0;
+        data.imu.has_data = (sections & SECTION_IMU) != 0;
+        data.velocity.has_data = (sections & SECTION_VELOCITY) != 0;
+        data.position.has_data = (sections & SECTION_POSITION) != 0;
+        data.attitude.has_data = (sections & SECTION_ATTITUDE) != 0;
+        data.timestamp.has_data = (sections & SECTION_TIMESTAMP) != 0;
+    }
+
     std::ostream& operator<<(std::ostream& os, const DataEsc &data) {
         os << "{";
         if (data.has_data) {
@@ -167,6 +213,29 @@ namespace robomaster_can_controller {
         return os;
     }
 
+    std::ostream& operator<<(std::ostream& os, const DataTimestamp &data) {
+        os << "{";
+        if (data.has_data) {
+            os << "\"first_frame\": " << data.first_frame << ", \"last_frame\": " << data.last_frame
+               << ", \"acquisition\": " << data.acquisition << ", \"uncertainty\": " << data.uncertainty;
+        }
+        os << "}";
+        return os;
+    }
+
+    std::ostream& print_with_timestamp(std::ostream& os, const DataRoboMasterState &data) {
+        os << "{\"robomaster\":{"
+           << "\"battery\":" << data.battery << ","
+           << "\"esc\":" << data.esc << ","
+           << "\"imu\":" << data.imu << ","
+           << "\"velocity\":" << data.velocity << ","
+           << "\"position\":" << data.position << ","
+           << "\"attitude\":" << data.attitude << ","
+           << "\"timestamp\":" << data.timestamp
+           << "}}";
+        return os;
+    }
+
     std::ostream& operator<<(std::ostream& os, const DataRoboMasterState &data) {
         os << "{\"robomaster\":{"
            << "\"battery\":" << data.battery << ","
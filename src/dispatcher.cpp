@@ -0,0 +1,54 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/dispatcher.h"
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+namespace robomaster_can_controller {
+    Dispatcher::Dispatcher() = default;
+
+    uint64_t Dispatcher::make_key(const uint32_t device_id, const uint16_t type) {
+        return static_cast<uint64_t>(device_id) << 16 | type;
+    }
+
+    void Dispatcher::bind_callback(const uint32_t device_id, const uint16_t type, std::vector<uint8_t> prefix, std::function<void(const Message&)> func) {
+        std::unique_lock lock(this->mutex_);
+        auto &subscriptions = this->table_[make_key(device_id, type)];
+        const auto subscription = std::find_if(subscriptions.begin(), subscriptions.end(), [&prefix](const Subscription &s) { return s.prefix == prefix; });
+
+        if (subscription != subscriptions.end()) { subscription->callback = std::move(func); return; }
+        subscriptions.push_back(Subscription{ std::move(prefix), std::move(func) });
+    }
+
+    bool Dispatcher::unbind_callback(const uint32_t device_id, const uint16_t type, const std::vector<uint8_t> &prefix) {
+        std::unique_lock lock(this->mutex_);
+        const auto slice = this->table_.find(make_key(device_id, type));
+        if (slice == this->table_.end()) { return false; }
+
+        auto &subscriptions = slice->second;
+        const auto size = subscriptions.size();
+        std::erase_if(subscriptions, [&prefix](const Subscription &s) { return s.prefix == prefix; });
+        const bool removed = size != subscriptions.size();
+        if (subscriptions.empty()) { this->table_.erase(slice); }
+        return removed;
+    }
+
+    bool Dispatcher::dispatch(const Message &msg) const {
+        std::shared_lock lock(this->mutex_);
+        const auto slice = this->table_.find(make_key(msg.get_device_id(), msg.get_type()));
+        if (slice == this->table_.end()) { return false; }
+
+        bool dispatched = false;
+        const auto &payload = msg.get_payload();
+        for (const auto &[prefix, callback] : slice->second) {
+            if (prefix.size() <= payload.size() && std::equal(prefix.cbegin(), prefix.cend(), payload.cbegin()) && callback) { callback(msg); dispatched = true; }
+        }
+        return dispatched;
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,240 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/emulator.h"
+#include "robomaster_can_controller/can_socket.h"
+#include "robomaster_can_controller/definitions.h"
+#include "robomaster_can_controller/logger.h"
+
+#include <poll.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numbers>
+#include <utility>
+
+namespace robomaster_can_controller {
+    static constexpr size_t STD_PUSH_PAYLOAD_LENGTH = 145;
+    static constexpr uint8_t STD_BOOT_MASK_COMPLETE = 0x07;
+    static constexpr int STD_POLL_TIMEOUT_MS = 1;
+    static constexpr size_t STD_MAX_FRAMES = 32;
+
+    Emulator::Emulator(const uint64_t seed)
+        : generator_(seed),
+          frame_loss_(0.0),
+          frame_corruption_(0.0),
+          push_period_(20000000),
+          push_time_(0),
+          time_(0),
+          push_sequence_(0),
+          boot_mask_(0),
+          flag_stop_(false)
+    {
+        for (uint32_t id = Reassembler::DEVICE_ID_BASE; id < Reassembler::DEVICE_ID_BASE + Reassembler::DEVICE_ID_COUNT; id++) { this->reassembler_.disable_device(id); }
+        this->reassembler_.enable_device(DEVICE_ID_INTELLI_CONTROLLER);
+    }
+
+    Emulator::~Emulator() {
+        this->flag_stop_ = true;
+        if (this->thread_.joinable()) { this->thread_.join(); }
+    }
+
+    void Emulator::set_frame_sink(std::function<void(uint32_t, const uint8_t*, size_t)> func) {
+        std::lock_guard lock(this->mutex_);
+        this->frame_sink_ = std::move(func);
+    }
+
+    void Emulator::set_push_rate(const double rate) {
+        std::lock_guard lock(this->mutex_);
+        this->push_period_ = 0.0 < rate ? static_cast<uint64_t>(1e9 / rate) : 0;
+        this->push_time_ = this->time_ + this->push_period_;
+    }
+
+    void Emulator::set_frame_loss(const double probability) {
+        std::lock_guard lock(this->mutex_);
+        this->frame_loss_ = std::clamp(probability, 0.0, 1.0);
+    }
+
+    void Emulator::set_frame_corruption(const double probability) {
+        std::lock_guard lock(this->mutex_);
+        this->frame_corruption_ = std::clamp(probability, 0.0, 1.0);
+    }
+
+    void Emulator::push_frame(const uint32_t id, const uint8_t *data, const size_t length) {
+        std::lock_guard lock(this->mutex_);
+        std::vector<Message> messages;
+
+        this->statistics_.frames_received++;
+        this->reassembler_.push_frame(id, data, length, messages);
+        for (const auto &msg : messages) { this->process_message(msg); }
+    }
+
+    void Emulator::process_message(const Message &msg) {
+        const auto &payload = msg.get_payload();
+        this->statistics_.messages_received++;
+        if (payload.size() < 3) { return; }
+
+        const uint8_t cmd_id = payload[2];
+        switch (msg.get_type()) {
+            case 0x0309:
+                if (cmd_id == 0x04) { this->boot_mask_ |= 0x01; }
+                if (cmd_id == 0x01) { this->boot_mask_ |= 0x02; }
+                if (cmd_id == 0x03) { this->boot_mask_ |= 0x04; }
+                this->state_.booted = this->boot_mask_ == STD_BOOT_MASK_COMPLETE;
+                break;
+            case 0xc309:
+                if (cmd_id == 0x19 && 4 <= payload.size()) { this->state_.work_mode = payload[3] != 0; }
+                if (cmd_id == 0x60) { this->statistics_.heartbeats++; }
+                break;
+            case 0xc3c9:
+                if (cmd_id == 0x20 && 11 <= payload.size()) {
+                    for (size_t i = 0; i < 4; i++) { this->state_.wheel_rpm[i] = msg.get_value_int16(3 + 2 * i); }
+                    this->state_.velocity = { 0.0f, 0.0f, 0.0f };
+                }
+                if (cmd_id == 0x21 && 15 <= payload.size()) {
+                    for (size_t i = 0; i < 3; i++) { this->state_.velocity[i] = msg.get_value_float(3 + 4 * i); }
+                    this->state_.wheel_rpm = { 0, 0, 0, 0 };
+                }
+                break;
+            case 0x0409:
+                if (cmd_id == 0x69 && 9 <= payload.size()) { this->state_.gimbal = { msg.get_value_int16(5), msg.get_value_int16(7) }; }
+                break;
+            case 0x1809:
+                if (cmd_id == 0x32 && 16 <= payload.size()) {
+                    this->state_.led_mode = msg.get_value_uint16(3);
+                    this->state_.led_color = { payload[6], payload[7], payload[8] };
+                    this->state_.led_mask = msg.get_value_uint16(14);
+                }
+                break;
+            default: break;
+        }
+
+        // the ack is sent by the motion controller with swapped sender and receiver in the type.
+        if (payload[0] & 0x40) {
+            const auto type = static_cast<uint16_t>(msg.get_type() << 8 | msg.get_type() >> 8);
+            this->send_message(Message(DEVICE_ID_MOTION_CONTROLLER, type, msg.get_sequence(), { 0x80, payload[1], payload[2], 0x00 }));
+            this->statistics_.acks++;
+        }
+    }
+
+    Message Emulator::make_state_push() {
+        Message msg(DEVICE_ID_MOTION_CONTROLLER, 0x0903, this->push_sequence_++, std::vector<uint8_t>(STD_PUSH_PAYLOAD_LENGTH, 0x00));
+        msg.set_value_uint32(0, 0x00084820);
+
+        const float yaw = this->state_.yaw * std::numbers::pi_v<float> / 180.0f;
+        const auto &velocity = this->state_.velocity;
+        msg.set_value_float(27, velocity[0] * std::cos(yaw) - velocity[1] * std::sin(yaw));
+        msg.set_value_float(31, velocity[0] * std::sin(yaw) + velocity[1] * std::cos(yaw));
+        msg.set_value_float(35, 0.0f);
+        msg.set_value_float(39, velocity[0]);
+        msg.set_value_float(43, velocity[1]);
+        msg.set_value_float(47, 0.0f);
+
+        msg.set_value_uint16(51, 12000);
+        msg.set_value_uint16(53, 300);
+        msg.set_value_int32(55, -1000);
+        msg.set_value_uint8(59, 100);
+
+        // the esc timestamps run with one tick per microsecond.
+        const auto ticks = static_cast<uint32_t>(this->time_ / 1000);
+        for (size_t i = 0; i < 4; i++) {
+            msg.set_value_int16(61 + 2 * i, this->state_.wheel_rpm[i]);
+            msg.set_value_uint32(77 + 4 * i, ticks);
+        }
+
+        msg.set_value_float(105, 1.0f);
+        msg.set_value_float(117, velocity[2]);
+        msg.set_value_float(121, this->state_.yaw);
+        for (size_t i = 0; i < 3; i++) { msg.set_value_float(133 + 4 * i, this->state_.position[i]); }
+        return msg;
+    }
+
+    void Emulator::send_message(const Message &msg) {
+        if (!this->frame_sink_) { return; }
+        const auto data = msg.to_vector();
+        std::bernoulli_distribution loss(this->frame_loss_);
+        std::bernoulli_distribution corruption(this->frame_corruption_);
+        uint8_t frame[8];
+
+        for (size_t i = 0; i < data.size(); i += 8) {
+            const size_t length = std::min(static_cast<size_t>(8), data.size() - i);
+            std::copy_n(data.begin() + static_cast<long>(i), length, frame);
+
+            if (loss(this->generator_)) { this->statistics_.frames_dropped++; continue; }
+            if (corruption(this->generator_)) {
+                frame[this->generator_() % length] ^= static_cast<uint8_t>(1u << this->generator_() % 8);
+                this->statistics_.frames_corrupted++;
+            }
+            this->frame_sink_(msg.get_device_id(), frame, length);
+            this->statistics_.frames_sent++;
+        }
+    }
+
+    size_t Emulator::step(const uint64_t time) {
+        std::lock_guard lock(this->mutex_);
+        size_t counter = 0;
+
+        const auto integrate = [this](const uint64_t t) {
+            const float dt = static_cast<float>(t - this->time_) * 1e-9f;
+            const float yaw = this->state_.yaw * std::numbers::pi_v<float> / 180.0f;
+            const auto &velocity = this->state_.velocity;
+            this->state_.position[0] += (velocity[0] * std::cos(yaw) - velocity[1] * std::sin(yaw)) * dt;
+            this->state_.position[1] += (velocity[0] * std::sin(yaw) + velocity[1] * std::cos(yaw)) * dt;
+            this->state_.yaw = std::remainder(this->state_.yaw + velocity[2] * dt, 360.0f);
+            this->time_ = t;
+        };
+
+        if (time < this->time_) { return 0; }
+        while (this->push_period_ != 0 && this->push_time_ <= time) {
+            integrate(this->push_time_);
+            this->send_message(this->make_state_push());
+            this->statistics_.pushes++;
+            this->push_time_ += this->push_period_;
+            counter++;
+        }
+        integrate(time);
+        return counter;
+    }
+
+    bool Emulator::init(const std::string &can_interface) {
+        return this->init(std::make_unique<CanSocket>(), can_interface);
+    }
+
+    bool Emulator::init(std::unique_ptr<Transport> transport, const std::string &name) {
+        if (this->thread_.joinable()) { log_message(LOG_ERROR, "Emulator", "Emulator already running"); return false; }
+        this->transport_.set_transport(std::move(transport));
+        if (!this->transport_.init(name)) { log_message(LOG_ERROR, "Emulator", "Emulator initialization failure"); return false; }
+
+        this->set_frame_sink([this](const uint32_t id, const uint8_t *data, const size_t length) { this->transport_.send_frame(id, data, length); });
+        this->thread_ = std::thread(&Emulator::start_thread, this);
+        return true;
+    }
+
+    void Emulator::start_thread() {
+        const auto start = std::chrono::steady_clock::now();
+        pollfd fd{ this->transport_.get_fd(), POLLIN, 0 };
+        CanFrame frames[STD_MAX_FRAMES];
+        size_t count;
+
+        while (!this->flag_stop_) {
+            if (0 < poll(&fd, 1, STD_POLL_TIMEOUT_MS) && this->transport_.read_frames(frames, STD_MAX_FRAMES, count)) {
+                for (size_t i = 0; i < count; i++) { this->push_frame(frames[i].id, frames[i].data, frames[i].length); }
+            }
+            this->step(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+        }
+    }
+
+    EmulatorState Emulator::get_state() const {
+        std::lock_guard lock(this->mutex_);
+        return this->state_;
+    }
+
+    EmulatorStatistics Emulator::get_statistics() const {
+        std::lock_guard lock(this->mutex_);
+        return this->statistics_;
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,226 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/fleet.h"
+#include "robomaster_can_controller/logger.h"
+#include "robomaster_can_controller/trace.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+
+namespace robomaster_can_controller {
+    static constexpr size_t STD_MAX_EVENTS = 16;
+    static constexpr size_t STD_MAX_FRAMES = 32;
+    static constexpr size_t STD_MAX_SEND_BURST = 64;
+    static constexpr double STD_READ_TIMEOUT = 0.001;
+
+    template<FrameTransport T>
+    BasicFleet<T>::BasicFleet() : epoll_fd_(-1), timer_fd_(-1), event_fd_(-1), flag_notified_(false), flag_stop_(false), flag_initialised_(false) { }
+
+    template<FrameTransport T>
+    BasicFleet<T>::~BasicFleet() {
+        if (this->flag_initialised_) {
+            this->flag_stop_ = true;
+            this->notify();
+            this->thread_io_.join();
+            { std::lock_guard lock(this->dispatch_mutex_); this->cv_dispatch_.notify_all(); }
+            for (auto &thread : this->threads_dispatch_) { thread.join(); }
+
+            // the handlers can not run without the threads, so they are stopped and no longer detach themselves.
+            for (const auto &member : this->members_) {
+                member->handler->flag_stop_ = true;
+                member->handler->fleet_.store(nullptr, std::memory_order_release);
+            }
+        }
+        if (0 <= this->epoll_fd_) { close(this->epoll_fd_); }
+        if (0 <= this->timer_fd_) { close(this->timer_fd_); }
+        if (0 <= this->event_fd_) { close(this->event_fd_); }
+    }
+
+    template<FrameTransport T>
+    bool BasicFleet<T>::init(const size_t dispatch_threads) {
+        if (this->flag_initialised_) { log_message(LOG_WARNING, "Fleet", "Fleet already running"); return false; }
+
+        this->epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        this->timer_fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        this->event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (this->epoll_fd_ < 0 || this->timer_fd_ < 0 || this->event_fd_ < 0) { log_message(LOG_ERROR, "Fleet", "Failed to create file descriptors"); return false; }
+
+        // the timer and the eventfd are marked with a null pointer, the transports with their member.
+        for (const int fd : { this->timer_fd_, this->event_fd_ }) {
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.ptr = nullptr;
+            if (epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) { log_message(LOG_ERROR, "Fleet", "Failed to register file descriptor"); return false; }
+        }
+
+        this->flag_initialised_ = true;
+        this->thread_io_ = std::thread(&BasicFleet::start_io_thread, this);
+        for (size_t i = 0; i < std::max(static_cast<size_t>(1), dispatch_threads); i++) { this->threads_dispatch_.emplace_back(&BasicFleet::start_dispatch_thread, this); }
+        return true;
+    }
+
+    template<FrameTransport T>
+    size_t BasicFleet<T>::get_size() {
+        std::lock_guard lock(this->mutex_);
+        return this->members_.size();
+    }
+
+    template<FrameTransport T>
+    bool BasicFleet<T>::attach(BasicHandler<T> &handler, const std::string &can_interface) {
+        if (!this->flag_initialised_) { log_message(LOG_ERROR, "Fleet", "Fleet not initialised"); return false; }
+        if (!handler.transport_.init(can_interface)) { return false; }
+
+        // the io thread only reads after epoll reported the transport as readable, the short timeout bounds a spurious wakeup.
+        handler.transport_.set_timeout(STD_READ_TIMEOUT);
+        handler.heartbeat_time_point_ = std::chrono::high_resolution_clock::now();
+        handler.flag_initialised_ = true;
+        handler.fleet_.store(this, std::memory_order_release);
+
+        auto member = std::make_shared<Member>();
+        member->handler = &handler;
+
+        std::lock_guard lock(this->mutex_);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = member.get();
+        if (epoll_ctl(this->epoll_fd_, EPOLL_CTL_ADD, handler.transport_.get_fd(), &event) < 0) {
+            log_message(LOG_ERROR, "Fleet", "Failed to register transport");
+            handler.fleet_.store(nullptr, std::memory_order_release);
+            handler.flag_stop_ = true;
+            return false;
+        }
+        this->members_.push_back(std::move(member));
+        this->notify();
+        return true;
+    }
+
+    template<FrameTransport T>
+    void BasicFleet<T>::detach(BasicHandler<T> &handler) {
+        std::shared_ptr<Member> member;
+        {
+            std::lock_guard lock(this->mutex_);
+            const auto it = std::find_if(this->members_.begin(), this->members_.end(), [&handler](const auto &m) { return m->handler == &handler; });
+            if (it == this->members_.end()) { return; }
+            member = *it;
+            if (member->polled) { epoll_ctl(this->epoll_fd_, EPOLL_CTL_DEL, handler.transport_.get_fd(), nullptr); }
+            this->members_.erase(it);
+        }
+
+        // a running dispatch of the handler finishes first, a queued dispatch is skipped.
+        std::lock_guard lock(member->dispatch_mutex);
+        member->detached = true;
+        handler.flag_stop_ = true;
+        handler.fleet_.store(nullptr, std::memory_order_release);
+    }
+
+    template<FrameTransport T>
+    void BasicFleet<T>::notify() {
+        if (this->flag_notified_.exchange(true, std::memory_order_acq_rel)) { return; }
+        constexpr uint64_t value = 1;
+        (void)write(this->event_fd_, &value, sizeof(value));
+    }
+
+    template<FrameTransport T>
+    void BasicFleet<T>::schedule(const std::shared_ptr<Member> &member) {
+        if (member->scheduled.exchange(true, std::memory_order_acq_rel)) { return; }
+        {
+            std::lock_guard lock(this->dispatch_mutex_);
+            this->dispatch_queue_.push_back(member);
+        }
+        this->cv_dispatch_.notify_one();
+    }
+
+    template<FrameTransport T>
+    bool BasicFleet<T>::send_all() {
+        const auto now = std::chrono::high_resolution_clock::now();
+        auto next = std::chrono::high_resolution_clock::time_point::max();
+        bool pending = false;
+
+        for (const auto &member : this->members_) {
+            BasicHandler<T> &handler = *member->handler;
+            if (!handler.is_running()) { continue; }
+            size_t count = 0;
+            while (count < STD_MAX_SEND_BURST && handler.send_step(now)) { count++; }
+            if (count == STD_MAX_SEND_BURST) { pending = true; }
+            next = std::min(next, handler.heartbeat_time_point_);
+        }
+
+        // the timer is armed relative to the earliest heartbeat of all handlers and disarmed without handlers.
+        itimerspec timer{};
+        if (next != std::chrono::high_resolution_clock::time_point::max()) {
+            const auto delay = std::max(std::chrono::nanoseconds(1), std::chrono::duration_cast<std::chrono::nanoseconds>(next - now));
+            timer.it_value.tv_sec = static_cast<time_t>(delay.count() / 1000000000);
+            timer.it_value.tv_nsec = static_cast<long>(delay.count() % 1000000000);
+        }
+        timerfd_settime(this->timer_fd_, 0, &timer, nullptr);
+        return pending;
+    }
+
+    template<FrameTransport T>
+    void BasicFleet<T>::start_io_thread() {
+        std::array<epoll_event, STD_MAX_EVENTS> events;
+        std::array<CanFrame, STD_MAX_FRAMES> frames;
+        std::vector<Message> messages;
+        bool pending = false;
+        ROBOMASTER_TRACE_THREAD_NAME("fleet_io");
+
+        while (!this->flag_stop_) {
+            const int count = epoll_wait(this->epoll_fd_, events.data(), static_cast<int>(events.size()), pending ? 0 : -1);
+            if (count < 0 && errno != EINTR) { log_message(LOG_ERROR, "Fleet", "Failed to wait for events"); break; }
+
+            std::lock_guard lock(this->mutex_);
+            for (int i = 0; i < count; i++) {
+                if (events[i].data.ptr == nullptr) {
+                    uint64_t value;
+                    (void)read(this->timer_fd_, &value, sizeof(value));
+                    this->flag_notified_.store(false, std::memory_order_release);
+                    (void)read(this->event_fd_, &value, sizeof(value));
+                    continue;
+                }
+
+                // the event may belong to a handler which was detached after epoll_wait returned.
+                const auto it = std::find_if(this->members_.begin(), this->members_.end(), [&events, i](const auto &m) { return m.get() == events[i].data.ptr; });
+                if (it == this->members_.end()) { continue; }
+
+                BasicHandler<T> &handler = *(*it)->handler;
+                if (handler.is_running() && handler.receive_step(frames.data(), frames.size(), messages) != 0) { this->schedule(*it); }
+                if (!handler.is_running() && (*it)->polled) { epoll_ctl(this->epoll_fd_, EPOLL_CTL_DEL, handler.transport_.get_fd(), nullptr); (*it)->polled = false; }
+            }
+            pending = this->send_all();
+        }
+    }
+
+    template<FrameTransport T>
+    void BasicFleet<T>::start_dispatch_thread() {
+        ROBOMASTER_TRACE_THREAD_NAME("fleet_dispatch");
+        while (true) {
+            std::shared_ptr<Member> member;
+            {
+                std::unique_lock lock(this->dispatch_mutex_);
+                this->cv_dispatch_.wait(lock, [this] { return this->flag_stop_ || !this->dispatch_queue_.empty(); });
+                if (this->flag_stop_) { return; }
+                member = std::move(this->dispatch_queue_.front());
+                this->dispatch_queue_.pop_front();
+            }
+
+            // cleared before the dispatch, so messages which arrive during the dispatch queue the handler again.
+            member->scheduled.store(false, std::memory_order_release);
+            std::lock_guard lock(member->dispatch_mutex);
+            if (!member->detached) { member->handler->dispatch_step(); }
+        }
+    }
+
+    template class BasicFleet<CanSocket>;
+    template class BasicFleet<LoopbackTransport>;
+    template class BasicFleet<AnyTransport>;
+} // namespace robomaster_can_controller
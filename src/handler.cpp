@@ -5,163 +5,365 @@
 // All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
 
 #include "robomaster_can_controller/handler.h"
+#include "robomaster_can_controller/fleet.h"
 #include "robomaster_can_controller/utils.h"
 #include "robomaster_can_controller/definitions.h"
+#include "robomaster_can_controller/trace.h"
+#include "robomaster_can_controller/logger.h"
 
+#include <array>
 #include <iostream>
 #include <algorithm>
-#include <map>
 #include <utility>
 
 namespace robomaster_can_controller {
     static constexpr size_t STD_MAX_ERROR_COUNT = 3;
     static constexpr auto STD_HEARTBEAT_TIME =  std::chrono::milliseconds(10);
+    static constexpr size_t STD_MAX_FRAMES = 32;
+    static constexpr size_t STD_MAX_INGRESS_COMMANDS = 32;
 
-    Handler::Handler()
-        : flag_initialised_(false),
+    template<FrameTransport T>
+    BasicHandler<T>::BasicHandler()
+        : recorder_(nullptr),
+          ingress_(nullptr),
+          attaching_(0),
+          fleet_(nullptr),
+          receiver_errors_(0),
+          sender_errors_(0),
+          flag_initialised_(false),
           flag_stop_(false) { }
 
-    void Handler::notify_all() {
+    template<FrameTransport T>
+    void BasicHandler<T>::notify_all() {
         this->cv_handler_.notify_all();
         this->cv_sender_.notify_all();
+        std::shared_lock lock(this->attach_mutex_);
+        if (this->ingress_ != nullptr) { this->ingress_->notify(); }
     }
 
-    void Handler::join_all() {
-        this->thread_receiver_.join();
-        this->thread_sender_.join();
-        this->thread_handler_.join();
+    template<FrameTransport T>
+    void BasicHandler<T>::join_all() {
+        // the threads are not started when the handler was attached to a fleet.
+        for (auto *thread : { &this->thread_receiver_, &this->thread_sender_, &this->thread_handler_ }) { if (thread->joinable()) { thread->join(); } }
     }
 
-    Handler::~Handler() {
+    template<FrameTransport T>
+    BasicHandler<T>::~BasicHandler() {
         if (this->flag_initialised_) {
+            if (BasicFleet<T> *fleet = this->fleet_.load(std::memory_order_acquire)) { fleet->detach(*this); return; }
             this->flag_stop_ = true;
             this->notify_all();
             this->join_all();
         }
     }
 
-    bool Handler::init(const std::string &can_interface) {
+    template<FrameTransport T>
+    bool BasicHandler<T>::init(const std::string &can_interface) {
         if (this->flag_initialised_) {
-            std::printf("[Handler]: Handler already running\n");
+            log_message(LOG_WARNING, "Handler", "Handler already running");
             return false;
         }
-        if(this->can_socket_.init(can_interface)) {
-            this->can_socket_.set_timeout(0.1);
+        if(this->transport_.init(can_interface)) {
+            this->transport_.set_timeout(0.1);
+            this->heartbeat_time_point_ = std::chrono::high_resolution_clock::now();
             this->flag_initialised_ = true;
-            this->thread_receiver_ = std::thread(&Handler::start_receiver_thread, this);
-            this->thread_sender_ = std::thread(&Handler::start_sender_thread, this);
-            this->thread_handler_ = std::thread(&Handler::start_handler_thread, this);
+            this->thread_receiver_ = std::thread(&BasicHandler::start_receiver_thread, this);
+            this->thread_sender_ = std::thread(&BasicHandler::start_sender_thread, this);
+            this->thread_handler_ = std::thread(&BasicHandler::start_handler_thread, this);
             return true;
         }
-        std::printf("[Handler]: Handler initialization failure\n");
+        log_message(LOG_ERROR, "Handler", "Handler initialization failure");
         return false;
     }
 
-    bool Handler::is_running() const {
+    template<FrameTransport T>
+    bool BasicHandler<T>::init(BasicFleet<T> &fleet, const std::string &can_interface) {
+        if (this->flag_initialised_) {
+            log_message(LOG_WARNING, "Handler", "Handler already running");
+            return false;
+        }
+        if (fleet.attach(*this, can_interface)) { return true; }
+        log_message(LOG_ERROR, "Handler", "Handler initialization failure");
+        return false;
+    }
+
+    template<FrameTransport T>
+    T &BasicHandler<T>::get_transport() {
+        return this->transport_;
+    }
+
+    template<FrameTransport T>
+    void BasicHandler<T>::set_recorder(Recorder *recorder) {
+        std::unique_lock lock(this->attach_mutex_);
+        this->recorder_ = recorder;
+    }
+
+    template<FrameTransport T>
+    void BasicHandler<T>::set_command_ingress(CommandIngress *ingress) {
+        // a sender which waits on the futex of the previous ingress holds the shared lock, it is woken up and does not wait on it again.
+        this->attaching_.fetch_add(1);
+        {
+            std::shared_lock lock(this->attach_mutex_);
+            if (this->ingress_ != nullptr) { this->ingress_->notify(); }
+        }
+        {
+            std::unique_lock lock(this->attach_mutex_);
+            this->ingress_ = ingress;
+        }
+        this->attaching_.fetch_sub(1);
+        this->cv_sender_.notify_all();
+    }
+
+    template<FrameTransport T>
+    uint16_t BasicHandler<T>::next_sequence(const uint16_t type) {
+        return this->sequences_[type % HANDLER_SEQUENCE_COUNTERS].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template<FrameTransport T>
+    bool BasicHandler<T>::is_running() const {
         return this->flag_initialised_ && !this->flag_stop_;
     }
 
-    bool Handler::send_message(const uint32_t id, const std::vector<uint8_t> &data) {
-        uint8_t frame_data[8] = {};
-        for (size_t i = 0; i < data.size(); i += 8) {
-            const size_t frame_length = std::min(static_cast<size_t>(8), data.size() - i);
-            std::copy_n(data.begin() + static_cast<long>(i), frame_length, frame_data);
-            if(!this->can_socket_.send_frame(id, frame_data, frame_length)) { return false; }
+    template<FrameTransport T>
+    StreamStatistics BasicHandler<T>::get_stream_statistics(const uint32_t device_id) const {
+        return this->reassembler_.get_statistics(device_id);
+    }
+
+    template<FrameTransport T>
+    MetricsSnapshot BasicHandler<T>::get_metrics() const {
+        MetricsSnapshot snapshot = this->metrics_.get_snapshot();
+        for (uint32_t device_id = Reassembler::DEVICE_ID_BASE; device_id < Reassembler::DEVICE_ID_BASE + Reassembler::DEVICE_ID_COUNT; device_id++) {
+            if (const StreamStatistics statistics = this->reassembler_.get_statistics(device_id); statistics.frames != 0) { snapshot.streams.emplace_back(device_id, statistics); }
         }
-        return true;
+        return snapshot;
+    }
+
+    template<FrameTransport T>
+    std::vector<ChannelLatency> BasicHandler<T>::get_latency_statistics() const {
+        return this->latency_tracker_.get_statistics();
     }
 
-    bool Handler::send_message(const Message &msg) {
-        return this->send_message(msg.get_device_id(), msg.to_vector());
-    }
-
-    void Handler::start_receiver_thread() {
-        struct msg_robomaster{
-            std::vector<uint8_t> buffer;
-            size_t length = 0;
-        };
-
-        std::map<uint32_t, msg_robomaster> map_msg_robomaster {
-            { DEVICE_ID_MOTION_CONTROLLER, msg_robomaster() }
-        };
-
-        uint32_t frame_id;
-        uint8_t frame_buffer[8] = {};
-        size_t frame_length;
-        size_t error_counter = 0;
-
-        while(error_counter <= STD_MAX_ERROR_COUNT && !this->flag_stop_) {
-            if(!can_socket_.read_frame(frame_id, frame_buffer, frame_length)) { error_counter++; continue; }
-            auto slice = map_msg_robomaster.find(frame_id);
-
-            if(slice == map_msg_robomaster.end()) { continue; }
-            auto&[buffer, length] = slice->second;
-            buffer.insert(std::end(buffer), frame_buffer, frame_buffer + frame_length);
-
-            if(length == 0) {
-                auto iterator = buffer.cbegin();
-                while(iterator != buffer.cend()) {
-                    iterator = std::find(iterator, std::cend(buffer),0x55); buffer.erase(std::cbegin(buffer), iterator);
-                    if(buffer.size() < 4) { break; }
-                    if(buffer[3] == calculate_crc8(buffer.data(), 3)) { length = buffer[1]; break; } iterator++;
-                }
-            } else if(length <= buffer.size()) {
-                if(const uint16_t crc16 = little_endian_to_uint16(buffer[length - 2], buffer[length - 1]); crc16 == calculate_crc16(buffer.data(), length - 2)) {
-                    this->queue_receiver_.push(Message(frame_id, std::vector(std::cbegin(buffer), std::cbegin(buffer) + static_cast<long>(length))));
-                    this->cv_handler_.notify_one();
-                }
-                buffer.erase(std::cbegin(buffer), std::cbegin(buffer) + static_cast<long>(length)); length = 0;
+    template<FrameTransport T>
+    bool BasicHandler<T>::send_messages(const Message *msgs, const size_t count) {
+        ROBOMASTER_TRACE_SCOPE("send_message");
+        // the frames of all messages are sent with one batch call of the transport.
+        this->sender_frames_.clear();
+        for (size_t i = 0; i < count; i++) {
+            const uint32_t id = msgs[i].get_device_id();
+            const std::vector<uint8_t> data = msgs[i].to_vector();
+            if (STD_MAX_FRAMES * 8 < data.size()) { log_message(LOG_ERROR, "Handler", "Message too long"); return false; }
+            for (size_t j = 0; j < data.size(); j += 8) {
+                CanFrame &frame = this->sender_frames_.emplace_back();
+                frame.id = id;
+                frame.length = static_cast<uint8_t>(std::min(static_cast<size_t>(8), data.size() - j));
+                std::copy_n(data.begin() + static_cast<long>(j), frame.length, frame.data);
             }
         }
+        if (!this->transport_.send_frames(this->sender_frames_.data(), this->sender_frames_.size())) { this->metrics_.add(METRIC_SEND_ERRORS); return false; }
+        this->metrics_.add(METRIC_FRAMES_SENT, this->sender_frames_.size());
+        this->metrics_.add(METRIC_MESSAGES_SENT, count);
+        std::shared_lock lock(this->attach_mutex_);
+        if (this->recorder_ != nullptr) { this->recorder_->record(this->sender_frames_.data(), this->sender_frames_.size(), RECORD_TRANSMIT); }
+        return true;
+    }
+
+    template<FrameTransport T>
+    bool BasicHandler<T>::send_message(const Message &msg) {
+        return this->send_messages(&msg, 1);
+    }
+
+    template<FrameTransport T>
+    size_t BasicHandler<T>::receive_step(CanFrame *frames, const size_t capacity, std::vector<Message> &messages) {
+        size_t frame_count;
+        bool success;
+        { ROBOMASTER_TRACE_SCOPE("read_frames"); success = this->transport_.read_frames(frames, capacity, frame_count); }
+        if (!success) {
+            this->metrics_.add(METRIC_READ_ERRORS);
+            if (STD_MAX_ERROR_COUNT < ++this->receiver_errors_) { this->flag_stop_ = true; log_message(LOG_ERROR, "Handler", "Receiver frame failure"); }
+            return 0;
+        }
+        if (frame_count == 0) { return 0; }
+
+        // the time from the kernel receive timestamp of the first frame until the batch reached the receiver thread.
+        ROBOMASTER_TRACE_SPAN("socket_latency", frames[0].timestamp, Tracer::now());
+        this->metrics_.add(METRIC_FRAMES_RECEIVED, frame_count);
+        {
+            std::shared_lock lock(this->attach_mutex_);
+            if (this->recorder_ != nullptr) { this->recorder_->record(frames, frame_count, RECORD_RECEIVE); }
+        }
+        {
+            ROBOMASTER_TRACE_SCOPE("reassembly");
+            for (size_t i = 0; i < frame_count; i++) { this->reassembler_.push_frame(frames[i].id, frames[i].data, frames[i].length, messages, frames[i].timestamp); }
+        }
+        if (messages.empty()) { return 0; }
 
-        if(error_counter != 0) { this->flag_stop_ = true; std::printf("[Handler]: Receiver frame failure\n"); }
+        const size_t count = messages.size();
+        this->metrics_.add(METRIC_MESSAGES_RECEIVED, count);
+        for (auto &msg : messages) { if (this->queue_receiver_.push(std::move(msg))) { this->metrics_.add(METRIC_RECEIVE_QUEUE_DROPS); } }
+        messages.clear();
+        return count;
     }
 
-    void Handler::start_sender_thread() {
-        uint16_t heartbeat_10ms_counter = 0;
-        std::chrono::high_resolution_clock::time_point heartbeat_10ms_time_point = std::chrono::high_resolution_clock::now();
-        size_t error_counter = 0;
+    template<FrameTransport T>
+    bool BasicHandler<T>::send_step(const std::chrono::high_resolution_clock::time_point now) {
+        bool success;
+        if (this->heartbeat_time_point_ < now) {
+            success = this->send_message(Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc309, this->next_sequence(0xc309), { 0x00, 0x3f, 0x60, 0x00, 0x04, 0x20, 0x00, 0x01, 0x00, 0x40, 0x00, 0x02, 0x10, 0x00, 0x03, 0x00, 0x00 }));
+            if (success) {
+                this->metrics_.record(METRIC_HEARTBEAT_LATENESS, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - this->heartbeat_time_point_).count()));
+                this->metrics_.add(METRIC_HEARTBEATS);
+                this->heartbeat_time_point_ += STD_HEARTBEAT_TIME;
+            }
+        } else {
+            // the ingress is drained first, so a local queue which is refilled all the time cannot starve the other processes.
+            std::shared_lock lock(this->attach_mutex_);
+            CommandIngress *ingress = this->ingress_;
+            size_t popped = 0;
+            for (; ingress != nullptr && popped < STD_MAX_INGRESS_COMMANDS && !ingress->empty(); popped++) {
+                uint64_t time;
+                Message msg = ingress->pop(time);
+                if (!msg.is_valid()) { this->metrics_.add(METRIC_INGRESS_REJECTED); continue; }
+                msg.set_sequence(this->next_sequence(msg.get_type()));
+                this->metrics_.add(METRIC_INGRESS_COMMANDS);
+                this->latency_tracker_.enqueue(msg, time);
+                this->sender_messages_.push_back(std::move(msg));
+            }
+
+            // all queued messages are sent together, so the messages of a batch are not split by a heartbeat.
+            size_t count = this->sender_messages_.size();
+            if (this->queue_sender_.pop_all(this->sender_messages_) == 0 && popped == 0) { return false; }
 
-        while (error_counter <= STD_MAX_ERROR_COUNT && !this->flag_stop_) {
-            if (heartbeat_10ms_time_point < std::chrono::high_resolution_clock::now()) {
-                if(this->send_message(Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc309, heartbeat_10ms_counter++, { 0x00, 0x3f, 0x60, 0x00, 0x04, 0x20, 0x00, 0x01, 0x00, 0x40, 0x00, 0x02, 0x10, 0x00, 0x03, 0x00, 0x00 }))) {
-                    heartbeat_10ms_time_point += STD_HEARTBEAT_TIME; error_counter = 0;
-                } else { error_counter++; }
-            } else if(!this->queue_sender_.empty()) {
-                if (Message msg = queue_sender_.pop(); msg.is_valid()) { if (this->send_message(msg)) { error_counter = 0; } else { error_counter++; } }
-            } else {
-                std::unique_lock lock(this->cv_sender_mutex_); this->cv_sender_.wait_until(lock, heartbeat_10ms_time_point);
+            // the local commands take part in the arbitration of the ingress in the order they were pushed.
+            for (size_t i = count; i < this->sender_messages_.size(); i++) {
+                Message &msg = this->sender_messages_[i];
+                if (!msg.is_valid()) { continue; }
+                if (ingress != nullptr && !ingress->accept(msg)) { this->latency_tracker_.evict(msg); this->metrics_.add(METRIC_LOCAL_REJECTED); continue; }
+                if (i != count) { this->sender_messages_[count] = std::move(msg); }
+                count++;
             }
+            lock.unlock();
+            this->sender_messages_.erase(this->sender_messages_.begin() + static_cast<long>(count), this->sender_messages_.end());
+            for (const Message &msg : this->sender_messages_) { this->latency_tracker_.dequeue(msg); }
+            success = this->sender_messages_.empty() || this->send_messages(this->sender_messages_.data(), this->sender_messages_.size());
+            for (const Message &msg : this->sender_messages_) { this->latency_tracker_.sent(msg, success); }
+            this->sender_messages_.clear();
         }
 
-        if(error_counter != 0) { this->flag_stop_ = true; std::printf("[Handler]: Transmitter frame failure\n"); }
+        if (success) { this->sender_errors_ = 0; }
+        else if (STD_MAX_ERROR_COUNT < ++this->sender_errors_) { this->flag_stop_ = true; log_message(LOG_ERROR, "Handler", "Transmitter frame failure"); }
+        return true;
     }
 
-    void Handler::start_handler_thread() {
+    template<FrameTransport T>
+    size_t BasicHandler<T>::dispatch_step() {
+        size_t count = 0;
+        while (!this->queue_receiver_.empty()) {
+            if (const Message msg = this->queue_receiver_.pop(); msg.is_valid()) {
+                // the time from the kernel receive timestamp of the last frame, covering the socket read, the reassembly and the queue wait.
+                ROBOMASTER_TRACE_SPAN("receive_to_dispatch", msg.get_time_last_frame(), Tracer::now());
+                this->process_message(msg);
+                count++;
+            }
+        }
+        return count;
+    }
+
+    template<FrameTransport T>
+    void BasicHandler<T>::start_receiver_thread() {
+        std::vector<Message> messages;
+        std::array<CanFrame, STD_MAX_FRAMES> frames;
+        ROBOMASTER_TRACE_THREAD_NAME("receiver");
+
+        while (!this->flag_stop_) {
+            if (this->receive_step(frames.data(), frames.size(), messages) == 0) { continue; }
+            ROBOMASTER_TRACE_INSTANT("notify_handler");
+            this->cv_handler_.notify_one();
+        }
+    }
+
+    template<FrameTransport T>
+    void BasicHandler<T>::start_sender_thread() {
+        ROBOMASTER_TRACE_THREAD_NAME("sender");
+
         while (!this->flag_stop_) {
-            if (!this->queue_receiver_.empty()) {
-                if (const Message msg = this->queue_receiver_.pop(); msg.is_valid()) { this->process_message(msg); }
-            } else {
-                std::unique_lock lock(this->cv_handler_mutex_);
-                this->cv_handler_.wait(lock);
+            // the futex word of the ingress is read before the queues are checked, so a command pushed in between ends the wait.
+            uint32_t signal = 0;
+            {
+                std::shared_lock lock(this->attach_mutex_);
+                if (this->ingress_ != nullptr) { signal = this->ingress_->get_signal(); }
             }
+            if (this->send_step(std::chrono::high_resolution_clock::now())) { continue; }
+
+            // while the ingress is replaced the sender waits on the condition variable, so the setter gets the exclusive lock.
+            if (this->attaching_ == 0) {
+                std::shared_lock lock(this->attach_mutex_);
+                if (this->ingress_ != nullptr && this->attaching_ == 0) { this->ingress_->wait(signal, this->heartbeat_time_point_); continue; }
+            }
+            std::unique_lock lock(this->cv_sender_mutex_); this->cv_sender_.wait_until(lock, this->heartbeat_time_point_);
         }
     }
 
-    void Handler::push_message(const Message &msg) {
-        this->queue_sender_.push(msg);
-        this->cv_sender_.notify_one();
+    template<FrameTransport T>
+    void BasicHandler<T>::start_handler_thread() {
+        ROBOMASTER_TRACE_THREAD_NAME("handler");
+        while (!this->flag_stop_) {
+            if (this->dispatch_step() != 0) { continue; }
+            ROBOMASTER_TRACE_SCOPE("wait");
+            std::unique_lock lock(this->cv_handler_mutex_);
+            this->cv_handler_.wait(lock);
+        }
     }
 
-    void Handler::bind_callback(std::function<void(const Message&)> func) {
-        this->callback_data_robomaster_state_ = std::move(func);
+    template<FrameTransport T>
+    void BasicHandler<T>::push_message(const Message &msg) {
+        this->latency_tracker_.enqueue(msg);
+        if (const auto evicted = this->queue_sender_.push(msg)) { this->latency_tracker_.evict(*evicted); this->metrics_.add(METRIC_SEND_QUEUE_DROPS); }
+        if (BasicFleet<T> *fleet = this->fleet_.load(std::memory_order_acquire)) { fleet->notify(); return; }
+        std::shared_lock lock(this->attach_mutex_);
+        if (this->ingress_ != nullptr) { this->ingress_->notify(); } else { this->cv_sender_.notify_one(); }
     }
 
-    void Handler::process_message(const Message &msg) {
-        if (msg.get_device_id() == DEVICE_ID_MOTION_CONTROLLER) {
-            switch (msg.get_type()) {
-            case 0x0903: if(4 < msg.get_payload().size() && msg.get_payload()[0] == 0x20 && msg.get_payload()[1] == 0x48 && msg.get_payload()[2] == 0x08 && msg.get_payload()[3] == 0x00 && this->callback_data_robomaster_state_) { this->callback_data_robomaster_state_(msg); }
-            default: break; }
+    template<FrameTransport T>
+    bool BasicHandler<T>::push_messages(const std::vector<Message> &msgs) {
+        for (const Message &msg : msgs) { this->latency_tracker_.enqueue(msg); }
+        if (!this->queue_sender_.push_batch(msgs)) {
+            for (const Message &msg : msgs) { this->latency_tracker_.evict(msg); }
+            this->metrics_.add(METRIC_SEND_QUEUE_DROPS, msgs.size());
+            return false;
         }
+        if (BasicFleet<T> *fleet = this->fleet_.load(std::memory_order_acquire)) { fleet->notify(); return true; }
+        std::shared_lock lock(this->attach_mutex_);
+        if (this->ingress_ != nullptr) { this->ingress_->notify(); } else { this->cv_sender_.notify_one(); }
+        return true;
+    }
+
+    template<FrameTransport T>
+    void BasicHandler<T>::bind_callback(std::function<void(const Message&)> func) {
+        // the state push needs data after its prefix, a payload of the prefix only is not forwarded as before the dispatch table.
+        if (func) { func = [callback = std::move(func)](const Message &msg) { if (4 < msg.get_payload().size()) { callback(msg); } }; }
+        this->dispatcher_.bind_callback(DEVICE_ID_MOTION_CONTROLLER, 0x0903, { 0x20, 0x48, 0x08, 0x00 }, std::move(func));
     }
+
+    template<FrameTransport T>
+    void BasicHandler<T>::bind_callback(const uint32_t device_id, const uint16_t type, std::vector<uint8_t> prefix, std::function<void(const Message&)> func) {
+        this->dispatcher_.bind_callback(device_id, type, std::move(prefix), std::move(func));
+    }
+
+    template<FrameTransport T>
+    bool BasicHandler<T>::unbind_callback(const uint32_t device_id, const uint16_t type, const std::vector<uint8_t> &prefix) {
+        return this->dispatcher_.unbind_callback(device_id, type, prefix);
+    }
+
+    template<FrameTransport T>
+    void BasicHandler<T>::process_message(const Message &msg) {
+        ROBOMASTER_TRACE_SCOPE("dispatch");
+        const auto start = std::chrono::steady_clock::now();
+        this->latency_tracker_.receive(msg);
+        this->dispatcher_.dispatch(msg);
+        this->metrics_.record(METRIC_CALLBACK_DURATION, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+    }
+
+    template class BasicHandler<CanSocket>;
+    template class BasicHandler<LoopbackTransport>;
+    template class BasicHandler<AnyTransport>;
 } // namespace robomaster_can_controller
\ No newline at end of file
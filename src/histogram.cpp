@@ -0,0 +1,124 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace robomaster_can_controller {
+    Histogram::Histogram() : buckets_(), count_(0), total_(0), min_(0), max_(0) { }
+
+    size_t Histogram::get_bucket(const uint64_t value) {
+        if (value < SUB_BUCKETS) { return static_cast<size_t>(value); }
+        const auto exponent = static_cast<size_t>(std::bit_width(value) - 1);
+        return (exponent - 3) * SUB_BUCKETS + static_cast<size_t>((value >> (exponent - 4)) & (SUB_BUCKETS - 1));
+    }
+
+    uint64_t Histogram::get_lower_bound(const size_t bucket) {
+        if (bucket < 2 * SUB_BUCKETS) { return bucket; }
+        const size_t exponent = bucket / SUB_BUCKETS + 3;
+        return (SUB_BUCKETS + bucket % SUB_BUCKETS) << (exponent - 4);
+    }
+
+    void Histogram::record(const uint64_t value) {
+        this->buckets_[get_bucket(value)]++;
+        this->min_ = this->count_ == 0 ? value : std::min(this->min_, value);
+        this->max_ = std::max(this->max_, value);
+        this->total_ += value;
+        this->count_++;
+    }
+
+    void Histogram::merge(const Histogram &other) {
+        if (other.count_ == 0) { return; }
+        for (size_t i = 0; i < BUCKETS; i++) { this->buckets_[i] += other.buckets_[i]; }
+        this->min_ = this->count_ == 0 ? other.min_ : std::min(this->min_, other.min_);
+        this->max_ = std::max(this->max_, other.max_);
+        this->total_ += other.total_;
+        this->count_ += other.count_;
+    }
+
+    void Histogram::reset() {
+        *this = Histogram();
+    }
+
+    uint64_t Histogram::get_count() const {
+        return this->count_;
+    }
+
+    uint64_t Histogram::get_min() const {
+        return this->min_;
+    }
+
+    uint64_t Histogram::get_max() const {
+        return this->max_;
+    }
+
+    double Histogram::get_mean() const {
+        return this->count_ == 0 ? 0.0 : static_cast<double>(this->total_) / static_cast<double>(this->count_);
+    }
+
+    uint64_t Histogram::get_percentile(const double percentile) const {
+        if (this->count_ == 0) { return 0; }
+
+        // the rank of the value, the result is the largest value of the bucket holding this rank.
+        const double share = std::clamp(percentile, 0.0, 100.0) / 100.0;
+        const auto rank = std::max(static_cast<uint64_t>(1), static_cast<uint64_t>(std::ceil(share * static_cast<double>(this->count_))));
+        uint64_t counter = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            counter += this->buckets_[i];
+            if (rank <= counter) {
+                const uint64_t upper = i + 1 < BUCKETS ? get_lower_bound(i + 1) - 1 : std::numeric_limits<uint64_t>::max();
+                return std::clamp(upper, this->min_, this->max_);
+            }
+        }
+        return this->max_;
+    }
+
+    uint64_t Histogram::get_bucket_count(const size_t bucket) const {
+        return bucket < BUCKETS ? this->buckets_[bucket] : 0;
+    }
+
+    AtomicHistogram::AtomicHistogram() : buckets_(), count_(0), total_(0), min_(std::numeric_limits<uint64_t>::max()), max_(0) { }
+
+    void AtomicHistogram::record(const uint64_t value) {
+        this->buckets_[Histogram::get_bucket(value)].fetch_add(1, std::memory_order_relaxed);
+        this->count_.fetch_add(1, std::memory_order_relaxed);
+        this->total_.fetch_add(value, std::memory_order_relaxed);
+
+        // the extremes change rarely, so the compare exchange loops are almost never taken.
+        uint64_t min = this->min_.load(std::memory_order_relaxed);
+        while (value < min && !this->min_.compare_exchange_weak(min, value, std::memory_order_relaxed)) { }
+        uint64_t max = this->max_.load(std::memory_order_relaxed);
+        while (max < value && !this->max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) { }
+    }
+
+    void AtomicHistogram::load(Histogram &histogram) const {
+        uint64_t count = 0;
+        for (size_t i = 0; i < Histogram::BUCKETS; i++) {
+            const uint64_t bucket = this->buckets_[i].load(std::memory_order_relaxed);
+            histogram.buckets_[i] += bucket;
+            count += bucket;
+        }
+        if (count == 0) { return; }
+
+        const uint64_t min = this->min_.load(std::memory_order_relaxed);
+        histogram.min_ = histogram.count_ == 0 ? min : std::min(histogram.min_, min);
+        histogram.max_ = std::max(histogram.max_, this->max_.load(std::memory_order_relaxed));
+        histogram.total_ += this->total_.load(std::memory_order_relaxed);
+        histogram.count_ += count;
+    }
+
+    void AtomicHistogram::reset() {
+        for (auto &bucket : this->buckets_) { bucket.store(0, std::memory_order_relaxed); }
+        this->count_.store(0, std::memory_order_relaxed);
+        this->total_.store(0, std::memory_order_relaxed);
+        this->min_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        this->max_.store(0, std::memory_order_relaxed);
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,173 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/history.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <ctime>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Get the span of the rows of a column.
+     */
+    template<typename T>
+    static std::span<const T> get_rows(const std::vector<T> &column, const size_t row, const size_t size) {
+        return std::span<const T>(column.data() + row, size);
+    }
+
+    StateHistory::StateHistory(const size_t capacity) : capacity_(std::max<size_t>(capacity, 1)), count_(0), signal_(0), waiters_(0) {
+        const size_t rows = 2 * (this->capacity_ + 1);
+        this->time_.resize(rows); this->sections_.resize(rows);
+        this->adc_value_.resize(rows); this->temperature_.resize(rows); this->current_.resize(rows); this->percent_.resize(rows);
+        this->speed_.resize(rows); this->angle_.resize(rows); this->time_stamp_.resize(rows); this->state_.resize(rows);
+        this->acc_x_.resize(rows); this->acc_y_.resize(rows); this->acc_z_.resize(rows);
+        this->gyro_x_.resize(rows); this->gyro_y_.resize(rows); this->gyro_z_.resize(rows);
+        this->vgx_.resize(rows); this->vgy_.resize(rows); this->vgz_.resize(rows);
+        this->vbx_.resize(rows); this->vby_.resize(rows); this->vbz_.resize(rows);
+        this->x_.resize(rows); this->y_.resize(rows); this->z_.resize(rows);
+        this->roll_.resize(rows); this->pitch_.resize(rows); this->yaw_.resize(rows);
+        this->last_frame_.resize(rows); this->acquisition_.resize(rows); this->uncertainty_.resize(rows);
+    }
+
+    size_t StateHistory::get_capacity() const {
+        return this->capacity_;
+    }
+
+    uint64_t StateHistory::get_count() const {
+        return this->count_.load(std::memory_order_acquire);
+    }
+
+    void StateHistory::write(const size_t row, const DataRoboMasterState &state, const uint64_t time) {
+        this->time_[row] = time;
+        this->sections_[row] = static_cast<uint8_t>(get_sections(state));
+        this->adc_value_[row] = state.battery.adc_value;
+        this->temperature_[row] = state.battery.temperature;
+        this->current_[row] = state.battery.current;
+        this->percent_[row] = state.battery.percent;
+        this->speed_[row] = state.esc.speed;
+        this->angle_[row] = state.esc.angle;
+        this->time_stamp_[row] = state.esc.time_stamp;
+        this->state_[row] = state.esc.state;
+        this->acc_x_[row] = state.imu.acc_x; this->acc_y_[row] = state.imu.acc_y; this->acc_z_[row] = state.imu.acc_z;
+        this->gyro_x_[row] = state.imu.gyro_x; this->gyro_y_[row] = state.imu.gyro_y; this->gyro_z_[row] = state.imu.gyro_z;
+        this->vgx_[row] = state.velocity.vgx; this->vgy_[row] = state.velocity.vgy; this->vgz_[row] = state.velocity.vgz;
+        this->vbx_[row] = state.velocity.vbx; this->vby_[row] = state.velocity.vby; this->vbz_[row] = state.velocity.vbz;
+        this->x_[row] = state.position.x; this->y_[row] = state.position.y; this->z_[row] = state.position.z;
+        this->roll_[row] = state.attitude.roll; this->pitch_[row] = state.attitude.pitch; this->yaw_[row] = state.attitude.yaw;
+        this->last_frame_[row] = state.timestamp.last_frame;
+        this->acquisition_[row] = state.timestamp.acquisition;
+        this->uncertainty_[row] = state.timestamp.uncertainty;
+    }
+
+    void StateHistory::push(const DataRoboMasterState &state) {
+        uint64_t time = state.timestamp.first_frame;
+        if (!state.timestamp.has_data) {
+            timespec now{};
+            clock_gettime(CLOCK_REALTIME, &now);
+            time = static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec);
+        }
+
+        const uint64_t number = this->count_.load(std::memory_order_relaxed);
+        const size_t row = number % (this->capacity_ + 1);
+        this->write(row, state, time);
+        this->write(row + this->capacity_ + 1, state, time);
+        this->count_.store(number + 1, std::memory_order_release);
+
+        // the signal and the waiters are sequentially consistent, so either the writer sees the waiter or the waiter sees the new count.
+        this->signal_.fetch_add(1);
+        if (this->waiters_.load() != 0) { syscall(SYS_futex, &this->signal_, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0); }
+    }
+
+    HistoryWindow StateHistory::get_window(uint64_t begin, size_t size) const {
+        const uint64_t count = this->get_count();
+        const uint64_t first = count < this->capacity_ ? 0 : count - this->capacity_;
+        begin = std::clamp(begin, first, count);
+        size = static_cast<size_t>(std::min<uint64_t>(size, count - begin));
+
+        HistoryWindow window;
+        window.begin = begin;
+        window.size = size;
+        const size_t row = begin % (this->capacity_ + 1);
+        window.time = get_rows(this->time_, row, size);
+        window.sections = get_rows(this->sections_, row, size);
+        window.adc_value = get_rows(this->adc_value_, row, size);
+        window.temperature = get_rows(this->temperature_, row, size);
+        window.current = get_rows(this->current_, row, size);
+        window.percent = get_rows(this->percent_, row, size);
+        window.speed = get_rows(this->speed_, row, size);
+        window.angle = get_rows(this->angle_, row, size);
+        window.time_stamp = get_rows(this->time_stamp_, row, size);
+        window.state = get_rows(this->state_, row, size);
+        window.acc_x = get_rows(this->acc_x_, row, size);
+        window.acc_y = get_rows(this->acc_y_, row, size);
+        window.acc_z = get_rows(this->acc_z_, row, size);
+        window.gyro_x = get_rows(this->gyro_x_, row, size);
+        window.gyro_y = get_rows(this->gyro_y_, row, size);
+        window.gyro_z = get_rows(this->gyro_z_, row, size);
+        window.vgx = get_rows(this->vgx_, row, size);
+        window.vgy = get_rows(this->vgy_, row, size);
+        window.vgz = get_rows(this->vgz_, row, size);
+        window.vbx = get_rows(this->vbx_, row, size);
+        window.vby = get_rows(this->vby_, row, size);
+        window.vbz = get_rows(this->vbz_, row, size);
+        window.x = get_rows(this->x_, row, size);
+        window.y = get_rows(this->y_, row, size);
+        window.z = get_rows(this->z_, row, size);
+        window.roll = get_rows(this->roll_, row, size);
+        window.pitch = get_rows(this->pitch_, row, size);
+        window.yaw = get_rows(this->yaw_, row, size);
+        window.last_frame = get_rows(this->last_frame_, row, size);
+        window.acquisition = get_rows(this->acquisition_, row, size);
+        window.uncertainty = get_rows(this->uncertainty_, row, size);
+        return window;
+    }
+
+    HistoryWindow StateHistory::last(const size_t size) const {
+        const uint64_t count = this->get_count();
+        const auto rows = static_cast<size_t>(std::min<uint64_t>({ count, size, this->capacity_ }));
+        return this->get_window(count - rows, rows);
+    }
+
+    HistoryWindow StateHistory::between(const uint64_t t0, const uint64_t t1) const {
+        const HistoryWindow window = this->last(this->capacity_);
+        if (t1 < t0) { return this->get_window(window.begin + window.size, 0); }
+        const auto begin = std::lower_bound(window.time.begin(), window.time.end(), t0);
+        const auto end = std::upper_bound(begin, window.time.end(), t1);
+        return this->get_window(window.begin + static_cast<uint64_t>(begin - window.time.begin()), static_cast<size_t>(end - begin));
+    }
+
+    bool StateHistory::is_valid(const HistoryWindow &window) const {
+        // the ring holds one row more than the capacity, the writer overwrites the state count - capacity - 1 while it pushes the state count.
+        return this->get_count() <= window.begin + this->capacity_;
+    }
+
+    bool StateHistory::wait(const uint64_t count, const double timeout) const {
+        this->waiters_.fetch_add(1);
+        const uint32_t signal = this->signal_.load();
+        if (count < this->get_count()) { this->waiters_.fetch_sub(1); return true; }
+
+        timespec time{};
+        if (0.0 < timeout) {
+            const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(timeout)).count();
+            time.tv_sec = static_cast<time_t>(duration / 1000000000);
+            time.tv_nsec = static_cast<long>(duration % 1000000000);
+        }
+        syscall(SYS_futex, &this->signal_, FUTEX_WAIT_PRIVATE, signal, 0.0 < timeout ? &time : nullptr, nullptr, 0);
+        this->waiters_.fetch_sub(1);
+        return count < this->get_count();
+    }
+
+    void StateHistory::notify() {
+        this->signal_.fetch_add(1);
+        syscall(SYS_futex, &this->signal_, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,301 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/ingress.h"
+#include "robomaster_can_controller/logger.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+namespace robomaster_can_controller {
+    static constexpr uint32_t STD_CLIENT_FREE = 0;
+    static constexpr uint32_t STD_CLIENT_CLAIMED = 1;
+    static constexpr uint32_t STD_CLIENT_READY = 2;
+
+    static uint64_t get_realtime() {
+        timespec time{};
+        clock_gettime(CLOCK_REALTIME, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+    /**
+     * @brief Get the address of the first command of the ring.
+     */
+    static IngressCommand *get_commands(IngressSegment *segment) {
+        return reinterpret_cast<IngressCommand*>(segment + 1);
+    }
+
+    static size_t get_segment_size(const size_t capacity) {
+        return sizeof(IngressSegment) + capacity * sizeof(IngressCommand);
+    }
+
+    static void wake(IngressSegment &segment) {
+        segment.signal.fetch_add(1, std::memory_order_release);
+        syscall(SYS_futex, &segment.signal, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    }
+
+    CommandIngress::CommandIngress() : fd_(-1), segment_(nullptr), size_(0), dequeue_(0), hold_(0), local_priority_(0) { }
+
+    CommandIngress::~CommandIngress() {
+        this->close();
+    }
+
+    bool CommandIngress::open(const std::string &name, const size_t capacity, const double hold, const uint32_t local_priority, const bool replace) {
+        if (this->segment_ != nullptr) { log_message(LOG_WARNING, "Ingress", "Ingress already open"); return false; }
+        if (capacity == 0 || UINT32_MAX < capacity) { log_message(LOG_ERROR, "Ingress", "Invalid capacity"); return false; }
+
+        // a segment of another ingress is never taken over, a stale segment is removed instead of reused on request,
+        // e.g. a ring which is blocked by a dead client.
+        if (replace) { shm_unlink(name.c_str()); }
+        this->fd_ = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0660);
+        if (this->fd_ < 0 && errno == EEXIST) { log_message(LOG_ERROR, "Ingress", "%s exists, it is used by another ingress or stale", name.c_str()); return false; }
+        if (this->fd_ < 0) { log_message(LOG_ERROR, "Ingress", "Failed to create %s", name.c_str()); return false; }
+
+        this->size_ = get_segment_size(capacity);
+        void *address = MAP_FAILED;
+        if (ftruncate(this->fd_, static_cast<off_t>(this->size_)) < 0 || (address = mmap(nullptr, this->size_, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd_, 0)) == MAP_FAILED) {
+            log_message(LOG_ERROR, "Ingress", "Failed to map %s", name.c_str());
+            ::close(this->fd_); this->fd_ = -1;
+            shm_unlink(name.c_str());
+            return false;
+        }
+
+        // the new object is zero filled, only the sequences of the ring need their initial positions.
+        this->segment_ = static_cast<IngressSegment*>(address);
+        this->segment_->version = INGRESS_VERSION;
+        this->segment_->capacity = static_cast<uint32_t>(capacity);
+        this->segment_->max_payload = INGRESS_MAX_PAYLOAD;
+        for (size_t i = 0; i < capacity; i++) { get_commands(this->segment_)[i].sequence.store(i, std::memory_order_relaxed); }
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(this->segment_->magic, INGRESS_MAGIC, sizeof(INGRESS_MAGIC));
+
+        this->name_ = name;
+        this->dequeue_ = 0;
+        this->hold_ = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(std::max(hold, 0.0)));
+        this->local_priority_ = local_priority;
+        this->channels_.clear();
+        return true;
+    }
+
+    void CommandIngress::close() {
+        if (this->segment_ == nullptr) { return; }
+        munmap(this->segment_, this->size_);
+        ::close(this->fd_);
+        shm_unlink(this->name_.c_str());
+        this->segment_ = nullptr;
+        this->fd_ = -1;
+    }
+
+    bool CommandIngress::is_open() const {
+        return this->segment_ != nullptr;
+    }
+
+    bool CommandIngress::empty() const {
+        if (this->segment_ == nullptr) { return true; }
+        const IngressCommand &command = get_commands(this->segment_)[this->dequeue_ % this->segment_->capacity];
+        return command.sequence.load(std::memory_order_acquire) != this->dequeue_ + 1;
+    }
+
+    CommandIngress::Channel &CommandIngress::get_channel(const uint32_t device_id, const uint16_t type) {
+        const auto it = std::find_if(this->channels_.begin(), this->channels_.end(), [device_id, type](const Channel &c) { return c.device_id == device_id && c.type == type; });
+        if (it != this->channels_.end()) { return *it; }
+        Channel &channel = this->channels_.emplace_back();
+        channel.device_id = device_id;
+        channel.type = type;
+        return channel;
+    }
+
+    bool CommandIngress::arbitrate(const uint32_t device_id, const uint16_t type, const uint32_t priority) {
+        // the channel belongs to the highest priority until its owner was silent for the hold time.
+        Channel &channel = this->get_channel(device_id, type);
+        const auto now = std::chrono::steady_clock::now();
+        if (priority < channel.priority && now < channel.until) { return false; }
+
+        channel.priority = priority;
+        channel.until = now + this->hold_;
+        return true;
+    }
+
+    Message CommandIngress::pop(uint64_t &time) {
+        if (this->empty()) { return Message(0, {}); }
+        IngressCommand &command = get_commands(this->segment_)[this->dequeue_ % this->segment_->capacity];
+
+        // the command is copied out of the ring before its slot is released to the producers.
+        const uint32_t client = std::min<uint32_t>(command.client, INGRESS_MAX_CLIENTS - 1);
+        const uint32_t priority = command.priority;
+        const uint32_t device_id = command.device_id;
+        const uint16_t type = command.type;
+        const std::vector<uint8_t> payload(command.payload, command.payload + std::min<size_t>(command.length, INGRESS_MAX_PAYLOAD));
+        time = command.time;
+        command.sequence.store(this->dequeue_ + this->segment_->capacity, std::memory_order_release);
+        this->dequeue_++;
+
+        IngressClient &slot = this->segment_->clients[client];
+        if (!this->arbitrate(device_id, type, priority)) { slot.rejected.fetch_add(1, std::memory_order_relaxed); return Message(0, {}); }
+
+        slot.accepted.fetch_add(1, std::memory_order_relaxed);
+        return Message(device_id, type, 0, payload);
+    }
+
+    bool CommandIngress::accept(const Message &msg) {
+        if (this->segment_ == nullptr) { return true; }
+        return this->arbitrate(msg.get_device_id(), msg.get_type(), this->local_priority_);
+    }
+
+    uint32_t CommandIngress::get_signal() const {
+        return this->segment_ == nullptr ? 0 : this->segment_->signal.load(std::memory_order_acquire);
+    }
+
+    void CommandIngress::wait(const uint32_t signal, const std::chrono::high_resolution_clock::time_point deadline) const {
+        if (this->segment_ == nullptr) { return; }
+        const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::high_resolution_clock::now()).count();
+        if (remaining <= 0) { return; }
+
+        timespec time{};
+        time.tv_sec = static_cast<time_t>(remaining / 1000000000);
+        time.tv_nsec = static_cast<long>(remaining % 1000000000);
+        syscall(SYS_futex, &this->segment_->signal, FUTEX_WAIT, signal, &time, nullptr, 0);
+    }
+
+    void CommandIngress::notify() {
+        if (this->segment_ != nullptr) { wake(*this->segment_); }
+    }
+
+    std::vector<IngressClientStatistics> CommandIngress::get_clients() const {
+        std::vector<IngressClientStatistics> clients;
+        if (this->segment_ == nullptr) { return clients; }
+        for (const auto &slot : this->segment_->clients) {
+            if (slot.state.load(std::memory_order_acquire) != STD_CLIENT_READY) { continue; }
+            IngressClientStatistics &client = clients.emplace_back();
+            client.name.assign(slot.name, strnlen(slot.name, sizeof(slot.name)));
+            client.pid = slot.pid;
+            client.priority = slot.priority;
+            client.pushed = slot.pushed.load(std::memory_order_relaxed);
+            client.dropped = slot.dropped.load(std::memory_order_relaxed);
+            client.accepted = slot.accepted.load(std::memory_order_relaxed);
+            client.rejected = slot.rejected.load(std::memory_order_relaxed);
+        }
+        return clients;
+    }
+
+    CommandClient::CommandClient() : fd_(-1), segment_(nullptr), size_(0), client_(0), priority_(0) { }
+
+    CommandClient::~CommandClient() {
+        this->close();
+    }
+
+    bool CommandClient::claim(const std::string &client_name) {
+        for (uint32_t i = 0; i < INGRESS_MAX_CLIENTS; i++) {
+            IngressClient &slot = this->segment_->clients[i];
+            uint32_t state = slot.state.load(std::memory_order_acquire);
+
+            // a ready slot of a process which no longer exists is taken over.
+            if (state == STD_CLIENT_READY && !(kill(slot.pid, 0) < 0 && errno == ESRCH)) { continue; }
+            if (state == STD_CLIENT_CLAIMED || !slot.state.compare_exchange_strong(state, STD_CLIENT_CLAIMED, std::memory_order_acq_rel)) { continue; }
+
+            slot.pid = getpid();
+            slot.priority = this->priority_;
+            std::memset(slot.name, 0, sizeof(slot.name));
+            std::memcpy(slot.name, client_name.data(), std::min(client_name.size(), sizeof(slot.name) - 1));
+            for (auto *counter : { &slot.pushed, &slot.dropped, &slot.accepted, &slot.rejected }) { counter->store(0, std::memory_order_relaxed); }
+            slot.state.store(STD_CLIENT_READY, std::memory_order_release);
+            this->client_ = i;
+            return true;
+        }
+        return false;
+    }
+
+    bool CommandClient::open(const std::string &name, const std::string &client_name, const uint32_t priority) {
+        if (this->segment_ != nullptr) { log_message(LOG_WARNING, "Ingress", "Client already open"); return false; }
+
+        this->fd_ = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+        if (this->fd_ < 0) { log_message(LOG_ERROR, "Ingress", "Failed to open %s", name.c_str()); return false; }
+
+        struct stat status{};
+        void *address = MAP_FAILED;
+        if (fstat(this->fd_, &status) < 0 || static_cast<size_t>(status.st_size) < sizeof(IngressSegment)
+            || (address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, this->fd_, 0)) == MAP_FAILED) {
+            log_message(LOG_ERROR, "Ingress", "Failed to map %s", name.c_str());
+            ::close(this->fd_); this->fd_ = -1;
+            return false;
+        }
+        this->segment_ = static_cast<IngressSegment*>(address);
+        this->size_ = static_cast<size_t>(status.st_size);
+        this->priority_ = priority;
+
+        const IngressSegment &segment = *this->segment_;
+        if (std::memcmp(segment.magic, INGRESS_MAGIC, sizeof(INGRESS_MAGIC)) != 0 || segment.version != INGRESS_VERSION || segment.max_payload != INGRESS_MAX_PAYLOAD
+            || segment.capacity == 0 || this->size_ < get_segment_size(segment.capacity)) {
+            log_message(LOG_ERROR, "Ingress", "Unknown segment layout of %s", name.c_str());
+            munmap(this->segment_, this->size_); this->segment_ = nullptr;
+            ::close(this->fd_); this->fd_ = -1;
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (!this->claim(client_name)) {
+            log_message(LOG_ERROR, "Ingress", "No free client slot in %s", name.c_str());
+            munmap(this->segment_, this->size_); this->segment_ = nullptr;
+            ::close(this->fd_); this->fd_ = -1;
+            return false;
+        }
+        return true;
+    }
+
+    void CommandClient::close() {
+        if (this->segment_ == nullptr) { return; }
+        this->segment_->clients[this->client_].state.store(STD_CLIENT_FREE, std::memory_order_release);
+        munmap(this->segment_, this->size_);
+        ::close(this->fd_);
+        this->segment_ = nullptr;
+        this->fd_ = -1;
+    }
+
+    bool CommandClient::is_open() const {
+        return this->segment_ != nullptr;
+    }
+
+    bool CommandClient::push(const Message &msg) {
+        if (this->segment_ == nullptr) { return false; }
+        if (INGRESS_MAX_PAYLOAD < msg.get_payload().size()) { log_message(LOG_ERROR, "Ingress", "Command too long"); return false; }
+        IngressSegment &segment = *this->segment_;
+        IngressClient &slot = segment.clients[this->client_];
+
+        // bounded multi producer queue, a producer claims a command by its sequence and publishes it by advancing the sequence.
+        uint64_t position = segment.enqueue.load(std::memory_order_relaxed);
+        IngressCommand *command;
+        while (true) {
+            command = &get_commands(&segment)[position % segment.capacity];
+            const uint64_t sequence = command->sequence.load(std::memory_order_acquire);
+            if (sequence == position && segment.enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) { break; }
+            if (sequence < position) { slot.dropped.fetch_add(1, std::memory_order_relaxed); return false; }
+            if (sequence != position) { position = segment.enqueue.load(std::memory_order_relaxed); }
+        }
+
+        command->client = this->client_;
+        command->priority = this->priority_;
+        command->device_id = msg.get_device_id();
+        command->type = msg.get_type();
+        command->length = static_cast<uint16_t>(msg.get_payload().size());
+        command->time = get_realtime();
+        std::copy(msg.get_payload().begin(), msg.get_payload().end(), command->payload);
+        command->sequence.store(position + 1, std::memory_order_release);
+
+        slot.pushed.fetch_add(1, std::memory_order_relaxed);
+        wake(segment);
+        return true;
+    }
+} // namespace robomaster_can_controller
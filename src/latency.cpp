@@ -0,0 +1,132 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/latency.h"
+
+#include <ctime>
+
+namespace robomaster_can_controller {
+    static constexpr uint64_t STD_ACK_TIMEOUT = 1000000000;
+    static constexpr uint64_t STD_PURGE_INTERVAL = 100000000;
+
+    /**
+     * @brief The key of a command in flight, the type and the sequence number.
+     */
+    static uint32_t get_key(const uint16_t type, const uint16_t sequence) {
+        return static_cast<uint32_t>(type) << 16 | sequence;
+    }
+
+    /**
+     * @brief The latency between two times, zero when the clock stepped back.
+     */
+    static uint64_t get_latency(const uint64_t start, const uint64_t end) {
+        return start < end ? end - start : 0;
+    }
+
+    LatencyTracker::LatencyTracker() : purge_time_(0) { }
+
+    uint64_t LatencyTracker::now() {
+        timespec time{};
+        clock_gettime(CLOCK_REALTIME, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+    ChannelLatency &LatencyTracker::get_channel(const uint32_t device_id, const uint16_t type) {
+        ChannelLatency &channel = this->channels_[{ device_id, type }];
+        channel.device_id = device_id;
+        channel.type = type;
+        return channel;
+    }
+
+    void LatencyTracker::purge(const uint64_t time) {
+        if (get_latency(this->purge_time_, time) < STD_PURGE_INTERVAL) { return; }
+        this->purge_time_ = time;
+
+        for (auto it = this->pending_.begin(); it != this->pending_.end();) {
+            if (get_latency(it->second.enqueue, time) < STD_ACK_TIMEOUT) { ++it; continue; }
+            if (it->second.sent && it->second.need_ack) { this->get_channel(it->second.device_id, static_cast<uint16_t>(it->first >> 16)).unanswered++; }
+            it = this->pending_.erase(it);
+        }
+    }
+
+    void LatencyTracker::enqueue(const Message &msg, const uint64_t time) {
+        std::lock_guard lock(this->mutex_);
+        this->purge(time);
+        this->get_channel(msg.get_device_id(), msg.get_type()).enqueued++;
+
+        // a command with the same type and sequence replaces the older one, which is unanswered when it waits for an acknowledgement.
+        Pending &pending = this->pending_[get_key(msg.get_type(), msg.get_sequence())];
+        if (pending.sent && pending.need_ack) { this->get_channel(pending.device_id, msg.get_type()).unanswered++; }
+        pending.device_id = msg.get_device_id();
+        pending.enqueue = time;
+        pending.need_ack = !msg.get_payload().empty() && (msg.get_payload()[0] & 0x40) != 0;
+        pending.sent = false;
+        pending.acked = false;
+    }
+
+    void LatencyTracker::evict(const Message &msg) {
+        std::lock_guard lock(this->mutex_);
+        this->get_channel(msg.get_device_id(), msg.get_type()).evicted++;
+        this->pending_.erase(get_key(msg.get_type(), msg.get_sequence()));
+    }
+
+    void LatencyTracker::dequeue(const Message &msg, const uint64_t time) {
+        std::lock_guard lock(this->mutex_);
+        const auto it = this->pending_.find(get_key(msg.get_type(), msg.get_sequence()));
+        if (it == this->pending_.end()) { return; }
+        this->get_channel(msg.get_device_id(), msg.get_type()).queue.record(get_latency(it->second.enqueue, time));
+    }
+
+    void LatencyTracker::sent(const Message &msg, const bool success, const uint64_t time) {
+        std::lock_guard lock(this->mutex_);
+        const auto it = this->pending_.find(get_key(msg.get_type(), msg.get_sequence()));
+        if (it == this->pending_.end()) { return; }
+
+        ChannelLatency &channel = this->get_channel(msg.get_device_id(), msg.get_type());
+        if (!success) { channel.send_failures++; this->pending_.erase(it); return; }
+
+        channel.sent++;
+        channel.sent_latency.record(get_latency(it->second.enqueue, time));
+        if (it->second.need_ack && !it->second.acked) { it->second.sent = true; } else { this->pending_.erase(it); }
+    }
+
+    bool LatencyTracker::receive(const Message &msg) {
+        // an acknowledgement has the response flag set, the state push with the same swapped type has not.
+        const auto &payload = msg.get_payload();
+        if (payload.empty() || (payload[0] & 0x80) == 0) { return false; }
+
+        std::lock_guard lock(this->mutex_);
+        if (this->pending_.empty()) { return false; }
+
+        const auto type = static_cast<uint16_t>(msg.get_type() << 8 | msg.get_type() >> 8);
+        const auto it = this->pending_.find(get_key(type, msg.get_sequence()));
+        if (it == this->pending_.end() || !it->second.need_ack || it->second.acked) { return false; }
+
+        const uint64_t time = msg.get_time_last_frame() != 0 ? msg.get_time_last_frame() : now();
+        ChannelLatency &channel = this->get_channel(it->second.device_id, type);
+        channel.acked++;
+        channel.ack_latency.record(get_latency(it->second.enqueue, time));
+
+        // the acknowledgement can overtake the sender thread, the command is removed after its write is tracked.
+        if (it->second.sent) { this->pending_.erase(it); } else { it->second.acked = true; }
+        return true;
+    }
+
+    std::vector<ChannelLatency> LatencyTracker::get_statistics() const {
+        std::lock_guard lock(this->mutex_);
+        std::vector<ChannelLatency> statistics;
+        statistics.reserve(this->channels_.size());
+        for (const auto &[key, channel] : this->channels_) { statistics.push_back(channel); }
+        return statistics;
+    }
+
+    void LatencyTracker::reset() {
+        std::lock_guard lock(this->mutex_);
+        this->pending_.clear();
+        this->channels_.clear();
+        this->purge_time_ = 0;
+    }
+} // namespace robomaster_can_controller
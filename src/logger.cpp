@@ -0,0 +1,160 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/logger.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <utility>
+
+namespace robomaster_can_controller {
+    static uint64_t get_realtime() {
+        timespec time{};
+        clock_gettime(CLOCK_REALTIME, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+    Logger::Logger(const uint64_t burst, const uint64_t window)
+        : enqueue_(0), dequeue_(0), signal_(0), dropped_(0), level_(LOG_INFO), burst_(burst), window_(window), sink_(&Logger::print), flag_stop_(false) {
+        for (size_t i = 0; i < CAPACITY; i++) { this->slots_[i].sequence.store(i, std::memory_order_relaxed); }
+        this->thread_ = std::thread(&Logger::start_thread, this);
+    }
+
+    Logger::~Logger() {
+        this->flag_stop_ = true;
+        this->signal_.fetch_add(1, std::memory_order_release);
+        this->signal_.notify_one();
+        this->thread_.join();
+    }
+
+    Logger &Logger::get_instance() {
+        static Logger logger;
+        return logger;
+    }
+
+    void Logger::print(const LogRecord &record) {
+        if (record.suppressed == 0) { std::printf("[%s]: %s\n", record.tag, record.text); }
+        else { std::printf("[%s]: %s (suppressed %" PRIu64 " similar messages)\n", record.tag, record.text, record.suppressed); }
+    }
+
+    bool Logger::rate_limit(const char *format, const uint64_t time, uint64_t &suppressed) {
+        // open addressing by the address of the format, a slot is claimed once and never released.
+        const size_t hash = std::hash<const void*>{}(format);
+        RateLimit *limit = nullptr;
+        for (size_t i = 0; i < RATE_LIMITS && limit == nullptr; i++) {
+            RateLimit &candidate = this->rate_limits_[(hash + i) % RATE_LIMITS];
+            const char *owner = candidate.format.load(std::memory_order_acquire);
+            if (owner == nullptr && candidate.format.compare_exchange_strong(owner, format, std::memory_order_acq_rel)) { owner = format; }
+            if (owner == format) { limit = &candidate; }
+        }
+        if (limit == nullptr) { suppressed = 0; return true; }
+
+        // the limit is approximate when several threads start a new window at once, which is fine for a rate limit.
+        uint64_t window = limit->window.load(std::memory_order_relaxed);
+        if (this->window_ <= time - window && limit->window.compare_exchange_strong(window, time, std::memory_order_relaxed)) { limit->count.store(0, std::memory_order_relaxed); }
+        if (this->burst_ <= limit->count.fetch_add(1, std::memory_order_relaxed)) { limit->suppressed.fetch_add(1, std::memory_order_relaxed); return false; }
+        suppressed = limit->suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool Logger::log(const LogLevel level, const char *tag, const char *format, ...) {
+        va_list args;
+        va_start(args, format);
+        const bool success = this->log(level, tag, format, args);
+        va_end(args);
+        return success;
+    }
+
+    bool Logger::log(const LogLevel level, const char *tag, const char *format, va_list args) {
+        if (level < this->level_.load(std::memory_order_relaxed)) { return false; }
+
+        const uint64_t time = get_realtime();
+        uint64_t suppressed = 0;
+        if (!this->rate_limit(format, time, suppressed)) { return false; }
+
+        // bounded multi producer queue, a producer claims a slot by its sequence and publishes it by advancing the sequence of the slot.
+        uint64_t position = this->enqueue_.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &this->slots_[position % CAPACITY];
+            const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            if (sequence == position && this->enqueue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) { break; }
+            if (sequence < position) { this->dropped_.fetch_add(1, std::memory_order_relaxed); return false; }
+            if (sequence != position) { position = this->enqueue_.load(std::memory_order_relaxed); }
+        }
+
+        LogRecord &record = slot->record;
+        record.time = time;
+        record.level = level;
+        record.tag = tag;
+        record.suppressed = suppressed;
+        std::vsnprintf(record.text, LogRecord::TEXT_SIZE, format, args);
+        slot->sequence.store(position + 1, std::memory_order_release);
+
+        this->signal_.fetch_add(1, std::memory_order_release);
+        this->signal_.notify_one();
+        return true;
+    }
+
+    bool Logger::pop(LogRecord &record) {
+        const uint64_t position = this->dequeue_.load(std::memory_order_relaxed);
+        Slot &slot = this->slots_[position % CAPACITY];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) { return false; }
+        record = slot.record;
+        slot.sequence.store(position + CAPACITY, std::memory_order_release);
+        this->dequeue_.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    void Logger::start_thread() {
+        LogRecord record;
+        while (true) {
+            const uint32_t signal = this->signal_.load(std::memory_order_acquire);
+            if (this->pop(record)) {
+                std::lock_guard lock(this->sink_mutex_);
+                if (this->sink_) { this->sink_(record); }
+                while (this->pop(record)) { if (this->sink_) { this->sink_(record); } }
+            }
+            this->dequeue_.notify_all();
+            if (this->flag_stop_) { break; }
+            this->signal_.wait(signal, std::memory_order_acquire);
+        }
+    }
+
+    void Logger::set_sink(std::function<void(const LogRecord&)> sink) {
+        std::lock_guard lock(this->sink_mutex_);
+        this->sink_ = std::move(sink);
+    }
+
+    void Logger::set_level(const LogLevel level) {
+        this->level_.store(level, std::memory_order_relaxed);
+    }
+
+    void Logger::flush() {
+        const uint64_t target = this->enqueue_.load(std::memory_order_acquire);
+        uint64_t position = this->dequeue_.load(std::memory_order_acquire);
+        while (position < target) {
+            this->signal_.fetch_add(1, std::memory_order_release);
+            this->signal_.notify_one();
+            this->dequeue_.wait(position, std::memory_order_acquire);
+            position = this->dequeue_.load(std::memory_order_acquire);
+        }
+    }
+
+    uint64_t Logger::get_dropped() const {
+        return this->dropped_.load(std::memory_order_relaxed);
+    }
+
+    bool log_message(const LogLevel level, const char *tag, const char *format, ...) {
+        va_list args;
+        va_start(args, format);
+        const bool success = Logger::get_instance().log(level, tag, format, args);
+        va_end(args);
+        return success;
+    }
+} // namespace robomaster_can_controller
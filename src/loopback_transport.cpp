@@ -0,0 +1,139 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/loopback_transport.h"
+#include "robomaster_can_controller/logger.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <unordered_map>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The transports which joined a bus.
+     */
+    struct LoopbackTransport::Bus {
+        std::mutex mutex;
+        std::vector<LoopbackTransport*> members;
+    };
+
+    /**
+     * @brief The registry of the named buses, a bus is removed when the last transport leaves it.
+     */
+    static std::mutex registry_mutex;
+    static std::unordered_map<std::string, std::weak_ptr<void>> registry;
+
+    static uint64_t get_realtime() {
+        timespec time{};
+        clock_gettime(CLOCK_REALTIME, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+    LoopbackTransport::LoopbackTransport(): event_fd_(-1), timeout_(-1) { }
+
+    LoopbackTransport::~LoopbackTransport() {
+        if (this->bus_) {
+            std::lock_guard lock(this->bus_->mutex);
+            std::erase(this->bus_->members, this);
+        }
+        if (0 <= this->event_fd_) { close(this->event_fd_); }
+    }
+
+    bool LoopbackTransport::init(const std::string &name) {
+        if (this->bus_) { log_message(LOG_WARNING, "Loopback", "Transport already joined a bus"); return false; }
+
+        this->event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (this->event_fd_ < 0) { log_message(LOG_ERROR, "Loopback", "Failed to open eventfd"); return false; }
+
+        {
+            std::lock_guard lock(registry_mutex);
+            auto &entry = registry[name];
+            this->bus_ = std::static_pointer_cast<Bus>(entry.lock());
+            if (!this->bus_) { this->bus_ = std::make_shared<Bus>(); entry = this->bus_; }
+        }
+
+        std::lock_guard lock(this->bus_->mutex);
+        this->bus_->members.push_back(this);
+        return true;
+    }
+
+    void LoopbackTransport::set_timeout(const double seconds) {
+        this->timeout_ = 0.0 < seconds ? std::max(1, static_cast<int>(std::lround(seconds * 1000.0))) : -1;
+    }
+
+    int LoopbackTransport::get_fd() const {
+        return this->event_fd_;
+    }
+
+    void LoopbackTransport::deliver(const CanFrame &frame) {
+        std::lock_guard lock(this->mutex_);
+        this->queue_.push_back(frame);
+
+        // the eventfd is signalled under the queue lock, so it is readable exactly while frames are queued.
+        if (this->queue_.size() == 1) { constexpr uint64_t value = 1; (void)write(this->event_fd_, &value, sizeof(value)); }
+    }
+
+    bool LoopbackTransport::wait() {
+        pollfd fd{ this->event_fd_, POLLIN, 0 };
+        return 0 < poll(&fd, 1, this->timeout_);
+    }
+
+    bool LoopbackTransport::send_frame(const uint32_t id, const uint8_t data[8], const size_t length) {
+        CanFrame frame;
+        frame.id = id;
+        frame.length = static_cast<uint8_t>(length);
+        if (8 < length) { log_message(LOG_ERROR, "Loopback", "Failed to send frame"); return false; }
+        memcpy(frame.data, data, length);
+        return this->send_frames(&frame, 1);
+    }
+
+    bool LoopbackTransport::send_frames(const CanFrame *frames, const size_t count) {
+        if (!this->bus_) { log_message(LOG_ERROR, "Loopback", "Failed to send frame"); return false; }
+        const uint64_t timestamp = get_realtime();
+
+        std::lock_guard lock(this->bus_->mutex);
+        for (size_t i = 0; i < count; i++) {
+            if (8 < frames[i].length) { log_message(LOG_ERROR, "Loopback", "Failed to send frame"); return false; }
+            CanFrame frame = frames[i];
+            frame.timestamp = timestamp;
+            for (LoopbackTransport *member : this->bus_->members) { if (member != this) { member->deliver(frame); } }
+        }
+        return true;
+    }
+
+    bool LoopbackTransport::read_frame(uint32_t &id, uint8_t data[8], size_t &length, uint64_t &timestamp) {
+        CanFrame frame;
+        size_t count;
+        if (!this->read_frames(&frame, 1, count)) { return false; }
+
+        id = frame.id;
+        length = count == 0 ? 0 : frame.length;
+        timestamp = frame.timestamp;
+        memcpy(data, frame.data, length);
+        return true;
+    }
+
+    bool LoopbackTransport::read_frames(CanFrame *frames, const size_t capacity, size_t &count) {
+        count = 0;
+        if (!this->bus_) { log_message(LOG_ERROR, "Loopback", "Failed to read frame"); return false; }
+        if (!this->wait()) { return true; }
+
+        std::lock_guard lock(this->mutex_);
+        count = std::min(capacity, this->queue_.size());
+        std::copy_n(this->queue_.begin(), count, frames);
+        this->queue_.erase(this->queue_.begin(), this->queue_.begin() + static_cast<long>(count));
+        if (this->queue_.empty()) { uint64_t value; (void)read(this->event_fd_, &value, sizeof(value)); }
+        return true;
+    }
+} // namespace robomaster_can_controller
@@ -7,19 +7,30 @@
 #include "robomaster_can_controller/message.h"
 #include "robomaster_can_controller/utils.h"
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
-#include <iomanip>
+#include <charconv>
+#include <cstring>
+#include <string_view>
 #include <utility>
 
 namespace robomaster_can_controller {
+    static constexpr size_t STD_MIN_LENGTH = 10;
+    static constexpr size_t STD_MAX_LENGTH = 0xff;
+    static constexpr size_t STD_PRINT_BYTES = 32;
+
     Message::Message(const uint32_t device_id, const std::vector<uint8_t> &msg_data)
         : is_valid_(false),
           device_id_(device_id),
           sequence_(0),
-          type_(0)
-
+          type_(0),
+          time_first_frame_(0),
+          time_last_frame_(0)
     {
-        if(10 < msg_data.size()) {
+        // the data comes from the bus, so the header has to match the size of the data before anything is read.
+        if(STD_MIN_LENGTH < msg_data.size() && msg_data.size() <= STD_MAX_LENGTH && msg_data[0] == 0x55 && msg_data[1] == msg_data.size()) {
             this->type_ = little_endian_to_uint16(msg_data[4], msg_data[5]);
             this->sequence_ = little_endian_to_uint16(msg_data[6], msg_data[7]);
             this->payload_.clear();
@@ -33,7 +44,9 @@ namespace robomaster_can_controller {
           device_id_(device_id),
           sequence_(sequence),
           type_(type),
-          payload_(std::move(payload))
+          payload_(std::move(payload)),
+          time_first_frame_(0),
+          time_last_frame_(0)
     { }
 
     uint32_t Message::get_device_id() const {
@@ -47,7 +60,7 @@ namespace robomaster_can_controller {
         return this->type_;
     }
 
-    std::vector<uint8_t> Message::get_payload() const {
+    const std::vector<uint8_t> &Message::get_payload() const {
         return this->payload_;
     }
 
@@ -55,6 +68,19 @@ namespace robomaster_can_controller {
         return this->payload_.size() + 10;
     }
 
+    uint64_t Message::get_time_first_frame() const {
+        return this->time_first_frame_;
+    }
+
+    uint64_t Message::get_time_last_frame() const {
+        return this->time_last_frame_;
+    }
+
+    void Message::set_time(const uint64_t time_first_frame, const uint64_t time_last_frame) {
+        this->time_first_frame_ = time_first_frame;
+        this->time_last_frame_ = time_last_frame;
+    }
+
     bool Message::is_valid() const {
         return this->is_valid_;
     }
@@ -63,6 +89,10 @@ namespace robomaster_can_controller {
         this->sequence_++;
     }
 
+    void Message::set_sequence(const uint16_t sequence) {
+        this->sequence_ = sequence;
+    }
+
     void Message::set_value_uint8(const size_t index, const uint8_t value) {
         assert(index < this->payload_.size());
         this->payload_[index] = value;
@@ -163,7 +193,7 @@ namespace robomaster_can_controller {
 
     std::vector<uint8_t> Message::to_vector() const {
         std::vector<uint8_t> vector;
-        if (this->is_valid_) {
+        if (this->is_valid_ && this->payload_.size() <= STD_MAX_LENGTH - STD_MIN_LENGTH) {
             // header, crc usw + payload
             vector.resize(10 + this->payload_.size());
             vector[0] = 0x55;
@@ -185,19 +215,32 @@ namespace robomaster_can_controller {
     }
 
     std::ostream& operator<<(std::ostream& os, const Message& msg) {
-        os << "Message( 0x"
-           << std::setfill('0') << std::setw(4) << std::hex << msg.get_device_id() << ", 0x"
-           << std::setfill('0') << std::setw(4) << std::hex << msg.get_type() << ", "
-           << std::setfill(' ') << std::setw(5) << std::dec << msg.get_sequence() << ", { ";
-
-        if (!msg.get_payload().empty()) {
-            os << "0x";
-            for (size_t i = 0; i < msg.get_payload().size(); i++) {
-                os << std::setfill('0') << std::setw(2) << std::hex << static_cast<uint16_t>(msg.get_payload()[i]);
-                if (i < msg.get_payload().size() - 1) { os << ", 0x"; }
-            }
+        // the message is formatted into a buffer without stream manipulators, a long payload is written in parts of STD_PRINT_BYTES.
+        std::array<char, 64 + STD_PRINT_BYTES * 6> buffer{};
+        char *position = buffer.data();
+        const auto text = [&position](const std::string_view value) { std::memcpy(position, value.data(), value.size()); position += value.size(); };
+        const auto hex = [&position](const uint32_t value) {
+            const size_t digits = std::max<size_t>(4, (std::bit_width(value) + 3) / 4);
+            uint_to_hex(value, position, digits); position += digits;
+        };
+
+        text("Message( 0x"); hex(msg.get_device_id());
+        text(", 0x"); hex(msg.get_type());
+        text(", ");
+        std::array<char, 5> sequence{};
+        const auto end = std::to_chars(sequence.begin(), sequence.end(), msg.get_sequence()).ptr;
+        position = std::fill_n(position, sequence.end() - end, ' ');
+        text(std::string_view(sequence.data(), end - sequence.data()));
+        text(", { ");
+
+        const std::vector<uint8_t> &payload = msg.get_payload();
+        for (size_t i = 0; i < payload.size(); i++) {
+            text(i == 0 ? "0x" : ", 0x");
+            uint_to_hex(payload[i], position, 2); position += 2;
+            if ((i + 1) % STD_PRINT_BYTES == 0) { os.write(buffer.data(), position - buffer.data()); position = buffer.data(); }
         }
-        os << " })" << std::dec;
+        text(" })");
+        os.write(buffer.data(), position - buffer.data());
         return os;
     }
 } // namespace robomaster_can_controller
\ No newline at end of file
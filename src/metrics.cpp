@@ -0,0 +1,207 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/metrics.h"
+#include "robomaster_can_controller/logger.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <tuple>
+
+namespace robomaster_can_controller {
+    static constexpr int STD_POLL_TIMEOUT = 100;
+
+    /**
+     * @brief The name and the help of every counter, indexed by MetricCounter.
+     */
+    static constexpr std::array<std::pair<const char*, const char*>, METRIC_COUNTER_COUNT> STD_COUNTER_NAMES = {{
+        { "robomaster_frames_received_total", "Number of received can frames." },
+        { "robomaster_frames_sent_total", "Number of sent can frames." },
+        { "robomaster_messages_received_total", "Number of reassembled messages." },
+        { "robomaster_messages_sent_total", "Number of sent messages including the heartbeat." },
+        { "robomaster_read_errors_total", "Number of failed reads of the transport." },
+        { "robomaster_send_errors_total", "Number of failed writes of the transport." },
+        { "robomaster_receive_queue_drops_total", "Number of received messages dropped by the overflow of the receiver queue." },
+        { "robomaster_send_queue_drops_total", "Number of commands dropped by the overflow of the sender queue." },
+        { "robomaster_heartbeats_total", "Number of sent heartbeats." },
+        { "robomaster_ingress_commands_total", "Number of commands of other processes taken from the command ingress." },
+        { "robomaster_ingress_rejected_total", "Number of commands of other processes discarded by the priority arbitration." },
+        { "robomaster_local_rejected_total", "Number of local commands discarded by the priority arbitration of the command ingress." }
+    }};
+
+    /**
+     * @brief The name and the help of every histogram, indexed by MetricHistogram.
+     */
+    static constexpr std::array<std::pair<const char*, const char*>, METRIC_HISTOGRAM_COUNT> STD_HISTOGRAM_NAMES = {{
+        { "robomaster_heartbeat_lateness_seconds", "Time between the scheduled and the actual send of the heartbeat." },
+        { "robomaster_callback_duration_seconds", "Duration of the dispatch of a received message including the callbacks." }
+    }};
+
+    /**
+     * @brief The quantiles of the exported summaries.
+     */
+    static constexpr std::array<double, 5> STD_QUANTILES = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+
+    /**
+     * @brief The shard of the next thread which records a metric.
+     */
+    static std::atomic<size_t> next_shard = 0;
+
+    static uint64_t get_realtime() {
+        timespec time{};
+        clock_gettime(CLOCK_REALTIME, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+    /**
+     * @brief Append a formatted line to the text.
+     */
+    template<typename... Args>
+    static void append(std::string &text, const char *format, Args... args) {
+        char line[256];
+        const int length = std::snprintf(line, sizeof(line), format, args...);
+        if (0 < length) { text.append(line, std::min(static_cast<size_t>(length), sizeof(line) - 1)); }
+    }
+
+    Metrics::Metrics() = default;
+
+    Metrics::Shard &Metrics::get_shard() {
+        static thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+        return this->shards_[shard];
+    }
+
+    void Metrics::add(const MetricCounter counter, const uint64_t value) {
+        this->get_shard().counters[counter].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void Metrics::record(const MetricHistogram histogram, const uint64_t value) {
+        this->get_shard().histograms[histogram].record(value);
+    }
+
+    MetricsSnapshot Metrics::get_snapshot() const {
+        MetricsSnapshot snapshot;
+        snapshot.time = get_realtime();
+        for (const auto &shard : this->shards_) {
+            for (size_t i = 0; i < METRIC_COUNTER_COUNT; i++) { snapshot.counters[i] += shard.counters[i].load(std::memory_order_relaxed); }
+            for (size_t i = 0; i < METRIC_HISTOGRAM_COUNT; i++) { shard.histograms[i].load(snapshot.histograms[i]); }
+        }
+        return snapshot;
+    }
+
+    std::string to_prometheus(const MetricsSnapshot &snapshot) {
+        std::string text;
+        text.reserve(4096);
+
+        for (size_t i = 0; i < METRIC_COUNTER_COUNT; i++) {
+            const auto &[name, help] = STD_COUNTER_NAMES[i];
+            append(text, "# HELP %s %s\n# TYPE %s counter\n%s %" PRIu64 "\n", name, help, name, name, snapshot.counters[i]);
+        }
+
+        for (size_t i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+            const auto &[name, help] = STD_HISTOGRAM_NAMES[i];
+            const Histogram &histogram = snapshot.histograms[i];
+            append(text, "# HELP %s %s\n# TYPE %s summary\n", name, help, name);
+            for (const double quantile : STD_QUANTILES) {
+                append(text, "%s{quantile=\"%g\"} %.9g\n", name, quantile, static_cast<double>(histogram.get_percentile(quantile * 100.0)) * 1e-9);
+            }
+            append(text, "%s_sum %.9g\n%s_count %" PRIu64 "\n", name, histogram.get_mean() * static_cast<double>(histogram.get_count()) * 1e-9, name, histogram.get_count());
+        }
+
+        // the counters of the streams share one metric family per counter with the device as label.
+        const std::array<std::tuple<const char*, const char*, uint64_t StreamStatistics::*>, 7> streams = {{
+            { "robomaster_stream_frames_total", "Number of can frames of the stream.", &StreamStatistics::frames },
+            { "robomaster_stream_bytes_total", "Number of bytes of the stream.", &StreamStatistics::bytes },
+            { "robomaster_stream_messages_total", "Number of messages with valid crc16 of the stream.", &StreamStatistics::messages },
+            { "robomaster_stream_crc16_errors_total", "Number of messages dropped due to a wrong crc16.", &StreamStatistics::crc_errors },
+            { "robomaster_stream_crc8_errors_total", "Number of sync bytes with a wrong header crc8.", &StreamStatistics::crc8_errors },
+            { "robomaster_stream_discarded_bytes_total", "Number of bytes skipped while searching for a header.", &StreamStatistics::discarded_bytes },
+            { "robomaster_stream_resyncs_total", "Number of searches for the next header.", &StreamStatistics::resyncs }
+        }};
+        if (!snapshot.streams.empty()) {
+            for (const auto &[name, help, member] : streams) {
+                append(text, "# HELP %s %s\n# TYPE %s counter\n", name, help, name);
+                for (const auto &[device_id, statistics] : snapshot.streams) { append(text, "%s{device=\"0x%03x\"} %" PRIu64 "\n", name, device_id, statistics.*member); }
+            }
+        }
+        return text;
+    }
+
+    bool write_text_file(const std::string &path, const std::string &text) {
+        const std::string temporary = path + ".tmp";
+        FILE *file = std::fopen(temporary.c_str(), "w");
+        if (file == nullptr) { log_message(LOG_ERROR, "Metrics", "Failed to create %s", temporary.c_str()); return false; }
+
+        const bool success = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+        if (std::fclose(file) != 0 || !success) { log_message(LOG_ERROR, "Metrics", "Failed to write %s", temporary.c_str()); std::remove(temporary.c_str()); return false; }
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) { log_message(LOG_ERROR, "Metrics", "Failed to replace %s", path.c_str()); std::remove(temporary.c_str()); return false; }
+        return true;
+    }
+
+    MetricsExporter::MetricsExporter(std::function<std::string()> source) : source_(std::move(source)), socket_(-1), flag_stop_(false) { }
+
+    MetricsExporter::~MetricsExporter() {
+        this->stop();
+    }
+
+    bool MetricsExporter::start(const std::string &path) {
+        if (this->thread_.joinable()) { log_message(LOG_ERROR, "Metrics", "Exporter already running"); return false; }
+
+        sockaddr_un address{};
+        if (sizeof(address.sun_path) <= path.size()) { log_message(LOG_ERROR, "Metrics", "Socket path too long"); return false; }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+
+        this->socket_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (this->socket_ < 0) { log_message(LOG_ERROR, "Metrics", "Failed to create socket"); return false; }
+
+        unlink(path.c_str());
+        if (bind(this->socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(this->socket_, 8) < 0) {
+            log_message(LOG_ERROR, "Metrics", "Failed to bind %s", path.c_str());
+            close(this->socket_); this->socket_ = -1;
+            return false;
+        }
+
+        this->path_ = path;
+        this->flag_stop_ = false;
+        this->thread_ = std::thread(&MetricsExporter::start_thread, this);
+        return true;
+    }
+
+    void MetricsExporter::stop() {
+        if (!this->thread_.joinable()) { return; }
+        this->flag_stop_ = true;
+        this->thread_.join();
+        close(this->socket_);
+        this->socket_ = -1;
+        unlink(this->path_.c_str());
+    }
+
+    void MetricsExporter::start_thread() {
+        pollfd fd{ this->socket_, POLLIN, 0 };
+        while (!this->flag_stop_) {
+            if (poll(&fd, 1, STD_POLL_TIMEOUT) <= 0) { continue; }
+
+            const int client = accept4(this->socket_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) { continue; }
+
+            const std::string text = this->source_();
+            for (size_t offset = 0; offset < text.size();) {
+                const ssize_t length = send(client, text.data() + offset, text.size() - offset, MSG_NOSIGNAL);
+                if (length <= 0) { break; }
+                offset += static_cast<size_t>(length);
+            }
+            close(client);
+        }
+    }
+} // namespace robomaster_can_controller
@@ -7,20 +7,29 @@
 #include "robomaster_can_controller/queue_msg.h"
 
 namespace robomaster_can_controller {
-    static constexpr size_t STD_MAX_QUEUE_SIZE = 10;
-
     QueueMsg::QueueMsg() = default;
 
-    void QueueMsg::push(const Message &msg) {
+    std::optional<Message> QueueMsg::push(const Message &msg) {
         std::lock_guard lock(this->mutex_);
-        if(STD_MAX_QUEUE_SIZE <= this->queue_.size()) { this->queue_.pop(); }
+        std::optional<Message> evicted;
+        if(QUEUE_MSG_MAX_SIZE <= this->queue_.size()) { evicted.emplace(std::move(this->queue_.front())); this->queue_.pop(); }
         this->queue_.push(msg);
+        return evicted;
     }
 
-    void QueueMsg::push(Message && msg) {
+    std::optional<Message> QueueMsg::push(Message && msg) {
         std::lock_guard lock(this->mutex_);
-        if(STD_MAX_QUEUE_SIZE <= this->queue_.size()) { this->queue_.pop(); }
+        std::optional<Message> evicted;
+        if(QUEUE_MSG_MAX_SIZE <= this->queue_.size()) { evicted.emplace(std::move(this->queue_.front())); this->queue_.pop(); }
         this->queue_.emplace(std::move(msg));
+        return evicted;
+    }
+
+    bool QueueMsg::push_batch(const std::vector<Message> &msgs) {
+        std::lock_guard lock(this->mutex_);
+        if (QUEUE_MSG_MAX_SIZE < this->queue_.size() + msgs.size()) { return false; }
+        for (const Message &msg : msgs) { this->queue_.push(msg); }
+        return true;
     }
 
     Message QueueMsg::pop() {
@@ -34,6 +43,13 @@ namespace robomaster_can_controller {
         return msg;
     }
 
+    size_t QueueMsg::pop_all(std::vector<Message> &msgs) {
+        std::lock_guard lock(this->mutex_);
+        const size_t count = this->queue_.size();
+        while (!this->queue_.empty()) { msgs.emplace_back(std::move(this->queue_.front())); this->queue_.pop(); }
+        return count;
+    }
+
     size_t QueueMsg::size() {
         std::lock_guard lock(this->mutex_);
         return this->queue_.size();
@@ -45,7 +61,7 @@ namespace robomaster_can_controller {
     }
 
     size_t QueueMsg::max_queue_size() {
-        return STD_MAX_QUEUE_SIZE;
+        return QUEUE_MSG_MAX_SIZE;
     }
 
     void QueueMsg::clear() {
@@ -0,0 +1,169 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/reassembler.h"
+#include "robomaster_can_controller/definitions.h"
+#include "robomaster_can_controller/utils.h"
+
+#include <algorithm>
+
+namespace robomaster_can_controller {
+    static constexpr size_t STD_MIN_MESSAGE_LENGTH = 10;
+    static constexpr size_t STD_COMPACT_THRESHOLD = 256;
+
+    Reassembler::Reassembler() {
+        this->enable_device(DEVICE_ID_MOTION_CONTROLLER);
+        this->enable_device(DEVICE_ID_GIMBAL);
+        this->enable_device(DEVICE_ID_HIT_DETECTOR_1);
+        this->enable_device(DEVICE_ID_HIT_DETECTOR_2);
+        this->enable_device(DEVICE_ID_HIT_DETECTOR_3);
+        this->enable_device(DEVICE_ID_HIT_DETECTOR_4);
+    }
+
+    Reassembler::Stream *Reassembler::get_stream(const uint32_t device_id) {
+        const uint32_t index = device_id - DEVICE_ID_BASE;
+        return index < DEVICE_ID_COUNT ? &this->streams_[index] : nullptr;
+    }
+
+    const Reassembler::Stream *Reassembler::get_stream(const uint32_t device_id) const {
+        const uint32_t index = device_id - DEVICE_ID_BASE;
+        return index < DEVICE_ID_COUNT ? &this->streams_[index] : nullptr;
+    }
+
+    bool Reassembler::enable_device(const uint32_t device_id) {
+        Stream *stream = this->get_stream(device_id);
+        if (stream == nullptr) { return false; }
+        stream->enabled = true;
+        return true;
+    }
+
+    void Reassembler::disable_device(const uint32_t device_id) {
+        Stream *stream = this->get_stream(device_id);
+        if (stream == nullptr) { return; }
+        stream->enabled = false;
+        stream->buffer.clear();
+        stream->frame_times.clear();
+        stream->head = 0;
+        stream->length = 0;
+    }
+
+    bool Reassembler::is_enabled(const uint32_t device_id) const {
+        const Stream *stream = this->get_stream(device_id);
+        return stream != nullptr && stream->enabled;
+    }
+
+    bool Reassembler::synchronise(Stream &stream) {
+        const uint8_t *buffer = stream.buffer.data();
+        const size_t size = stream.buffer.size();
+        const size_t head = stream.head;
+        uint64_t crc8_errors = 0;
+        bool found = false;
+
+        while (true) {
+            stream.head += find_byte(buffer + stream.head, size - stream.head, 0x55);
+            if (size - stream.head < 4) { break; }
+
+            const uint8_t *header = buffer + stream.head;
+            if (header[3] != calculate_crc8(header, 3)) { crc8_errors++; }
+            else if (STD_MIN_MESSAGE_LENGTH <= header[1]) { stream.length = header[1]; found = true; break; }
+            stream.head++;
+        }
+
+        if (head != stream.head) {
+            stream.discarded_bytes.fetch_add(stream.head - head, std::memory_order_relaxed);
+            stream.resyncs.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (crc8_errors != 0) { stream.crc8_errors.fetch_add(crc8_errors, std::memory_order_relaxed); }
+        return found;
+    }
+
+    uint64_t Reassembler::get_frame_time(const Stream &stream, const size_t position) {
+        const auto frame = std::upper_bound(std::cbegin(stream.frame_times), std::cend(stream.frame_times), position, [](const size_t p, const auto &f) { return p < f.first; });
+        return frame == std::cbegin(stream.frame_times) ? 0 : std::prev(frame)->second;
+    }
+
+    void Reassembler::compact(Stream &stream) {
+        auto &buffer = stream.buffer;
+        auto &frame_times = stream.frame_times;
+
+        if (stream.head == buffer.size()) { buffer.clear(); frame_times.clear(); stream.head = 0; return; }
+        if (stream.head < STD_COMPACT_THRESHOLD) { return; }
+
+        // keep the time of the frame which contains the new front of the buffer.
+        const auto frame = std::upper_bound(std::cbegin(frame_times), std::cend(frame_times), stream.head, [](const size_t p, const auto &f) { return p < f.first; });
+        frame_times.erase(std::cbegin(frame_times), std::prev(frame));
+        for (auto &[offset, time] : frame_times) { offset = std::max(offset, stream.head) - stream.head; }
+
+        buffer.erase(std::cbegin(buffer), std::cbegin(buffer) + static_cast<long>(stream.head)); stream.head = 0;
+    }
+
+    size_t Reassembler::push_frame(const uint32_t device_id, const uint8_t *data, const size_t length, std::vector<Message> &messages, const uint64_t timestamp) {
+        Stream *stream = this->get_stream(device_id);
+        if (stream == nullptr || !stream->enabled) { return 0; }
+
+        stream->frames.fetch_add(1, std::memory_order_relaxed);
+        stream->bytes.fetch_add(length, std::memory_order_relaxed);
+
+        auto &buffer = stream->buffer;
+        stream->frame_times.emplace_back(buffer.size(), timestamp);
+        buffer.insert(std::end(buffer), data, data + length);
+
+        size_t counter = 0;
+        while ((stream->length != 0 || synchronise(*stream)) && stream->length <= buffer.size() - stream->head) {
+            const uint8_t *msg_data = buffer.data() + stream->head;
+            const size_t msg_length = stream->length;
+            stream->length = 0;
+
+            if (const uint16_t crc16 = little_endian_to_uint16(msg_data[msg_length - 2], msg_data[msg_length - 1]); crc16 == calculate_crc16(msg_data, msg_length - 2)) {
+                messages.emplace_back(device_id, std::vector(msg_data, msg_data + msg_length));
+                messages.back().set_time(get_frame_time(*stream, stream->head), get_frame_time(*stream, stream->head + msg_length - 1));
+                stream->messages.fetch_add(1, std::memory_order_relaxed);
+                stream->head += msg_length;
+                counter++;
+            } else {
+                // the header may be a false candidate, so search the next header right after the sync byte.
+                stream->crc_errors.fetch_add(1, std::memory_order_relaxed);
+                stream->discarded_bytes.fetch_add(1, std::memory_order_relaxed);
+                stream->head++;
+            }
+        }
+
+        // compact the buffer once per frame instead of erasing every skipped byte.
+        compact(*stream);
+        return counter;
+    }
+
+    StreamStatistics Reassembler::get_statistics(const uint32_t device_id) const {
+        StreamStatistics statistics;
+        const Stream *stream = this->get_stream(device_id);
+        if (stream == nullptr) { return statistics; }
+
+        statistics.frames          = stream->frames.load(std::memory_order_relaxed);
+        statistics.bytes           = stream->bytes.load(std::memory_order_relaxed);
+        statistics.messages        = stream->messages.load(std::memory_order_relaxed);
+        statistics.crc_errors      = stream->crc_errors.load(std::memory_order_relaxed);
+        statistics.crc8_errors     = stream->crc8_errors.load(std::memory_order_relaxed);
+        statistics.discarded_bytes = stream->discarded_bytes.load(std::memory_order_relaxed);
+        statistics.resyncs         = stream->resyncs.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+    void Reassembler::reset() {
+        for (auto &stream : this->streams_) { stream.buffer.clear(); stream.frame_times.clear(); stream.head = 0; stream.length = 0; }
+    }
+
+    void Reassembler::reset_statistics() {
+        for (auto &stream : this->streams_) {
+            stream.frames.store(0, std::memory_order_relaxed);
+            stream.bytes.store(0, std::memory_order_relaxed);
+            stream.messages.store(0, std::memory_order_relaxed);
+            stream.crc_errors.store(0, std::memory_order_relaxed);
+            stream.crc8_errors.store(0, std::memory_order_relaxed);
+            stream.discarded_bytes.store(0, std::memory_order_relaxed);
+            stream.resyncs.store(0, std::memory_order_relaxed);
+        }
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,203 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/recorder.h"
+#include "robomaster_can_controller/logger.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+
+namespace robomaster_can_controller {
+    static constexpr size_t STD_CHUNK_SIZE = 4 * 1024 * 1024;
+    static constexpr auto STD_IDLE_TIME = std::chrono::milliseconds(1);
+
+    static uint64_t get_realtime() {
+        timespec time{};
+        clock_gettime(CLOCK_REALTIME, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+    Recorder::Recorder(const size_t capacity, const uint32_t index_interval)
+        : mask_(std::bit_ceil(std::max(capacity, static_cast<size_t>(2))) - 1),
+          head_(0),
+          tail_(0),
+          recorded_(0),
+          dropped_(0),
+          written_(0),
+          fd_(-1),
+          chunk_(nullptr),
+          chunk_offset_(0),
+          offset_(0),
+          sequence_(0),
+          index_interval_(std::max(index_interval, static_cast<uint32_t>(2))),
+          flag_open_(false),
+          flag_stop_(false)
+    {
+        this->slots_ = std::make_unique<Slot[]>(this->mask_ + 1);
+        for (size_t i = 0; i <= this->mask_; i++) { this->slots_[i].sequence.store(i, std::memory_order_relaxed); }
+    }
+
+    Recorder::~Recorder() {
+        this->close();
+    }
+
+    bool Recorder::open(const std::string &path) {
+        if (this->thread_.joinable()) { log_message(LOG_ERROR, "Recorder", "Recorder already open"); return false; }
+
+        this->fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (this->fd_ < 0) { log_message(LOG_ERROR, "Recorder", "Failed to create %s", path.c_str()); return false; }
+
+        this->chunk_offset_ = 0;
+        if (ftruncate(this->fd_, STD_CHUNK_SIZE) < 0 || (this->chunk_ = static_cast<uint8_t*>(mmap(nullptr, STD_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd_, 0))) == MAP_FAILED) {
+            log_message(LOG_ERROR, "Recorder", "Failed to map %s", path.c_str());
+            ::close(this->fd_); this->fd_ = -1; this->chunk_ = nullptr;
+            return false;
+        }
+
+        RecordFileHeader header{};
+        std::memcpy(header.magic, RECORD_MAGIC, sizeof(header.magic));
+        header.version = RECORD_VERSION;
+        header.record_size = sizeof(Record);
+        header.index_interval = this->index_interval_;
+        header.start_time = get_realtime();
+        std::memcpy(this->chunk_, &header, sizeof(header));
+
+        this->offset_ = sizeof(RecordFileHeader);
+        this->sequence_ = 0;
+        this->written_ = 0;
+        this->flag_stop_ = false;
+        this->flag_open_ = true;
+        this->thread_ = std::thread(&Recorder::start_writer_thread, this);
+        return true;
+    }
+
+    void Recorder::close() {
+        if (!this->thread_.joinable()) { return; }
+        this->flag_open_ = false;
+        this->flag_stop_ = true;
+        this->thread_.join();
+
+        // frames which are left after a write failure are counted as dropped.
+        Record record{};
+        while (this->pop(record)) { this->dropped_.fetch_add(1, std::memory_order_relaxed); }
+
+        if (this->chunk_ != nullptr) { munmap(this->chunk_, STD_CHUNK_SIZE); }
+        this->chunk_ = nullptr;
+
+        // cut the preallocated chunk and store the number of records for the reader.
+        const uint64_t record_count = (this->offset_ - sizeof(RecordFileHeader)) / sizeof(Record);
+        if (ftruncate(this->fd_, static_cast<off_t>(this->offset_)) < 0) { log_message(LOG_ERROR, "Recorder", "Failed to truncate the log"); }
+        if (pwrite(this->fd_, &record_count, sizeof(record_count), offsetof(RecordFileHeader, record_count)) < 0) { log_message(LOG_ERROR, "Recorder", "Failed to write the header"); }
+        ::close(this->fd_);
+        this->fd_ = -1;
+    }
+
+    bool Recorder::is_open() const {
+        return this->flag_open_.load(std::memory_order_relaxed);
+    }
+
+    bool Recorder::record(const CanFrame &frame, const RecordType type) {
+        if (!this->flag_open_.load(std::memory_order_relaxed)) { this->dropped_.fetch_add(1, std::memory_order_relaxed); return false; }
+
+        // bounded multi producer queue, a slot is free when its sequence equals the position.
+        uint64_t position = this->head_.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &this->slots_[position & this->mask_];
+            const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<int64_t>(sequence - position);
+            if (difference == 0) { if (this->head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) { break; } }
+            else if (difference < 0) { this->dropped_.fetch_add(1, std::memory_order_relaxed); return false; }
+            else { position = this->head_.load(std::memory_order_relaxed); }
+        }
+
+        Record &record = slot->record;
+        record.timestamp = frame.timestamp != 0 ? frame.timestamp : get_realtime();
+        record.id = frame.id;
+        record.type = type;
+        record.length = std::min<uint8_t>(frame.length, 8);
+        record.reserved = 0;
+        std::memcpy(record.data, frame.data, sizeof(record.data));
+        record.sequence = 0;
+
+        slot->sequence.store(position + 1, std::memory_order_release);
+        this->recorded_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t Recorder::record(const CanFrame *frames, const size_t count, const RecordType type) {
+        size_t counter = 0;
+        for (size_t i = 0; i < count; i++) { if (this->record(frames[i], type)) { counter++; } }
+        return counter;
+    }
+
+    bool Recorder::pop(Record &record) {
+        Slot &slot = this->slots_[this->tail_ & this->mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != this->tail_ + 1) { return false; }
+
+        record = slot.record;
+        slot.sequence.store(this->tail_ + this->mask_ + 1, std::memory_order_release);
+        this->tail_++;
+        return true;
+    }
+
+    bool Recorder::write_record(const Record &record) {
+        if (this->offset_ == this->chunk_offset_ + STD_CHUNK_SIZE) {
+            munmap(this->chunk_, STD_CHUNK_SIZE);
+            this->chunk_offset_ += STD_CHUNK_SIZE;
+            this->chunk_ = static_cast<uint8_t*>(MAP_FAILED);
+            if (0 <= ftruncate(this->fd_, static_cast<off_t>(this->chunk_offset_ + STD_CHUNK_SIZE))) {
+                this->chunk_ = static_cast<uint8_t*>(mmap(nullptr, STD_CHUNK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd_, static_cast<off_t>(this->chunk_offset_)));
+            }
+            if (this->chunk_ == MAP_FAILED) { this->chunk_ = nullptr; return false; }
+        }
+
+        std::memcpy(this->chunk_ + (this->offset_ - this->chunk_offset_), &record, sizeof(Record));
+        this->offset_ += sizeof(Record);
+        this->written_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Recorder::start_writer_thread() {
+        Record record{};
+        while (true) {
+            if (!this->pop(record)) {
+                if (this->flag_stop_) { break; }
+                std::this_thread::sleep_for(STD_IDLE_TIME); continue;
+            }
+
+            // the index records are placed at fixed positions in front of a frame record.
+            if (((this->offset_ - sizeof(RecordFileHeader)) / sizeof(Record)) % this->index_interval_ == 0) {
+                Record index{};
+                index.timestamp = record.timestamp;
+                index.type = RECORD_INDEX;
+                index.sequence = this->sequence_;
+                if (!this->write_record(index)) { break; }
+            }
+
+            record.sequence = this->sequence_++;
+            if (!this->write_record(record)) { break; }
+        }
+
+        if (this->chunk_ == nullptr) { this->flag_open_ = false; log_message(LOG_ERROR, "Recorder", "Failed to grow the log"); }
+    }
+
+    RecorderStatistics Recorder::get_statistics() const {
+        RecorderStatistics statistics;
+        statistics.recorded = this->recorded_.load(std::memory_order_relaxed);
+        statistics.dropped  = this->dropped_.load(std::memory_order_relaxed);
+        statistics.written  = this->written_.load(std::memory_order_relaxed);
+        return statistics;
+    }
+} // namespace robomaster_can_controller
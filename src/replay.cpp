@@ -0,0 +1,209 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/replay.h"
+#include "robomaster_can_controller/definitions.h"
+#include "robomaster_can_controller/logger.h"
+#include "robomaster_can_controller/recorder.h"
+#include "robomaster_can_controller/utils.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <utility>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Add the time since the given start to the stage latency.
+     */
+    static void add_latency(StageLatency &stage, const std::chrono::steady_clock::time_point start) {
+        const auto latency = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        stage.count++;
+        stage.total += latency;
+        stage.max = std::max(stage.max, latency);
+    }
+
+    /**
+     * @brief Get the value of a hex digit or -1 for any other character.
+     */
+    static int hex_value(const char c) {
+        if ('0' <= c && c <= '9') { return c - '0'; }
+        if ('a' <= c && c <= 'f') { return c - 'a' + 10; }
+        if ('A' <= c && c <= 'F') { return c - 'A' + 10; }
+        return -1;
+    }
+
+    /**
+     * @brief Parse a single line of a candump log.
+     *
+     * @return 1 for a frame, 0 for a skipped line and -1 for a malformed line.
+     */
+    static int parse_candump_line(const std::string &line, CanFrame &frame) {
+        const size_t open = line.find('(');
+        if (open == std::string::npos) { return line.find_first_not_of(" \t\r") == std::string::npos ? 0 : -1; }
+
+        // the fraction of the timestamp has microsecond or nanosecond resolution depending on the candump version.
+        char *end = nullptr;
+        const uint64_t seconds = std::strtoull(line.c_str() + open + 1, &end, 10);
+        if (*end != '.') { return -1; }
+        const char *fraction = end + 1;
+        uint64_t nanoseconds = std::strtoull(fraction, &end, 10);
+        if (*end != ')' || end == fraction || 9 < end - fraction) { return -1; }
+        for (auto digits = end - fraction; digits < 9; digits++) { nanoseconds *= 10; }
+
+        const size_t id_begin = line.find_first_not_of(' ', line.find(' ', static_cast<size_t>(end - line.c_str()) + 2));
+        const size_t separator = line.find('#', id_begin);
+        if (id_begin == std::string::npos || separator == std::string::npos) { return -1; }
+
+        const uint32_t id = std::strtoul(line.c_str() + id_begin, &end, 16);
+        if (end != line.c_str() + separator) { return -1; }
+        if (separator + 1 < line.size() && (line[separator + 1] == '#' || line[separator + 1] == 'R')) { return 0; }
+
+        frame.id = id;
+        frame.length = 0;
+        frame.timestamp = seconds * 1000000000ULL + nanoseconds;
+        for (size_t i = separator + 1; i < line.size() && hex_value(line[i]) != -1; i += 2) {
+            const int high = hex_value(line[i]), low = i + 1 < line.size() ? hex_value(line[i + 1]) : -1;
+            if (low == -1 || frame.length == 8) { return -1; }
+            frame.data[frame.length++] = static_cast<uint8_t>(high << 4 | low);
+        }
+        return 1;
+    }
+
+    bool load_record_log(const std::string &path, std::vector<CanFrame> &frames, const bool include_transmit) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) { log_message(LOG_ERROR, "Replay", "Failed to open %s", path.c_str()); return false; }
+
+        RecordFileHeader header{};
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, RECORD_MAGIC, sizeof(header.magic)) != 0) {
+            log_message(LOG_ERROR, "Replay", "%s is no recorder log", path.c_str()); return false;
+        }
+        if (header.version != RECORD_VERSION || header.record_size != sizeof(Record)) { log_message(LOG_ERROR, "Replay", "Unsupported log version %u", header.version); return false; }
+
+        // a log which was not closed has no record count, the records end at the first unused record.
+        Record record{};
+        for (uint64_t i = 0; (header.record_count == 0 || i < header.record_count) && file.read(reinterpret_cast<char*>(&record), sizeof(record)); i++) {
+            if (record.type == RECORD_NONE) { break; }
+            if (record.type != RECORD_RECEIVE && !(include_transmit && record.type == RECORD_TRANSMIT)) { continue; }
+
+            CanFrame &frame = frames.emplace_back();
+            frame.id = record.id;
+            frame.length = std::min<uint8_t>(record.length, 8);
+            frame.timestamp = record.timestamp;
+            std::memcpy(frame.data, record.data, sizeof(frame.data));
+        }
+        return true;
+    }
+
+    bool load_candump_log(const std::string &path, std::vector<CanFrame> &frames) {
+        std::ifstream file(path);
+        if (!file) { log_message(LOG_ERROR, "Replay", "Failed to open %s", path.c_str()); return false; }
+
+        std::string line;
+        for (size_t number = 1; std::getline(file, line); number++) {
+            CanFrame frame;
+            const int result = parse_candump_line(line, frame);
+            if (result < 0) { log_message(LOG_ERROR, "Replay", "Malformed line %zu in %s", number, path.c_str()); return false; }
+            if (0 < result) { frames.push_back(frame); }
+        }
+        return true;
+    }
+
+    bool load_log(const std::string &path, std::vector<CanFrame> &frames) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) { log_message(LOG_ERROR, "Replay", "Failed to open %s", path.c_str()); return false; }
+
+        char magic[sizeof(RECORD_MAGIC)] = {};
+        file.read(magic, sizeof(magic));
+        if (std::memcmp(magic, RECORD_MAGIC, sizeof(magic)) == 0) { return load_record_log(path, frames); }
+        return load_candump_log(path, frames);
+    }
+
+    size_t to_candump(const CanFrame &frame, const std::string &interface, char *buffer, const size_t size) {
+        // the fraction is written with a leading one, so to_chars keeps its leading zeros and the one is overwritten.
+        std::array<char, 48> time{};
+        char *end = std::to_chars(time.data() + 1, time.data() + 21, frame.timestamp / 1000000000ULL).ptr;
+        end = std::to_chars(end, end + 7, frame.timestamp % 1000000000ULL / 1000 + 1000000).ptr;
+        time[0] = '(';
+        *(end - 7) = '.';
+        *end++ = ')';
+        *end++ = ' ';
+
+        const size_t digits = frame.id <= 0x7ff ? 3 : 8;
+        const size_t length = std::min<uint8_t>(frame.length, 8);
+        const auto time_size = static_cast<size_t>(end - time.data());
+        const size_t line_size = time_size + interface.size() + 1 + digits + 1 + length * 2;
+        if (size < line_size) { return 0; }
+
+        std::memcpy(buffer, time.data(), time_size); buffer += time_size;
+        std::memcpy(buffer, interface.data(), interface.size()); buffer += interface.size();
+        *buffer++ = ' ';
+        uint_to_hex(frame.id, buffer, digits); buffer += digits;
+        *buffer++ = '#';
+        hex_encode(frame.data, length, buffer, length * 2);
+        return line_size;
+    }
+
+    Replay::Replay() {
+        // the states are counted in the callback of the RoboMaster, so a message which triggers it belongs to the decoding stage.
+        this->robomaster_.set_callback([this](const DataRoboMasterState &data) {
+            this->statistics_.states++;
+            if (this->callback_data_robomaster_state_) { this->callback_data_robomaster_state_(data); }
+        });
+    }
+
+    void Replay::set_callback(std::function<void(const DataRoboMasterState&)> func) {
+        this->callback_data_robomaster_state_ = std::move(func);
+    }
+
+    void Replay::bind_callback(const uint32_t device_id, const uint16_t type, std::vector<uint8_t> prefix, std::function<void(const Message&)> func) {
+        this->robomaster_.set_callback(device_id, type, std::move(prefix), std::move(func));
+    }
+
+    ReplayStatistics Replay::run(const std::vector<CanFrame> &frames, const ReplayMode mode) {
+        this->statistics_ = ReplayStatistics();
+        this->reassembler_.reset();
+        this->reassembler_.reset_statistics();
+        this->robomaster_.clock_sync_.reset();
+
+        std::vector<Message> messages;
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t first_timestamp = frames.empty() ? 0 : frames.front().timestamp;
+
+        for (const CanFrame &frame : frames) {
+            if (mode == REPLAY_REALTIME && first_timestamp <= frame.timestamp) {
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(frame.timestamp - first_timestamp));
+            }
+
+            const auto reassembly_start = std::chrono::steady_clock::now();
+            this->reassembler_.push_frame(frame.id, frame.data, frame.length, messages, frame.timestamp);
+            add_latency(this->statistics_.reassembly, reassembly_start);
+            this->statistics_.frames++;
+
+            for (const Message &msg : messages) {
+                const uint64_t states = this->statistics_.states;
+                const auto process_start = std::chrono::steady_clock::now();
+                this->robomaster_.handler_.process_message(msg);
+                add_latency(states == this->statistics_.states ? this->statistics_.dispatch : this->statistics_.decode, process_start);
+            }
+            this->statistics_.messages += messages.size();
+            messages.clear();
+        }
+
+        this->statistics_.duration = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        if (this->statistics_.duration != 0) { this->statistics_.messages_per_second = static_cast<double>(this->statistics_.messages) * 1e9 / static_cast<double>(this->statistics_.duration); }
+        return this->statistics_;
+    }
+
+    StreamStatistics Replay::get_stream_statistics(const uint32_t device_id) const {
+        return this->reassembler_.get_statistics(device_id);
+    }
+} // namespace robomaster_can_controller
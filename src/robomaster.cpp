@@ -9,9 +9,11 @@
 #include "robomaster_can_controller/robomaster.h"
 #include "robomaster_can_controller/definitions.h"
 #include "robomaster_can_controller/utils.h"
+#include "robomaster_can_controller/trace.h"
+#include "robomaster_can_controller/logger.h"
 
 namespace robomaster_can_controller {
-    RoboMaster::RoboMaster():counter_drive_(0), counter_led_(0), counter_gimbal_(0), counter_blaster_(0) {
+    RoboMaster::RoboMaster():telemetry_publisher_(nullptr), history_(nullptr), state_log_(nullptr) {
         this->handler_.bind_callback([this]<typename T0>(T0 && PH1) { decode_state(std::forward<T0>(PH1)); });
     }
 
@@ -21,66 +23,43 @@ namespace robomaster_can_controller {
         this->callback_data_robomaster_state_ = std::move(func);
     }
 
+    void RoboMaster::set_callback(const uint32_t device_id, const uint16_t type, std::vector<uint8_t> prefix, std::function<void(const Message&)> func) {
+        this->handler_.bind_callback(device_id, type, std::move(prefix), std::move(func));
+    }
+
     void RoboMaster::boot_sequence() {
         this->handler_.push_message(Message(DEVICE_ID_INTELLI_CONTROLLER, 0x0309, 0, { 0x40, 0x48, 0x04, 0x00, 0x09, 0x00 }));
         this->handler_.push_message(Message(DEVICE_ID_INTELLI_CONTROLLER, 0x0309, 1, { 0x40, 0x48, 0x01, 0x09, 0x00, 0x00, 0x00, 0x03 }));
         this->handler_.push_message(Message(DEVICE_ID_INTELLI_CONTROLLER, 0x0309, 2, { 0x40, 0x48, 0x03, 0x09, 0x01, 0x03, 0x00, 0x07, 0xa7, 0x02, 0x29, 0x88, 0x03, 0x00, 0x02, 0x00, 0x66, 0x3e, 0x3e, 0x4c, 0x03, 0x00, 0x02, 0x00, 0xfb, 0xdc, 0xf5, 0xd7, 0x03, 0x00, 0x02, 0x00, 0x09, 0xa3, 0x26, 0xe2, 0x03, 0x00, 0x02, 0x00, 0xf4, 0x1d, 0x1c, 0xdc, 0x03, 0x00, 0x02, 0x00, 0x42, 0xee, 0x13, 0x1d, 0x03, 0x00, 0x02, 0x00, 0xb3, 0xf7, 0xe6, 0x47, 0x03, 0x00, 0x02, 0x00, 0x32, 0x00 }));
     }
 
+    void RoboMaster::push_command(Message msg) {
+        msg.set_sequence(this->handler_.next_sequence(msg.get_type()));
+        this->handler_.push_message(msg);
+    }
+
     void RoboMaster::set_work_mode(const bool mode) {
-        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0xc309, 0, { 0x40, 0x3f, 0x19, 0x00 });
-        msg.set_value_uint8(3, mode);
-        this->handler_.push_message(std::move(msg));
+        this->handler_.push_message(make_work_mode_command(mode));
     }
 
     void RoboMaster::set_brake() {
-        const Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, this->counter_drive_++, { 0x40, 0x3F, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
-        this->handler_.push_message(std::move(msg));
+        this->push_command(make_brake_command());
     }
 
     void RoboMaster::set_wheel_rpm(const int16_t fr, const int16_t fl, const int16_t rl, const int16_t rr) {
-        const auto w1 = clip<int16_t>(fr, -1000, 1000);
-        const auto w2 = clip<int16_t>(fl, -1000, 1000);
-        const auto w3 = clip<int16_t>(rl, -1000, 1000);
-        const auto w4 = clip<int16_t>(rr, -1000, 1000);
-
-        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, this->counter_drive_++, { 0x40, 0x3F, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
-        msg.set_value_int16(3, w1);
-        msg.set_value_int16(5, w2);
-        msg.set_value_int16(7, w3);
-        msg.set_value_int16(9, w4);
-        this->handler_.push_message(std::move(msg));
+        this->push_command(make_wheel_rpm_command(fr, fl, rl, rr));
     }
 
     void RoboMaster::set_velocity(const float x, const float y, const float z) {
-        const auto cx = clip<float>(x,   -3.5f,   3.5f);
-        const auto cy = clip<float>(y,   -3.5f,   3.5f);
-        const auto cz = clip<float>(z, -600.0f, 600.0f);
-
-        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, this->counter_drive_++, { 0x00, 0x3f, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
-        msg.set_value_float(3, cx);
-        msg.set_value_float(7, cy);
-        msg.set_value_float(11, cz);
-        this->handler_.push_message(std::move(msg));
+        this->push_command(make_velocity_command(x, y, z));
     }
 
     void RoboMaster::set_gimbal(const int16_t y, const int16_t z) {
-        const auto cy = clip<int16_t>(y, -1024, 1024);
-        const auto cz = clip<int16_t>(z, -1024, 1024);
-
-        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0x0409, this->counter_gimbal_++, { 0x00, 0x04, 0x69, 0x08, 0x05, 0x00, 0x00, 0x00, 0x00 });
-        msg.set_value_int16(5, cy);
-        msg.set_value_int16(7, cz);
-        this->handler_.push_message(std::move(msg));
+        this->push_command(make_gimbal_command(y, z));
     }
 
     void RoboMaster::set_blaster(const BlasterType blaster) {
-        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0x1709, this->counter_blaster_++);
-        switch (blaster) {
-            case INFRARED: msg.set_payload({ 0x00, 0x3f, 0x55, 0x73, 0x00, 0xff, 0x00, 0x01, 0x28, 0x00, 0x00 }); break;
-            case GELBEADS: msg.set_payload({ 0x00, 0x3f, 0x51, 0x01 }); break;
-        }
-        this->handler_.push_message(std::move(msg));
+        this->push_command(make_blaster_command(blaster));
     }
 
     bool RoboMaster::init(const std::string &can_interface) {
@@ -89,33 +68,22 @@ namespace robomaster_can_controller {
         } return false;
     }
 
+    bool RoboMaster::init(Fleet &fleet, const std::string &can_interface) {
+        if (this->handler_.init(fleet, can_interface)) {
+            this->boot_sequence(); return true;
+        } return false;
+    }
+
     void RoboMaster::set_led_off(const uint16_t mask) {
-        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, this->counter_led_++, { 0x00, 0x3f, 0x32, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
-        msg.set_value_uint16(3, 0x70);
-        msg.set_value_uint16(14, mask);
-        this->handler_.push_message(std::move(msg));
+        this->push_command(make_led_off_command(mask));
     }
 
     void RoboMaster::set_led_on(const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b) {
-        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, this->counter_led_++, { 0x00, 0x3f, 0x32, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
-        msg.set_value_uint16(3, 0x71); // effect mode on
-        msg.set_value_uint8(6, r);
-        msg.set_value_uint8(7, g);
-        msg.set_value_uint8(8, b);
-        msg.set_value_uint16(14, mask);
-        this->handler_.push_message(std::move(msg));
+        this->push_command(make_led_on_command(mask, r, g, b));
     }
 
     void RoboMaster::set_led_breath(const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b, const uint16_t t_rise, const uint16_t t_down) {
-        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, this->counter_led_++, { 0x00, 0x3f, 0x32, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
-        msg.set_value_uint16(3, 0x72); // effect mode breath
-        msg.set_value_uint8(6, r);
-        msg.set_value_uint8(7, g);
-        msg.set_value_uint8(8, b);
-        msg.set_value_uint16(10, t_rise);
-        msg.set_value_uint16(12, t_down);
-        msg.set_value_uint16(14, mask);
-        this->handler_.push_message(std::move(msg));
+        this->push_command(make_led_breath_command(mask, r, g, b, t_rise, t_down));
     }
 
     void RoboMaster::set_led_breath(const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b, const float t_rise, const float t_down) {
@@ -130,15 +98,7 @@ namespace robomaster_can_controller {
     }
 
     void RoboMaster::set_led_flash(const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b, const uint16_t t_on, const uint16_t t_off) {
-        Message msg(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, this->counter_led_++, { 0x00, 0x3f, 0x32, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
-        msg.set_value_uint16(3, 0x73);
-        msg.set_value_uint8(6, r);
-        msg.set_value_uint8(7, g);
-        msg.set_value_uint8(8, b);
-        msg.set_value_uint16(10, t_on);
-        msg.set_value_uint16(12, t_off);
-        msg.set_value_uint16(14, mask);
-        this->handler_.push_message(std::move(msg));
+        this->push_command(make_led_flash_command(mask, r, g, b, t_on, t_off));
     }
 
     void RoboMaster::set_led_flash(const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b, const float t_on, const float t_off) {
@@ -153,19 +113,146 @@ namespace robomaster_can_controller {
     }
 
     void RoboMaster::decode_state(const Message &msg) {
-        if (this->callback_data_robomaster_state_) {
+        // the setters wait for the lock, so the publisher, history and log are not used after they were replaced.
+        std::unique_lock lock(this->attach_mutex_);
+        TelemetryPublisher *publisher = this->telemetry_publisher_;
+        StateHistory *history = this->history_;
+        StateLog *state_log = this->state_log_;
+        if (this->callback_data_robomaster_state_ || publisher != nullptr || history != nullptr || state_log != nullptr) {
             DataRoboMasterState data;
-            data.velocity   = decode_data_velocity(27, msg);
-            data.battery    = decode_data_battery(51, msg);
-            data.esc        = decode_data_esc(61, msg);
-            data.imu        = decode_data_imu(97, msg);
-            data.attitude   = decode_data_attitude(121, msg);
-            data.position   = decode_data_position(133, msg);
+            {
+                ROBOMASTER_TRACE_SCOPE("decode_state");
+                data = decode_robomaster_state(msg);
+
+                if (data.esc.has_data && data.timestamp.has_data) {
+                    this->clock_sync_.add_sample(data.esc.time_stamp[0], data.timestamp.first_frame);
+                    data.timestamp.acquisition = this->clock_sync_.to_host_time(data.esc.time_stamp[0]);
+                    data.timestamp.uncertainty = this->clock_sync_.get_uncertainty();
+                }
+            }
+            if (publisher != nullptr) { ROBOMASTER_TRACE_SCOPE("publish_telemetry"); publisher->publish(data); }
+            if (history != nullptr) { ROBOMASTER_TRACE_SCOPE("push_history"); history->push(data); }
+            if (state_log != nullptr) { ROBOMASTER_TRACE_SCOPE("push_state_log"); state_log->push(data); }
+            lock.unlock();
+            if (!this->callback_data_robomaster_state_) { return; }
+
+            ROBOMASTER_TRACE_SCOPE("user_callback");
             this->callback_data_robomaster_state_(data);
         }
     }
 
+    CommandBatch RoboMaster::batch() {
+        return CommandBatch(*this);
+    }
+
+    CommandBatch::CommandBatch(RoboMaster &robomaster) : robomaster_(robomaster) {
+        this->messages_.reserve(COMMAND_BATCH_MAX_SIZE);
+        this->sequenced_.reserve(COMMAND_BATCH_MAX_SIZE);
+    }
+
+    CommandBatch &CommandBatch::add(Message msg, const bool sequenced) {
+        this->messages_.push_back(std::move(msg));
+        this->sequenced_.push_back(sequenced); return *this;
+    }
+
+    CommandBatch &CommandBatch::set_work_mode(const bool mode) {
+        return this->add(make_work_mode_command(mode), false);
+    }
+
+    CommandBatch &CommandBatch::set_velocity(const float x, const float y, const float z) {
+        return this->add(make_velocity_command(x, y, z));
+    }
+
+    CommandBatch &CommandBatch::set_wheel_rpm(const int16_t fr, const int16_t fl, const int16_t rl, const int16_t rr) {
+        return this->add(make_wheel_rpm_command(fr, fl, rl, rr));
+    }
+
+    CommandBatch &CommandBatch::set_brake() {
+        return this->add(make_brake_command());
+    }
+
+    CommandBatch &CommandBatch::set_gimbal(const int16_t y, const int16_t z) {
+        return this->add(make_gimbal_command(y, z));
+    }
+
+    CommandBatch &CommandBatch::set_blaster(const BlasterType blaster) {
+        return this->add(make_blaster_command(blaster));
+    }
+
+    CommandBatch &CommandBatch::set_led_off(const uint16_t mask) {
+        return this->add(make_led_off_command(mask));
+    }
+
+    CommandBatch &CommandBatch::set_led_on(const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b) {
+        return this->add(make_led_on_command(mask, r, g, b));
+    }
+
+    CommandBatch &CommandBatch::set_led_breath(const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b, const uint16_t t_rise, const uint16_t t_down) {
+        return this->add(make_led_breath_command(mask, r, g, b, t_rise, t_down));
+    }
+
+    CommandBatch &CommandBatch::set_led_flash(const uint16_t mask, const uint8_t r, const uint8_t g, const uint8_t b, const uint16_t t_on, const uint16_t t_off) {
+        return this->add(make_led_flash_command(mask, r, g, b, t_on, t_off));
+    }
+
+    size_t CommandBatch::size() const {
+        return this->messages_.size();
+    }
+
+    bool CommandBatch::commit() {
+        if (COMMAND_BATCH_MAX_SIZE < this->messages_.size()) { log_message(LOG_ERROR, "RoboMaster", "Batch of %zu commands too large", this->messages_.size()); this->clear(); return false; }
+
+        // the sequences follow the commands which were pushed while the batch was collected.
+        for (size_t i = 0; i < this->messages_.size(); i++) {
+            if (this->sequenced_[i]) { this->messages_[i].set_sequence(this->robomaster_.handler_.next_sequence(this->messages_[i].get_type())); }
+        }
+        const bool success = this->messages_.empty() || this->robomaster_.handler_.push_messages(this->messages_);
+        if (!success) { log_message(LOG_WARNING, "RoboMaster", "Sender queue full, batch of %zu commands discarded", this->messages_.size()); }
+        this->clear();
+        return success;
+    }
+
+    void CommandBatch::clear() {
+        this->messages_.clear();
+        this->sequenced_.clear();
+    }
+
     bool RoboMaster::is_running() const {
         return this->handler_.is_running();
     }
+
+    StreamStatistics RoboMaster::get_stream_statistics(const uint32_t device_id) const {
+        return this->handler_.get_stream_statistics(device_id);
+    }
+
+    void RoboMaster::set_recorder(Recorder *recorder) {
+        this->handler_.set_recorder(recorder);
+    }
+
+    void RoboMaster::set_telemetry_publisher(TelemetryPublisher *publisher) {
+        std::lock_guard lock(this->attach_mutex_);
+        this->telemetry_publisher_ = publisher;
+    }
+
+    void RoboMaster::set_history(StateHistory *history) {
+        std::lock_guard lock(this->attach_mutex_);
+        this->history_ = history;
+    }
+
+    void RoboMaster::set_state_log(StateLog *log) {
+        std::lock_guard lock(this->attach_mutex_);
+        this->state_log_ = log;
+    }
+
+    void RoboMaster::set_command_ingress(CommandIngress *ingress) {
+        this->handler_.set_command_ingress(ingress);
+    }
+
+    std::vector<ChannelLatency> RoboMaster::get_latency_statistics() const {
+        return this->handler_.get_latency_statistics();
+    }
+
+    MetricsSnapshot RoboMaster::get_metrics() const {
+        return this->handler_.get_metrics();
+    }
 } // namespace robomaster_can_controller
\ No newline at end of file
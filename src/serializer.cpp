@@ -0,0 +1,227 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/serializer.h"
+
+#include <charconv>
+#include <cstring>
+#include <string_view>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The precision of the floats, the default precision of the streams.
+     */
+    static constexpr int STD_FLOAT_PRECISION = 6;
+
+    /**
+     * @brief Writes into the buffer until it is full, the following writes are ignored.
+     */
+    class Writer {
+        char *position_;
+        char *end_;
+        char *begin_;
+        size_t fields_;
+        bool overflow_;
+
+    public:
+        Writer(char *buffer, const size_t size) : position_(buffer), end_(buffer + size), begin_(buffer), fields_(0), overflow_(false) { }
+
+        void text(const std::string_view text) {
+            if (static_cast<size_t>(this->end_ - this->position_) < text.size()) { this->overflow_ = true; return; }
+            std::memcpy(this->position_, text.data(), text.size());
+            this->position_ += text.size();
+        }
+
+        void number(const float value) {
+            this->put(std::to_chars(this->position_, this->end_, value, std::chars_format::general, STD_FLOAT_PRECISION));
+        }
+
+        void number(const uint8_t value) {
+            this->put(std::to_chars(this->position_, this->end_, static_cast<uint16_t>(value)));
+        }
+
+        template<typename T>
+        void number(const T value) {
+            this->put(std::to_chars(this->position_, this->end_, value));
+        }
+
+        /**
+         * @brief Write the values of an array separated by comma and space.
+         */
+        template<typename T, size_t N>
+        void array(const std::array<T, N> &values) {
+            this->text("[");
+            for (size_t i = 0; i < N; i++) { if (i != 0) { this->text(", "); } this->number(values[i]); }
+            this->text("]");
+        }
+
+        /**
+         * @brief Write a CSV field, every field but the first is preceded by a comma.
+         */
+        template<typename T>
+        void field(const T value) {
+            if (this->fields_++ != 0) { this->text(","); }
+            this->number(value);
+        }
+
+        /**
+         * @brief Write empty CSV fields.
+         */
+        void empty(const size_t count) {
+            for (size_t i = 0; i < count; i++) { if (this->fields_++ != 0) { this->text(","); } }
+        }
+
+        size_t finish() const {
+            return this->overflow_ ? 0 : static_cast<size_t>(this->position_ - this->begin_);
+        }
+
+    private:
+        void put(const std::to_chars_result result) {
+            if (result.ec != std::errc()) { this->overflow_ = true; this->position_ = this->end_; return; }
+            this->position_ = result.ptr;
+        }
+    };
+
+    static void write_json(Writer &writer, const DataBattery &data) {
+        writer.text("{");
+        if (data.has_data) {
+            writer.text("\"adc\": "); writer.number(data.adc_value);
+            writer.text(", \"temp\": "); writer.number(data.temperature);
+            writer.text(", \"current\": "); writer.number(data.current);
+            writer.text(", \"percent\": "); writer.number(data.percent);
+        }
+        writer.text("}");
+    }
+
+    static void write_json(Writer &writer, const DataEsc &data) {
+        writer.text("{");
+        if (data.has_data) {
+            writer.text("\"speed\": "); writer.array(data.speed);
+            writer.text(", \"angle\": "); writer.array(data.angle);
+            writer.text(", \"time_stamp\": "); writer.array(data.time_stamp);
+            writer.text(", \"state\": "); writer.array(data.state);
+        }
+        writer.text("}");
+    }
+
+    static void write_json(Writer &writer, const DataImu &data) {
+        writer.text("{");
+        if (data.has_data) {
+            writer.text("\"accel\": "); writer.array(std::array<float, 3>{ data.acc_x, data.acc_y, data.acc_z });
+            writer.text(", \"gyro\": "); writer.array(std::array<float, 3>{ data.gyro_x, data.gyro_y, data.gyro_z });
+        }
+        writer.text("}");
+    }
+
+    static void write_json(Writer &writer, const DataVelocity &data) {
+        writer.text("{");
+        if (data.has_data) {
+            writer.text("\"global\": "); writer.array(std::array<float, 3>{ data.vgx, data.vgy, data.vgz });
+            writer.text(", \"body\": "); writer.array(std::array<float, 3>{ data.vbx, data.vby, data.vbz });
+        }
+        writer.text("}");
+    }
+
+    static void write_json(Writer &writer, const DataPosition &data) {
+        writer.text("{");
+        if (data.has_data) {
+            writer.text("\"x\": "); writer.number(data.x);
+            writer.text(", \"y\": "); writer.number(data.y);
+            writer.text(", \"z\": "); writer.number(data.z);
+        }
+        writer.text("}");
+    }
+
+    static void write_json(Writer &writer, const DataAttitude &data) {
+        writer.text("{");
+        if (data.has_data) {
+            writer.text("\"roll\": "); writer.number(data.roll);
+            writer.text(", \"pitch\": "); writer.number(data.pitch);
+            writer.text(", \"yaw\": "); writer.number(data.yaw);
+        }
+        writer.text("}");
+    }
+
+    static void write_json(Writer &writer, const DataTimestamp &data) {
+        writer.text("{");
+        if (data.has_data) {
+            writer.text("\"first_frame\": "); writer.number(data.first_frame);
+            writer.text(", \"last_frame\": "); writer.number(data.last_frame);
+            writer.text(", \"acquisition\": "); writer.number(data.acquisition);
+            writer.text(", \"uncertainty\": "); writer.number(data.uncertainty);
+        }
+        writer.text("}");
+    }
+
+    size_t to_json(const DataRoboMasterState &data, char *buffer, const size_t size, const bool timestamp) {
+        Writer writer(buffer, size);
+        writer.text("{\"robomaster\":{\"battery\":"); write_json(writer, data.battery);
+        writer.text(",\"esc\":"); write_json(writer, data.esc);
+        writer.text(",\"imu\":"); write_json(writer, data.imu);
+        writer.text(",\"velocity\":"); write_json(writer, data.velocity);
+        writer.text(",\"position\":"); write_json(writer, data.position);
+        writer.text(",\"attitude\":"); write_json(writer, data.attitude);
+        if (timestamp) { writer.text(",\"timestamp\":"); write_json(writer, data.timestamp); }
+        writer.text("}}");
+        return writer.finish();
+    }
+
+    size_t to_csv(const DataRoboMasterState &data, char *buffer, const size_t size) {
+        Writer writer(buffer, size);
+        if (data.battery.has_data) {
+            writer.field(data.battery.adc_value); writer.field(data.battery.temperature);
+            writer.field(data.battery.current); writer.field(data.battery.percent);
+        } else { writer.empty(4); }
+
+        if (data.esc.has_data) {
+            for (const int16_t value : data.esc.speed) { writer.field(value); }
+            for (const int16_t value : data.esc.angle) { writer.field(value); }
+            for (const uint32_t value : data.esc.time_stamp) { writer.field(value); }
+            for (const uint8_t value : data.esc.state) { writer.field(value); }
+        } else { writer.empty(16); }
+
+        if (data.imu.has_data) {
+            writer.field(data.imu.acc_x); writer.field(data.imu.acc_y); writer.field(data.imu.acc_z);
+            writer.field(data.imu.gyro_x); writer.field(data.imu.gyro_y); writer.field(data.imu.gyro_z);
+        } else { writer.empty(6); }
+
+        if (data.velocity.has_data) {
+            writer.field(data.velocity.vgx); writer.field(data.velocity.vgy); writer.field(data.velocity.vgz);
+            writer.field(data.velocity.vbx); writer.field(data.velocity.vby); writer.field(data.velocity.vbz);
+        } else { writer.empty(6); }
+
+        if (data.position.has_data) {
+            writer.field(data.position.x); writer.field(data.position.y); writer.field(data.position.z);
+        } else { writer.empty(3); }
+
+        if (data.attitude.has_data) {
+            writer.field(data.attitude.roll); writer.field(data.attitude.pitch); writer.field(data.attitude.yaw);
+        } else { writer.empty(3); }
+
+        if (data.timestamp.has_data) {
+            writer.field(data.timestamp.first_frame); writer.field(data.timestamp.last_frame);
+            writer.field(data.timestamp.acquisition); writer.field(data.timestamp.uncertainty);
+        } else { writer.empty(4); }
+        return writer.finish();
+    }
+
+    size_t to_csv_header(char *buffer, const size_t size) {
+        Writer writer(buffer, size);
+        writer.text("battery.adc,battery.temp,battery.current,battery.percent,"
+                    "esc.speed.0,esc.speed.1,esc.speed.2,esc.speed.3,esc.angle.0,esc.angle.1,esc.angle.2,esc.angle.3,"
+                    "esc.time_stamp.0,esc.time_stamp.1,esc.time_stamp.2,esc.time_stamp.3,esc.state.0,esc.state.1,esc.state.2,esc.state.3,"
+                    "imu.accel.0,imu.accel.1,imu.accel.2,imu.gyro.0,imu.gyro.1,imu.gyro.2,"
+                    "velocity.global.0,velocity.global.1,velocity.global.2,velocity.body.0,velocity.body.1,velocity.body.2,"
+                    "position.x,position.y,position.z,attitude.roll,attitude.pitch,attitude.yaw,"
+                    "timestamp.first_frame,timestamp.last_frame,timestamp.acquisition,timestamp.uncertainty");
+        return writer.finish();
+    }
+
+    bool write_line(std::FILE *file, const char *buffer, const size_t size) {
+        if (size == 0) { return false; }
+        return std::fwrite(buffer, 1, size, file) == size && std::fputc('\n', file) != EOF;
+    }
+} // namespace robomaster_can_controller
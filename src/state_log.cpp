@@ -0,0 +1,498 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/state_log.h"
+#include "robomaster_can_controller/logger.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <type_traits>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief The upper bound of the encoded size of a state, used to reject corrupt blocks before they are allocated.
+     */
+    static constexpr size_t STD_MAX_STATE_SIZE = 512;
+
+    /**
+     * @brief The number of integer and float columns, the integer columns start with the sections of the state.
+     */
+    static constexpr size_t STD_INTEGER_COLUMNS = 1 + 4 + 16 + 4;
+    static constexpr size_t STD_FLOAT_COLUMNS = 18;
+
+    static uint64_t get_realtime() {
+        timespec time{};
+        clock_gettime(CLOCK_REALTIME, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+    /**
+     * @brief Visit the integer fields of a state in column order after the sections, with the order of the delta encoding.
+     * The receive times and the time stamps of the motors grow steadily, so the delta of their deltas is stored.
+     */
+    template<typename State, typename Function>
+    static void visit_integers(State &state, Function &&function) {
+        function(state.battery.adc_value, 1); function(state.battery.temperature, 1);
+        function(state.battery.current, 1); function(state.battery.percent, 1);
+        for (auto &value : state.esc.speed) { function(value, 1); }
+        for (auto &value : state.esc.angle) { function(value, 1); }
+        for (auto &value : state.esc.time_stamp) { function(value, 2); }
+        for (auto &value : state.esc.state) { function(value, 1); }
+        function(state.timestamp.first_frame, 2); function(state.timestamp.last_frame, 2);
+        function(state.timestamp.acquisition, 2); function(state.timestamp.uncertainty, 1);
+    }
+
+    /**
+     * @brief Visit the float fields of a state in column order.
+     */
+    template<typename State, typename Function>
+    static void visit_floats(State &state, Function &&function) {
+        function(state.imu.acc_x); function(state.imu.acc_y); function(state.imu.acc_z);
+        function(state.imu.gyro_x); function(state.imu.gyro_y); function(state.imu.gyro_z);
+        function(state.velocity.vgx); function(state.velocity.vgy); function(state.velocity.vgz);
+        function(state.velocity.vbx); function(state.velocity.vby); function(state.velocity.vbz);
+        function(state.position.x); function(state.position.y); function(state.position.z);
+        function(state.attitude.roll); function(state.attitude.pitch); function(state.attitude.yaw);
+    }
+
+    static uint64_t zigzag_encode(const uint64_t value) {
+        return (value << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(value) >> 63);
+    }
+
+    static uint64_t zigzag_decode(const uint64_t value) {
+        return (value >> 1) ^ (0 - (value & 1));
+    }
+
+    /**
+     * @brief Appends bits to the payload, the most significant bit first.
+     */
+    class BitWriter {
+        std::vector<uint8_t> &payload_;
+        uint64_t bits_;
+        uint32_t count_;
+
+    public:
+        explicit BitWriter(std::vector<uint8_t> &payload) : payload_(payload), bits_(0), count_(0) { }
+
+        /**
+         * @brief Write the lower width bits of the value, at most 32 bits.
+         */
+        void write(const uint64_t value, const uint32_t width) {
+            this->bits_ = (this->bits_ << width) | (value & ((1ULL << width) - 1));
+            this->count_ += width;
+            while (8 <= this->count_) { this->count_ -= 8; this->payload_.push_back(static_cast<uint8_t>(this->bits_ >> this->count_)); }
+        }
+
+        /**
+         * @brief Pad the last byte with zeros, so the next column starts at a byte.
+         */
+        void flush() {
+            if (this->count_ != 0) { this->write(0, 8 - this->count_); }
+        }
+    };
+
+    /**
+     * @brief Reads bits of the payload, reading behind the end sets the overflow flag.
+     */
+    class BitReader {
+        const uint8_t *payload_;
+        size_t size_;
+        size_t &position_;
+        uint32_t bit_;
+        bool overflow_;
+
+    public:
+        BitReader(const uint8_t *payload, const size_t size, size_t &position) : payload_(payload), size_(size), position_(position), bit_(0), overflow_(false) { }
+
+        uint64_t read(const uint32_t width) {
+            uint64_t value = 0;
+            for (uint32_t i = 0; i < width; i++) {
+                if (this->size_ <= this->position_) { this->overflow_ = true; return 0; }
+                value = (value << 1) | ((this->payload_[this->position_] >> (7 - this->bit_)) & 1);
+                if (++this->bit_ == 8) { this->bit_ = 0; this->position_++; }
+            }
+            return value;
+        }
+
+        /**
+         * @brief Skip the padding of the last byte.
+         *
+         * @return true, when no read was behind the end.
+         */
+        bool finish() {
+            if (this->bit_ != 0) { this->bit_ = 0; this->position_++; }
+            return !this->overflow_;
+        }
+    };
+
+    static void encode_integers(const uint64_t *values, const size_t count, const int order, std::vector<uint8_t> &payload) {
+        uint64_t previous = 0;
+        uint64_t previous_delta = 0;
+        for (size_t i = 0; i < count; i++) {
+            const uint64_t delta = values[i] - previous;
+            uint64_t value = zigzag_encode(order == 2 ? delta - previous_delta : delta);
+            while (0x80 <= value) { payload.push_back(static_cast<uint8_t>(value | 0x80)); value >>= 7; }
+            payload.push_back(static_cast<uint8_t>(value));
+            previous = values[i];
+            previous_delta = i == 0 ? 0 : delta;
+        }
+    }
+
+    static bool decode_integers(const uint8_t *payload, const size_t size, size_t &position, const size_t count, const int order, uint64_t *values) {
+        uint64_t previous = 0;
+        uint64_t previous_delta = 0;
+        for (size_t i = 0; i < count; i++) {
+            uint64_t value = 0;
+            for (uint32_t shift = 0;; shift += 7) {
+                if (size <= position || 63 < shift) { return false; }
+                const uint8_t byte = payload[position++];
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) { break; }
+            }
+
+            const uint64_t delta = zigzag_decode(value) + (order == 2 ? previous_delta : 0);
+            values[i] = previous + delta;
+            previous = values[i];
+            previous_delta = i == 0 ? 0 : delta;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Encode floats by the XOR with the previous value. An equal value takes a single bit, a value whose meaningful bits
+     * fit into the window of the previous value takes two bits and the meaningful bits, otherwise the window is stored as well.
+     */
+    static void encode_floats(const float *values, const size_t count, std::vector<uint8_t> &payload) {
+        BitWriter writer(payload);
+        uint32_t previous = 0;
+        uint32_t leading = UINT32_MAX;
+        uint32_t trailing = 0;
+        for (size_t i = 0; i < count; i++) {
+            const auto bits = std::bit_cast<uint32_t>(values[i]);
+            const uint32_t value = bits ^ previous;
+            previous = bits;
+            if (value == 0) { writer.write(0, 1); continue; }
+
+            const auto value_leading = static_cast<uint32_t>(std::countl_zero(value));
+            const auto value_trailing = static_cast<uint32_t>(std::countr_zero(value));
+            if (leading != UINT32_MAX && leading <= value_leading && trailing <= value_trailing) {
+                writer.write(0b10, 2);
+                writer.write(value >> trailing, 32 - leading - trailing);
+                continue;
+            }
+
+            leading = value_leading;
+            trailing = value_trailing;
+            const uint32_t length = 32 - leading - trailing;
+            writer.write(0b11, 2);
+            writer.write(leading, 5);
+            writer.write(length - 1, 5);
+            writer.write(value >> trailing, length);
+        }
+        writer.flush();
+    }
+
+    static bool decode_floats(const uint8_t *payload, const size_t size, size_t &position, const size_t count, float *values) {
+        BitReader reader(payload, size, position);
+        uint32_t previous = 0;
+        uint32_t leading = UINT32_MAX;
+        uint32_t trailing = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (reader.read(1) != 0) {
+                if (reader.read(1) != 0) {
+                    leading = static_cast<uint32_t>(reader.read(5));
+                    const auto length = static_cast<uint32_t>(reader.read(5)) + 1;
+                    if (32 < leading + length) { return false; }
+                    trailing = 32 - leading - length;
+                } else if (leading == UINT32_MAX) { return false; }
+                previous ^= static_cast<uint32_t>(reader.read(32 - leading - trailing)) << trailing;
+            }
+            values[i] = std::bit_cast<float>(previous);
+        }
+        return reader.finish();
+    }
+
+    void encode_state_block(const DataRoboMasterState *states, const size_t count, std::vector<uint8_t> &payload) {
+        // the states are transposed into columns first, the sections are the first integer column.
+        std::vector<uint64_t> integers(STD_INTEGER_COLUMNS * count);
+        std::vector<float> floats(STD_FLOAT_COLUMNS * count);
+        std::array<int, STD_INTEGER_COLUMNS> orders{};
+        orders[0] = 1;
+        for (size_t i = 0; i < count; i++) {
+            integers[i] = get_sections(states[i]);
+            size_t column = 1;
+            visit_integers(states[i], [&](const auto &value, const int order) { orders[column] = order; integers[column++ * count + i] = static_cast<uint64_t>(value); });
+            column = 0;
+            visit_floats(states[i], [&](const float value) { floats[column++ * count + i] = value; });
+        }
+
+        for (size_t column = 0; column < STD_INTEGER_COLUMNS; column++) { encode_integers(&integers[column * count], count, orders[column], payload); }
+        for (size_t column = 0; column < STD_FLOAT_COLUMNS; column++) { encode_floats(&floats[column * count], count, payload); }
+    }
+
+    bool decode_state_block(const uint8_t *payload, const size_t size, const size_t count, std::vector<DataRoboMasterState> &states) {
+        // every integer column takes at least one byte per state, so the count is bounded by the payload before it is allocated.
+        if (STATE_LOG_MAX_BLOCK_SIZE < count || size / STD_INTEGER_COLUMNS < count) { return false; }
+        states.assign(count, DataRoboMasterState());
+        if (count == 0) { return size == 0; }
+
+        // the order of a column is known from the field itself, so it is taken from an empty state.
+        std::array<int, STD_INTEGER_COLUMNS> orders{};
+        orders[0] = 1;
+        size_t column = 1;
+        visit_integers(states[0], [&](const auto&, const int order) { orders[column++] = order; });
+
+        std::vector<uint64_t> integers(STD_INTEGER_COLUMNS * count);
+        std::vector<float> floats(STD_FLOAT_COLUMNS * count);
+        size_t position = 0;
+        for (column = 0; column < STD_INTEGER_COLUMNS; column++) {
+            if (!decode_integers(payload, size, position, count, orders[column], &integers[column * count])) { return false; }
+        }
+        for (column = 0; column < STD_FLOAT_COLUMNS; column++) {
+            if (!decode_floats(payload, size, position, count, &floats[column * count])) { return false; }
+        }
+        if (position != size) { return false; }
+
+        for (size_t i = 0; i < count; i++) {
+            set_sections(states[i], static_cast<uint32_t>(integers[i]));
+            column = 1;
+            visit_integers(states[i], [&](auto &value, const int) { value = static_cast<std::remove_reference_t<decltype(value)>>(integers[column++ * count + i]); });
+            column = 0;
+            visit_floats(states[i], [&](float &value) { value = floats[column++ * count + i]; });
+        }
+        return true;
+    }
+
+    StateLog::StateLog(const size_t capacity, const size_t block_size)
+        : mask_(std::bit_ceil(std::max(capacity, static_cast<size_t>(2))) - 1),
+          head_(0),
+          signal_(0),
+          tail_(0),
+          waiting_(false),
+          pushed_(0),
+          dropped_(0),
+          written_(0),
+          blocks_(0),
+          bytes_(0),
+          fd_(-1),
+          block_size_(std::clamp(block_size, static_cast<size_t>(1), STATE_LOG_MAX_BLOCK_SIZE)),
+          flag_open_(false),
+          flag_stop_(false)
+    {
+        this->ring_ = std::make_unique<DataRoboMasterState[]>(this->mask_ + 1);
+    }
+
+    StateLog::~StateLog() {
+        this->close();
+    }
+
+    bool StateLog::open(const std::string &path) {
+        if (this->thread_.joinable()) { log_message(LOG_WARNING, "StateLog", "State log already open"); return false; }
+
+        this->fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (this->fd_ < 0) { log_message(LOG_ERROR, "StateLog", "Failed to create %s", path.c_str()); return false; }
+
+        StateLogHeader header{};
+        std::memcpy(header.magic, STATE_LOG_MAGIC, sizeof(header.magic));
+        header.version = STATE_LOG_VERSION;
+        header.block_size = static_cast<uint32_t>(this->block_size_);
+        header.start_time = get_realtime();
+        if (!this->write_all(reinterpret_cast<const uint8_t*>(&header), sizeof(header))) {
+            log_message(LOG_ERROR, "StateLog", "Failed to write %s", path.c_str());
+            ::close(this->fd_); this->fd_ = -1;
+            return false;
+        }
+
+        this->bytes_ = sizeof(header);
+        this->flag_stop_ = false;
+        this->flag_open_ = true;
+        this->thread_ = std::thread(&StateLog::start_writer_thread, this);
+        return true;
+    }
+
+    void StateLog::close() {
+        if (!this->thread_.joinable()) { return; }
+        this->flag_open_ = false;
+        this->flag_stop_ = true;
+        this->signal_.fetch_add(1);
+        syscall(SYS_futex, &this->signal_, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+        this->thread_.join();
+
+        // states which are left after a write failure are counted as dropped.
+        const uint64_t head = this->head_.load(std::memory_order_acquire);
+        this->dropped_.fetch_add(head - this->tail_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        this->tail_.store(head, std::memory_order_release);
+
+        ::close(this->fd_);
+        this->fd_ = -1;
+    }
+
+    bool StateLog::is_open() const {
+        return this->flag_open_.load(std::memory_order_relaxed);
+    }
+
+    bool StateLog::push(const DataRoboMasterState &state) {
+        if (!this->flag_open_.load(std::memory_order_relaxed)) { this->dropped_.fetch_add(1, std::memory_order_relaxed); return false; }
+
+        const uint64_t head = this->head_.load(std::memory_order_relaxed);
+        if (this->mask_ < head - this->tail_.load(std::memory_order_acquire)) { this->dropped_.fetch_add(1, std::memory_order_relaxed); return false; }
+
+        this->ring_[head & this->mask_] = state;
+        this->head_.store(head + 1, std::memory_order_release);
+        this->pushed_.fetch_add(1, std::memory_order_relaxed);
+
+        // the signal and the waiting flag are sequentially consistent, so either the producer sees the waiting writer or the writer sees the new head.
+        this->signal_.fetch_add(1);
+        if (this->waiting_.load()) { syscall(SYS_futex, &this->signal_, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0); }
+        return true;
+    }
+
+    bool StateLog::write_all(const uint8_t *data, size_t size) {
+        while (0 < size) {
+            const ssize_t count = ::write(this->fd_, data, size);
+            if (count < 0 && errno == EINTR) { continue; }
+            if (count <= 0) { return false; }
+            data += count;
+            size -= static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    bool StateLog::write_block(const std::vector<DataRoboMasterState> &states, std::vector<uint8_t> &buffer) {
+        buffer.assign(sizeof(StateLogBlock), 0);
+        encode_state_block(states.data(), states.size(), buffer);
+
+        StateLogBlock block{};
+        std::memcpy(block.magic, STATE_LOG_BLOCK_MAGIC, sizeof(block.magic));
+        block.count = static_cast<uint32_t>(states.size());
+        block.size = static_cast<uint32_t>(buffer.size() - sizeof(StateLogBlock));
+        std::memcpy(buffer.data(), &block, sizeof(block));
+        if (!this->write_all(buffer.data(), buffer.size())) { return false; }
+
+        this->written_.fetch_add(states.size(), std::memory_order_relaxed);
+        this->blocks_.fetch_add(1, std::memory_order_relaxed);
+        this->bytes_.fetch_add(buffer.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    void StateLog::start_writer_thread() {
+        std::vector<DataRoboMasterState> states;
+        std::vector<uint8_t> buffer;
+        states.reserve(this->block_size_);
+        buffer.reserve(this->block_size_ * STD_MAX_STATE_SIZE / 4);
+
+        bool failed = false;
+        while (!failed) {
+            const uint64_t tail = this->tail_.load(std::memory_order_relaxed);
+            if (tail == this->head_.load(std::memory_order_acquire)) {
+                if (this->flag_stop_) { break; }
+                this->waiting_.store(true);
+                const uint32_t signal = this->signal_.load();
+                if (tail == this->head_.load() && !this->flag_stop_) { syscall(SYS_futex, &this->signal_, FUTEX_WAIT_PRIVATE, signal, nullptr, nullptr, 0); }
+                this->waiting_.store(false);
+                continue;
+            }
+
+            states.push_back(this->ring_[tail & this->mask_]);
+            this->tail_.store(tail + 1, std::memory_order_release);
+            if (states.size() == this->block_size_) { failed = !this->write_block(states, buffer); states.clear(); }
+        }
+
+        // the last block is written when the log is closed.
+        if (!failed && !states.empty()) { failed = !this->write_block(states, buffer); }
+        if (failed) {
+            this->dropped_.fetch_add(states.size(), std::memory_order_relaxed);
+            this->flag_open_ = false;
+            log_message(LOG_ERROR, "StateLog", "Failed to write the log");
+        }
+    }
+
+    StateLogStatistics StateLog::get_statistics() const {
+        StateLogStatistics statistics;
+        statistics.pushed  = this->pushed_.load(std::memory_order_relaxed);
+        statistics.dropped = this->dropped_.load(std::memory_order_relaxed);
+        statistics.written = this->written_.load(std::memory_order_relaxed);
+        statistics.blocks  = this->blocks_.load(std::memory_order_relaxed);
+        statistics.bytes   = this->bytes_.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+    StateLogReader::StateLogReader() : fd_(-1), header_{}, index_(0) { }
+
+    StateLogReader::~StateLogReader() {
+        this->close();
+    }
+
+    static bool read_all(const int fd, void *data, const size_t size) {
+        size_t position = 0;
+        while (position < size) {
+            const ssize_t count = ::read(fd, static_cast<uint8_t*>(data) + position, size - position);
+            if (count < 0 && errno == EINTR) { continue; }
+            if (count <= 0) { return false; }
+            position += static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    bool StateLogReader::open(const std::string &path) {
+        this->close();
+        this->fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (this->fd_ < 0) { log_message(LOG_ERROR, "StateLog", "Failed to open %s", path.c_str()); return false; }
+
+        if (!read_all(this->fd_, &this->header_, sizeof(this->header_)) || std::memcmp(this->header_.magic, STATE_LOG_MAGIC, sizeof(STATE_LOG_MAGIC)) != 0 || this->header_.version != STATE_LOG_VERSION) {
+            log_message(LOG_ERROR, "StateLog", "%s is no state log", path.c_str());
+            this->close();
+            return false;
+        }
+        return true;
+    }
+
+    void StateLogReader::close() {
+        if (0 <= this->fd_) { ::close(this->fd_); }
+        this->fd_ = -1;
+        this->states_.clear();
+        this->index_ = 0;
+    }
+
+    uint64_t StateLogReader::get_start_time() const {
+        return this->header_.start_time;
+    }
+
+    bool StateLogReader::read_block() {
+        StateLogBlock block{};
+        if (this->fd_ < 0 || !read_all(this->fd_, &block, sizeof(block))) { return false; }
+        if (std::memcmp(block.magic, STATE_LOG_BLOCK_MAGIC, sizeof(block.magic)) != 0 || block.count == 0 || this->header_.block_size < block.count || STATE_LOG_MAX_BLOCK_SIZE < block.count ||
+            static_cast<size_t>(block.count) * STD_MAX_STATE_SIZE < block.size || block.size < static_cast<size_t>(block.count) * STD_INTEGER_COLUMNS) {
+            log_message(LOG_WARNING, "StateLog", "Corrupt block");
+            return false;
+        }
+
+        this->payload_.resize(block.size);
+        if (!read_all(this->fd_, this->payload_.data(), block.size)) { log_message(LOG_WARNING, "StateLog", "Truncated block"); return false; }
+        if (!decode_state_block(this->payload_.data(), block.size, block.count, this->states_)) { log_message(LOG_WARNING, "StateLog", "Corrupt block"); return false; }
+        this->index_ = 0;
+        return true;
+    }
+
+    bool StateLogReader::next(DataRoboMasterState &state) {
+        if (this->states_.size() <= this->index_) {
+            this->states_.clear();
+            if (!this->read_block()) { this->close(); return false; }
+        }
+        state = this->states_[this->index_++];
+        return true;
+    }
+} // namespace robomaster_can_controller
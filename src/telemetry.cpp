@@ -0,0 +1,220 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/telemetry.h"
+#include "robomaster_can_controller/logger.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Get the address of the first entry of the history ring.
+     */
+    static TelemetryEntry *get_entries(TelemetrySegment *segment) {
+        return reinterpret_cast<TelemetryEntry*>(segment + 1);
+    }
+
+    static const TelemetryEntry *get_entries(const TelemetrySegment *segment) {
+        return reinterpret_cast<const TelemetryEntry*>(segment + 1);
+    }
+
+    static size_t get_segment_size(const size_t capacity) {
+        return sizeof(TelemetrySegment) + capacity * sizeof(TelemetryEntry);
+    }
+
+    TelemetryPublisher::TelemetryPublisher() : fd_(-1), segment_(nullptr), size_(0) { }
+
+    TelemetryPublisher::~TelemetryPublisher() {
+        this->close();
+    }
+
+    bool TelemetryPublisher::open(const std::string &name, const size_t capacity, const bool replace) {
+        if (this->segment_ != nullptr) { log_message(LOG_WARNING, "Telemetry", "Publisher already open"); return false; }
+        if (capacity == 0 || UINT32_MAX < capacity) { log_message(LOG_ERROR, "Telemetry", "Invalid capacity"); return false; }
+
+        // a segment of another publisher is never taken over, a stale segment is removed instead of truncated on request,
+        // so readers which still map it never see a shrunk mapping.
+        if (replace) { shm_unlink(name.c_str()); }
+        this->fd_ = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (this->fd_ < 0 && errno == EEXIST) { log_message(LOG_ERROR, "Telemetry", "%s exists, it is used by another publisher or stale", name.c_str()); return false; }
+        if (this->fd_ < 0) { log_message(LOG_ERROR, "Telemetry", "Failed to create %s", name.c_str()); return false; }
+
+        this->size_ = get_segment_size(capacity);
+        void *address = MAP_FAILED;
+        if (ftruncate(this->fd_, static_cast<off_t>(this->size_)) < 0 || (address = mmap(nullptr, this->size_, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd_, 0)) == MAP_FAILED) {
+            log_message(LOG_ERROR, "Telemetry", "Failed to map %s", name.c_str());
+            ::close(this->fd_); this->fd_ = -1;
+            shm_unlink(name.c_str());
+            return false;
+        }
+
+        // the new object is zero filled, so the sequences and the counter start at zero.
+        this->segment_ = static_cast<TelemetrySegment*>(address);
+        this->segment_->version = TELEMETRY_VERSION;
+        this->segment_->state_size = sizeof(DataRoboMasterState);
+        this->segment_->capacity = static_cast<uint32_t>(capacity);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(this->segment_->magic, TELEMETRY_MAGIC, sizeof(TELEMETRY_MAGIC));
+        this->name_ = name;
+        return true;
+    }
+
+    void TelemetryPublisher::close() {
+        if (this->segment_ == nullptr) { return; }
+        munmap(this->segment_, this->size_);
+        ::close(this->fd_);
+        shm_unlink(this->name_.c_str());
+        this->segment_ = nullptr;
+        this->fd_ = -1;
+    }
+
+    bool TelemetryPublisher::is_open() const {
+        return this->segment_ != nullptr;
+    }
+
+    void TelemetryPublisher::publish(const DataRoboMasterState &state) {
+        if (this->segment_ == nullptr) { return; }
+        TelemetrySegment &segment = *this->segment_;
+        const uint64_t number = segment.count.load(std::memory_order_relaxed);
+
+        // history ring, the entry is odd while it is written.
+        TelemetryEntry &entry = get_entries(&segment)[number % segment.capacity];
+        entry.sequence.store(2 * number + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&entry.state, &state, sizeof(state));
+        entry.sequence.store(2 * number + 2, std::memory_order_release);
+
+        // latest state behind the seqlock.
+        const uint32_t sequence = segment.sequence.load(std::memory_order_relaxed);
+        segment.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&segment.latest, &state, sizeof(state));
+        segment.count.store(number + 1, std::memory_order_release);
+        segment.sequence.store(sequence + 2, std::memory_order_release);
+
+        syscall(SYS_futex, &segment.sequence, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    uint64_t TelemetryPublisher::get_count() const {
+        return this->segment_ == nullptr ? 0 : this->segment_->count.load(std::memory_order_relaxed);
+    }
+
+    TelemetryReader::TelemetryReader() : fd_(-1), segment_(nullptr), size_(0) { }
+
+    TelemetryReader::~TelemetryReader() {
+        this->close();
+    }
+
+    bool TelemetryReader::open(const std::string &name) {
+        if (this->segment_ != nullptr) { log_message(LOG_WARNING, "Telemetry", "Reader already open"); return false; }
+
+        this->fd_ = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (this->fd_ < 0) { log_message(LOG_ERROR, "Telemetry", "Failed to open %s", name.c_str()); return false; }
+
+        struct stat status{};
+        void *address = MAP_FAILED;
+        if (fstat(this->fd_, &status) < 0 || static_cast<size_t>(status.st_size) < sizeof(TelemetrySegment)
+            || (address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_SHARED, this->fd_, 0)) == MAP_FAILED) {
+            log_message(LOG_ERROR, "Telemetry", "Failed to map %s", name.c_str());
+            ::close(this->fd_); this->fd_ = -1;
+            return false;
+        }
+        this->segment_ = static_cast<const TelemetrySegment*>(address);
+        this->size_ = static_cast<size_t>(status.st_size);
+
+        const TelemetrySegment &segment = *this->segment_;
+        if (std::memcmp(segment.magic, TELEMETRY_MAGIC, sizeof(TELEMETRY_MAGIC)) != 0 || segment.version != TELEMETRY_VERSION
+            || segment.state_size != sizeof(DataRoboMasterState) || segment.capacity == 0 || this->size_ < get_segment_size(segment.capacity)) {
+            log_message(LOG_ERROR, "Telemetry", "Unknown segment layout of %s", name.c_str());
+            this->close();
+            return false;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    void TelemetryReader::close() {
+        if (this->segment_ == nullptr) { return; }
+        munmap(const_cast<TelemetrySegment*>(this->segment_), this->size_);
+        ::close(this->fd_);
+        this->segment_ = nullptr;
+        this->fd_ = -1;
+    }
+
+    bool TelemetryReader::is_open() const {
+        return this->segment_ != nullptr;
+    }
+
+    size_t TelemetryReader::get_capacity() const {
+        return this->segment_ == nullptr ? 0 : this->segment_->capacity;
+    }
+
+    uint64_t TelemetryReader::get_count() const {
+        return this->segment_ == nullptr ? 0 : this->segment_->count.load(std::memory_order_acquire);
+    }
+
+    bool TelemetryReader::read_latest(DataRoboMasterState &state, uint64_t &count) const {
+        if (this->segment_ == nullptr) { return false; }
+        const TelemetrySegment &segment = *this->segment_;
+
+        while (true) {
+            const uint32_t sequence = segment.sequence.load(std::memory_order_acquire);
+            if (sequence % 2 != 0) { continue; }
+            count = segment.count.load(std::memory_order_acquire);
+            if (count == 0) { return false; }
+
+            std::memcpy(&state, &segment.latest, sizeof(state));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (segment.sequence.load(std::memory_order_relaxed) == sequence) { return true; }
+        }
+    }
+
+    bool TelemetryReader::read(const uint64_t number, DataRoboMasterState &state) const {
+        if (this->segment_ == nullptr) { return false; }
+        const TelemetryEntry &entry = get_entries(this->segment_)[number % this->segment_->capacity];
+
+        // the entry holds the state only while its sequence matches the number before and after the copy.
+        const uint64_t sequence = 2 * number + 2;
+        if (entry.sequence.load(std::memory_order_acquire) != sequence) { return false; }
+        std::memcpy(&state, &entry.state, sizeof(state));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return entry.sequence.load(std::memory_order_relaxed) == sequence;
+    }
+
+    bool TelemetryReader::wait(const uint64_t count, const double timeout) const {
+        if (this->segment_ == nullptr) { return false; }
+        const TelemetrySegment &segment = *this->segment_;
+        const auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(std::max(timeout, 0.0));
+
+        while (true) {
+            // the sequence is read before the count, so a state published in between changes the futex word and the wait returns at once.
+            const uint32_t sequence = segment.sequence.load(std::memory_order_acquire);
+            if (count < segment.count.load(std::memory_order_acquire)) { return true; }
+
+            timespec time{};
+            if (0.0 < timeout) {
+                const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(end - std::chrono::steady_clock::now()).count();
+                if (remaining <= 0) { return false; }
+                time.tv_sec = static_cast<time_t>(remaining / 1000000000);
+                time.tv_nsec = static_cast<long>(remaining % 1000000000);
+            }
+            syscall(SYS_futex, &segment.sequence, FUTEX_WAIT, sequence, 0.0 < timeout ? &time : nullptr, nullptr, 0);
+        }
+    }
+} // namespace robomaster_can_controller
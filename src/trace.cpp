@@ -0,0 +1,157 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/trace.h"
+#include "robomaster_can_controller/logger.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Write a string as JSON string without the quotes.
+     */
+    static void write_escaped(FILE *file, const char *text) {
+        for (; *text != '\0'; text++) {
+            if (*text == '"' || *text == '\\') { std::fputc('\\', file); }
+            if (static_cast<unsigned char>(*text) < 0x20) { std::fprintf(file, "\\u%04x", *text); continue; }
+            std::fputc(*text, file);
+        }
+    }
+
+    Tracer &Tracer::get_instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    uint64_t Tracer::now() {
+        timespec time{};
+        clock_gettime(CLOCK_REALTIME, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000ULL + static_cast<uint64_t>(time.tv_nsec);
+    }
+
+    Tracer::BufferOwner::~BufferOwner() {
+        if (this->buffer != nullptr) { Tracer::get_instance().retire(*this->buffer); }
+    }
+
+    Tracer::Buffer &Tracer::get_buffer() {
+        static thread_local BufferOwner owner;
+        if (owner.buffer == nullptr) {
+            std::lock_guard lock(this->mutex_);
+            if (this->free_.empty()) { this->free_.push_back(std::make_unique<Buffer>()); }
+            Buffer &buffer = *this->buffers_.emplace_back(std::move(this->free_.back()));
+            this->free_.pop_back();
+            buffer.thread_id = static_cast<uint32_t>(gettid());
+            owner.buffer = &buffer;
+        }
+        return *owner.buffer;
+    }
+
+    void Tracer::retire(Buffer &buffer) {
+        std::lock_guard lock(this->mutex_);
+        buffer.retired = true;
+        this->recycle(RETIRED_CAPACITY);
+    }
+
+    void Tracer::recycle(const size_t keep) {
+        // the rings are kept in the order of their creation, so the oldest retired rings are released first.
+        size_t retired = std::count_if(this->buffers_.begin(), this->buffers_.end(), [](const auto &buffer) { return buffer->retired; });
+        for (auto it = this->buffers_.begin(); keep < retired && it != this->buffers_.end();) {
+            if (!(*it)->retired) { ++it; continue; }
+            Buffer &buffer = **it;
+            buffer.head.store(0, std::memory_order_relaxed);
+            buffer.thread_name.clear();
+            buffer.retired = false;
+            this->free_.push_back(std::move(*it));
+            it = this->buffers_.erase(it);
+            retired--;
+        }
+    }
+
+    void Tracer::record(const char *name, const uint64_t start, const uint64_t duration, const char phase) {
+        Buffer &buffer = this->get_buffer();
+        const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        TraceEvent &event = buffer.events[head % CAPACITY];
+        event.name = name;
+        event.start = start;
+        event.duration = duration;
+        event.phase = phase;
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Tracer::set_thread_name(const std::string &name) {
+        Buffer &buffer = this->get_buffer();
+        std::lock_guard lock(this->mutex_);
+        buffer.thread_name = name;
+    }
+
+    void Tracer::copy_events(const Buffer &buffer, std::vector<TraceEvent> &events) {
+        const uint64_t head = buffer.head.load(std::memory_order_acquire);
+        const uint64_t begin = CAPACITY < head ? head - CAPACITY : 0;
+        const size_t offset = events.size();
+        for (uint64_t i = begin; i < head; i++) { events.push_back(buffer.events[i % CAPACITY]); }
+
+        // the owning thread may have overwritten the oldest events while they were copied, including the event it is writing right now.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t end = buffer.head.load(std::memory_order_relaxed) + 1;
+        const uint64_t valid = CAPACITY < end ? std::min(end - CAPACITY, head) : 0;
+        if (begin < valid) { events.erase(events.begin() + static_cast<long>(offset), events.begin() + static_cast<long>(offset + (valid - begin))); }
+    }
+
+    std::vector<TraceEvent> Tracer::get_events() {
+        std::lock_guard lock(this->mutex_);
+        std::vector<TraceEvent> events;
+        for (const auto &buffer : this->buffers_) { copy_events(*buffer, events); }
+        this->recycle();
+        return events;
+    }
+
+    bool Tracer::write_chrome_trace(const std::string &path) {
+        FILE *file = std::fopen(path.c_str(), "w");
+        if (file == nullptr) { log_message(LOG_ERROR, "Trace", "Failed to create %s", path.c_str()); return false; }
+
+        std::lock_guard lock(this->mutex_);
+        const auto pid = static_cast<uint32_t>(getpid());
+        std::vector<TraceEvent> events;
+        bool first = true;
+        std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+        for (const auto &buffer : this->buffers_) {
+            if (!buffer->thread_name.empty()) {
+                std::fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",", pid, buffer->thread_id);
+                write_escaped(file, buffer->thread_name.c_str());
+                std::fprintf(file, "\"}}");
+                first = false;
+            }
+
+            events.clear();
+            copy_events(*buffer, events);
+            for (const TraceEvent &event : events) {
+                std::fprintf(file, "%s\n{\"name\":\"", first ? "" : ",");
+                write_escaped(file, event.name);
+                std::fprintf(file, "\",\"ph\":\"%c\",\"pid\":%u,\"tid\":%u,\"ts\":%" PRIu64 ".%03" PRIu64, event.phase, pid, buffer->thread_id, event.start / 1000, event.start % 1000);
+                if (event.phase == 'X') { std::fprintf(file, ",\"dur\":%" PRIu64 ".%03" PRIu64 "}", event.duration / 1000, event.duration % 1000); }
+                else { std::fprintf(file, ",\"s\":\"t\"}"); }
+                first = false;
+            }
+        }
+
+        std::fprintf(file, "\n]}\n");
+        this->recycle();
+        if (std::fclose(file) != 0) { log_message(LOG_ERROR, "Trace", "Failed to write %s", path.c_str()); return false; }
+        return true;
+    }
+
+    void Tracer::clear() {
+        std::lock_guard lock(this->mutex_);
+        for (const auto &buffer : this->buffers_) { buffer->head.store(0, std::memory_order_relaxed); }
+        this->recycle();
+    }
+} // namespace robomaster_can_controller
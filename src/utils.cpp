@@ -5,7 +5,14 @@
 // All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
 
 #include "robomaster_can_controller/utils.h"
-#include <iomanip>
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace robomaster_can_controller {
     const uint8_t TABLE_CRC8[] = {
@@ -74,22 +81,94 @@ namespace robomaster_can_controller {
         return crc;
     }
 
-    std::string string_to_hex(const uint8_t * data, const size_t length) {
-        std::stringstream ss;
+    size_t find_byte(const uint8_t *data, const size_t length, const uint8_t value) {
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128i pattern = _mm_set1_epi8(static_cast<char>(value));
+        for (; i + 16 <= length; i += 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            if (const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern))); mask != 0) { return i + __builtin_ctz(mask); }
+        }
+#elif defined(__ARM_NEON)
+        const uint8x16_t pattern = vdupq_n_u8(value);
+        for (; i + 16 <= length; i += 16) {
+            // narrow the 16 byte compare result to a 64 bit mask with 4 bits per byte.
+            const uint8x16_t block = vceqq_u8(vld1q_u8(data + i), pattern);
+            if (const uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(block), 4)), 0); mask != 0) { return i + (__builtin_ctzll(mask) >> 2); }
+        }
+#endif
+        for (; i < length; i++) { if (data[i] == value) { return i; } }
+        return length;
+    }
+
+    /**
+     * @brief The two lower case hex digits of every byte.
+     */
+    static constexpr auto TABLE_HEX = [] {
+        std::array<char, 512> table{};
+        for (size_t i = 0; i < 256; i++) { table[i * 2] = "0123456789abcdef"[i >> 4]; table[i * 2 + 1] = "0123456789abcdef"[i & 0x0f]; }
+        return table;
+    }();
+
+    size_t hex_encode(const uint8_t *data, const size_t length, char *buffer, const size_t size) {
+        if (size / 2 < length) { return 0; }
+        size_t i = 0;
+#if defined(__SSE2__)
+        // split the bytes into nibbles, interleave them and add '0' or 'a' - 10 to every nibble.
+        const __m128i mask = _mm_set1_epi8(0x0f);
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i zero = _mm_set1_epi8('0');
+        const __m128i letter = _mm_set1_epi8('a' - '0' - 10);
+        for (; i + 16 <= length; i += 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            const __m128i high = _mm_and_si128(_mm_srli_epi16(block, 4), mask);
+            const __m128i low = _mm_and_si128(block, mask);
+            for (const __m128i nibbles : { _mm_unpacklo_epi8(high, low), _mm_unpackhi_epi8(high, low) }) {
+                const __m128i digits = _mm_add_epi8(_mm_add_epi8(nibbles, zero), _mm_and_si128(_mm_cmpgt_epi8(nibbles, nine), letter));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), digits);
+                buffer += 16;
+            }
+        }
+#elif defined(__ARM_NEON)
+        const uint8x16_t mask = vdupq_n_u8(0x0f);
+        const uint8x16_t nine = vdupq_n_u8(9);
+        const uint8x16_t zero = vdupq_n_u8('0');
+        const uint8x16_t letter = vdupq_n_u8('a' - '0' - 10);
+        for (; i + 16 <= length; i += 16) {
+            const uint8x16_t block = vld1q_u8(data + i);
+            uint8x16x2_t nibbles = vzipq_u8(vshrq_n_u8(block, 4), vandq_u8(block, mask));
+            for (uint8x16_t &value : nibbles.val) { value = vaddq_u8(vaddq_u8(value, zero), vandq_u8(vcgtq_u8(value, nine), letter)); }
+            vst1q_u8(reinterpret_cast<uint8_t *>(buffer), nibbles.val[0]);
+            vst1q_u8(reinterpret_cast<uint8_t *>(buffer) + 16, nibbles.val[1]);
+            buffer += 32;
+        }
+#endif
+        for (; i < length; i++) { std::memcpy(buffer, &TABLE_HEX[data[i] * 2], 2); buffer += 2; }
+        return length * 2;
+    }
+
+    size_t hex_dump(const uint8_t *data, const size_t length, char *buffer, const size_t size, const char separator) {
+        if (length == 0 || size < length * 3 - 1) { return 0; }
         for (size_t i = 0; i < length; i++) {
-            ss << std::setfill('0') << std::setw(2) << std::hex << static_cast<uint32_t>(data[i]);
-            if (i < length - 1) { ss << ' '; }
+            std::memcpy(buffer, &TABLE_HEX[data[i] * 2], 2);
+            if (i + 1 < length) { buffer[2] = separator; }
+            buffer += 3;
         }
-        return ss.str();
+        return length * 3 - 1;
+    }
+
+    void uint_to_hex(uint64_t value, char *buffer, const size_t digits) {
+        for (size_t i = digits; 0 < i; i--) { buffer[i - 1] = "0123456789abcdef"[value & 0x0f]; value >>= 4; }
+    }
+
+    std::string string_to_hex(const uint8_t * data, const size_t length) {
+        std::string text(length == 0 ? 0 : length * 3 - 1, ' ');
+        hex_dump(data, length, text.data(), text.size());
+        return text;
     }
 
     std::string string_to_hex(const std::vector<uint8_t> &data) {
-        std::stringstream ss;
-        for (size_t i = 0; i < data.size(); i++) {
-            ss << std::setfill('0') << std::setw(2) << std::hex << static_cast<uint32_t>(data[i]);
-            if (i < data.size() - 1) { ss << ' '; }
-        }
-        return ss.str();
+        return string_to_hex(data.data(), data.size());
     }
 
     uint16_t little_endian_to_uint16(const uint8_t lsb, const uint8_t msb) {
@@ -97,8 +176,8 @@ namespace robomaster_can_controller {
     }
 
     std::string stringUint16ToHex(const uint16_t value) {
-        std::stringstream ss;
-        ss << std::setfill('0') << std::setw(4) << std::hex << value;
-        return ss.str();
+        std::string text(4, '0');
+        uint_to_hex(value, text.data(), text.size());
+        return text;
     }
-} // namespace robomaster_can_controller
\ No newline at end of file
+} // namespace robomaster_can_controller
@@ -0,0 +1,240 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/bridge.h"
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Connect a client with a receive timeout.
+     */
+    static int connect_client(const std::string &path) {
+        const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) { close(fd); return -1; }
+        const timeval timeout{ 2, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        return fd;
+    }
+
+    template<typename T>
+    static bool send_packet(const int fd, const uint8_t type, const std::vector<T> &entries) {
+        std::vector<uint8_t> packet(sizeof(BridgeHeader) + entries.size() * sizeof(T));
+        const BridgeHeader header{ { BRIDGE_MAGIC[0], BRIDGE_MAGIC[1] }, BRIDGE_VERSION, type, static_cast<uint16_t>(entries.size()), 0 };
+        std::memcpy(packet.data(), &header, sizeof(header));
+        std::memcpy(packet.data() + sizeof(header), entries.data(), entries.size() * sizeof(T));
+        return send(fd, packet.data(), packet.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(packet.size());
+    }
+
+    /**
+     * @brief Subscribe and wait for the acknowledgement.
+     */
+    static bool subscribe(const int fd, const uint32_t sections, const uint16_t batch, const uint16_t decimation) {
+        if (!send_packet(fd, BRIDGE_SUBSCRIBE, std::vector{ BridgeSubscribe{ sections, batch, decimation } })) { return false; }
+        std::array<uint8_t, 64> buffer{};
+        BridgeHeader header{};
+        if (recv(fd, buffer.data(), buffer.size(), 0) != sizeof(BridgeHeader) + sizeof(BridgeSubscribe)) { return false; }
+        std::memcpy(&header, buffer.data(), sizeof(header));
+        return header.type == BRIDGE_SUBSCRIBE;
+    }
+
+    /**
+     * @brief Receive a packet of states.
+     */
+    static std::vector<std::pair<uint64_t, DataRoboMasterState>> receive_states(const int fd) {
+        std::vector<std::pair<uint64_t, DataRoboMasterState>> states;
+        std::array<uint8_t, 8192> buffer{};
+        const ssize_t length = recv(fd, buffer.data(), buffer.size(), 0);
+        if (length < static_cast<ssize_t>(sizeof(BridgeHeader))) { return states; }
+        BridgeHeader header{};
+        std::memcpy(&header, buffer.data(), sizeof(header));
+        size_t offset = sizeof(header);
+        for (size_t i = 0; i < header.count; i++) {
+            auto &[sequence, state] = states.emplace_back();
+            const size_t size = decode_bridge_record(buffer.data() + offset, static_cast<size_t>(length) - offset, state, sequence);
+            if (size == 0) { states.clear(); return states; }
+            offset += size;
+        }
+        return states;
+    }
+
+    static DataRoboMasterState make_state(const int32_t value) {
+        DataRoboMasterState state;
+        state.battery = { true, 100, 30, value, 90, 0 };
+        state.velocity = { true, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, static_cast<float>(value) };
+        state.timestamp = { true, 1, 2, 3, 4 };
+        return state;
+    }
+
+    template<typename F>
+    static bool wait_for(F condition) {
+        const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!condition()) {
+            if (end < std::chrono::steady_clock::now()) { return false; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    TEST(BridgeTest, Record) {
+        DataRoboMasterState state = make_state(-7);
+        state.esc = { true, { 1, 2, 3, 4 }, { 5, 6, 7, 8 }, { 9, 10, 11, 12 }, { 13, 14, 15, 16 } };
+        std::array<uint8_t, BRIDGE_MAX_RECORD> buffer{};
+
+        // only the subscribed sections with data are encoded.
+        const size_t size = encode_bridge_record(state, SECTION_ALL, 42, buffer.data());
+        ASSERT_EQ(size, sizeof(BridgeStateRecord) + sizeof(BridgeBattery) + sizeof(BridgeEsc) + sizeof(BridgeVelocity) + sizeof(BridgeTimestamp));
+        DataRoboMasterState decoded;
+        uint64_t sequence = 0;
+        ASSERT_EQ(decode_bridge_record(buffer.data(), size, decoded, sequence), size);
+        ASSERT_EQ(sequence, 42);
+        ASSERT_EQ(decoded.battery.current, -7);
+        ASSERT_EQ(decoded.esc.state[3], 16);
+        ASSERT_EQ(decoded.velocity.vbz, -7.0f);
+        ASSERT_EQ(decoded.timestamp.uncertainty, 4);
+        ASSERT_FALSE(decoded.imu.has_data);
+        ASSERT_EQ(decode_bridge_record(buffer.data(), size - 1, decoded, sequence), 0);
+
+        const size_t battery = encode_bridge_record(state, SECTION_BATTERY | SECTION_IMU, 1, buffer.data());
+        ASSERT_EQ(battery, sizeof(BridgeStateRecord) + sizeof(BridgeBattery));
+        ASSERT_EQ(decode_bridge_record(buffer.data(), battery, decoded, sequence), battery);
+        ASSERT_TRUE(decoded.battery.has_data);
+        ASSERT_FALSE(decoded.velocity.has_data);
+    }
+
+    TEST(BridgeTest, SubscriptionAndCommands) {
+        const std::string path = make_name("/tmp/robomaster_bridge_test_", "subscription", ".sock");
+        Bridge bridge;
+        std::vector<BridgeCommand> commands;
+        std::mutex mutex;
+        bridge.set_command_callback([&](const BridgeCommand &command) { std::lock_guard lock(mutex); commands.push_back(command); });
+        ASSERT_TRUE(bridge.open(path));
+        ASSERT_FALSE(bridge.open(path));
+
+        const int battery = connect_client(path);
+        const int batched = connect_client(path);
+        ASSERT_LE(0, battery);
+        ASSERT_LE(0, batched);
+        ASSERT_TRUE(subscribe(battery, SECTION_BATTERY, 1, 1));
+        ASSERT_TRUE(subscribe(batched, SECTION_ALL, 4, 2));
+        ASSERT_EQ(bridge.get_statistics().clients, 2);
+
+        for (int32_t i = 0; i < 8; i++) { bridge.publish(make_state(i)); }
+
+        // one packet per state with the battery only.
+        for (int32_t i = 0; i < 8; i++) {
+            const auto states = receive_states(battery);
+            ASSERT_EQ(states.size(), 1);
+            ASSERT_EQ(states[0].first, static_cast<uint64_t>(i));
+            ASSERT_EQ(states[0].second.battery.current, i);
+            ASSERT_FALSE(states[0].second.velocity.has_data);
+        }
+
+        // every second state, four states in one packet.
+        const auto states = receive_states(batched);
+        ASSERT_EQ(states.size(), 4);
+        for (size_t i = 0; i < states.size(); i++) {
+            ASSERT_EQ(states[i].first, 2 * i);
+            ASSERT_EQ(states[i].second.velocity.vbz, static_cast<float>(2 * i));
+            ASSERT_TRUE(states[i].second.timestamp.has_data);
+        }
+
+        BridgeCommand velocity{};
+        velocity.type = BRIDGE_VELOCITY;
+        velocity.x = 0.5f;
+        BridgeCommand brake{};
+        brake.type = BRIDGE_BRAKE;
+        ASSERT_TRUE(send_packet(battery, BRIDGE_COMMAND, std::vector{ velocity, brake }));
+        ASSERT_TRUE(send_packet(battery, BRIDGE_COMMAND, std::vector<uint8_t>{ 1, 2, 3 }));
+        ASSERT_TRUE(wait_for([&] { return bridge.get_statistics().invalid == 1; }));
+        {
+            std::lock_guard lock(mutex);
+            ASSERT_EQ(commands.size(), 2);
+            ASSERT_EQ(commands[0].type, BRIDGE_VELOCITY);
+            ASSERT_EQ(commands[0].x, 0.5f);
+            ASSERT_EQ(commands[1].type, BRIDGE_BRAKE);
+        }
+
+        close(battery);
+        ASSERT_TRUE(wait_for([&] { return bridge.get_statistics().clients == 1; }));
+        close(batched);
+        bridge.close();
+        ASSERT_NE(access(path.c_str(), F_OK), 0);
+    }
+
+    TEST(BridgeTest, SlowClient) {
+        const std::string path = make_name("/tmp/robomaster_bridge_test_", "slow", ".sock");
+        Bridge bridge;
+        ASSERT_TRUE(bridge.open(path));
+
+        // the slow client never reads, the fast client keeps receiving the newest states.
+        const int slow = connect_client(path);
+        const int fast = connect_client(path);
+        ASSERT_TRUE(subscribe(slow, SECTION_ALL, 1, 1));
+        ASSERT_TRUE(subscribe(fast, SECTION_BATTERY, 1, 1));
+
+        constexpr int32_t COUNT = 20000;
+        std::atomic<bool> stop = false;
+        std::atomic<int32_t> last = -1;
+        std::thread reader([&] {
+            while (!stop) { for (const auto &[sequence, state] : receive_states(fast)) { last = state.battery.current; } }
+        });
+        const auto start = std::chrono::steady_clock::now();
+        for (int32_t i = 0; i < COUNT; i++) { bridge.publish(make_state(i)); }
+        ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+
+        ASSERT_TRUE(wait_for([&] { return last == COUNT - 1; }));
+        const BridgeStatistics statistics = bridge.get_statistics();
+        stop = true;
+        shutdown(fast, SHUT_RDWR);
+        reader.join();
+
+        ASSERT_LT(0, statistics.dropped);
+        ASSERT_EQ(statistics.clients, 2);
+        close(slow);
+        close(fast);
+    }
+
+    TEST(BridgeTest, PublishWhileClosing) {
+        const std::string path = make_name("/tmp/robomaster_bridge_test_", "closing", ".sock");
+        Bridge bridge;
+
+        // the decode thread keeps publishing while the bridge is closed and opened again.
+        std::atomic<bool> stop = false;
+        std::thread publisher([&] { for (int32_t i = 0; !stop; i++) { bridge.publish(make_state(i)); } });
+        for (size_t i = 0; i < 50; i++) {
+            ASSERT_TRUE(bridge.open(path));
+            bridge.close();
+        }
+        stop = true;
+        publisher.join();
+
+        // a publish after the last close is ignored and a new open delivers the states again.
+        ASSERT_TRUE(bridge.open(path));
+        const int client = connect_client(path);
+        ASSERT_TRUE(subscribe(client, SECTION_BATTERY, 1, 1));
+        bridge.publish(make_state(7));
+        const auto states = receive_states(client);
+        ASSERT_EQ(states.size(), 1);
+        ASSERT_EQ(states[0].second.battery.current, 7);
+        close(client);
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,68 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/clock_sync.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <random>
+
+namespace robomaster_can_controller {
+    static constexpr uint64_t HOST_START = 1700000000000000000ULL;
+    static constexpr uint64_t MIN_DELAY = 300000;
+
+    /**
+     * @brief Device clock with 1 tick per microsecond and a drift of 50 ppm which starts shortly before the wrap around.
+     */
+    static uint32_t device_clock(const uint64_t time) {
+        return static_cast<uint32_t>(0xfff00000u + static_cast<uint64_t>(static_cast<double>(time) / 1000.0 * (1.0 + 50e-6)));
+    }
+
+    /**
+     * @brief Random transport delay with an exponential distribution and a mean of 2 ms on top of the minimal delay, every 20th delay is an outlier.
+     */
+    static uint64_t delay(std::mt19937 &generator, const size_t i) {
+        std::exponential_distribution distribution(1.0 / 2e6);
+        return MIN_DELAY + static_cast<uint64_t>(distribution(generator)) + (i % 20 == 0 ? 50000000 : 0);
+    }
+
+    TEST(ClockSyncTest, OffsetAndDrift) {
+        ClockSync clock_sync;
+        std::mt19937 generator(1337);
+
+        ASSERT_FALSE(clock_sync.is_synchronised());
+        ASSERT_EQ(clock_sync.to_host_time(device_clock(0)), 0);
+
+        for (size_t i = 0; i < 1000; i++) {
+            const uint64_t time = i * 20000000ULL;
+            clock_sync.add_sample(device_clock(time), HOST_START + time + delay(generator, i));
+        }
+
+        ASSERT_TRUE(clock_sync.is_synchronised());
+        ASSERT_NEAR(clock_sync.get_skew(), 1000.0 / (1.0 + 50e-6), 0.01);
+
+        // the mapped time is the acquisition time plus the minimal delay, the error is within the uncertainty.
+        const uint64_t time = 1000 * 20000000ULL;
+        const auto host_time = static_cast<double>(clock_sync.to_host_time(device_clock(time)));
+        ASSERT_NEAR(host_time, static_cast<double>(HOST_START + time + MIN_DELAY), 100000.0);
+        ASSERT_LE(std::abs(host_time - static_cast<double>(HOST_START + time + MIN_DELAY)), static_cast<double>(clock_sync.get_uncertainty()));
+        ASSERT_LT(clock_sync.get_uncertainty(), 1000000);
+    }
+
+    TEST(ClockSyncTest, DeviceReset) {
+        ClockSync clock_sync;
+        std::mt19937 generator(1337);
+
+        for (size_t i = 0; i < 100; i++) {
+            const uint64_t time = i * 20000000ULL;
+            clock_sync.add_sample(device_clock(time), HOST_START + time + delay(generator, i));
+        }
+        ASSERT_TRUE(clock_sync.is_synchronised());
+
+        clock_sync.add_sample(device_clock(0), HOST_START + 100 * 20000000ULL);
+        ASSERT_FALSE(clock_sync.is_synchronised());
+    }
+} // namespace robomaster_can_controller
@@ -155,4 +155,18 @@ namespace robomaster_can_controller {
         ASSERT_FLOAT_EQ(velocity.vby, 11.0f);
         ASSERT_FLOAT_EQ(velocity.vbz, 12.0f);
     }
+
+    TEST(DataTest, DecodeDataTimestamp) {
+        Message msg = Message(0, 0, 0, std::vector<uint8_t>(4, 0));
+
+        DataTimestamp timestamp = decode_data_timestamp(msg);
+        ASSERT_FALSE(timestamp.has_data);
+
+        msg.set_time(1000, 2000);
+        timestamp = decode_data_timestamp(msg);
+
+        ASSERT_TRUE(timestamp.has_data);
+        ASSERT_EQ(timestamp.first_frame, 1000);
+        ASSERT_EQ(timestamp.last_frame, 2000);
+    }
 } // namespace robomaster_can_controller
@@ -0,0 +1,64 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/dispatcher.h"
+#include "robomaster_can_controller/definitions.h"
+#include "gtest/gtest.h"
+
+namespace robomaster_can_controller {
+    TEST(DispatcherTest, DispatchPrefix) {
+        Dispatcher dispatcher;
+        size_t counter_state = 0;
+        size_t counter_other = 0;
+
+        dispatcher.bind_callback(DEVICE_ID_MOTION_CONTROLLER, 0x0903, { 0x20, 0x48, 0x08, 0x00 }, [&counter_state](const Message &) { counter_state++; });
+        dispatcher.bind_callback(DEVICE_ID_MOTION_CONTROLLER, 0x0903, { 0x20, 0x48, 0x09 }, [&counter_other](const Message &) { counter_other++; });
+
+        ASSERT_TRUE(dispatcher.dispatch(Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 0, { 0x20, 0x48, 0x08, 0x00, 0x01 })));
+        ASSERT_TRUE(dispatcher.dispatch(Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 1, { 0x20, 0x48, 0x09, 0x00 })));
+        ASSERT_FALSE(dispatcher.dispatch(Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 2, { 0x20, 0x48 })));
+        ASSERT_FALSE(dispatcher.dispatch(Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 3, { 0x20, 0x48, 0x0a, 0x00 })));
+
+        ASSERT_EQ(counter_state, 1);
+        ASSERT_EQ(counter_other, 1);
+    }
+
+    TEST(DispatcherTest, DispatchDeviceAndType) {
+        Dispatcher dispatcher;
+        size_t counter_gimbal = 0;
+        size_t counter_ack = 0;
+
+        dispatcher.bind_callback(DEVICE_ID_GIMBAL, 0x0904, {}, [&counter_gimbal](const Message &) { counter_gimbal++; });
+        dispatcher.bind_callback(DEVICE_ID_MOTION_CONTROLLER, 0xc9c3, {}, [&counter_ack](const Message &) { counter_ack++; });
+
+        ASSERT_TRUE(dispatcher.dispatch(Message(DEVICE_ID_GIMBAL, 0x0904, 0, { 0x01 })));
+        ASSERT_TRUE(dispatcher.dispatch(Message(DEVICE_ID_GIMBAL, 0x0904, 1)));
+        ASSERT_FALSE(dispatcher.dispatch(Message(DEVICE_ID_MOTION_CONTROLLER, 0x0904, 2, { 0x01 })));
+        ASSERT_TRUE(dispatcher.dispatch(Message(DEVICE_ID_MOTION_CONTROLLER, 0xc9c3, 3, { 0x80, 0x3f, 0x20, 0x00 })));
+        ASSERT_FALSE(dispatcher.dispatch(Message(DEVICE_ID_HIT_DETECTOR_1, 0xc9c3, 4, { 0x80, 0x3f, 0x20, 0x00 })));
+
+        ASSERT_EQ(counter_gimbal, 2);
+        ASSERT_EQ(counter_ack, 1);
+    }
+
+    TEST(DispatcherTest, ReplaceAndUnbind) {
+        Dispatcher dispatcher;
+        size_t counter_first = 0;
+        size_t counter_second = 0;
+
+        dispatcher.bind_callback(DEVICE_ID_MOTION_CONTROLLER, 0x0903, { 0x20 }, [&counter_first](const Message &) { counter_first++; });
+        dispatcher.bind_callback(DEVICE_ID_MOTION_CONTROLLER, 0x0903, { 0x20 }, [&counter_second](const Message &) { counter_second++; });
+
+        ASSERT_TRUE(dispatcher.dispatch(Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 0, { 0x20 })));
+        ASSERT_EQ(counter_first, 0);
+        ASSERT_EQ(counter_second, 1);
+
+        ASSERT_TRUE(dispatcher.unbind_callback(DEVICE_ID_MOTION_CONTROLLER, 0x0903, { 0x20 }));
+        ASSERT_FALSE(dispatcher.unbind_callback(DEVICE_ID_MOTION_CONTROLLER, 0x0903, { 0x20 }));
+        ASSERT_FALSE(dispatcher.dispatch(Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 1, { 0x20 })));
+        ASSERT_EQ(counter_second, 1);
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,114 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/emulator.h"
+#include "robomaster_can_controller/data.h"
+#include "robomaster_can_controller/definitions.h"
+#include "gtest/gtest.h"
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Emulator with a frame sink which feeds a reassembler like the receiver thread of the handler.
+     */
+    struct EmulatorBus {
+        Emulator emulator;
+        Reassembler reassembler;
+        std::vector<Message> messages;
+
+        explicit EmulatorBus(const uint64_t seed=0) : emulator(seed) {
+            this->emulator.set_frame_sink([this](const uint32_t id, const uint8_t *data, const size_t length) { this->reassembler.push_frame(id, data, length, this->messages); });
+        }
+
+        void send(const Message &msg) {
+            const auto data = msg.to_vector();
+            for (size_t i = 0; i < data.size(); i += 8) { this->emulator.push_frame(msg.get_device_id(), data.data() + i, std::min(static_cast<size_t>(8), data.size() - i)); }
+        }
+    };
+
+    TEST(EmulatorTest, BootSequenceAck) {
+        EmulatorBus bus;
+        bus.send(Message(DEVICE_ID_INTELLI_CONTROLLER, 0x0309, 0, { 0x40, 0x48, 0x04, 0x00, 0x09, 0x00 }));
+        bus.send(Message(DEVICE_ID_INTELLI_CONTROLLER, 0x0309, 1, { 0x40, 0x48, 0x01, 0x09, 0x00, 0x00, 0x00, 0x03 }));
+        ASSERT_FALSE(bus.emulator.get_state().booted);
+        bus.send(Message(DEVICE_ID_INTELLI_CONTROLLER, 0x0309, 2, { 0x40, 0x48, 0x03, 0x09, 0x01, 0x03, 0x00, 0x07 }));
+        bus.send(Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc309, 3, { 0x40, 0x3f, 0x19, 0x01 }));
+
+        ASSERT_TRUE(bus.emulator.get_state().booted);
+        ASSERT_TRUE(bus.emulator.get_state().work_mode);
+        ASSERT_EQ(bus.messages.size(), 4);
+        ASSERT_EQ(bus.messages[0].get_device_id(), DEVICE_ID_MOTION_CONTROLLER);
+        ASSERT_EQ(bus.messages[0].get_type(), 0x0903);
+        ASSERT_EQ(bus.messages[0].get_sequence(), 0);
+        ASSERT_EQ(bus.messages[0].get_payload(), std::vector<uint8_t>({ 0x80, 0x48, 0x04, 0x00 }));
+        ASSERT_EQ(bus.messages[3].get_type(), 0x09c3);
+        ASSERT_EQ(bus.emulator.get_statistics().acks, 4);
+    }
+
+    TEST(EmulatorTest, Commands) {
+        EmulatorBus bus;
+        Message velocity(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, 0, { 0x00, 0x3f, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+        velocity.set_value_float(3, 0.5f);
+        velocity.set_value_float(7, -0.25f);
+        bus.send(velocity);
+        bus.send(Message(DEVICE_ID_INTELLI_CONTROLLER, 0x0409, 0, { 0x00, 0x04, 0x69, 0x08, 0x05, 0x10, 0x00, 0xf0, 0xff }));
+        bus.send(Message(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, 0, { 0x00, 0x3f, 0x32, 0x71, 0x00, 0x00, 0xff, 0x80, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x00 }));
+
+        const auto state = bus.emulator.get_state();
+        ASSERT_FLOAT_EQ(state.velocity[0], 0.5f);
+        ASSERT_FLOAT_EQ(state.velocity[1], -0.25f);
+        ASSERT_EQ(state.gimbal[0], 16);
+        ASSERT_EQ(state.gimbal[1], -16);
+        ASSERT_EQ(state.led_mode, 0x71);
+        ASSERT_EQ(state.led_mask, 0x0f);
+        ASSERT_EQ(state.led_color[1], 0x80);
+        ASSERT_TRUE(bus.messages.empty());
+    }
+
+    TEST(EmulatorTest, StatePush) {
+        EmulatorBus bus;
+        Message velocity(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, 0, { 0x00, 0x3f, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+        velocity.set_value_float(3, 1.0f);
+        bus.send(velocity);
+        bus.emulator.set_push_rate(100.0);
+
+        ASSERT_EQ(bus.emulator.step(1000000000), 100);
+        ASSERT_EQ(bus.messages.size(), 100);
+
+        const Message &msg = bus.messages.back();
+        ASSERT_EQ(msg.get_type(), 0x0903);
+        ASSERT_EQ(msg.get_sequence(), 99);
+        ASSERT_EQ(msg.get_length(), 155);
+
+        const auto esc = decode_data_esc(61, msg);
+        const auto position = decode_data_position(133, msg);
+        ASSERT_TRUE(esc.has_data);
+        ASSERT_EQ(esc.time_stamp[0], 1000000);
+        ASSERT_NEAR(position.x, 1.0f, 1e-4f);
+        ASSERT_NEAR(decode_data_velocity(27, msg).vbx, 1.0f, 1e-6f);
+        ASSERT_EQ(bus.emulator.get_statistics().frames_sent, 100 * 20);
+    }
+
+    TEST(EmulatorTest, FaultInjection) {
+        EmulatorBus bus(1337);
+        bus.emulator.set_push_rate(1000.0);
+        bus.emulator.set_frame_loss(0.01);
+        bus.emulator.set_frame_corruption(0.01);
+        bus.emulator.step(1000000000);
+
+        const auto emulator = bus.emulator.get_statistics();
+        const auto stream = bus.reassembler.get_statistics(DEVICE_ID_MOTION_CONTROLLER);
+        ASSERT_EQ(emulator.pushes, 1000);
+        ASSERT_LT(0, emulator.frames_dropped);
+        ASSERT_LT(0, emulator.frames_corrupted);
+        ASSERT_EQ(emulator.frames_sent + emulator.frames_dropped, 1000 * 20);
+        ASSERT_EQ(stream.frames, emulator.frames_sent);
+
+        // every valid message is a complete state push, damaged messages are dropped without losing the following ones.
+        ASSERT_LT(bus.messages.size(), 1000);
+        ASSERT_LT(500, bus.messages.size());
+        for (const auto &msg : bus.messages) { ASSERT_EQ(msg.get_length(), 155); }
+    }
+} // namespace robomaster_can_controller
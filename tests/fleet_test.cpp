@@ -0,0 +1,83 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/fleet.h"
+#include "robomaster_can_controller/emulator.h"
+#include "robomaster_can_controller/definitions.h"
+#include "gtest/gtest.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Wait until the condition holds or the timeout expires.
+     */
+    template<typename F>
+    static bool wait_for(F condition, const std::chrono::milliseconds timeout=std::chrono::milliseconds(5000)) {
+        const auto end = std::chrono::steady_clock::now() + timeout;
+        while (!condition()) {
+            if (end < std::chrono::steady_clock::now()) { return false; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+
+    TEST(FleetTest, SharedThreads) {
+        constexpr size_t COUNT = 4;
+        std::array<Emulator, COUNT> emulators;
+        std::array<std::atomic<size_t>, COUNT> states{};
+
+        BasicFleet<LoopbackTransport> fleet;
+        ASSERT_TRUE(fleet.init(2));
+        std::array<std::unique_ptr<BasicHandler<LoopbackTransport>>, COUNT> handlers;
+        for (size_t i = 0; i < COUNT; i++) {
+            const std::string bus = "fleet_test_bus_" + std::to_string(i);
+            ASSERT_TRUE(emulators[i].init(std::make_unique<LoopbackTransport>(), bus));
+            handlers[i] = std::make_unique<BasicHandler<LoopbackTransport>>();
+            handlers[i]->bind_callback([&states, i](const Message&) { states[i]++; });
+            ASSERT_TRUE(handlers[i]->init(fleet, bus));
+            ASSERT_TRUE(handlers[i]->is_running());
+        }
+        ASSERT_EQ(fleet.get_size(), COUNT);
+        ASSERT_FALSE(handlers[0]->init(fleet, "fleet_test_bus_0"));
+
+        // every handler receives its own state pushes and sends its own heartbeats and commands.
+        handlers[2]->push_message(Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc309, 0, { 0x40, 0x3f, 0x19, 0x01 }));
+        ASSERT_TRUE(wait_for([&] {
+            for (size_t i = 0; i < COUNT; i++) { if (states[i] < 5 || emulators[i].get_statistics().heartbeats < 5) { return false; } }
+            return emulators[2].get_state().work_mode;
+        }));
+        ASSERT_FALSE(emulators[1].get_state().work_mode);
+        ASSERT_TRUE(wait_for([&] { const auto statistics = handlers[2]->get_latency_statistics(); return statistics.size() == 1 && statistics[0].acked == 1; }));
+
+        // a detached handler no longer receives, the others keep running.
+        handlers[1].reset();
+        ASSERT_EQ(fleet.get_size(), COUNT - 1);
+        const size_t received = states[3];
+        ASSERT_TRUE(wait_for([&] { return received + 5 <= states[3]; }));
+        ASSERT_EQ(handlers[3]->get_metrics().counters[METRIC_READ_ERRORS], 0);
+    }
+
+    TEST(FleetTest, FleetDestroyedFirst) {
+        Emulator emulator;
+        BasicHandler<LoopbackTransport> handler;
+        ASSERT_TRUE(emulator.init(std::make_unique<LoopbackTransport>(), "fleet_test_bus_order"));
+        {
+            BasicFleet<LoopbackTransport> fleet;
+            ASSERT_FALSE(handler.init(fleet, "fleet_test_bus_order"));
+            ASSERT_TRUE(fleet.init());
+            ASSERT_TRUE(handler.init(fleet, "fleet_test_bus_order"));
+            ASSERT_TRUE(wait_for([&] { return 3 <= emulator.get_statistics().heartbeats; }));
+        }
+        ASSERT_FALSE(handler.is_running());
+        handler.push_message(Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc309, 0, { 0x40, 0x3f, 0x19, 0x01 }));
+    }
+} // namespace robomaster_can_controller
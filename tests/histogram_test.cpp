@@ -0,0 +1,53 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/histogram.h"
+#include "gtest/gtest.h"
+
+namespace robomaster_can_controller {
+    TEST(HistogramTest, Buckets) {
+        for (uint64_t value = 0; value < 32; value++) {
+            ASSERT_EQ(Histogram::get_bucket(value), value);
+            ASSERT_EQ(Histogram::get_lower_bound(value), value);
+        }
+        for (size_t bucket = 1; bucket < Histogram::BUCKETS; bucket++) {
+            const uint64_t lower = Histogram::get_lower_bound(bucket);
+            ASSERT_EQ(Histogram::get_bucket(lower), bucket);
+            ASSERT_EQ(Histogram::get_bucket(lower - 1), bucket - 1);
+        }
+        ASSERT_EQ(Histogram::get_bucket(UINT64_MAX), Histogram::BUCKETS - 1);
+    }
+
+    TEST(HistogramTest, Percentiles) {
+        Histogram histogram;
+        ASSERT_EQ(histogram.get_percentile(50.0), 0);
+        ASSERT_EQ(histogram.get_mean(), 0.0);
+
+        for (uint64_t value = 1; value <= 100000; value++) { histogram.record(value * 1000); }
+        ASSERT_EQ(histogram.get_count(), 100000);
+        ASSERT_EQ(histogram.get_min(), 1000);
+        ASSERT_EQ(histogram.get_max(), 100000000);
+        ASSERT_DOUBLE_EQ(histogram.get_mean(), 50000.5 * 1000);
+
+        // the resolution of the buckets is 1/16 of the value.
+        ASSERT_NEAR(histogram.get_percentile(50.0), 50000000.0, 50000000.0 / 16);
+        ASSERT_NEAR(histogram.get_percentile(99.0), 99000000.0, 99000000.0 / 16);
+        ASSERT_LE(99000000, histogram.get_percentile(99.0));
+        ASSERT_EQ(histogram.get_percentile(100.0), 100000000);
+        ASSERT_NEAR(histogram.get_percentile(0.0), 1000.0, 1000.0 / 16);
+
+        Histogram other;
+        other.record(5);
+        other.merge(histogram);
+        ASSERT_EQ(other.get_count(), 100001);
+        ASSERT_EQ(other.get_min(), 5);
+        ASSERT_EQ(other.get_max(), 100000000);
+
+        other.reset();
+        ASSERT_EQ(other.get_count(), 0);
+        ASSERT_EQ(other.get_bucket_count(Histogram::get_bucket(5)), 0);
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,136 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/history.h"
+#include "robomaster_can_controller/bridge.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <thread>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Create a state where the imu, the ESC and the receive time hold the given value.
+     */
+    static DataRoboMasterState make_state(const uint32_t value) {
+        DataRoboMasterState state;
+        state.imu.has_data = true;
+        state.imu.acc_x = static_cast<float>(value);
+        state.imu.gyro_z = -static_cast<float>(value);
+        state.esc.has_data = true;
+        state.esc.speed = { static_cast<int16_t>(value), 0, 0, static_cast<int16_t>(-value) };
+        state.timestamp.has_data = true;
+        state.timestamp.first_frame = 1000 + 10 * static_cast<uint64_t>(value);
+        return state;
+    }
+
+    TEST(HistoryTest, Last) {
+        StateHistory history(4);
+        ASSERT_EQ(history.get_capacity(), 4);
+        ASSERT_EQ(history.last(10).size, 0);
+
+        for (uint32_t i = 0; i < 6; i++) { history.push(make_state(i)); }
+        ASSERT_EQ(history.get_count(), 6);
+
+        // the window wraps around the end of the ring and is still contiguous.
+        const HistoryWindow window = history.last(10);
+        ASSERT_EQ(window.begin, 2);
+        ASSERT_EQ(window.size, 4);
+        ASSERT_TRUE(history.is_valid(window));
+        for (size_t i = 0; i < window.size; i++) {
+            ASSERT_FLOAT_EQ(window.acc_x[i], static_cast<float>(i + 2));
+            ASSERT_FLOAT_EQ(window.gyro_z[i], -static_cast<float>(i + 2));
+            ASSERT_EQ(window.speed[i][0], static_cast<int16_t>(i + 2));
+            ASSERT_EQ(window.speed[i][3], -static_cast<int16_t>(i + 2));
+            ASSERT_EQ(window.sections[i], SECTION_ESC | SECTION_IMU | SECTION_TIMESTAMP);
+        }
+        ASSERT_FLOAT_EQ(std::accumulate(window.acc_x.begin(), window.acc_x.end(), 0.0f) / static_cast<float>(window.size), 3.5f);
+
+        const HistoryWindow latest = history.last(2);
+        ASSERT_EQ(latest.begin, 4);
+        ASSERT_FLOAT_EQ(latest.acc_x[1], 5.0f);
+
+        // the states of an old window are overwritten.
+        for (uint32_t i = 6; i < 8; i++) { history.push(make_state(i)); }
+        ASSERT_FALSE(history.is_valid(window));
+        ASSERT_TRUE(history.is_valid(latest));
+
+        const HistoryWindow window_old = history.get_window(0, 3);
+        ASSERT_EQ(window_old.begin, 4);
+        ASSERT_EQ(window_old.size, 3);
+    }
+
+    TEST(HistoryTest, Between) {
+        StateHistory history(8);
+        for (uint32_t i = 0; i < 12; i++) { history.push(make_state(i)); }
+
+        // the history holds the times 1040 to 1110.
+        HistoryWindow window = history.between(1055, 1080);
+        ASSERT_EQ(window.begin, 6);
+        ASSERT_EQ(window.size, 3);
+        ASSERT_EQ(window.time[0], 1060);
+        ASSERT_EQ(window.time[2], 1080);
+
+        window = history.between(0, 1045);
+        ASSERT_EQ(window.begin, 4);
+        ASSERT_EQ(window.size, 1);
+
+        ASSERT_EQ(history.between(2000, 3000).size, 0);
+        ASSERT_EQ(history.between(1080, 1060).size, 0);
+        ASSERT_EQ(history.between(0, UINT64_MAX).size, 8);
+    }
+
+    TEST(HistoryTest, Wait) {
+        StateHistory history(8);
+        ASSERT_FALSE(history.wait(0, 0.01));
+
+        std::thread thread([&history] { std::this_thread::sleep_for(std::chrono::milliseconds(20)); history.push(make_state(1)); });
+        ASSERT_TRUE(history.wait(0));
+        thread.join();
+        ASSERT_TRUE(history.wait(0, 0.01));
+
+        std::thread notify([&history] { std::this_thread::sleep_for(std::chrono::milliseconds(20)); history.notify(); });
+        ASSERT_FALSE(history.wait(1));
+        notify.join();
+    }
+
+    TEST(HistoryTest, ConcurrentReaders) {
+        static constexpr uint32_t COUNT = 20000;
+        StateHistory history(1024);
+        std::atomic<bool> done = false;
+        std::atomic<uint64_t> checked = 0;
+
+        const auto reader = [&] {
+            uint64_t count = 0;
+            while (!done) {
+                if (!history.wait(count, 0.01)) { continue; }
+                const HistoryWindow window = history.last(64);
+                bool consistent = true;
+                for (size_t i = 0; i < window.size; i++) {
+                    const auto number = static_cast<float>(window.begin + i);
+                    consistent &= window.acc_x[i] == number && window.gyro_z[i] == -number;
+                }
+                if (history.is_valid(window)) { ASSERT_TRUE(consistent); checked++; }
+                count = window.begin + window.size;
+            }
+        };
+        std::thread first(reader);
+        std::thread second(reader);
+
+        for (uint32_t i = 0; i < COUNT; i++) {
+            history.push(make_state(i));
+            if (i % 64 == 0) { std::this_thread::yield(); }
+        }
+        done = true;
+        history.notify();
+        first.join();
+        second.join();
+        ASSERT_EQ(history.get_count(), COUNT);
+        ASSERT_LT(0, checked.load());
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,204 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/ingress.h"
+#include "robomaster_can_controller/command.h"
+#include "robomaster_can_controller/handler.h"
+#include "robomaster_can_controller/emulator.h"
+#include "robomaster_can_controller/definitions.h"
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace robomaster_can_controller {
+    TEST(IngressTest, Arbitration) {
+        const std::string name = make_name("/robomaster_ingress_test_", "arbitration");
+        CommandIngress ingress;
+        ASSERT_TRUE(ingress.open(name, 16, 0.05));
+
+        CommandClient autonomy, safety;
+        ASSERT_TRUE(autonomy.open(name, "autonomy", 1));
+        ASSERT_TRUE(safety.open(name, "safety", 10));
+        ASSERT_TRUE(ingress.empty());
+
+        uint64_t time = 0;
+        ASSERT_TRUE(autonomy.push(make_velocity_command(1.0f, 0.0f, 0.0f)));
+        const Message first = ingress.pop(time);
+        ASSERT_TRUE(first.is_valid());
+        ASSERT_EQ(first.get_type(), 0xc3c9);
+        ASSERT_EQ(first.get_value_float(3), 1.0f);
+        ASSERT_LT(0, time);
+
+        // the safety monitor takes over the drive channel, the autonomy is discarded while the safety monitor keeps sending.
+        ASSERT_TRUE(safety.push(make_brake_command()));
+        ASSERT_TRUE(autonomy.push(make_velocity_command(2.0f, 0.0f, 0.0f)));
+        ASSERT_TRUE(autonomy.push(make_led_on_command(LED_MASK_ALL, 255, 0, 0)));
+        const Message brake = ingress.pop(time);
+        ASSERT_TRUE(brake.is_valid());
+        ASSERT_EQ(brake.get_value_uint8(2), 0x20);
+        ASSERT_FALSE(ingress.pop(time).is_valid());
+        ASSERT_TRUE(ingress.pop(time).is_valid());
+        ASSERT_TRUE(ingress.empty());
+        ASSERT_FALSE(ingress.pop(time).is_valid());
+
+        // the local commands are arbitrated with the local priority, only the drive channel is owned by the safety monitor.
+        ASSERT_FALSE(ingress.accept(make_velocity_command(2.0f, 0.0f, 0.0f)));
+        ASSERT_TRUE(ingress.accept(make_gimbal_command(0, 0)));
+
+        // after the hold time the autonomy owns the channel again.
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        ASSERT_TRUE(autonomy.push(make_velocity_command(3.0f, 0.0f, 0.0f)));
+        const Message last = ingress.pop(time);
+        ASSERT_TRUE(last.is_valid());
+        ASSERT_EQ(last.get_value_float(3), 3.0f);
+
+        const auto clients = ingress.get_clients();
+        ASSERT_EQ(clients.size(), 2);
+        ASSERT_EQ(clients[0].name, "autonomy");
+        ASSERT_EQ(clients[0].pid, getpid());
+        ASSERT_EQ(clients[0].pushed, 4);
+        ASSERT_EQ(clients[0].accepted, 3);
+        ASSERT_EQ(clients[0].rejected, 1);
+        ASSERT_EQ(clients[1].name, "safety");
+        ASSERT_EQ(clients[1].priority, 10);
+        ASSERT_EQ(clients[1].accepted, 1);
+    }
+
+    TEST(IngressTest, Limits) {
+        const std::string name = make_name("/robomaster_ingress_test_", "limits");
+        CommandClient client;
+        ASSERT_FALSE(client.open(name, "client", 0));
+        ASSERT_FALSE(client.push(make_brake_command()));
+
+        CommandIngress ingress, other;
+        ASSERT_TRUE(ingress.open(name, 2));
+        ASSERT_TRUE(client.open(name, "client", 0));
+
+        // the segment of a live ingress is not taken over without replace.
+        ASSERT_FALSE(other.open(name, 2));
+        ASSERT_FALSE(client.push(Message(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, 0, std::vector<uint8_t>(INGRESS_MAX_PAYLOAD + 1))));
+
+        // the ring is full after two commands and has room again after a pop.
+        ASSERT_TRUE(client.push(make_brake_command()));
+        ASSERT_TRUE(client.push(make_brake_command()));
+        ASSERT_FALSE(client.push(make_brake_command()));
+        uint64_t time;
+        ASSERT_TRUE(ingress.pop(time).is_valid());
+        ASSERT_TRUE(client.push(make_brake_command()));
+        ASSERT_EQ(ingress.get_clients()[0].dropped, 1);
+
+        // all slots are used, a released slot is reused.
+        std::array<CommandClient, INGRESS_MAX_CLIENTS> clients;
+        for (size_t i = 0; i < INGRESS_MAX_CLIENTS - 1; i++) { ASSERT_TRUE(clients[i].open(name, "client" + std::to_string(i), 0)); }
+        ASSERT_FALSE(clients.back().open(name, "last", 0));
+        client.close();
+        ASSERT_TRUE(clients.back().open(name, "last", 0));
+        ASSERT_EQ(ingress.get_clients().size(), INGRESS_MAX_CLIENTS);
+    }
+
+    TEST(IngressTest, HandlerArbitration) {
+        const std::string name = make_name("/robomaster_ingress_test_", "local");
+        CommandIngress ingress;
+        BasicHandler<LoopbackTransport> handler;
+        ASSERT_TRUE(ingress.open(name, 16, 5.0, 1));
+        ASSERT_TRUE(handler.init("ingress_local_test_bus"));
+        handler.set_command_ingress(&ingress);
+
+        CommandClient safety;
+        ASSERT_TRUE(safety.open(name, "safety", 10));
+        ASSERT_TRUE(safety.push(make_brake_command()));
+        for (size_t i = 0; i < 500 && handler.get_metrics().counters[METRIC_INGRESS_COMMANDS] == 0; i++) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+        ASSERT_EQ(handler.get_metrics().counters[METRIC_INGRESS_COMMANDS], 1);
+
+        // the brake of the ingress took the first sequence of the drive commands.
+        ASSERT_EQ(handler.next_sequence(0xc3c9), 1);
+
+        // the safety monitor owns the drive channel, the velocity of the local batch is discarded and its gimbal command is sent.
+        ASSERT_TRUE(handler.push_messages({ make_velocity_command(1.0f, 0.0f, 0.0f, handler.next_sequence(0xc3c9)), make_gimbal_command(0, 0, handler.next_sequence(0x0409)) }));
+        const auto get_channel = [&handler](const uint16_t type) {
+            for (const ChannelLatency &channel : handler.get_latency_statistics()) { if (channel.type == type) { return channel; } }
+            return ChannelLatency();
+        };
+        for (size_t i = 0; i < 500 && get_channel(0x0409).sent == 0; i++) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+        ASSERT_EQ(get_channel(0x0409).sent, 1);
+        ASSERT_EQ(handler.get_metrics().counters[METRIC_LOCAL_REJECTED], 1);
+
+        const ChannelLatency drive = get_channel(0xc3c9);
+        ASSERT_EQ(drive.enqueued, 2);
+        ASSERT_EQ(drive.evicted, 1);
+        ASSERT_EQ(drive.sent, 1);
+    }
+
+    TEST(IngressTest, ReplaceWhileRunning) {
+        const std::string name = make_name("/robomaster_ingress_test_", "replace");
+        BasicHandler<LoopbackTransport> handler;
+        ASSERT_TRUE(handler.init("ingress_replace_test_bus"));
+        std::atomic<bool> stop = false;
+        std::thread pusher([&handler, &stop] { while (!stop) { handler.push_message(make_gimbal_command(0, 0)); std::this_thread::yield(); } });
+
+        // the setter returns when the sender no longer uses the previous ingress, so it can be destroyed right away.
+        for (size_t i = 0; i < 20; i++) {
+            auto ingress = std::make_unique<CommandIngress>();
+            ASSERT_TRUE(ingress->open(name, 16, 5.0));
+            handler.set_command_ingress(ingress.get());
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            handler.set_command_ingress(nullptr);
+            ingress.reset();
+        }
+        stop = true;
+        pusher.join();
+        ASSERT_TRUE(handler.is_running());
+    }
+
+    TEST(IngressTest, HandlerWithEmulator) {
+        const std::string name = make_name("/robomaster_ingress_test_", "handler");
+        CommandIngress ingress;
+        Emulator emulator;
+        BasicHandler<LoopbackTransport> handler;
+        ASSERT_TRUE(ingress.open(name));
+        ASSERT_TRUE(emulator.init(std::make_unique<LoopbackTransport>(), "ingress_test_bus"));
+        ASSERT_TRUE(handler.init("ingress_test_bus"));
+        handler.set_command_ingress(&ingress);
+        handler.push_message(make_work_mode_command(true));
+
+        // another process drives the robot through the ingress.
+        const pid_t pid = fork();
+        ASSERT_LE(0, pid);
+        if (pid == 0) {
+            CommandClient client;
+            if (!client.open(name, "teleop", 5)) { _exit(1); }
+            if (!client.push(make_velocity_command(0.5f, 0.0f, 0.25f))) { _exit(2); }
+            _exit(0);
+        }
+        int status = 0;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status));
+        ASSERT_EQ(WEXITSTATUS(status), 0);
+
+        EmulatorState state;
+        for (size_t i = 0; i < 500; i++) {
+            state = emulator.get_state();
+            if (state.work_mode && state.velocity[0] == 0.5f) { break; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        ASSERT_TRUE(state.work_mode);
+        ASSERT_EQ(state.velocity[0], 0.5f);
+        ASSERT_EQ(state.velocity[2], 0.25f);
+
+        const MetricsSnapshot metrics = handler.get_metrics();
+        ASSERT_EQ(metrics.counters[METRIC_INGRESS_COMMANDS], 1);
+        ASSERT_EQ(metrics.counters[METRIC_INGRESS_REJECTED], 0);
+    }
+} // namespace robomaster_can_controller
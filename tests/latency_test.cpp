@@ -0,0 +1,99 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/latency.h"
+#include "robomaster_can_controller/handler.h"
+#include "robomaster_can_controller/emulator.h"
+#include "robomaster_can_controller/definitions.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <thread>
+
+namespace robomaster_can_controller {
+    TEST(LatencyTest, TrackCommands) {
+        LatencyTracker tracker;
+        const Message velocity(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, 7, { 0x00, 0x3f, 0x21, 0x00 });
+        const Message mode(DEVICE_ID_INTELLI_CONTROLLER, 0xc309, 3, { 0x40, 0x3f, 0x19, 0x01 });
+
+        tracker.enqueue(velocity, 1000);
+        tracker.dequeue(velocity, 1500);
+        tracker.sent(velocity, true, 2000);
+
+        tracker.enqueue(mode, 1000);
+        tracker.dequeue(mode, 1100);
+        tracker.sent(mode, true, 1200);
+
+        // the state push has the swapped type of the boot sequence but no response flag.
+        ASSERT_FALSE(tracker.receive(Message(DEVICE_ID_MOTION_CONTROLLER, 0x09c3, 3, { 0x20, 0x48, 0x08, 0x00 })));
+        Message ack(DEVICE_ID_MOTION_CONTROLLER, 0x09c3, 3, { 0x80, 0x3f, 0x19, 0x00 });
+        ack.set_time(4000, 5000);
+        ASSERT_TRUE(tracker.receive(ack));
+        ASSERT_FALSE(tracker.receive(ack));
+
+        const auto statistics = tracker.get_statistics();
+        ASSERT_EQ(statistics.size(), 2);
+        ASSERT_EQ(statistics[0].type, 0xc309);
+        ASSERT_EQ(statistics[0].acked, 1);
+        ASSERT_EQ(statistics[0].ack_latency.get_max(), 4000);
+        ASSERT_EQ(statistics[0].sent_latency.get_max(), 200);
+        ASSERT_EQ(statistics[1].type, 0xc3c9);
+        ASSERT_EQ(statistics[1].enqueued, 1);
+        ASSERT_EQ(statistics[1].sent, 1);
+        ASSERT_EQ(statistics[1].acked, 0);
+        ASSERT_EQ(statistics[1].queue.get_max(), 500);
+        ASSERT_EQ(statistics[1].sent_latency.get_max(), 1000);
+    }
+
+    TEST(LatencyTest, EvictedAndUnanswered) {
+        LatencyTracker tracker;
+        const Message first(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, 0, { 0x00, 0x3f, 0x32 });
+        const Message second(DEVICE_ID_INTELLI_CONTROLLER, 0x0309, 1, { 0x40, 0x48, 0x04 });
+
+        tracker.enqueue(first, 1000);
+        tracker.evict(first);
+        tracker.dequeue(first, 2000);
+        tracker.sent(first, true, 3000);
+
+        tracker.enqueue(second, 1000);
+        tracker.sent(second, true, 2000);
+        tracker.enqueue(Message(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, 1, { 0x00 }), 3000000000ULL);
+
+        const auto statistics = tracker.get_statistics();
+        ASSERT_EQ(statistics.size(), 2);
+        ASSERT_EQ(statistics[0].type, 0x0309);
+        ASSERT_EQ(statistics[0].unanswered, 1);
+        ASSERT_EQ(statistics[1].type, 0x1809);
+        ASSERT_EQ(statistics[1].enqueued, 2);
+        ASSERT_EQ(statistics[1].evicted, 1);
+        ASSERT_EQ(statistics[1].sent, 0);
+    }
+
+    TEST(LatencyTest, HandlerWithEmulator) {
+        Emulator emulator;
+        BasicHandler<LoopbackTransport> handler;
+        ASSERT_TRUE(emulator.init(std::make_unique<LoopbackTransport>(), "latency_test_bus"));
+        ASSERT_TRUE(handler.init("latency_test_bus"));
+
+        handler.push_message(Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc309, 0, { 0x40, 0x3f, 0x19, 0x01 }));
+        handler.push_message(Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, 0, { 0x00, 0x3f, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }));
+
+        std::vector<ChannelLatency> statistics;
+        for (size_t i = 0; i < 500; i++) {
+            statistics = handler.get_latency_statistics();
+            if (statistics.size() == 2 && statistics[0].acked == 1 && statistics[1].sent == 1) { break; }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        ASSERT_EQ(statistics.size(), 2);
+        ASSERT_EQ(statistics[0].type, 0xc309);
+        ASSERT_EQ(statistics[0].acked, 1);
+        ASSERT_EQ(statistics[0].ack_latency.get_count(), 1);
+        ASSERT_LT(0, statistics[0].ack_latency.get_max());
+        ASSERT_EQ(statistics[1].type, 0xc3c9);
+        ASSERT_EQ(statistics[1].sent, 1);
+        ASSERT_EQ(statistics[1].ack_latency.get_count(), 0);
+    }
+} // namespace robomaster_can_controller
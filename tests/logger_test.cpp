@@ -0,0 +1,79 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/logger.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace robomaster_can_controller {
+    TEST(LoggerTest, Sink) {
+        Logger logger;
+        std::mutex mutex;
+        std::vector<LogRecord> records;
+        logger.set_sink([&](const LogRecord &record) { std::lock_guard lock(mutex); records.push_back(record); });
+        logger.set_level(LOG_WARNING);
+
+        ASSERT_FALSE(logger.log(LOG_INFO, "Test", "Filtered"));
+        ASSERT_TRUE(logger.log(LOG_WARNING, "Test", "Value %d", 42));
+        ASSERT_TRUE(logger.log(LOG_ERROR, "Other", "%s", std::string(200, 'x').c_str()));
+        logger.flush();
+
+        std::lock_guard lock(mutex);
+        ASSERT_EQ(records.size(), 2);
+        ASSERT_EQ(records[0].level, LOG_WARNING);
+        ASSERT_STREQ(records[0].tag, "Test");
+        ASSERT_STREQ(records[0].text, "Value 42");
+        ASSERT_EQ(std::string(records[1].text), std::string(LogRecord::TEXT_SIZE - 1, 'x'));
+        ASSERT_NE(records[0].time, 0);
+    }
+
+    TEST(LoggerTest, RateLimit) {
+        Logger logger(5, 50000000);
+        std::mutex mutex;
+        std::vector<LogRecord> records;
+        logger.set_sink([&](const LogRecord &record) { std::lock_guard lock(mutex); records.push_back(record); });
+
+        size_t queued = 0;
+        for (size_t i = 0; i < 100; i++) { queued += logger.log(LOG_ERROR, "Test", "Repeated %zu", i); }
+        ASSERT_EQ(queued, 5);
+        ASSERT_TRUE(logger.log(LOG_ERROR, "Test", "Different"));
+
+        // the next window passes again and reports the suppressed messages.
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        for (size_t i = 0; i < 100; i++) { logger.log(LOG_ERROR, "Test", "Repeated %zu", i); }
+        logger.flush();
+
+        std::lock_guard lock(mutex);
+        ASSERT_EQ(records.size(), 11);
+        ASSERT_STREQ(records[5].text, "Different");
+        ASSERT_EQ(records[6].suppressed, 95);
+        ASSERT_EQ(records[7].suppressed, 0);
+    }
+
+    TEST(LoggerTest, NeverBlocks) {
+        Logger logger(Logger::CAPACITY * 4);
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        logger.set_sink([released](const LogRecord&) { released.wait(); });
+
+        // the sink blocks the drain thread, so the ring fills up and further messages are dropped instead of blocking.
+        const auto start = std::chrono::steady_clock::now();
+        size_t queued = 0;
+        for (size_t i = 0; i < Logger::CAPACITY * 2; i++) { queued += logger.log(LOG_ERROR, "Test", "Flood %zu", i); }
+        ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+        ASSERT_LE(queued, Logger::CAPACITY + 1);
+        ASSERT_EQ(logger.get_dropped(), Logger::CAPACITY * 2 - queued);
+
+        release.set_value();
+        logger.flush();
+    }
+} // namespace robomaster_can_controller
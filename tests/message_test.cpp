@@ -7,6 +7,8 @@
 #include "robomaster_can_controller/data.h"
 #include "gtest/gtest.h"
 
+#include <sstream>
+
 namespace robomaster_can_controller {
     TEST(MessageTest, ValueUint8) {
         Message msg = Message(0, 0, 0, std::vector<uint8_t>{1,2});
@@ -150,4 +152,46 @@ namespace robomaster_can_controller {
         ASSERT_FALSE(msg.is_valid());
         ASSERT_EQ(msg.get_payload().size(), 0);
     }
+
+    TEST(MessageTest, CreationFromRawData) {
+        const std::vector<uint8_t> data = Message(0x202, 0x0903, 7, std::vector<uint8_t>{0xDE, 0xAD, 0xBE, 0xEF}).to_vector();
+        const Message msg(0x202, data);
+
+        ASSERT_TRUE(msg.is_valid());
+        ASSERT_EQ(msg.get_type(), 0x0903);
+        ASSERT_EQ(msg.get_sequence(), 7);
+        ASSERT_EQ(msg.get_payload(), std::vector<uint8_t>({0xDE, 0xAD, 0xBE, 0xEF}));
+
+        // the length byte must match the size of the data and the data must start with the sync byte.
+        std::vector<uint8_t> truncated(data.begin(), data.end() - 1);
+        ASSERT_FALSE(Message(0x202, truncated).is_valid());
+        std::vector<uint8_t> extended = data;
+        extended.push_back(0x00);
+        ASSERT_FALSE(Message(0x202, extended).is_valid());
+        std::vector<uint8_t> unsynced = data;
+        unsynced[0] = 0x00;
+        ASSERT_FALSE(Message(0x202, unsynced).is_valid());
+        ASSERT_FALSE(Message(0x202, std::vector<uint8_t>(300, 0x55)).is_valid());
+
+        // a payload which does not fit the length byte cannot be encoded.
+        ASSERT_TRUE(Message(0x202, 0x0903, 0, std::vector<uint8_t>(245, 0x00)).to_vector().size() == 255);
+        ASSERT_TRUE(Message(0x202, 0x0903, 0, std::vector<uint8_t>(246, 0x00)).to_vector().empty());
+    }
+
+    TEST(MessageTest, Stream) {
+        std::ostringstream stream;
+        stream << Message(0x202, 0x0903, 7, std::vector<uint8_t>{0xDE, 0xAD, 0x0B, 0xEF});
+        ASSERT_EQ(stream.str(), "Message( 0x0202, 0x0903,     7, { 0xde, 0xad, 0x0b, 0xef })");
+
+        stream.str("");
+        stream << Message(0x12345, 0x0001, 65535, std::vector<uint8_t>{});
+        ASSERT_EQ(stream.str(), "Message( 0x12345, 0x0001, 65535, {  })");
+
+        // a payload longer than a part of the buffer.
+        stream.str("");
+        stream << Message(0x202, 0x0903, 0, std::vector<uint8_t>(100, 0x5a));
+        std::string expected = "Message( 0x0202, 0x0903,     0, { 0x5a";
+        for (size_t i = 1; i < 100; i++) { expected += ", 0x5a"; }
+        ASSERT_EQ(stream.str(), expected + " })");
+    }
 } // namespace robomaster_can_controller
@@ -0,0 +1,102 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/metrics.h"
+#include "robomaster_can_controller/handler.h"
+#include "robomaster_can_controller/emulator.h"
+#include "robomaster_can_controller/definitions.h"
+#include "gtest/gtest.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace robomaster_can_controller {
+    TEST(MetricsTest, ShardedCounters) {
+        Metrics metrics;
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < 4; i++) {
+            threads.emplace_back([&metrics, i] {
+                for (uint64_t j = 0; j < 10000; j++) {
+                    metrics.add(METRIC_FRAMES_RECEIVED);
+                    metrics.record(METRIC_CALLBACK_DURATION, 1000 * (i + 1));
+                }
+            });
+        }
+        for (auto &thread : threads) { thread.join(); }
+
+        const MetricsSnapshot snapshot = metrics.get_snapshot();
+        ASSERT_EQ(snapshot.counters[METRIC_FRAMES_RECEIVED], 40000);
+        ASSERT_EQ(snapshot.counters[METRIC_SEND_ERRORS], 0);
+        ASSERT_EQ(snapshot.histograms[METRIC_CALLBACK_DURATION].get_count(), 40000);
+        ASSERT_EQ(snapshot.histograms[METRIC_CALLBACK_DURATION].get_min(), 1000);
+        ASSERT_EQ(snapshot.histograms[METRIC_CALLBACK_DURATION].get_max(), 4000);
+        ASSERT_EQ(snapshot.histograms[METRIC_HEARTBEAT_LATENESS].get_count(), 0);
+    }
+
+    TEST(MetricsTest, Prometheus) {
+        MetricsSnapshot snapshot;
+        snapshot.counters[METRIC_SEND_QUEUE_DROPS] = 3;
+        snapshot.histograms[METRIC_HEARTBEAT_LATENESS].record(2000);
+        StreamStatistics statistics;
+        statistics.crc_errors = 5;
+        snapshot.streams.emplace_back(DEVICE_ID_MOTION_CONTROLLER, statistics);
+
+        const std::string text = to_prometheus(snapshot);
+        ASSERT_NE(text.find("# TYPE robomaster_send_queue_drops_total counter\nrobomaster_send_queue_drops_total 3\n"), std::string::npos);
+        ASSERT_NE(text.find("robomaster_heartbeat_lateness_seconds{quantile=\"0.5\"} 2e-06\n"), std::string::npos);
+        ASSERT_NE(text.find("robomaster_heartbeat_lateness_seconds_count 1\n"), std::string::npos);
+        ASSERT_NE(text.find("robomaster_stream_crc16_errors_total{device=\"0x202\"} 5\n"), std::string::npos);
+
+        const std::string path = testing::TempDir() + "metrics_test.prom";
+        ASSERT_TRUE(write_text_file(path, text));
+        std::ifstream file(path);
+        ASSERT_EQ(std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()), text);
+    }
+
+    TEST(MetricsTest, HandlerWithExporter) {
+        Emulator emulator;
+        BasicHandler<LoopbackTransport> handler;
+        emulator.set_push_rate(200.0);
+        ASSERT_TRUE(emulator.init(std::make_unique<LoopbackTransport>(), "metrics_test_bus"));
+        ASSERT_TRUE(handler.init("metrics_test_bus"));
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        const MetricsSnapshot snapshot = handler.get_metrics();
+        ASSERT_LT(0, snapshot.counters[METRIC_FRAMES_RECEIVED]);
+        ASSERT_LT(0, snapshot.counters[METRIC_MESSAGES_RECEIVED]);
+        ASSERT_LT(0, snapshot.counters[METRIC_HEARTBEATS]);
+        ASSERT_EQ(snapshot.counters[METRIC_HEARTBEATS], snapshot.histograms[METRIC_HEARTBEAT_LATENESS].get_count());
+        ASSERT_LE(snapshot.histograms[METRIC_CALLBACK_DURATION].get_count(), snapshot.counters[METRIC_MESSAGES_RECEIVED]);
+        ASSERT_EQ(snapshot.streams.size(), 1);
+        ASSERT_EQ(snapshot.streams[0].first, DEVICE_ID_MOTION_CONTROLLER);
+
+        const std::string path = testing::TempDir() + "metrics_test.sock";
+        MetricsExporter exporter([&handler] { return to_prometheus(handler.get_metrics()); });
+        ASSERT_TRUE(exporter.start(path));
+
+        const int client = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, path.c_str(), path.size());
+        ASSERT_EQ(connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+
+        std::string text;
+        char buffer[4096];
+        for (ssize_t length; (length = read(client, buffer, sizeof(buffer))) > 0;) { text.append(buffer, static_cast<size_t>(length)); }
+        close(client);
+        exporter.stop();
+
+        ASSERT_NE(text.find("robomaster_frames_received_total "), std::string::npos);
+        ASSERT_NE(text.find("robomaster_stream_messages_total{device=\"0x202\"} "), std::string::npos);
+    }
+} // namespace robomaster_can_controller
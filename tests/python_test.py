@@ -0,0 +1,57 @@
+# Copyright (c) 2024 Vinzenz Weist
+#
+# Licensed under the MIT License.
+# For details on the licensing terms, see the LICENSE file. Copyright refers to Fraunhofer IML
+
+import unittest
+
+import numpy as np
+import robomaster_can_controller as rm
+
+
+class PythonTest(unittest.TestCase):
+    """The parts of the bindings which run without a can interface."""
+
+    def test_history(self) -> None:
+        robomaster = rm.RoboMaster(history=100)
+        self.assertEqual(robomaster.capacity(), 100)
+        self.assertEqual(robomaster.count(), 0)
+        self.assertIsNone(robomaster.latest())
+        self.assertEqual(robomaster.wait(1, 0.01), 0)
+
+        for copy in (True, False):
+            window = robomaster.last(10, copy=copy)
+            self.assertEqual(len(window["sequence"]), 0)
+            self.assertEqual(window["speed"].shape, (0, 4))
+            self.assertEqual(window["acc_x"].dtype, np.float32)
+            self.assertTrue(robomaster.is_valid(window))
+            self.assertEqual(len(robomaster.between(0, 2**63, copy=copy)["time"]), 0)
+        self.assertFalse(robomaster.last(10, copy=False)["speed"].flags.writeable)
+
+        with self.assertRaises(ValueError):
+            rm.RoboMaster(history=0)
+
+    def test_bind_and_close(self) -> None:
+        robomaster = rm.RoboMaster(history=100)
+        robomaster.bind(lambda states: None, batch=10)
+        robomaster.bind(lambda states: None, batch=100, copy=False)
+        robomaster.bind(None)
+        with self.assertRaises(ValueError):
+            robomaster.bind(lambda states: None, batch=0)
+        with self.assertRaises(ValueError):
+            robomaster.bind(lambda states: None, batch=101)
+
+        self.assertFalse(robomaster.init("robomaster_python_test"))
+        self.assertFalse(robomaster.is_running())
+        robomaster.close()
+        with self.assertRaises(ValueError):
+            robomaster.is_running()
+
+    def test_sections(self) -> None:
+        sections = [rm.SECTION_BATTERY, rm.SECTION_ESC, rm.SECTION_IMU, rm.SECTION_VELOCITY,
+                    rm.SECTION_POSITION, rm.SECTION_ATTITUDE, rm.SECTION_TIMESTAMP]
+        self.assertEqual(len(set(sections)), len(sections))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -40,7 +40,11 @@ namespace robomaster_can_controller {
     TEST(QueueTest, Overflow) {
         QueueMsg queue;
 
-        for (size_t i = 0; i < queue.max_queue_size() + 1; i++) { queue.push(Message(DEVICE_ID_MOTION_CONTROLLER, 1337, i, std::vector<uint8_t>{static_cast<uint8_t>(i)})); }
+        for (size_t i = 0; i < queue.max_queue_size(); i++) { ASSERT_FALSE(queue.push(Message(DEVICE_ID_MOTION_CONTROLLER, 1337, i, std::vector<uint8_t>{static_cast<uint8_t>(i)}))); }
+        const auto evicted = queue.push(Message(DEVICE_ID_MOTION_CONTROLLER, 1337, queue.max_queue_size(), std::vector<uint8_t>{static_cast<uint8_t>(queue.max_queue_size())}));
+        ASSERT_TRUE(evicted.has_value());
+        ASSERT_EQ(evicted->get_sequence(), 0);
+        ASSERT_EQ(evicted->get_payload()[0], 0);
 
         Message m = queue.pop();
 
@@ -72,4 +76,29 @@ namespace robomaster_can_controller {
         ASSERT_EQ(queue.size(), 0);
         ASSERT_TRUE(queue.empty());
     }
+
+    TEST(QueueTest, PushBatch) {
+        QueueMsg queue;
+        std::vector<Message> batch;
+        for (uint16_t i = 0; i < 4; i++) { batch.emplace_back(DEVICE_ID_MOTION_CONTROLLER, 1337, i, std::vector<uint8_t>{static_cast<uint8_t>(i)}); }
+
+        ASSERT_TRUE(queue.push_batch(batch));
+        ASSERT_TRUE(queue.push_batch(batch));
+
+        // a batch which does not fit is rejected as a whole, the queued messages are not evicted.
+        ASSERT_FALSE(queue.push_batch(batch));
+        ASSERT_EQ(queue.size(), 2 * batch.size());
+        batch.erase(batch.begin() + static_cast<long>(queue.max_queue_size() - 2 * batch.size()), batch.end());
+        ASSERT_TRUE(queue.push_batch(batch));
+        ASSERT_EQ(queue.size(), queue.max_queue_size());
+        ASSERT_FALSE(queue.push_batch({ batch.front() }));
+
+        std::vector<Message> msgs;
+        ASSERT_EQ(queue.pop_all(msgs), queue.max_queue_size());
+        ASSERT_EQ(msgs.size(), queue.max_queue_size());
+        ASSERT_EQ(msgs.front().get_sequence(), 0);
+        ASSERT_EQ(msgs.back().get_sequence(), batch.back().get_sequence());
+        ASSERT_TRUE(queue.empty());
+        ASSERT_EQ(queue.pop_all(msgs), 0);
+    }
 } // namespace robomaster_can_controller
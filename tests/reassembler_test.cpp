@@ -0,0 +1,170 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/reassembler.h"
+#include "robomaster_can_controller/definitions.h"
+#include "robomaster_can_controller/utils.h"
+#include "gtest/gtest.h"
+
+namespace robomaster_can_controller {
+    static void push_frames(Reassembler &reassembler, const uint32_t device_id, const std::vector<uint8_t> &data, std::vector<Message> &messages) {
+        for (size_t i = 0; i < data.size(); i += 8) {
+            reassembler.push_frame(device_id, data.data() + i, std::min(static_cast<size_t>(8), data.size() - i), messages);
+        }
+    }
+
+    TEST(ReassemblerTest, SingleMessage) {
+        Reassembler reassembler;
+        std::vector<Message> messages;
+        const Message msg(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 42, { 0x20, 0x48, 0x08, 0x00, 0xDE, 0xAD, 0xBE, 0xEF, 0x01, 0x02 });
+
+        push_frames(reassembler, DEVICE_ID_MOTION_CONTROLLER, msg.to_vector(), messages);
+
+        ASSERT_EQ(messages.size(), 1);
+        ASSERT_TRUE(messages[0].is_valid());
+        ASSERT_EQ(messages[0].get_device_id(), DEVICE_ID_MOTION_CONTROLLER);
+        ASSERT_EQ(messages[0].get_type(), 0x0903);
+        ASSERT_EQ(messages[0].get_sequence(), 42);
+        ASSERT_EQ(messages[0].get_payload(), msg.get_payload());
+    }
+
+    TEST(ReassemblerTest, FrameTimes) {
+        Reassembler reassembler;
+        std::vector<Message> messages;
+        std::vector<uint8_t> data = { 0x00, 0x00, 0x00 };
+        const auto first = Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 1, std::vector<uint8_t>(20, 0x01)).to_vector();
+        const auto second = Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 2, std::vector<uint8_t>(20, 0x02)).to_vector();
+        data.insert(data.end(), first.begin(), first.end());
+        data.insert(data.end(), second.begin(), second.end());
+
+        // frame n is received at time 1000 + n, the first message spans the frames 0 to 4 and the second one the frames 4 to 7.
+        for (size_t i = 0; i < data.size(); i += 8) {
+            reassembler.push_frame(DEVICE_ID_MOTION_CONTROLLER, data.data() + i, std::min(static_cast<size_t>(8), data.size() - i), messages, 1000 + i / 8);
+        }
+
+        ASSERT_EQ(messages.size(), 2);
+        ASSERT_EQ(messages[0].get_time_first_frame(), 1000);
+        ASSERT_EQ(messages[0].get_time_last_frame(), 1004);
+        ASSERT_EQ(messages[1].get_time_first_frame(), 1004);
+        ASSERT_EQ(messages[1].get_time_last_frame(), 1007);
+    }
+
+    TEST(ReassemblerTest, BackToBackMessages) {
+        Reassembler reassembler;
+        std::vector<Message> messages;
+        std::vector<uint8_t> data;
+
+        for (uint16_t i = 0; i < 5; i++) {
+            const auto vector = Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, i, std::vector<uint8_t>(3 + i, static_cast<uint8_t>(i))).to_vector();
+            data.insert(data.end(), vector.begin(), vector.end());
+        }
+        push_frames(reassembler, DEVICE_ID_MOTION_CONTROLLER, data, messages);
+
+        ASSERT_EQ(messages.size(), 5);
+        for (uint16_t i = 0; i < 5; i++) {
+            ASSERT_EQ(messages[i].get_sequence(), i);
+            ASSERT_EQ(messages[i].get_payload().size(), 3 + i);
+        }
+    }
+
+    TEST(ReassemblerTest, InterleavedDevices) {
+        Reassembler reassembler;
+        std::vector<Message> messages;
+        const auto motion = Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 1, std::vector<uint8_t>(20, 0x11)).to_vector();
+        const auto gimbal = Message(DEVICE_ID_GIMBAL, 0x0904, 2, std::vector<uint8_t>(20, 0x22)).to_vector();
+        const auto hit = Message(DEVICE_ID_HIT_DETECTOR_3, 0x0905, 3, std::vector<uint8_t>(20, 0x33)).to_vector();
+
+        for (size_t i = 0; i < motion.size(); i += 8) {
+            const size_t length = std::min(static_cast<size_t>(8), motion.size() - i);
+            reassembler.push_frame(DEVICE_ID_MOTION_CONTROLLER, motion.data() + i, length, messages);
+            reassembler.push_frame(DEVICE_ID_GIMBAL, gimbal.data() + i, length, messages);
+            reassembler.push_frame(DEVICE_ID_HIT_DETECTOR_3, hit.data() + i, length, messages);
+        }
+
+        ASSERT_EQ(messages.size(), 3);
+        ASSERT_EQ(messages[0].get_device_id(), DEVICE_ID_MOTION_CONTROLLER);
+        ASSERT_EQ(messages[1].get_device_id(), DEVICE_ID_GIMBAL);
+        ASSERT_EQ(messages[2].get_device_id(), DEVICE_ID_HIT_DETECTOR_3);
+        ASSERT_EQ(messages[2].get_payload()[0], 0x33);
+
+        ASSERT_EQ(reassembler.get_statistics(DEVICE_ID_GIMBAL).frames, 4);
+        ASSERT_EQ(reassembler.get_statistics(DEVICE_ID_GIMBAL).bytes, 30);
+        ASSERT_EQ(reassembler.get_statistics(DEVICE_ID_GIMBAL).messages, 1);
+    }
+
+    TEST(ReassemblerTest, UnknownDevice) {
+        Reassembler reassembler;
+        std::vector<Message> messages;
+        const auto data = Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc309, 0, { 0x40, 0x3f, 0x19, 0x01 }).to_vector();
+
+        ASSERT_FALSE(reassembler.is_enabled(DEVICE_ID_INTELLI_CONTROLLER));
+        ASSERT_FALSE(reassembler.is_enabled(0x7ff));
+        push_frames(reassembler, DEVICE_ID_INTELLI_CONTROLLER, data, messages);
+        push_frames(reassembler, 0x7ff, data, messages);
+        ASSERT_TRUE(messages.empty());
+
+        ASSERT_TRUE(reassembler.enable_device(DEVICE_ID_INTELLI_CONTROLLER));
+        ASSERT_FALSE(reassembler.enable_device(0x7ff));
+        push_frames(reassembler, DEVICE_ID_INTELLI_CONTROLLER, data, messages);
+        ASSERT_EQ(messages.size(), 1);
+    }
+
+    TEST(ReassemblerTest, CorruptedMessage) {
+        Reassembler reassembler;
+        std::vector<Message> messages;
+        auto corrupted = Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 1, std::vector<uint8_t>(12, 0x01)).to_vector();
+        const auto valid = Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 2, std::vector<uint8_t>(12, 0x02)).to_vector();
+        corrupted[10]++;
+
+        std::vector<uint8_t> data = { 0x00, 0x55, 0x01 };
+        data.insert(data.end(), corrupted.begin(), corrupted.end());
+        data.insert(data.end(), valid.begin(), valid.end());
+        push_frames(reassembler, DEVICE_ID_MOTION_CONTROLLER, data, messages);
+
+        ASSERT_EQ(messages.size(), 1);
+        ASSERT_EQ(messages[0].get_sequence(), 2);
+        ASSERT_EQ(reassembler.get_statistics(DEVICE_ID_MOTION_CONTROLLER).crc_errors, 1);
+        ASSERT_EQ(reassembler.get_statistics(DEVICE_ID_MOTION_CONTROLLER).discarded_bytes, 3 + corrupted.size());
+        ASSERT_EQ(reassembler.get_statistics(DEVICE_ID_MOTION_CONTROLLER).crc8_errors, 1);
+    }
+
+    TEST(ReassemblerTest, FalseHeader) {
+        Reassembler reassembler;
+        std::vector<Message> messages;
+        const auto valid = Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, 7, std::vector<uint8_t>(12, 0x07)).to_vector();
+
+        // a header with valid crc8 which announces a message much longer than the following valid message.
+        std::vector<uint8_t> data = { 0x55, 0xff, 0x04, 0x00 };
+        data[3] = calculate_crc8(data.data(), 3);
+        data.insert(data.end(), valid.begin(), valid.end());
+        data.resize(data.size() + 0xff, 0x00);
+        push_frames(reassembler, DEVICE_ID_MOTION_CONTROLLER, data, messages);
+
+        ASSERT_EQ(messages.size(), 1);
+        ASSERT_EQ(messages[0].get_sequence(), 7);
+        ASSERT_EQ(reassembler.get_statistics(DEVICE_ID_MOTION_CONTROLLER).crc_errors, 1);
+    }
+
+    TEST(ReassemblerTest, NoisyStream) {
+        Reassembler reassembler;
+        std::vector<Message> messages;
+        std::vector<uint8_t> data;
+        uint32_t seed = 1337;
+
+        for (uint16_t i = 0; i < 200; i++) {
+            // random noise with a high density of sync bytes between the messages.
+            for (size_t j = 0; j < 40; j++) { seed = seed * 1103515245 + 12345; data.push_back((seed >> 16) & 1 ? 0x55 : static_cast<uint8_t>(seed >> 8)); }
+            const auto vector = Message(DEVICE_ID_MOTION_CONTROLLER, 0x0903, i, std::vector<uint8_t>(20, static_cast<uint8_t>(i))).to_vector();
+            data.insert(data.end(), vector.begin(), vector.end());
+        }
+        data.resize(data.size() + 0xff, 0x00);
+        push_frames(reassembler, DEVICE_ID_MOTION_CONTROLLER, data, messages);
+
+        ASSERT_EQ(messages.size(), 200);
+        for (uint16_t i = 0; i < 200; i++) { ASSERT_EQ(messages[i].get_sequence(), i); }
+        ASSERT_LT(0, reassembler.get_statistics(DEVICE_ID_MOTION_CONTROLLER).resyncs);
+    }
+} // namespace robomaster_can_controller
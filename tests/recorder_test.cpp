@@ -0,0 +1,111 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/recorder.h"
+#include "robomaster_can_controller/handler.h"
+#include "robomaster_can_controller/emulator.h"
+#include "robomaster_can_controller/definitions.h"
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace robomaster_can_controller {
+    static void read_log(const std::string &path, RecordFileHeader &header, std::vector<Record> &records) {
+        std::ifstream file(path, std::ios::binary);
+        const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        ASSERT_LE(sizeof(RecordFileHeader), data.size());
+        ASSERT_EQ((data.size() - sizeof(RecordFileHeader)) % sizeof(Record), 0);
+
+        std::memcpy(&header, data.data(), sizeof(header));
+        records.resize((data.size() - sizeof(RecordFileHeader)) / sizeof(Record));
+        std::memcpy(records.data(), data.data() + sizeof(RecordFileHeader), records.size() * sizeof(Record));
+    }
+
+    TEST(RecorderTest, RecordAndIndex) {
+        const std::string path = testing::TempDir() + "recorder_test.rmlog";
+        Recorder recorder(4096, 16);
+
+        CanFrame frame;
+        ASSERT_FALSE(recorder.record(frame, RECORD_RECEIVE));
+        ASSERT_TRUE(recorder.open(path));
+        ASSERT_TRUE(recorder.is_open());
+
+        // more frames than the ring can hold and more records than fit into the first chunk of the log.
+        for (uint32_t i = 0; i < 150000; i++) {
+            frame.id = DEVICE_ID_MOTION_CONTROLLER;
+            frame.length = 8;
+            std::memcpy(frame.data, &i, sizeof(i));
+            frame.timestamp = 1000 + i;
+            while (!recorder.record(frame, i % 2 == 0 ? RECORD_RECEIVE : RECORD_TRANSMIT)) { std::this_thread::yield(); }
+        }
+        recorder.close();
+        ASSERT_FALSE(recorder.is_open());
+
+        RecordFileHeader header{};
+        std::vector<Record> records;
+        read_log(path, header, records);
+
+        ASSERT_EQ(std::memcmp(header.magic, RECORD_MAGIC, sizeof(header.magic)), 0);
+        ASSERT_EQ(header.version, RECORD_VERSION);
+        ASSERT_EQ(header.record_size, sizeof(Record));
+        ASSERT_EQ(header.index_interval, 16);
+        ASSERT_EQ(header.record_count, records.size());
+        ASSERT_EQ(records.size(), 150000 + 150000 / 15);
+        ASSERT_EQ(recorder.get_statistics().written, records.size());
+
+        uint32_t counter = 0;
+        for (size_t i = 0; i < records.size(); i++) {
+            const Record &record = records[i];
+            if (i % 16 == 0) {
+                ASSERT_EQ(record.type, RECORD_INDEX);
+                ASSERT_EQ(record.sequence, counter);
+                ASSERT_EQ(record.timestamp, 1000 + counter);
+                continue;
+            }
+            uint32_t value;
+            std::memcpy(&value, record.data, sizeof(value));
+            ASSERT_EQ(value, counter);
+            ASSERT_EQ(record.sequence, counter);
+            ASSERT_EQ(record.type, counter % 2 == 0 ? RECORD_RECEIVE : RECORD_TRANSMIT);
+            counter++;
+        }
+    }
+
+    TEST(RecorderTest, HandlerRecording) {
+        const std::string path = testing::TempDir() + "recorder_handler_test.rmlog";
+        Recorder recorder;
+        Emulator emulator;
+        ASSERT_TRUE(recorder.open(path));
+        {
+            BasicHandler<LoopbackTransport> handler;
+            emulator.set_push_rate(100.0);
+            ASSERT_TRUE(emulator.init(std::make_unique<LoopbackTransport>(), "recorder_test_bus"));
+            ASSERT_TRUE(handler.init("recorder_test_bus"));
+            handler.set_recorder(&recorder);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            handler.set_recorder(nullptr);
+        }
+        recorder.close();
+
+        RecordFileHeader header{};
+        std::vector<Record> records;
+        read_log(path, header, records);
+
+        size_t received = 0, transmitted = 0;
+        for (const auto &record : records) {
+            if (record.type == RECORD_RECEIVE) { received++; ASSERT_EQ(record.id, DEVICE_ID_MOTION_CONTROLLER); }
+            if (record.type == RECORD_TRANSMIT) { transmitted++; ASSERT_EQ(record.id, DEVICE_ID_INTELLI_CONTROLLER); }
+            if (record.type != RECORD_INDEX) { ASSERT_LT(0, record.timestamp); }
+        }
+        ASSERT_LT(0, received);
+        ASSERT_LT(0, transmitted);
+        ASSERT_EQ(recorder.get_statistics().dropped, 0);
+    }
+} // namespace robomaster_can_controller
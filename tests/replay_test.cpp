@@ -0,0 +1,148 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/replay.h"
+#include "robomaster_can_controller/recorder.h"
+#include "robomaster_can_controller/emulator.h"
+#include "robomaster_can_controller/definitions.h"
+#include "gtest/gtest.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Record one second of state pushes of a driving emulator.
+     */
+    static void record_emulator(const std::string &path) {
+        Emulator emulator;
+        Recorder recorder;
+        uint64_t now = 0;
+        ASSERT_TRUE(recorder.open(path));
+
+        emulator.set_frame_sink([&recorder, &now](const uint32_t id, const uint8_t *data, const size_t length) {
+            CanFrame frame;
+            frame.id = id;
+            frame.length = static_cast<uint8_t>(length);
+            frame.timestamp = now;
+            std::memcpy(frame.data, data, length);
+            while (!recorder.record(frame, RECORD_RECEIVE)) { std::this_thread::yield(); }
+        });
+        emulator.set_push_rate(100.0);
+
+        Message velocity(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, 0, { 0x00, 0x3f, 0x21, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+        velocity.set_value_float(3, 1.0f);
+        const auto data = velocity.to_vector();
+        for (size_t i = 0; i < data.size(); i += 8) { emulator.push_frame(velocity.get_device_id(), data.data() + i, std::min(static_cast<size_t>(8), data.size() - i)); }
+
+        for (now = 1000000000ULL; now <= 2000000000ULL; now += 10000000ULL) { emulator.step(now - 1000000000ULL); }
+        recorder.close();
+    }
+
+    TEST(ReplayTest, RecordedEmulator) {
+        const std::string path = testing::TempDir() + "replay_test.rmlog";
+        record_emulator(path);
+
+        std::vector<CanFrame> frames;
+        ASSERT_TRUE(load_record_log(path, frames));
+        ASSERT_EQ(frames.size(), 100 * 20);
+
+        std::vector<DataRoboMasterState> states;
+        Replay replay;
+        replay.set_callback([&states](const DataRoboMasterState &state) { states.push_back(state); });
+
+        const ReplayStatistics statistics = replay.run(frames);
+        ASSERT_EQ(statistics.frames, frames.size());
+        ASSERT_EQ(statistics.messages, 100);
+        ASSERT_EQ(statistics.states, 100);
+        ASSERT_EQ(statistics.reassembly.count, frames.size());
+        ASSERT_EQ(statistics.decode.count, 100);
+        ASSERT_EQ(states.size(), 100);
+        ASSERT_EQ(replay.get_stream_statistics(DEVICE_ID_MOTION_CONTROLLER).crc_errors, 0);
+
+        ASSERT_NEAR(states.back().position.x, 1.0f, 1e-4f);
+        ASSERT_EQ(states.back().esc.time_stamp[0], 1000000);
+        ASSERT_EQ(states.back().timestamp.last_frame, frames.back().timestamp);
+
+        // the states pass the clock synchronisation of the live path, so the acquisition time is mapped into the receive times.
+        ASSERT_LE(states.back().timestamp.acquisition, states.back().timestamp.first_frame);
+        ASSERT_NEAR(static_cast<double>(states.back().timestamp.acquisition), static_cast<double>(states.back().timestamp.first_frame), 5e6);
+
+        // a second run starts from a fresh state and decodes the same data.
+        std::vector<DataRoboMasterState> first = std::move(states);
+        states.clear();
+        ASSERT_EQ(replay.run(frames).states, 100);
+        ASSERT_EQ(replay.get_stream_statistics(DEVICE_ID_MOTION_CONTROLLER).messages, 100);
+        for (size_t i = 0; i < first.size(); i++) {
+            ASSERT_EQ(first[i].position.x, states[i].position.x);
+            ASSERT_EQ(first[i].esc.time_stamp[0], states[i].esc.time_stamp[0]);
+            ASSERT_EQ(first[i].timestamp.acquisition, states[i].timestamp.acquisition);
+        }
+    }
+
+    TEST(ReplayTest, CandumpLog) {
+        const std::string path = testing::TempDir() + "replay_test.log";
+        {
+            std::ofstream file(path);
+            file << "(1700000000.123456) can0 202#55110004A1000000\n";
+            file << "(1700000000.123500) can0 201#55\n";
+            file << "(1700000000.200000000) can0 202##1550011\n";
+            file << "(1700000000.300000) can0 202#R\n";
+            file << "\n";
+            file << "(1700000001.000001) vcan0 00000202#0102030405060708\n";
+        }
+
+        std::vector<CanFrame> frames;
+        ASSERT_TRUE(load_log(path, frames));
+        ASSERT_EQ(frames.size(), 3);
+        ASSERT_EQ(frames[0].id, 0x202);
+        ASSERT_EQ(frames[0].length, 8);
+        ASSERT_EQ(frames[0].data[0], 0x55);
+        ASSERT_EQ(frames[0].data[4], 0xa1);
+        ASSERT_EQ(frames[0].timestamp, 1700000000123456000ULL);
+        ASSERT_EQ(frames[1].id, 0x201);
+        ASSERT_EQ(frames[1].length, 1);
+        ASSERT_EQ(frames[2].timestamp, 1700000001000001000ULL);
+        ASSERT_EQ(frames[2].data[7], 0x08);
+
+        {
+            std::ofstream file(path);
+            file << "(1700000000.123456) can0 202#551\n";
+        }
+        frames.clear();
+        ASSERT_FALSE(load_candump_log(path, frames));
+        ASSERT_FALSE(load_log(testing::TempDir() + "replay_test_missing.log", frames));
+    }
+
+    TEST(ReplayTest, CandumpRoundTrip) {
+        std::vector<CanFrame> frames(3);
+        frames[0] = { 0x202, 8, { 0x55, 0x11, 0x00, 0x04, 0xa1, 0x00, 0x0f, 0xff }, 1700000000123456000ULL };
+        frames[1] = { 0x201, 1, { 0x55 }, 1700000000000001000ULL };
+        frames[2] = { 0x12345678, 0, {}, 1000000ULL };
+
+        const std::string path = testing::TempDir() + "replay_test_dump.log";
+        std::array<char, 128> buffer{};
+        {
+            std::ofstream file(path);
+            for (const CanFrame &frame : frames) { file << std::string(buffer.data(), to_candump(frame, "can0", buffer.data(), buffer.size())) << "\n"; }
+        }
+        const size_t size = to_candump(frames[0], "can0", buffer.data(), buffer.size());
+        ASSERT_EQ(std::string(buffer.data(), size), "(1700000000.123456) can0 202#55110004a1000fff");
+        ASSERT_EQ(to_candump(frames[0], "can0", buffer.data(), size - 1), 0);
+
+        std::vector<CanFrame> loaded;
+        ASSERT_TRUE(load_candump_log(path, loaded));
+        ASSERT_EQ(loaded.size(), frames.size());
+        for (size_t i = 0; i < frames.size(); i++) {
+            ASSERT_EQ(loaded[i].id, frames[i].id);
+            ASSERT_EQ(loaded[i].length, frames[i].length);
+            ASSERT_EQ(loaded[i].timestamp, frames[i].timestamp);
+            ASSERT_EQ(std::memcmp(loaded[i].data, frames[i].data, sizeof(frames[i].data)), 0);
+        }
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,114 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/serializer.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Create a state with data in every part.
+     */
+    static DataRoboMasterState make_state(const float value) {
+        DataRoboMasterState state;
+        state.battery = { true, 11800, 310, -1520, 87, 0 };
+        state.esc = { true, { 1, -2, 300, -8192 }, { 0, 32767, 12, 7 }, { 1, 4000000000, 3, 4 }, { 0, 1, 2, 255 } };
+        state.imu = { true, value, -value, 9.81f, 1e-7f, -123456789.0f, 0.1f };
+        state.velocity = { true, 0.5f, -0.25f, 0.0f, 1.0f / 3.0f, 2.0f / 3.0f, -0.0f };
+        state.position = { true, 1234.5678f, -0.000012345f, 3.0e38f };
+        state.attitude = { true, 179.99f, -90.0f, 359.5f };
+        state.timestamp = { true, 1700000000123456789, 1700000000123556789, 0, UINT64_MAX };
+        return state;
+    }
+
+    static std::string to_stream(const DataRoboMasterState &state, const bool timestamp=false) {
+        std::ostringstream stream;
+        if (timestamp) { print_with_timestamp(stream, state); } else { stream << state; }
+        return stream.str();
+    }
+
+    TEST(SerializerTest, JsonEqualsStream) {
+        std::array<char, SERIALIZER_MAX_SIZE> buffer{};
+        for (const float value : { 0.0f, 1.0f, -1.5f, 0.000123456f, 1234567.0f, std::numeric_limits<float>::max(), std::numeric_limits<float>::infinity() }) {
+            const DataRoboMasterState state = make_state(value);
+            const size_t size = to_json(state, buffer.data(), buffer.size());
+            ASSERT_LT(0, size);
+            ASSERT_EQ(std::string(buffer.data(), size), to_stream(state));
+            ASSERT_EQ(std::string(buffer.data(), to_json(state, buffer.data(), buffer.size(), true)), to_stream(state, true));
+        }
+
+        const DataRoboMasterState empty;
+        const size_t size = to_json(empty, buffer.data(), buffer.size());
+        ASSERT_EQ(std::string(buffer.data(), size), to_stream(empty));
+        ASSERT_EQ(std::string(buffer.data(), to_json(empty, buffer.data(), buffer.size(), true)), to_stream(empty, true));
+    }
+
+    TEST(SerializerTest, Csv) {
+        std::array<char, SERIALIZER_MAX_SIZE> buffer{};
+        size_t size = to_csv_header(buffer.data(), buffer.size());
+        const std::string header(buffer.data(), size);
+        ASSERT_EQ(std::count(header.begin(), header.end(), ','), 41);
+        ASSERT_EQ(header.substr(0, 24), "battery.adc,battery.temp");
+
+        DataRoboMasterState state = make_state(1.5f);
+        size = to_csv(state, buffer.data(), buffer.size());
+        std::string line(buffer.data(), size);
+        ASSERT_EQ(std::count(line.begin(), line.end(), ','), 41);
+        ASSERT_EQ(line.substr(0, 21), "11800,310,-1520,87,1,");
+        ASSERT_NE(line.find(",1.5,-1.5,9.81,1e-07,-1.23457e+08,0.1,"), std::string::npos);
+        ASSERT_EQ(line.substr(line.size() - 20), std::to_string(UINT64_MAX));
+
+        // the columns of a part without data are empty.
+        state.battery.has_data = false;
+        state.timestamp.has_data = false;
+        size = to_csv(state, buffer.data(), buffer.size());
+        line = std::string(buffer.data(), size);
+        ASSERT_EQ(std::count(line.begin(), line.end(), ','), 41);
+        ASSERT_EQ(line.substr(0, 6), ",,,,1,");
+        ASSERT_EQ(line.substr(line.size() - 4), ",,,,");
+
+        size = to_csv(DataRoboMasterState(), buffer.data(), buffer.size());
+        ASSERT_EQ(std::string(buffer.data(), size), std::string(41, ','));
+    }
+
+    TEST(SerializerTest, BufferTooSmall) {
+        const DataRoboMasterState state = make_state(std::numeric_limits<float>::lowest());
+        std::array<char, SERIALIZER_MAX_SIZE> buffer{};
+        const size_t json = to_json(state, buffer.data(), buffer.size(), true);
+        const size_t csv = to_csv(state, buffer.data(), buffer.size());
+        ASSERT_LT(json, SERIALIZER_MAX_SIZE);
+        ASSERT_LT(csv, SERIALIZER_MAX_SIZE);
+        ASSERT_LT(to_csv_header(buffer.data(), buffer.size()), SERIALIZER_MAX_SIZE);
+
+        for (size_t size = 0; size < json; size += 7) { ASSERT_EQ(to_json(state, buffer.data(), size, true), 0); }
+        for (size_t size = 0; size < csv; size += 7) { ASSERT_EQ(to_csv(state, buffer.data(), size), 0); }
+        ASSERT_EQ(to_json(state, buffer.data(), json, true), json);
+        ASSERT_EQ(to_csv(state, buffer.data(), csv), csv);
+    }
+
+    TEST(SerializerTest, WriteLine) {
+        // the output fills the whole buffer, the newline is still written after it.
+        const DataRoboMasterState state = make_state(1.5f);
+        std::array<char, SERIALIZER_MAX_SIZE> buffer{};
+        std::vector<char> exact(to_json(state, buffer.data(), buffer.size()));
+        ASSERT_EQ(to_json(state, exact.data(), exact.size()), exact.size());
+
+        std::FILE *file = std::tmpfile();
+        ASSERT_NE(file, nullptr);
+        ASSERT_TRUE(write_line(file, exact.data(), exact.size()));
+        ASSERT_FALSE(write_line(file, buffer.data(), to_json(state, buffer.data(), 8)));
+        std::rewind(file);
+        const size_t size = std::fread(buffer.data(), 1, buffer.size(), file);
+        std::fclose(file);
+        ASSERT_EQ(std::string(buffer.data(), size), std::string(exact.begin(), exact.end()) + "\n");
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,128 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/state_log.h"
+#include "robomaster_can_controller/serializer.h"
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Create a state of a driving RoboMaster at 50 Hz.
+     */
+    static DataRoboMasterState make_state(const uint32_t i) {
+        const float time = static_cast<float>(i) * 0.02f;
+        DataRoboMasterState state;
+        state.battery = { i % 10 == 0, static_cast<uint16_t>(11800 - i / 100), 310, static_cast<int32_t>(-1520 - i % 7), 87, 0 };
+        state.esc.has_data = true;
+        for (size_t j = 0; j < 4; j++) {
+            state.esc.speed[j] = static_cast<int16_t>(j % 2 == 0 ? 300 : -300);
+            state.esc.angle[j] = static_cast<int16_t>((i * 37 + j * 1000) % 32768);
+            state.esc.time_stamp[j] = 4000000000u + i * 20000;
+            state.esc.state[j] = 0;
+        }
+        state.imu = { true, 0.01f * std::sin(time), 0.0f, 1.0f, 0.0f, 0.0f, 0.25f };
+        state.velocity = { true, 0.5f, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f };
+        state.position = { true, 0.5f * time, 0.0f, 0.0f };
+        state.attitude = { true, 0.0f, 0.0f, std::round(time * 10.0f) };
+        state.timestamp = { true, 1700000000000000000 + i * 20000000ULL, 1700000000000100000 + i * 20000000ULL, 1700000000000050000 + i * 20000000ULL, 1000 };
+        return state;
+    }
+
+    static bool is_equal(const DataRoboMasterState &a, const DataRoboMasterState &b) {
+        std::array<char, SERIALIZER_MAX_SIZE> buffer_a{};
+        std::array<char, SERIALIZER_MAX_SIZE> buffer_b{};
+        const size_t size_a = to_csv(a, buffer_a.data(), buffer_a.size());
+        const size_t size_b = to_csv(b, buffer_b.data(), buffer_b.size());
+        return size_a == size_b && std::memcmp(buffer_a.data(), buffer_b.data(), size_a) == 0;
+    }
+
+    TEST(StateLogTest, Block) {
+        std::vector<DataRoboMasterState> states;
+        for (uint32_t i = 0; i < 100; i++) { states.push_back(make_state(i)); }
+
+        // extreme values and a part without data.
+        DataRoboMasterState extreme = make_state(100);
+        extreme.imu = { true, std::numeric_limits<float>::quiet_NaN(), -0.0f, std::numeric_limits<float>::infinity(), std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::lowest(), 1e-7f };
+        extreme.battery = { true, UINT16_MAX, 0, INT32_MIN, UINT8_MAX, 0 };
+        extreme.esc.speed = { INT16_MIN, INT16_MAX, 0, -1 };
+        extreme.esc.time_stamp = { 0, UINT32_MAX, 1, 2 };
+        extreme.timestamp = { true, UINT64_MAX, 0, 1, UINT64_MAX };
+        extreme.velocity.has_data = false;
+        states.push_back(extreme);
+        states.push_back(make_state(101));
+
+        std::vector<uint8_t> payload;
+        encode_state_block(states.data(), states.size(), payload);
+        std::vector<DataRoboMasterState> decoded;
+        ASSERT_TRUE(decode_state_block(payload.data(), payload.size(), states.size(), decoded));
+        ASSERT_EQ(decoded.size(), states.size());
+        for (size_t i = 0; i < states.size(); i++) { ASSERT_TRUE(is_equal(states[i], decoded[i])) << i; }
+        ASSERT_EQ(std::memcmp(&decoded[100].imu.acc_y, &extreme.imu.acc_y, sizeof(float)), 0);
+        ASSERT_FALSE(decoded[100].velocity.has_data);
+
+        // every cut payload is rejected.
+        for (size_t size = 0; size < payload.size(); size++) { ASSERT_FALSE(decode_state_block(payload.data(), size, states.size(), decoded)); }
+
+        // a count which the payload or the maximum block size can not hold is rejected before the states are allocated.
+        ASSERT_FALSE(decode_state_block(payload.data(), payload.size(), payload.size(), decoded));
+        ASSERT_FALSE(decode_state_block(payload.data(), payload.size(), STATE_LOG_MAX_BLOCK_SIZE + 1, decoded));
+        ASSERT_FALSE(decode_state_block(payload.data(), payload.size(), std::numeric_limits<size_t>::max(), decoded));
+    }
+
+    TEST(StateLogTest, WriteAndRead) {
+        const std::string path = make_name(testing::TempDir() + "state_log_test_", "write_and_read", ".rmstate");
+        StateLog log(256, 500);
+        ASSERT_FALSE(log.push(make_state(0)));
+        ASSERT_TRUE(log.open(path));
+        ASSERT_TRUE(log.is_open());
+
+        // more states than the ring can hold, the last block is not full.
+        const uint32_t count = 5250;
+        for (uint32_t i = 0; i < count; i++) { while (!log.push(make_state(i))) { std::this_thread::yield(); } }
+        log.close();
+        ASSERT_FALSE(log.is_open());
+
+        const StateLogStatistics statistics = log.get_statistics();
+        ASSERT_EQ(statistics.pushed, count);
+        ASSERT_EQ(statistics.written, count);
+        ASSERT_EQ(statistics.blocks, 11);
+        ASSERT_EQ(statistics.bytes, std::filesystem::file_size(path));
+
+        // the log is at least ten times smaller than the JSON lines of the states.
+        std::array<char, SERIALIZER_MAX_SIZE> buffer{};
+        size_t json = 0;
+        for (uint32_t i = 0; i < count; i++) { json += to_json(make_state(i), buffer.data(), buffer.size()) + 1; }
+        ASSERT_LT(statistics.bytes * 10, json);
+
+        StateLogReader reader;
+        ASSERT_TRUE(reader.open(path));
+        ASSERT_LT(0, reader.get_start_time());
+        DataRoboMasterState state;
+        uint32_t i = 0;
+        for (; reader.next(state); i++) { ASSERT_TRUE(is_equal(state, make_state(i))) << i; }
+        ASSERT_EQ(i, count);
+        ASSERT_FALSE(reader.next(state));
+
+        // a log which was cut by a crash ends with the last complete block.
+        std::filesystem::resize_file(path, statistics.bytes - 10);
+        ASSERT_TRUE(reader.open(path));
+        for (i = 0; reader.next(state); i++) { }
+        ASSERT_EQ(i, 5000);
+
+        std::filesystem::resize_file(path, 10);
+        ASSERT_FALSE(reader.open(path));
+        std::filesystem::remove(path);
+    }
+} // namespace robomaster_can_controller
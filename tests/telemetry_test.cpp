@@ -0,0 +1,182 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/telemetry.h"
+#include "gtest/gtest.h"
+#include "test_utils.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Create a state where every field holds the given value, so a torn read is detected.
+     */
+    static DataRoboMasterState make_state(const uint32_t value) {
+        DataRoboMasterState state;
+        state.battery.has_data = true;
+        state.battery.adc_value = static_cast<uint16_t>(value);
+        state.battery.current = static_cast<int32_t>(value);
+        state.velocity.has_data = true;
+        state.velocity.vgx = static_cast<float>(value);
+        state.timestamp.first_frame = value;
+        return state;
+    }
+
+    static bool is_consistent(const DataRoboMasterState &state) {
+        const auto value = static_cast<uint32_t>(state.battery.current);
+        return state.battery.adc_value == static_cast<uint16_t>(value) && state.velocity.vgx == static_cast<float>(value) && state.timestamp.first_frame == value;
+    }
+
+    TEST(TelemetryTest, LatestAndHistory) {
+        const std::string name = make_name("/robomaster_telemetry_test_", "history");
+        TelemetryPublisher publisher;
+        TelemetryReader reader;
+        ASSERT_FALSE(reader.open(name));
+        ASSERT_TRUE(publisher.open(name, 4));
+        ASSERT_FALSE(publisher.open(name, 4));
+        ASSERT_TRUE(reader.open(name));
+        ASSERT_EQ(reader.get_capacity(), 4);
+
+        DataRoboMasterState state;
+        uint64_t count = 0;
+        ASSERT_FALSE(reader.read_latest(state, count));
+        ASSERT_FALSE(reader.read(0, state));
+
+        for (uint32_t i = 0; i < 6; i++) { publisher.publish(make_state(i)); }
+        ASSERT_EQ(publisher.get_count(), 6);
+        ASSERT_EQ(reader.get_count(), 6);
+        ASSERT_TRUE(reader.read_latest(state, count));
+        ASSERT_EQ(count, 6);
+        ASSERT_EQ(state.battery.current, 5);
+
+        // the ring keeps the last four states, the older ones are overwritten.
+        ASSERT_FALSE(reader.read(0, state));
+        ASSERT_FALSE(reader.read(1, state));
+        for (uint32_t i = 2; i < 6; i++) {
+            ASSERT_TRUE(reader.read(i, state));
+            ASSERT_EQ(state.battery.current, static_cast<int32_t>(i));
+            ASSERT_TRUE(is_consistent(state));
+        }
+        ASSERT_FALSE(reader.read(6, state));
+
+        // a reader keeps its mapping after the publisher removed the segment.
+        publisher.close();
+        ASSERT_TRUE(reader.read_latest(state, count));
+        TelemetryReader other;
+        ASSERT_FALSE(other.open(name));
+    }
+
+    TEST(TelemetryTest, ExistingSegment) {
+        const std::string name = make_name("/robomaster_telemetry_test_", "existing");
+        TelemetryPublisher publisher, second;
+        TelemetryReader reader;
+        ASSERT_TRUE(publisher.open(name, 4));
+        ASSERT_TRUE(reader.open(name));
+
+        // the segment of a live publisher is not taken over, its readers keep receiving its states.
+        ASSERT_FALSE(second.open(name, 4));
+        publisher.publish(make_state(1));
+        ASSERT_EQ(reader.get_count(), 1);
+    }
+
+    TEST(TelemetryTest, UnknownLayout) {
+        const std::string name = make_name("/robomaster_telemetry_test_", "layout");
+        const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+        ASSERT_LE(0, fd);
+        ASSERT_EQ(ftruncate(fd, 4096), 0);
+        ASSERT_EQ(write(fd, "XXXX", 4), 4);
+        close(fd);
+
+        TelemetryReader reader;
+        ASSERT_FALSE(reader.open(name));
+        ASSERT_FALSE(reader.is_open());
+
+        // the publisher replaces the stale segment only on request.
+        TelemetryPublisher publisher;
+        ASSERT_FALSE(publisher.open(name));
+        ASSERT_TRUE(publisher.open(name, 256, true));
+        ASSERT_TRUE(reader.open(name));
+    }
+
+    TEST(TelemetryTest, Wait) {
+        const std::string name = make_name("/robomaster_telemetry_test_", "wait");
+        TelemetryPublisher publisher;
+        TelemetryReader reader;
+        ASSERT_TRUE(publisher.open(name));
+        ASSERT_TRUE(reader.open(name));
+
+        const auto start = std::chrono::steady_clock::now();
+        ASSERT_FALSE(reader.wait(0, 0.05));
+        ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(50));
+
+        std::thread thread([&publisher] { std::this_thread::sleep_for(std::chrono::milliseconds(20)); publisher.publish(make_state(1)); });
+        ASSERT_TRUE(reader.wait(0, 5.0));
+        ASSERT_TRUE(reader.wait(0));
+        thread.join();
+        ASSERT_FALSE(reader.wait(1, 0.01));
+    }
+
+    TEST(TelemetryTest, ConcurrentReader) {
+        const std::string name = make_name("/robomaster_telemetry_test_", "concurrent");
+        TelemetryPublisher publisher;
+        TelemetryReader reader;
+        ASSERT_TRUE(publisher.open(name, 16));
+        ASSERT_TRUE(reader.open(name));
+
+        constexpr uint32_t COUNT = 20000;
+        std::atomic<bool> stop = false;
+        std::atomic<size_t> torn = 0, reads = 0;
+        std::thread thread([&] {
+            DataRoboMasterState state;
+            uint64_t count = 0;
+            while (!stop) {
+                if (reader.read_latest(state, count)) { reads++; if (!is_consistent(state) || state.battery.current != static_cast<int32_t>(count - 1)) { torn++; } }
+                if (0 < count && reader.read(count - 1, state) && !is_consistent(state)) { torn++; }
+            }
+        });
+        for (uint32_t i = 0; i < COUNT; i++) { publisher.publish(make_state(i)); }
+        stop = true;
+        thread.join();
+        ASSERT_EQ(torn, 0);
+        ASSERT_LT(0, reads);
+    }
+
+    TEST(TelemetryTest, OtherProcess) {
+        const std::string name = make_name("/robomaster_telemetry_test_", "process");
+        TelemetryPublisher publisher;
+        ASSERT_TRUE(publisher.open(name, 8));
+
+        // the child waits on the futex of the segment and reads every state of the ring.
+        const pid_t pid = fork();
+        ASSERT_LE(0, pid);
+        if (pid == 0) {
+            TelemetryReader reader;
+            if (!reader.open(name)) { _exit(1); }
+            uint64_t count = 0;
+            DataRoboMasterState state;
+            while (count < 3) {
+                if (!reader.wait(count, 5.0)) { _exit(2); }
+                if (!reader.read(count, state) || state.battery.current != static_cast<int32_t>(count)) { _exit(3); }
+                count++;
+            }
+            _exit(0);
+        }
+        for (uint32_t i = 0; i < 3; i++) { std::this_thread::sleep_for(std::chrono::milliseconds(20)); publisher.publish(make_state(i)); }
+
+        int status = 0;
+        ASSERT_EQ(waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status));
+        ASSERT_EQ(WEXITSTATUS(status), 0);
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,28 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#ifndef ROBOMASTER_CAN_CONTROLLER_TEST_UTILS_H_
+#define ROBOMASTER_CAN_CONTROLLER_TEST_UTILS_H_
+
+#include <unistd.h>
+
+#include <string>
+
+namespace robomaster_can_controller {
+    /**
+     * @brief Create the name of a shared memory object, socket or file of a test. The process id keeps parallel test runs apart.
+     *
+     * @param prefix The prefix, e.g. /robomaster_ingress_test_.
+     * @param test The name of the test.
+     * @param suffix The suffix, e.g. the file extension.
+     * @return std::string as name.
+     */
+    inline std::string make_name(const std::string &prefix, const char *test, const std::string &suffix="") {
+        return prefix + test + "_" + std::to_string(getpid()) + suffix;
+    }
+} // namespace robomaster_can_controller
+
+#endif // ROBOMASTER_CAN_CONTROLLER_TEST_UTILS_H_
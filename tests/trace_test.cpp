@@ -0,0 +1,102 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/trace.h"
+#include "gtest/gtest.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+namespace robomaster_can_controller {
+    TEST(TraceTest, RecordThreads) {
+        Tracer &tracer = Tracer::get_instance();
+        tracer.clear();
+
+        std::thread thread([&tracer] {
+            tracer.set_thread_name("worker");
+            for (uint64_t i = 0; i < 100; i++) { tracer.record("worker_span", 1000 + i, 10); }
+        });
+        thread.join();
+        for (uint64_t i = 0; i < 50; i++) { tracer.record("main_span", 2000 + i, 20); }
+        tracer.record("main_instant", 3000, 0, 'i');
+
+        const auto events = tracer.get_events();
+        const auto count = [&events](const std::string &name) { return std::count_if(events.begin(), events.end(), [&name](const TraceEvent &event) { return name == event.name; }); };
+        ASSERT_EQ(events.size(), 151);
+        ASSERT_EQ(count("worker_span"), 100);
+        ASSERT_EQ(count("main_span"), 50);
+        ASSERT_EQ(count("main_instant"), 1);
+    }
+
+    TEST(TraceTest, ExitedThreads) {
+        Tracer &tracer = Tracer::get_instance();
+        tracer.clear();
+
+        // the events of an exited thread are dumped once, then its ring is reused by the next thread.
+        std::thread([&tracer] { tracer.record("first_span", 1000, 10); }).join();
+        ASSERT_EQ(tracer.get_events().size(), 1);
+        ASSERT_TRUE(tracer.get_events().empty());
+        std::thread([&tracer] { tracer.record("second_span", 2000, 10); }).join();
+        const auto events = tracer.get_events();
+        ASSERT_EQ(events.size(), 1);
+        ASSERT_STREQ(events[0].name, "second_span");
+
+        // without a dump only the rings of the latest exited threads are kept.
+        for (size_t i = 0; i < Tracer::RETIRED_CAPACITY + 4; i++) { std::thread([&tracer] { tracer.record("span", 3000, 10); }).join(); }
+        ASSERT_EQ(tracer.get_events().size(), Tracer::RETIRED_CAPACITY);
+    }
+
+    TEST(TraceTest, Overflow) {
+        Tracer &tracer = Tracer::get_instance();
+        tracer.clear();
+
+        for (uint64_t i = 0; i < Tracer::CAPACITY + 100; i++) { tracer.record("span", i + 1, 1); }
+        const auto events = tracer.get_events();
+        ASSERT_EQ(events.size(), Tracer::CAPACITY - 1);
+
+        // the oldest events are overwritten, the latest events are kept in order.
+        ASSERT_EQ(events.back().start, Tracer::CAPACITY + 100);
+        for (size_t i = 1; i < events.size(); i++) { ASSERT_EQ(events[i].start, events[i - 1].start + 1); }
+    }
+
+    TEST(TraceTest, ChromeTrace) {
+        Tracer &tracer = Tracer::get_instance();
+        tracer.clear();
+        tracer.set_thread_name("main");
+
+        const uint64_t start = Tracer::now();
+        {
+            const TraceScope scope("scope");
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        tracer.record("instant", Tracer::now(), 0, 'i');
+        ASSERT_LE(start, Tracer::now());
+
+        const std::string path = "/tmp/robomaster_trace_test_" + std::to_string(getpid()) + ".json";
+        ASSERT_TRUE(tracer.write_chrome_trace(path));
+        std::ifstream file(path);
+        const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::remove(path.c_str());
+
+        ASSERT_EQ(text.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0);
+        ASSERT_NE(text.find("\"name\":\"thread_name\",\"ph\":\"M\""), std::string::npos);
+        ASSERT_NE(text.find("\"args\":{\"name\":\"main\"}"), std::string::npos);
+        const size_t scope = text.find("{\"name\":\"scope\",\"ph\":\"X\"");
+        ASSERT_NE(scope, std::string::npos);
+        ASSERT_NE(text.find("{\"name\":\"instant\",\"ph\":\"i\""), std::string::npos);
+
+        // the duration is written in microseconds.
+        const size_t duration = text.find("\"dur\":", scope);
+        ASSERT_NE(duration, std::string::npos);
+        ASSERT_GE(std::stod(text.substr(duration + 6)), 1000.0);
+        ASSERT_FALSE(tracer.write_chrome_trace("/nonexistent/trace.json"));
+    }
+} // namespace robomaster_can_controller
@@ -0,0 +1,162 @@
+// Copyright (c) 2023 Fraunhofer IML, 2024 Vinzenz Weist
+//
+// This project contains contributions from multiple authors.
+// The original code is licensed under the MIT License by Fraunhofer IML.
+// All modifications and additional code are licensed under the MIT License by Vinzenz Weist.
+
+#include "robomaster_can_controller/handler.h"
+#include "robomaster_can_controller/emulator.h"
+#include "robomaster_can_controller/definitions.h"
+#include "gtest/gtest.h"
+
+#include <poll.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace robomaster_can_controller {
+    static_assert(FrameTransport<CanSocket>);
+    static_assert(FrameTransport<LoopbackTransport>);
+    static_assert(FrameTransport<AnyTransport>);
+
+    static bool is_readable(const int fd) {
+        pollfd poll_fd{ fd, POLLIN, 0 };
+        return 0 < poll(&poll_fd, 1, 0);
+    }
+
+    TEST(TransportTest, LoopbackBus) {
+        LoopbackTransport a, b, c, other;
+        ASSERT_TRUE(a.init("transport_test_bus"));
+        ASSERT_TRUE(b.init("transport_test_bus"));
+        ASSERT_TRUE(c.init("transport_test_bus"));
+        ASSERT_TRUE(other.init("transport_test_other"));
+        ASSERT_FALSE(a.init("transport_test_bus"));
+        b.set_timeout(0.01);
+        other.set_timeout(0.01);
+
+        constexpr uint8_t data[8] = { 0x55, 0x0e, 0x04, 0x66, 0x01, 0x02, 0x03, 0x04 };
+        ASSERT_FALSE(is_readable(b.get_fd()));
+        ASSERT_TRUE(a.send_frame(DEVICE_ID_MOTION_CONTROLLER, data, 8));
+        ASSERT_TRUE(is_readable(b.get_fd()));
+        ASSERT_TRUE(is_readable(c.get_fd()));
+        ASSERT_FALSE(is_readable(a.get_fd()));
+        ASSERT_FALSE(is_readable(other.get_fd()));
+
+        uint32_t id;
+        uint8_t buffer[8];
+        size_t length;
+        uint64_t timestamp;
+        ASSERT_TRUE(b.read_frame(id, buffer, length, timestamp));
+        ASSERT_EQ(id, DEVICE_ID_MOTION_CONTROLLER);
+        ASSERT_EQ(length, 8);
+        ASSERT_EQ(buffer[3], 0x66);
+        ASSERT_LT(0, timestamp);
+        ASSERT_FALSE(is_readable(b.get_fd()));
+
+        // the timeout returns success without a frame.
+        ASSERT_TRUE(b.read_frame(id, buffer, length, timestamp));
+        ASSERT_EQ(length, 0);
+        ASSERT_TRUE(other.read_frame(id, buffer, length, timestamp));
+        ASSERT_EQ(length, 0);
+    }
+
+    TEST(TransportTest, LoopbackBatch) {
+        AnyTransport sender(std::make_unique<LoopbackTransport>());
+        LoopbackTransport receiver;
+        ASSERT_TRUE(sender.init("transport_test_batch"));
+        ASSERT_TRUE(receiver.init("transport_test_batch"));
+
+        CanFrame frames[20];
+        for (uint8_t i = 0; i < 20; i++) { frames[i].id = DEVICE_ID_INTELLI_CONTROLLER; frames[i].length = i % 9; frames[i].data[0] = i; }
+        ASSERT_TRUE(sender.send_frames(frames, 20));
+
+        CanFrame buffer[16];
+        size_t count;
+        ASSERT_TRUE(receiver.read_frames(buffer, 16, count));
+        ASSERT_EQ(count, 16);
+        ASSERT_TRUE(is_readable(receiver.get_fd()));
+        ASSERT_TRUE(receiver.read_frames(buffer, 16, count));
+        ASSERT_EQ(count, 4);
+        ASSERT_EQ(buffer[3].data[0], 19);
+        ASSERT_EQ(buffer[3].length, 19 % 9);
+        ASSERT_FALSE(is_readable(receiver.get_fd()));
+
+        frames[0].length = 9;
+        ASSERT_FALSE(sender.send_frames(frames, 1));
+        ASSERT_FALSE(AnyTransport().send_frames(frames, 1));
+    }
+
+    TEST(TransportTest, HandlerWithEmulator) {
+        // the state of the callbacks outlives the handler threads.
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t pushes = 0, acks = 0;
+        Emulator emulator;
+        BasicHandler<LoopbackTransport> handler;
+
+        emulator.set_push_rate(200.0);
+        ASSERT_TRUE(emulator.init(std::make_unique<LoopbackTransport>(), "transport_test_handler"));
+        handler.bind_callback([&](const Message&) { std::lock_guard lock(mutex); pushes++; cv.notify_all(); });
+        handler.bind_callback(DEVICE_ID_MOTION_CONTROLLER, 0x09c3, {}, [&](const Message&) { std::lock_guard lock(mutex); acks++; cv.notify_all(); });
+        ASSERT_TRUE(handler.init("transport_test_handler"));
+
+        handler.push_message(Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc309, 0, { 0x40, 0x3f, 0x19, 0x01 }));
+
+        std::unique_lock lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&] { return 10 <= pushes && acks == 1; }));
+        ASSERT_TRUE(emulator.get_state().work_mode);
+        ASSERT_LT(0, emulator.get_statistics().heartbeats);
+        ASSERT_TRUE(handler.is_running());
+    }
+
+    TEST(TransportTest, HandlerBatch) {
+        BasicHandler<LoopbackTransport> handler;
+        LoopbackTransport receiver;
+        ASSERT_TRUE(receiver.init("transport_test_handler_batch"));
+        receiver.set_timeout(0.01);
+        ASSERT_TRUE(handler.init("transport_test_handler_batch"));
+
+        // the velocity, gimbal and LED command of one control tick.
+        const std::vector<Message> batch = {
+            Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, 1, { 0x00, 0x3f, 0x21, 0x00, 0x00, 0x00, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }),
+            Message(DEVICE_ID_INTELLI_CONTROLLER, 0x0409, 2, { 0x00, 0x04, 0x69, 0x08, 0x05, 0x10, 0x00, 0xf0, 0xff }),
+            Message(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, 3, { 0x00, 0x3f, 0x32, 0x71, 0x00, 0x00, 0xff, 0x80, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0f, 0x00 })
+        };
+        std::vector<uint8_t> expected;
+        for (const Message &msg : batch) { const auto data = msg.to_vector(); expected.insert(expected.end(), data.begin(), data.end()); }
+        ASSERT_TRUE(handler.push_messages(batch));
+
+        // the frames of the batch follow each other on the bus, a heartbeat is sent before or after them.
+        std::vector<uint8_t> bus;
+        CanFrame frames[16];
+        size_t count;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::search(bus.begin(), bus.end(), expected.begin(), expected.end()) == bus.end() && std::chrono::steady_clock::now() < deadline) {
+            ASSERT_TRUE(receiver.read_frames(frames, 16, count));
+            for (size_t i = 0; i < count; i++) { bus.insert(bus.end(), frames[i].data, frames[i].data + frames[i].length); }
+        }
+        ASSERT_NE(std::search(bus.begin(), bus.end(), expected.begin(), expected.end()), bus.end());
+
+        const MetricsSnapshot metrics = handler.get_metrics();
+        ASSERT_LE(3, metrics.counters[METRIC_MESSAGES_SENT]);
+        ASSERT_EQ(metrics.counters[METRIC_SEND_QUEUE_DROPS], 0);
+    }
+
+    TEST(TransportTest, HandlerBatchFull) {
+        // without a sender thread the queue is not drained.
+        BasicHandler<LoopbackTransport> handler;
+        std::vector<Message> batch;
+        for (uint16_t i = 0; i < QUEUE_MSG_MAX_SIZE; i++) { batch.emplace_back(DEVICE_ID_INTELLI_CONTROLLER, 0x1809, i, std::vector<uint8_t>{ 0x00 }); }
+        ASSERT_TRUE(handler.push_messages(batch));
+
+        // the queued commands are kept, the batch which does not fit is dropped.
+        ASSERT_FALSE(handler.push_messages({ Message(DEVICE_ID_INTELLI_CONTROLLER, 0xc3c9, 0, std::vector<uint8_t>{ 0x00 }) }));
+        ASSERT_EQ(handler.get_metrics().counters[METRIC_SEND_QUEUE_DROPS], 1);
+        for (const ChannelLatency &channel : handler.get_latency_statistics()) {
+            ASSERT_EQ(channel.evicted, channel.type == 0xc3c9 ? 1 : 0);
+            ASSERT_EQ(channel.enqueued, channel.type == 0xc3c9 ? 1 : QUEUE_MSG_MAX_SIZE);
+        }
+    }
+} // namespace robomaster_can_controller
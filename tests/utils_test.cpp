@@ -9,6 +9,9 @@
 #include "robomaster_can_controller/definitions.h"
 #include "gtest/gtest.h"
 
+#include <array>
+#include <string>
+
 namespace robomaster_can_controller {
     const static Message MSG_ENABLE = Message( DEVICE_ID_INTELLI_CONTROLLER, 0xc309, 0, { 0x40, 0x3f, 0x19, 0x01 });
     const static Message MSG_DISABLE = Message( DEVICE_ID_INTELLI_CONTROLLER, 0xc309, 0, { 0x40, 0x3f, 0x19, 0x00 });
@@ -45,6 +48,20 @@ namespace robomaster_can_controller {
         ASSERT_NE(calculate_crc8(vector_enable.data(), vector_enable.size() - 2), crc8);
     }
 
+    TEST(UtilTest, find_byte) {
+        std::vector<uint8_t> data(100, 0x00);
+
+        ASSERT_EQ(find_byte(data.data(), data.size(), 0x55), data.size());
+        ASSERT_EQ(find_byte(data.data(), 0, 0x00), 0);
+
+        for (size_t i : { 0, 1, 15, 16, 17, 63, 64, 97, 99 }) {
+            data[i] = 0x55;
+            ASSERT_EQ(find_byte(data.data(), data.size(), 0x55), i);
+            ASSERT_EQ(find_byte(data.data(), i, 0x55), i);
+            data[i] = 0x00;
+        }
+    }
+
     TEST(UtilTest, clip) {
         ASSERT_FLOAT_EQ(clip<float>(-10.0f, -1.0f, 1.0f), -1.0f);
         ASSERT_FLOAT_EQ(clip<float>( -1.0f, -1.0f, 1.0f), -1.0f);
@@ -58,4 +75,31 @@ namespace robomaster_can_controller {
         ASSERT_FLOAT_EQ(clip<int>( 100, -100, 100),  100);
         ASSERT_FLOAT_EQ(clip<int>( 101, -100, 100),  100);
     }
+
+    TEST(UtilTest, hex_encode) {
+        std::vector<uint8_t> data(100);
+        for (size_t i = 0; i < data.size(); i++) { data[i] = static_cast<uint8_t>(i * 37 + 5); }
+        data[0] = 0x00; data[1] = 0xff; data[2] = 0x9a; data[17] = 0xa9;
+
+        // compare the table and the vector path with a single byte reference for every length around the blocks.
+        std::array<char, 256> buffer{};
+        for (size_t length : { 0, 1, 15, 16, 17, 31, 32, 33, 100 }) {
+            std::string expected;
+            for (size_t i = 0; i < length; i++) { expected += "0123456789abcdef"[data[i] >> 4]; expected += "0123456789abcdef"[data[i] & 0x0f]; }
+            ASSERT_EQ(hex_encode(data.data(), length, buffer.data(), buffer.size()), length * 2);
+            ASSERT_EQ(std::string(buffer.data(), length * 2), expected);
+        }
+        ASSERT_EQ(hex_encode(data.data(), 17, buffer.data(), 33), 0);
+
+        ASSERT_EQ(hex_dump(data.data(), 3, buffer.data(), buffer.size(), ','), 8);
+        ASSERT_EQ(std::string(buffer.data(), 8), "00,ff,9a");
+        ASSERT_EQ(hex_dump(data.data(), 3, buffer.data(), 7), 0);
+        ASSERT_EQ(string_to_hex(std::vector<uint8_t>{ 0xde, 0xad, 0x0b }), "de ad 0b");
+        ASSERT_EQ(string_to_hex(std::vector<uint8_t>{}), "");
+
+        uint_to_hex(0x202, buffer.data(), 4);
+        ASSERT_EQ(std::string(buffer.data(), 4), "0202");
+        uint_to_hex(0xdeadbeef, buffer.data(), 3);
+        ASSERT_EQ(std::string(buffer.data(), 3), "eef");
+    }
 } // namespace robomaster_can_controller
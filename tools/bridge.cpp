@@ -0,0 +1,70 @@
+// Copyright (c) 2024 Vinzenz Weist
+//
+// Licensed under the MIT License.
+// For details on the licensing terms, see the LICENSE file. Copyright refers to Fraunhofer IML
+
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include "robomaster_can_controller/robomaster.h"
+#include "robomaster_can_controller/bridge.h"
+
+/**
+ * @brief Forward a command of a client to the RoboMaster.
+ */
+void execute(robomaster_can_controller::RoboMaster &robomaster, const robomaster_can_controller::BridgeCommand &command) {
+    using namespace robomaster_can_controller;
+    switch (command.type) {
+        case BRIDGE_WORK_MODE: robomaster.set_work_mode(command.mask != 0); break;
+        case BRIDGE_VELOCITY: robomaster.set_velocity(command.x, command.y, command.z); break;
+        case BRIDGE_WHEEL_RPM: robomaster.set_wheel_rpm(command.values[0], command.values[1], command.values[2], command.values[3]); break;
+        case BRIDGE_BRAKE: robomaster.set_brake(); break;
+        case BRIDGE_GIMBAL: robomaster.set_gimbal(command.values[0], command.values[1]); break;
+        case BRIDGE_BLASTER: robomaster.set_blaster(command.mask == GELBEADS ? GELBEADS : INFRARED); break;
+        case BRIDGE_LED_OFF: robomaster.set_led_off(command.mask); break;
+        case BRIDGE_LED_ON: robomaster.set_led_on(command.mask, command.r, command.g, command.b); break;
+        case BRIDGE_LED_BREATH: robomaster.set_led_breath(command.mask, command.r, command.g, command.b, command.t_1, command.t_2); break;
+        case BRIDGE_LED_FLASH: robomaster.set_led_flash(command.mask, command.r, command.g, command.b, command.t_1, command.t_2); break;
+        default: break;
+    }
+}
+
+/**
+ * Serve the states and accept the commands of a RoboMaster over a local unix socket until SIGINT or SIGTERM.
+ * Usage: robomaster_can_controller_bridge [can_interface] [socket_path]
+ */
+int main(int argc, char **argv) {
+    // Using namespace for simplicity
+    using namespace robomaster_can_controller;
+
+    const std::string can_interface = 1 < argc ? argv[1] : "can0";
+    const std::string path = 2 < argc ? argv[2] : "/tmp/robomaster.sock";
+
+    // the signals are received with sigtimedwait, so they do not interrupt the threads.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    Bridge bridge;
+    RoboMaster robomaster;
+    if (!bridge.open(path)) { return EXIT_FAILURE; }
+    robomaster.set_callback([&bridge](const DataRoboMasterState &state) { bridge.publish(state); });
+    bridge.set_command_callback([&robomaster](const BridgeCommand &command) { execute(robomaster, command); });
+    if (!robomaster.init(can_interface)) { return EXIT_FAILURE; }
+
+    std::cout << "bridge " << can_interface << " on " << path << std::endl;
+    const timespec timeout{ 10, 0 };
+    while (robomaster.is_running()) {
+        if (0 < sigtimedwait(&signals, nullptr, &timeout)) { break; }
+        const BridgeStatistics statistics = bridge.get_statistics();
+        std::cout << statistics.clients << " clients, " << statistics.states << " states, " << statistics.packets << " packets, "
+                  << statistics.dropped << " dropped, " << statistics.commands << " commands" << std::endl;
+    }
+
+    // the callbacks use the bridge and the RoboMaster, the bridge is closed before the RoboMaster is destroyed.
+    bridge.close();
+    return robomaster.is_running() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
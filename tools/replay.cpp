@@ -0,0 +1,75 @@
+// Copyright (c) 2024 Vinzenz Weist
+//
+// Licensed under the MIT License.
+// For details on the licensing terms, see the LICENSE file. Copyright refers to Fraunhofer IML
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "robomaster_can_controller/replay.h"
+#include "robomaster_can_controller/definitions.h"
+#include "robomaster_can_controller/serializer.h"
+
+/**
+ * @brief Print the mean and the maximum latency of a stage.
+ */
+void print_stage(const char *name, const robomaster_can_controller::StageLatency &stage) {
+    const double mean = stage.count == 0 ? 0.0 : static_cast<double>(stage.total) / static_cast<double>(stage.count);
+    std::cout << name << ": " << stage.count << " calls, mean " << mean << " ns, max " << stage.max << " ns" << std::endl;
+}
+
+/**
+ * Replay a recorder log or a candump log through the reassembly, dispatch and decoding path, with --dump print the frames as candump log instead.
+ * Usage: robomaster_can_controller_replay <log> [--realtime] [--repeat N] [--print] [--dump]
+ */
+int main(int argc, char **argv) {
+    // Using namespace for simplicity
+    using namespace robomaster_can_controller;
+
+    if (argc < 2) { std::cout << "Usage: " << argv[0] << " <log> [--realtime] [--repeat N] [--print] [--dump]" << std::endl; return EXIT_FAILURE; }
+
+    ReplayMode mode = REPLAY_FAST;
+    size_t repeat = 1;
+    bool print = false;
+    bool dump = false;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--realtime") == 0) { mode = REPLAY_REALTIME; }
+        else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) { repeat = std::strtoul(argv[++i], nullptr, 10); }
+        else if (std::strcmp(argv[i], "--print") == 0) { print = true; }
+        else if (std::strcmp(argv[i], "--dump") == 0) { dump = true; }
+        else { std::cout << "Unknown argument " << argv[i] << std::endl; return EXIT_FAILURE; }
+    }
+
+    std::vector<CanFrame> frames;
+    if (!load_log(argv[1], frames)) { return EXIT_FAILURE; }
+
+    std::array<char, SERIALIZER_MAX_SIZE> buffer{};
+    if (dump) {
+        for (const CanFrame &frame : frames) {
+            write_line(stdout, buffer.data(), to_candump(frame, "can0", buffer.data(), buffer.size()));
+        }
+        return EXIT_SUCCESS;
+    }
+
+    Replay replay;
+    if (print) {
+        replay.set_callback([&buffer](const DataRoboMasterState &state) {
+            write_line(stdout, buffer.data(), to_json(state, buffer.data(), buffer.size(), true));
+        });
+    }
+
+    for (size_t i = 0; i < repeat; i++) {
+        const ReplayStatistics statistics = replay.run(frames, mode);
+        const StreamStatistics stream = replay.get_stream_statistics(DEVICE_ID_MOTION_CONTROLLER);
+
+        std::cout << "run " << i + 1 << ": " << statistics.frames << " frames, " << statistics.messages << " messages, " << statistics.states << " states in "
+                  << static_cast<double>(statistics.duration) * 1e-6 << " ms, " << statistics.messages_per_second << " messages/s" << std::endl;
+        std::cout << "motion controller: " << stream.crc_errors << " crc errors, " << stream.discarded_bytes << " discarded bytes" << std::endl;
+        print_stage("reassembly", statistics.reassembly);
+        print_stage("dispatch", statistics.dispatch);
+        print_stage("decode", statistics.decode);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2024 Vinzenz Weist
+//
+// Licensed under the MIT License.
+// For details on the licensing terms, see the LICENSE file. Copyright refers to Fraunhofer IML
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "robomaster_can_controller/state_log.h"
+#include "robomaster_can_controller/serializer.h"
+
+/**
+ * Convert a state log of a StateLog back to JSON lines, with --csv to CSV with header.
+ * Usage: robomaster_can_controller_state_log <log> [--csv]
+ */
+int main(int argc, char **argv) {
+    // Using namespace for simplicity
+    using namespace robomaster_can_controller;
+
+    if (argc < 2) { std::cout << "Usage: " << argv[0] << " <log> [--csv]" << std::endl; return EXIT_FAILURE; }
+    bool csv = false;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--csv") == 0) { csv = true; }
+        else { std::cout << "Unknown argument " << argv[i] << std::endl; return EXIT_FAILURE; }
+    }
+
+    StateLogReader reader;
+    if (!reader.open(argv[1])) { return EXIT_FAILURE; }
+
+    std::array<char, SERIALIZER_MAX_SIZE> buffer{};
+    if (csv) {
+        write_line(stdout, buffer.data(), to_csv_header(buffer.data(), buffer.size()));
+    }
+
+    DataRoboMasterState state;
+    while (reader.next(state)) {
+        write_line(stdout, buffer.data(), csv ? to_csv(state, buffer.data(), buffer.size()) : to_json(state, buffer.data(), buffer.size(), true));
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2024 Vinzenz Weist
+//
+// Licensed under the MIT License.
+// For details on the licensing terms, see the LICENSE file. Copyright refers to Fraunhofer IML
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "robomaster_can_controller/telemetry.h"
+#include "robomaster_can_controller/serializer.h"
+
+/**
+ * @brief Print a state as JSON or CSV line.
+ */
+void print_state(const robomaster_can_controller::DataRoboMasterState &state, const bool csv) {
+    static std::array<char, robomaster_can_controller::SERIALIZER_MAX_SIZE> buffer;
+    robomaster_can_controller::write_line(stdout, buffer.data(), csv ? to_csv(state, buffer.data(), buffer.size()) : to_json(state, buffer.data(), buffer.size(), true));
+}
+
+/**
+ * Print the states of a telemetry segment of another process, e.g. of a RoboMaster with set_telemetry_publisher.
+ * Every state of the history ring is printed, with --latest only the latest state after every wakeup, with --csv as CSV.
+ * Usage: robomaster_can_controller_telemetry <name> [--latest] [--csv]
+ */
+int main(int argc, char **argv) {
+    // Using namespace for simplicity
+    using namespace robomaster_can_controller;
+
+    if (argc < 2) { std::cout << "Usage: " << argv[0] << " <name> [--latest] [--csv]" << std::endl; return EXIT_FAILURE; }
+    bool latest = false;
+    bool csv = false;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--latest") == 0) { latest = true; }
+        else if (std::strcmp(argv[i], "--csv") == 0) { csv = true; }
+        else { std::cout << "Unknown argument " << argv[i] << std::endl; return EXIT_FAILURE; }
+    }
+
+    TelemetryReader reader;
+    if (!reader.open(argv[1])) { return EXIT_FAILURE; }
+    if (csv) {
+        std::array<char, SERIALIZER_MAX_SIZE> header{};
+        write_line(stdout, header.data(), to_csv_header(header.data(), header.size()));
+    }
+
+    uint64_t count = reader.get_count();
+    DataRoboMasterState state;
+    while (true) {
+        if (!reader.wait(count, 1.0)) { std::cout << "no state within 1 s" << std::endl; continue; }
+        if (latest) {
+            if (reader.read_latest(state, count)) { print_state(state, csv); std::fflush(stdout); }
+            continue;
+        }
+
+        // a reader which falls behind the ring continues with the oldest state which is still available.
+        const uint64_t end = reader.get_count();
+        if (reader.get_capacity() < end - count) { std::cout << "missed " << end - count - reader.get_capacity() << " states" << std::endl; count = end - reader.get_capacity(); }
+        for (; count < end; count++) { if (reader.read(count, state)) { print_state(state, csv); } }
+        std::fflush(stdout);
+    }
+}